@@ -60,6 +60,9 @@
         #include "bolt/cl/scan_by_key.h"
         #include "bolt/cl/gather.h"
         #include "bolt/cl/scatter.h"
+        #if defined( ENABLE_TBB )
+            #include "bolt/btbb/scan_engine.h"
+        #endif
 
         //#define BOLT_PROFILER_ENABLED
         #define BOLT_BENCH_DEVICE_VECTOR_FLAGS CL_MEM_READ_WRITE,
@@ -225,6 +228,7 @@ enum benchmarkType {
     bm_platform,
     bm_queryOpenCL,
     bm_runMode,
+    bm_scanEngine,
     bm_throwaway,
     bm_vecType,
     bm_version,
@@ -260,6 +264,7 @@ std::string benchmark_options[]={
     "--platform",
     "--queryOpenCL",
     "--runMode",
+    "--scanEngine",
     "--throw-away",
     "--vecType",
     "--version",
@@ -1259,6 +1264,9 @@ cout<<"-v [ --version ]"<<"\n\t\t\t\tPrint queryable version information from th
     cout<<"-c [ --cpu ]"<<"\n\t\t\t\tReport only OpenCL CPU devices\n";
     cout<<"-a [ --all ]"<<"\n\t\t\t\tReport all OpenCL devices\n";
     cout<<"-m [ --runMode] arg"<<"\n\t\t\t\tRun Mode: 0-Auto, 1-SerialCPU, 2-MultiCoreCPU, 3-GPU\n";
+#if (BENCHMARK_CL_AMP == CL_BENCH) && defined( ENABLE_TBB )
+    cout<<"--scanEngine arg"<<"\n\t\t\t\tMultiCoreCPU scans: 0-single pass look-back, 1-two pass parallel_scan\n";
+#endif
 #endif
     cout<<"-q [ --queryCuda ]"<<"\n\t\t\t\tPrint queryable platform and device info and return\n";
     cout<<"-D [ --deviceMemory ]"<<"\n\t\t\t\tAllocate vectors in device memory; default is host memory\n";
@@ -1291,6 +1299,7 @@ int main( int argc, char* argv[] )
     size_t length           = 1024;
     size_t vecType          = 0;
     size_t runMode          = 0;
+    size_t scanEngine       = 0;
     size_t routine          = f_binarytransform;
     size_t numThrowAway     = 0;
     std::string function_called=functionNames[routine] ;
@@ -1403,6 +1412,21 @@ int main( int argc, char* argv[] )
                            }
                        }
                        break;
+                   case bm_scanEngine:
+                       {
+                           if((loop+1)<argc)
+                           {
+                               scanEngine = atoi(argv[loop+1]);
+                               loop = loop + 1;
+                           }
+                           else
+                           {
+                               std::cerr << "[ --scanEngine ]   option requires one integer argument(Scan Engine.)" << std::endl;
+                               PrintHelp();
+                               return 1;
+                           }
+                       }
+                       break;
 #endif
                    case bm_help:
                    case bm_HELP:
@@ -1559,6 +1583,16 @@ int main( int argc, char* argv[] )
     {
         ctrl.setForceRunMode( bolt::BENCH_BEND::control::MultiCoreCpu );
         strDeviceName = "MultiCore CPU";
+#if (BENCHMARK_CL_AMP == CL_BENCH) && defined( ENABLE_TBB )
+        // Lets the GB/s of the single pass scans be compared with the tbb::parallel_scan ones
+        if (scanEngine == 1)
+        {
+            bolt::btbb::setScanEngine( bolt::btbb::TwoPassScan );
+            strDeviceName = "MultiCore CPU (two pass scan)";
+        }
+        else
+            bolt::btbb::setScanEngine( bolt::btbb::LookbackScan );
+#endif
     }
     else // gpu || automatic (RunMode == 0)
     {
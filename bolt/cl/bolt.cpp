@@ -27,7 +27,21 @@
 #include <vector>
 #include <set>
 
+#include <typeinfo>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __i386__ ) || defined( __x86_64__ )
+#include <emmintrin.h>
+#endif
+
 #include "bolt/cl/bolt.h"
+#include "bolt/cl/program_cache.h"
 #include "bolt/unicode.h"
 
 //  Include all kernel string objects
@@ -404,8 +418,196 @@ namespace bolt {
         cl_int * err = NULL);
 
 
-    void wait(const bolt::cl::control &ctl, ::cl::Event &e)
+    namespace
     {
+        typedef boost::chrono::steady_clock waitClock;
+
+        //  Bounds of the spin window of a balanced wait.  Waking a blocked thread costs tens of microseconds, so a
+        //  command expected to finish within maxSpinNanoseconds is cheaper to spin for; a longer one is still
+        //  polled for minSpinNanoseconds, in case it finishes early
+        const cl_ulong minSpinNanoseconds = 2000;
+        const cl_ulong maxSpinNanoseconds = 200000;
+
+        //  The status of the event is polled after this many pauses; every poll is a call into the runtime
+        const unsigned pausesPerPoll = 16;
+
+        inline void cpuPause( )
+        {
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __i386__ ) || defined( __x86_64__ )
+            _mm_pause( );
+#endif
+        }
+
+        inline cl_ulong nanoseconds( waitClock::duration d )
+        {
+            return static_cast< cl_ulong >( boost::chrono::duration_cast< boost::chrono::nanoseconds >( d ).count( ) );
+        }
+
+        //  Waits are told apart by device, command type and site
+        struct waitKey
+        {
+            cl_device_id device;
+            cl_command_type command;
+            std::string site;
+
+            bool operator<( const waitKey& rhs ) const
+            {
+                if( device != rhs.device )
+                    return device < rhs.device;
+                if( command != rhs.command )
+                    return command < rhs.command;
+                return site < rhs.site;
+            }
+        };
+
+        struct waitRegistry
+        {
+            waitRegistry( ): waits( 0 ), spinCompletions( 0 ), blockingWaits( 0 ), spinNanoseconds( 0 ),
+                wakeupNanoseconds( 0 ), maxWakeupNanoseconds( 0 )
+            {}
+
+            boost::mutex guard;
+            std::map< waitKey, cl_ulong > expected;     // moving average of how long the waits of a key took, in ns
+
+            boost::atomic< cl_ulong > waits;
+            boost::atomic< cl_ulong > spinCompletions;
+            boost::atomic< cl_ulong > blockingWaits;
+            boost::atomic< cl_ulong > spinNanoseconds;
+            boost::atomic< cl_ulong > wakeupNanoseconds;
+            boost::atomic< cl_ulong > maxWakeupNanoseconds;
+        };
+
+        waitRegistry& getWaitRegistry( )
+        {
+            static waitRegistry _registry;
+            return _registry;
+        }
+
+        //  What the completion callback of an event tells the thread blocked on it; the callback owns a reference,
+        //  so a waiter that gives up early does not leave it a dangling pointer
+        struct wakeup
+        {
+            wakeup( ): complete( false )
+            {}
+
+            boost::mutex guard;
+            boost::condition_variable done;
+            bool complete;
+            waitClock::time_point when;
+        };
+
+        void CL_CALLBACK wakeWaiter( cl_event, cl_int, void* data )
+        {
+            boost::shared_ptr< wakeup >* owner = static_cast< boost::shared_ptr< wakeup >* >( data );
+            {
+                boost::lock_guard< boost::mutex > lock( ( *owner )->guard );
+                ( *owner )->when = waitClock::now( );
+                ( *owner )->complete = true;
+                ( *owner )->done.notify_one( );
+            }
+            delete owner;
+        }
+
+        void balancedWait( const bolt::cl::control &ctl, ::cl::Event &e, const char* site )
+        {
+            waitRegistry& registry = getWaitRegistry( );
+            const ::cl::CommandQueue& q = ctl.getCommandQueue( );
+            V_OPENCL( q.flush( ), "flush call failed" );
+
+            waitKey key;
+            key.device = q.getInfo< CL_QUEUE_DEVICE >( )( );
+            key.command = e.getInfo< CL_EVENT_COMMAND_TYPE >( );
+            key.site = site ? site : "";
+
+            cl_ulong expected;
+            {
+                boost::lock_guard< boost::mutex > lock( registry.guard );
+                expected = registry.expected[ key ];
+            }
+
+            //  A site seen for the first time spins as long as any; later ones spin for twice their usual time
+            cl_ulong window = maxSpinNanoseconds;
+            if( expected > maxSpinNanoseconds )
+                window = minSpinNanoseconds;
+            else if( expected != 0 )
+                window = std::min( std::max( 2 * expected, minSpinNanoseconds ), maxSpinNanoseconds );
+
+            const waitClock::time_point start = waitClock::now( );
+            waitClock::time_point completed = start;
+            cl_int status;
+            for( ; ; )
+            {
+                status = e.getInfo< CL_EVENT_COMMAND_EXECUTION_STATUS >( );
+                completed = waitClock::now( );
+                if( status <= CL_COMPLETE || nanoseconds( completed - start ) >= window )
+                    break;
+
+                for( unsigned pause = 0; pause < pausesPerPoll; ++pause )
+                    cpuPause( );
+            }
+
+            ++registry.waits;
+            registry.spinNanoseconds += nanoseconds( completed - start );
+
+            if( status <= CL_COMPLETE )
+                ++registry.spinCompletions;
+            else
+            {
+                ++registry.blockingWaits;
+
+                boost::shared_ptr< wakeup > w = boost::make_shared< wakeup >( );
+                boost::shared_ptr< wakeup >* owner = new boost::shared_ptr< wakeup >( w );
+                bool callback = false;
+                try
+                {
+                    callback = e.setCallback( CL_COMPLETE, wakeWaiter, owner ) == CL_SUCCESS;
+                }
+                catch( ::cl::Error& )
+                {
+                }
+
+                if( callback )
+                {
+                    boost::unique_lock< boost::mutex > lock( w->guard );
+                    while( !w->complete )
+                        w->done.wait( lock );
+
+                    completed = w->when;
+                    const cl_ulong latency = nanoseconds( waitClock::now( ) - completed );
+                    registry.wakeupNanoseconds += latency;
+
+                    cl_ulong maxLatency = registry.maxWakeupNanoseconds.load( );
+                    while( latency > maxLatency && !registry.maxWakeupNanoseconds.compare_exchange_weak( maxLatency, latency ) )
+                        ;
+                }
+                else
+                {
+                    //  OpenCL 1.0 has no event callbacks; the wakeup is not measured
+                    delete owner;
+                    V_OPENCL( e.wait( ), "wait call failed" );
+                    completed = waitClock::now( );
+                }
+
+                status = e.getInfo< CL_EVENT_COMMAND_EXECUTION_STATUS >( );
+            }
+
+            V_OPENCL( status < CL_COMPLETE ? status : CL_SUCCESS, "the command waited for failed" );
+
+            //  A quarter of every new observation goes into the average, so a site follows a change of input size
+            //  within a few calls
+            const cl_ulong observed = std::max< cl_ulong >( nanoseconds( completed - start ), 1 );
+            boost::lock_guard< boost::mutex > lock( registry.guard );
+            cl_ulong& average = registry.expected[ key ];
+            average = ( average == 0 ) ? observed : ( 3 * average + observed ) / 4;
+        }
+    }
+
+    void wait(const bolt::cl::control &ctl, ::cl::Event &e, const char* site)
+    {
+        //  An asynchronous call waits for its commands when its result is asked for
+        if( ctl.getDeferred( ) != NULL )
+            return;
+
         const bolt::cl::control::e_WaitMode waitMode = ctl.getWaitMode();
         if (waitMode == bolt::cl::control::BusyWait) {
             const ::cl::CommandQueue& q = ctl.getCommandQueue();
@@ -413,7 +615,9 @@ namespace bolt {
             while (e.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() != CL_COMPLETE) {
                 // spin here for fast completion detection...
             };
-        } else if ((waitMode == bolt::cl::control::NiceWait) || (waitMode == bolt::cl::control::BalancedWait)) {
+        } else if (waitMode == bolt::cl::control::BalancedWait) {
+            balancedWait( ctl, e, site );
+        } else if (waitMode == bolt::cl::control::NiceWait) {
             cl_int l_Error = e.wait();
             V_OPENCL( l_Error, "wait call failed" );
         } else if (waitMode == bolt::cl::control::ClFinish) {
@@ -423,6 +627,25 @@ namespace bolt {
         }
     };
 
+    waitStatistics getWaitStatistics( )
+    {
+        waitRegistry& registry = getWaitRegistry( );
+        waitStatistics stats = { registry.waits, registry.spinCompletions, registry.blockingWaits,
+                                 registry.spinNanoseconds, registry.wakeupNanoseconds, registry.maxWakeupNanoseconds };
+        return stats;
+    }
+
+    void resetWaitStatistics( )
+    {
+        waitRegistry& registry = getWaitRegistry( );
+        registry.waits = 0;
+        registry.spinCompletions = 0;
+        registry.blockingWaits = 0;
+        registry.spinNanoseconds = 0;
+        registry.wakeupNanoseconds = 0;
+        registry.maxWakeupNanoseconds = 0;
+    }
+
     /**************************************************************************
      * Compile Kernel from primitive information
      *************************************************************************/
@@ -448,9 +671,50 @@ namespace bolt {
         std::cout << hr << std::endl;
     }
 
+    namespace
+    {
+        // Kernels are cached per thread, because clSetKernelArg must not be called on one kernel object from
+        // several threads at once; a kernel set up and enqueued by one thread can be reused by that thread
+        typedef ::std::map< ProgramMapKey, ::std::vector< ::cl::Kernel > > KernelMap;
+        boost::thread_specific_ptr< KernelMap > threadKernels;
+
+        // Identifies everything that goes into the kernels returned by getKernels, without assembling them
+        ProgramDigest kernelDigest(
+            const control&      ctl,
+            const std::vector<std::string>& typeNames,
+            const KernelTemplateSpecializer * const kts,
+            const std::vector<std::string>& typeDefs,
+            const std::string&  kernelString,
+            const std::string&  options )
+        {
+            ProgramDigester digester;
+            digester.add( typeid( *kts ).name( ) );
+            for( size_t i = 0; i < typeNames.size( ); ++i )
+                digester.add( typeNames[ i ] );
+            for( size_t i = 0; i < typeDefs.size( ); ++i )
+                digester.add( typeDefs[ i ] );
+
+            // the whole base kernel string goes in, so that a specializer reused with different kernels of
+            // the same length does not return the kernels of another program
+            digester.add( kernelString );
+
+            unsigned debugMode = ctl.getDebugMode( ) & control::debug::SaveCompilerTemps;
+            digester.add( &debugMode, sizeof( debugMode ) );
+            digester.add( options );
+            digester.add( ctl.getCompileOptions( ) );
+            return digester.digest( );
+        }
+    }
+
+    void clearKernelCache( )
+    {
+        threadKernels.reset( );
+    }
+
     /**************************************************************************
     * getKernels
-    * - concatenates input strings into complete kernel string to be compiled
+    * - returns the kernels this thread created before for the same specialization
+    * - otherwise concatenates input strings into complete kernel string to be compiled
     * - takes into account control
     * - requests program/kernel from ProgramMap
     **************************************************************************/
@@ -462,6 +726,23 @@ namespace bolt {
         const std::string&  kernelString,
         const std::string&  options )
     {
+        // a debug build of the kernels always goes through the whole path, so that the kernels are printed
+        const bool useKernelCache = !( ctl.getDebugMode( ) & control::debug::Compile );
+        ::cl::Context context = ctl.getContext( );
+        ::cl::Device device = ctl.getDevice( );
+        ProgramMapKey kernelKey = { context( ), device( ), { 0, 0 } };
+
+        if( useKernelCache )
+        {
+            kernelKey.digest = kernelDigest( ctl, typeNames, kts, typeDefs, kernelString, options );
+            if( threadKernels.get( ) == NULL )
+                threadKernels.reset( new KernelMap );
+
+            KernelMap::const_iterator cached = threadKernels->find( kernelKey );
+            if( cached != threadKernels->end( ) )
+                return cached->second;
+        }
+
         std::string completeKernelString;
         /* In device vector.h functional.h and bolt.h the defintions of cl_* are given. These cl_* are typedef'd
          * to there corresponding types in cl_platforms.h. To the kernel Actually the cl_* are passed, But the OpenCL
@@ -518,8 +799,8 @@ namespace bolt {
 
         // request program from program cache (ProgramMap)
         ::cl::Program program = acquireProgram(
-            ctl.getContext(),
-            ctl.getDevice(),
+            context,
+            device,
             compileOptions,
             completeKernelString);
 
@@ -551,9 +832,45 @@ namespace bolt {
             }
         }
 
+        // only a complete set of kernels is remembered; a failed kernel is retried on the next call
+        if( useKernelCache && kernels.size( ) == kts->numKernels( ) )
+            threadKernels->insert( std::make_pair( kernelKey, kernels ) );
+
         return kernels;
     }
 
+    namespace
+    {
+        // Called by the ProgramMap for a program that this process has not built yet
+        ::cl::Program buildProgram(
+            const ::cl::Context& context,
+            const ::cl::Device&  device,
+            const ::std::string& options,
+            const ::std::string& source,
+            const ProgramDigest& digest )
+        {
+            cl_int l_err;
+            ::cl::Program program;
+
+            // a previous process may have left the binary in the persistent program cache;
+            // -save-temps builds always go through the compiler, so that the temporaries are produced
+            ProgramCache& diskCache = ProgramCache::getInstance( );
+            bool useDiskCache = options.find( "-save-temps" ) == std::string::npos;
+            ProgramDigest diskKey = { 0, 0 };
+            if( useDiskCache )
+                diskKey = ProgramCache::makeKey( device, digest );
+
+            if( !useDiskCache || !diskCache.load( context, device, options, diskKey, program ) )
+            {
+                program = ::bolt::cl::compileProgram(context, device, options, source, &l_err);
+                V_OPENCL( l_err, "bolt::cl::compileProgram() failed" );
+                if( useDiskCache )
+                    diskCache.store( device, diskKey, program );
+            }
+            return program;
+        }
+    }
+
     /**************************************************************************
      * aquireKernels
      * - returns kernels from ProgramMap if exist
@@ -565,32 +882,114 @@ namespace bolt {
         const ::std::string& options,
         const ::std::string& source)
     {
-        // only one threads get to seach and retrieve-or-compile at a time
-        boost::lock_guard< boost::mutex > lock( ::bolt::cl::programMapMutex ); // unlocks upon return
-        cl_int l_err;
+        // Does Program already exist?  Only the digest of the options and the source is compared
+        ProgramDigest digest = ProgramDigester( ).add( options ).add( source ).digest( );
+        ProgramMapKey key = { context( ), device( ), digest };
 
-        // Does Program already exist?
-        std::string deviceStr = device.getInfo< CL_DEVICE_NAME >( );
-        deviceStr += "; " + device.getInfo< CL_DEVICE_VERSION >( );
-        deviceStr += "; " + device.getInfo< CL_DEVICE_VENDOR >( );
-        ProgramMapKey key = {context, deviceStr, options, source};
-        ProgramMap::iterator iter = programMap.find( key );
         ::cl::Program program;
+        if( programMap.find( key, program ) )
+            return program;
+
+        // map does not yet contain desired program; only this key waits while it is built
+        return programMap.acquire( key, context, device,
+            boost::bind( &buildProgram, boost::cref( context ), boost::cref( device ),
+                         boost::cref( options ), boost::cref( source ), boost::cref( digest ) ) );
+    } // aquireProgram
+
+    /**************************************************************************
+    * ProgramMap
+    **************************************************************************/
+    bool ProgramMap::find( const ProgramMapKey& key, ::cl::Program& program ) const
+    {
+        const shard& s = shardOf( key );
+        boost::shared_lock< boost::shared_mutex > lock( s.guard );
+
+        ::std::map< ProgramMapKey, ProgramMapValue >::const_iterator iter = s.programs.find( key );
+        if( iter == s.programs.end( ) )
+            return false;
+
+        program = iter->second.program;
+        return true;
+    }
+
+    ::cl::Program ProgramMap::acquire(
+        const ProgramMapKey& key,
+        const ::cl::Context& context,
+        const ::cl::Device&  device,
+        const builder& build )
+    {
+        shard& s = shardOf( key );
+
+        for( ;; )
+        {
+            boost::shared_ptr< boost::mutex > building;
+            boost::unique_lock< boost::mutex > buildLock;
+            {
+                boost::unique_lock< boost::shared_mutex > lock( s.guard );
+
+                ::std::map< ProgramMapKey, ProgramMapValue >::iterator iter = s.programs.find( key );
+                if( iter != s.programs.end( ) )
+                    return iter->second.program;
+
+                ::std::map< ProgramMapKey, boost::shared_ptr< boost::mutex > >::iterator pendingIter =
+                    s.pending.find( key );
+                if( pendingIter == s.pending.end( ) )
+                {
+                    // this thread builds the program; it holds the pending mutex until the program is published
+                    building.reset( new boost::mutex );
+                    buildLock = boost::unique_lock< boost::mutex >( *building );
+                    s.pending.insert( std::make_pair( key, building ) );
+                }
+                else
+                    building = pendingIter->second;
+            }
+
+            if( !buildLock.owns_lock( ) )
+            {
+                // another thread is building the program; wait for it and look again, as its build may have failed
+                boost::lock_guard< boost::mutex > waitLock( *building );
+                continue;
+            }
+
+            ::cl::Program program;
+            try
+            {
+                program = build( );
+            }
+            catch( ... )
+            {
+                boost::unique_lock< boost::shared_mutex > lock( s.guard );
+                s.pending.erase( key );
+                throw;
+            }
 
-        // map does not yet contain desired program
-        if( iter == programMap.end( ) )
+            boost::unique_lock< boost::shared_mutex > lock( s.guard );
+            ProgramMapValue value = { context, device, program };
+            s.programs.insert( std::make_pair( key, value ) );
+            s.pending.erase( key );
+            return program;
+        }
+    }
+
+    void ProgramMap::clear( )
+    {
+        for( size_t i = 0; i < shardCount; ++i )
         {
-            program = ::bolt::cl::compileProgram(context, device, options, source, &l_err);
-            V_OPENCL( l_err, "bolt::cl::compileProgram() failed" );
-            ProgramMapValue value = { program };
-            programMap.insert( std::make_pair( key, value ) );
+            boost::unique_lock< boost::shared_mutex > lock( m_shards[ i ].guard );
+            m_shards[ i ].programs.clear( );
         }
-        else // map already contains desired kernel
+    }
+
+    size_t ProgramMap::size( ) const
+    {
+        size_t total = 0;
+        for( size_t i = 0; i < shardCount; ++i )
         {
-            program = iter->second.program;
+            boost::shared_lock< boost::shared_mutex > lock( m_shards[ i ].guard );
+            total += m_shards[ i ].programs.size( );
         }
-        return program;
-    } // aquireProgram
+        return total;
+    }
 
     /**************************************************************************
     * compileProgram
@@ -640,8 +1039,75 @@ namespace bolt {
     } // compileProgram
 
 
+    /**************************************************************************
+    * ProgramDigester
+    * - two independent 64-bit lanes; lane 0 is FNV-1a, lane 1 a multiply/xorshift
+    *   mix, both finalized with the murmur3 avalanche step
+    **************************************************************************/
+    namespace
+    {
+        inline cl_ulong finalizeLane( cl_ulong h )
+        {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+    }
+
+    ProgramDigester::ProgramDigester( ) :
+        m_lane0( 0xcbf29ce484222325ULL ),
+        m_lane1( 0x9e3779b97f4a7c15ULL ),
+        m_length( 0 )
+    {}
+
+    ProgramDigester& ProgramDigester::add( const void* data, size_t size )
+    {
+        const unsigned char* bytes = static_cast< const unsigned char* >( data );
+        cl_ulong lane0 = m_lane0;
+        cl_ulong lane1 = m_lane1;
+        for( size_t i = 0; i < size; ++i )
+        {
+            lane0 = ( lane0 ^ bytes[ i ] ) * 0x100000001b3ULL;
+            lane1 = ( lane1 ^ bytes[ i ] ) * 0x87c37b91114253d5ULL;
+            lane1 ^= lane1 >> 29;
+        }
+        m_lane0 = lane0;
+        m_lane1 = lane1;
+        m_length += size;
+        return *this;
+    }
+
+    ProgramDigester& ProgramDigester::add( const ::std::string& str )
+    {
+        cl_ulong length = str.size( );
+        add( &length, sizeof( length ) );
+        return add( str.data( ), str.size( ) );
+    }
+
+    ProgramDigest ProgramDigester::digest( ) const
+    {
+        ProgramDigest result;
+        result.high = finalizeLane( m_lane0 ^ m_length );
+        result.low  = finalizeLane( m_lane1 + m_length );
+        return result;
+    }
+
+    ::std::string ProgramDigest::toString( ) const
+    {
+        static const char hexDigits[] = "0123456789abcdef";
+        ::std::string str( 32, '0' );
+        for( int i = 0; i < 16; ++i )
+        {
+            str[ 15 - i ] = hexDigits[ ( high >> ( 4 * i ) ) & 0xf ];
+            str[ 31 - i ] = hexDigits[ ( low >> ( 4 * i ) ) & 0xf ];
+        }
+        return str;
+    }
+
         // externed in bolt.h
-        boost::mutex programMapMutex;
         ProgramMap programMap;
 
 
@@ -0,0 +1,391 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#include <cstdlib>
+#include <algorithm>
+
+#include <boost/functional/hash.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/buffer_pool.h"
+
+namespace bolt {
+    namespace cl {
+
+    namespace
+    {
+        //  The size class of minBufferSize
+        const unsigned minSizeClass = 8;
+
+        //  The pools of all contexts in use; a pool is owned by the controls and buffers that use it, which keep its
+        //  context alive, and it removes its entry when the last of them goes away
+        struct poolRegistry
+        {
+            boost::mutex guard;
+            std::map< cl_context, boost::weak_ptr< BufferPool > > pools;
+        };
+
+        poolRegistry& getRegistry( )
+        {
+            static poolRegistry _registry;
+            return _registry;
+        }
+    }
+
+    //  A buffer owned by the pool; it is on the free list of its size class and on the LRU list of its shard while
+    //  it is cached, and on neither while it is handed out
+    struct BufferPool::pooledBuffer
+    {
+        ::cl::Buffer buffer;
+        freeKey key;
+        size_t size;
+        size_t home;    // the shard the buffer returns to
+        bufferList::iterator freePosition;
+        bufferList::iterator lruPosition;
+        pooledBuffer* nextReleased;
+    };
+
+    //  The deleter of the pointers handed out by acquire; it keeps the pool alive as long as one of its buffers is
+    //  in use
+    class BufferPool::recycleBuffer
+    {
+    public:
+        recycleBuffer( const boost::shared_ptr< BufferPool >& pool, pooledBuffer* buffer ):
+            m_pool( pool ), m_buffer( buffer )
+        {}
+
+        void operator( )( ::cl::Buffer* )
+        {
+            m_pool->recycle( m_buffer );
+        }
+
+    private:
+        boost::shared_ptr< BufferPool > m_pool;
+        pooledBuffer* m_buffer;
+    };
+
+    bool BufferPool::freeKey::operator<( const freeKey& rhs ) const
+    {
+        if( context != rhs.context )
+            return context < rhs.context;
+        if( flags != rhs.flags )
+            return flags < rhs.flags;
+        return sizeClass < rhs.sizeClass;
+    }
+
+    boost::shared_ptr< BufferPool > BufferPool::getPool( const ::cl::CommandQueue& queue )
+    {
+        if( queue( ) == NULL )
+            return boost::shared_ptr< BufferPool >( new BufferPool( ) );
+
+        ::cl::Context context = queue.getInfo< CL_QUEUE_CONTEXT >( );
+
+        poolRegistry& registry = getRegistry( );
+        boost::lock_guard< boost::mutex > lock( registry.guard );
+
+        boost::weak_ptr< BufferPool >& entry = registry.pools[ context( ) ];
+        boost::shared_ptr< BufferPool > pool = entry.lock( );
+        if( !pool )
+        {
+            pool.reset( new BufferPool( ) );
+            pool->m_context = context( );
+            entry = pool;
+        }
+
+        return pool;
+    }
+
+    BufferPool::BufferPool( ) :
+        m_context( NULL ),
+        m_numShards( std::max( boost::thread::hardware_concurrency( ), 1u ) ),
+        m_shards( new shard[ m_numShards ] ),
+        m_maxSize( static_cast< size_t >( 256 ) << 20 ),
+        m_bytesHeld( 0 ),
+        m_bytesInUse( 0 )
+    {
+        const char* sizeMB = std::getenv( "BOLT_BUFFER_POOL_SIZE_MB" );
+        if( sizeMB != NULL && *sizeMB != '\0' )
+            m_maxSize = static_cast< size_t >( std::strtoul( sizeMB, NULL, 10 ) ) << 20;
+
+        resetStatistics( );
+    }
+
+    BufferPool::~BufferPool( )
+    {
+        //  Every buffer in use holds a reference to the pool, so all of them have been released by now
+        for( size_t s = 0; s < m_numShards; ++s )
+        {
+            collect( m_shards[ s ] );
+            evict( m_shards[ s ], 0 );
+        }
+
+        //  Leave the entry alone if getPool has already replaced it with the pool of a new control
+        if( m_context != NULL )
+        {
+            poolRegistry& registry = getRegistry( );
+            boost::lock_guard< boost::mutex > lock( registry.guard );
+
+            std::map< cl_context, boost::weak_ptr< BufferPool > >::iterator entry = registry.pools.find( m_context );
+            if( entry != registry.pools.end( ) && entry->second.expired( ) )
+                registry.pools.erase( entry );
+        }
+    }
+
+    unsigned BufferPool::sizeClass( size_t reqSize )
+    {
+        unsigned sizeClass = minSizeClass;
+        while( sizeClass < sizeof( size_t ) * 8 - 1 && ( static_cast< size_t >( 1 ) << sizeClass ) < reqSize )
+            ++sizeClass;
+
+        return sizeClass;
+    }
+
+    size_t BufferPool::threadShard( ) const
+    {
+        return boost::hash< boost::thread::id >( )( boost::this_thread::get_id( ) ) % m_numShards;
+    }
+
+    BufferPool::buffPointer BufferPool::acquire( const ::cl::CommandQueue& queue, size_t reqSize, cl_mem_flags flags,
+                                                 const void* host_ptr )
+    {
+        ::cl::Context context = queue.getInfo< CL_QUEUE_CONTEXT >( );
+
+        //  The kernels only read a read only buffer, so one that is initialized from host memory can come from the
+        //  pool and be filled with a write.  Any other buffer that wraps host memory is tied to that memory
+        bool upload = false;
+        if( host_ptr != NULL )
+        {
+            const cl_mem_flags hostFlags = CL_MEM_USE_HOST_PTR | CL_MEM_COPY_HOST_PTR;
+            if( ( flags & CL_MEM_READ_ONLY ) && ( flags & hostFlags ) )
+            {
+                flags &= ~hostFlags;
+                upload = true;
+            }
+            else
+            {
+                ++m_misses;
+                return buffPointer( new ::cl::Buffer( context, flags, reqSize, const_cast< void* >( host_ptr ) ) );
+            }
+        }
+
+        const size_t home = threadShard( );
+        const unsigned reqClass = sizeClass( reqSize );
+        pooledBuffer* pooled = take( home, context( ), flags, reqClass );
+        if( pooled == NULL )
+            pooled = create( home, context, flags, reqClass );
+
+        buffPointer buffPtr( &pooled->buffer, recycleBuffer( shared_from_this( ), pooled ) );
+        if( upload )
+            queue.enqueueWriteBuffer( pooled->buffer, CL_TRUE, 0, reqSize, host_ptr );
+
+        return buffPtr;
+    }
+
+    BufferPool::pooledBuffer* BufferPool::take( size_t home, cl_context context, cl_mem_flags flags,
+                                                unsigned sizeClass )
+    {
+        //  The own shard first; the others only when it has nothing that fits
+        for( size_t s = 0; s < m_numShards; ++s )
+        {
+            shard& from = m_shards[ ( home + s ) % m_numShards ];
+            boost::lock_guard< boost::mutex > lock( from.guard );
+            collect( from );
+
+            //  The own size class fits best; the next one wastes at most three quarters of the buffer
+            for( unsigned fit = sizeClass; fit <= sizeClass + 1; ++fit )
+            {
+                const freeKey key = { context, flags, fit };
+                freeMap::iterator free = from.free.find( key );
+                if( free == from.free.end( ) || free->second.empty( ) )
+                    continue;
+
+                pooledBuffer* pooled = free->second.back( );
+                free->second.pop_back( );
+                from.lru.erase( pooled->lruPosition );
+
+                pooled->home = home;
+                m_bytesInUse += pooled->size;
+                ++m_hits;
+                return pooled;
+            }
+        }
+
+        ++m_misses;
+        return NULL;
+    }
+
+    BufferPool::pooledBuffer* BufferPool::create( size_t home, const ::cl::Context& context, cl_mem_flags flags,
+                                                  unsigned sizeClass )
+    {
+        const size_t size = static_cast< size_t >( 1 ) << sizeClass;
+        const size_t maxSize = m_maxSize;
+        m_evictions += trim( home, maxSize > size ? maxSize - size : 0 );
+
+        pooledBuffer* pooled = new pooledBuffer;
+        try
+        {
+            try
+            {
+                pooled->buffer = ::cl::Buffer( context, flags, size );
+            }
+            catch( ::cl::Error& )
+            {
+                //  The device may be out of memory because of what the pool caches; free it all and try again
+                m_evictions += trim( home, 0 );
+                pooled->buffer = ::cl::Buffer( context, flags, size );
+            }
+        }
+        catch( ... )
+        {
+            delete pooled;
+            throw;
+        }
+
+        const freeKey key = { context( ), flags, sizeClass };
+        pooled->key = key;
+        pooled->size = size;
+        pooled->home = home;
+        pooled->nextReleased = NULL;
+
+        m_bytesHeld += size;
+        m_bytesInUse += size;
+        return pooled;
+    }
+
+    void BufferPool::recycle( pooledBuffer* pooled )
+    {
+        //  Push on the list of released buffers; only collect( ) pops, and it takes the whole list at once, so the
+        //  push cannot be confused by a node that was popped and pushed again
+        boost::atomic< pooledBuffer* >& released = m_shards[ pooled->home ].released;
+
+        pooledBuffer* head = released.load( boost::memory_order_relaxed );
+        do
+        {
+            pooled->nextReleased = head;
+        }
+        while( !released.compare_exchange_weak( head, pooled, boost::memory_order_release,
+                                                boost::memory_order_relaxed ) );
+    }
+
+    //  Moves the released buffers of a shard back into their size classes; the guard of the shard must be held
+    void BufferPool::collect( shard& from )
+    {
+        pooledBuffer* pooled = from.released.exchange( NULL, boost::memory_order_acquire );
+
+        //  The list holds the latest release first; reverse it to keep the LRU order
+        pooledBuffer* ordered = NULL;
+        while( pooled != NULL )
+        {
+            pooledBuffer* next = pooled->nextReleased;
+            pooled->nextReleased = ordered;
+            ordered = pooled;
+            pooled = next;
+        }
+
+        for( ; ordered != NULL; ordered = ordered->nextReleased )
+        {
+            bufferList& free = from.free[ ordered->key ];
+            ordered->freePosition = free.insert( free.end( ), ordered );
+            ordered->lruPosition = from.lru.insert( from.lru.end( ), ordered );
+            m_bytesInUse -= ordered->size;
+        }
+    }
+
+    //  Frees the least recently released buffers of a shard until the pool holds no more than maxSize bytes, or
+    //  the shard caches nothing any more; the guard of the shard must be held.  Returns the number of buffers freed
+    size_t BufferPool::evict( shard& from, size_t maxSize )
+    {
+        size_t evicted = 0;
+        while( m_bytesHeld > maxSize && !from.lru.empty( ) )
+        {
+            pooledBuffer* pooled = from.lru.front( );
+            from.lru.pop_front( );
+
+            freeMap::iterator free = from.free.find( pooled->key );
+            free->second.erase( pooled->freePosition );
+            if( free->second.empty( ) )
+                from.free.erase( free );
+
+            m_bytesHeld -= pooled->size;
+            ++evicted;
+            delete pooled;
+        }
+
+        return evicted;
+    }
+
+    //  Evicts from the shard home first, then from the others, until the pool holds no more than maxSize bytes
+    size_t BufferPool::trim( size_t home, size_t maxSize )
+    {
+        size_t evicted = 0;
+        for( size_t s = 0; s < m_numShards && m_bytesHeld > maxSize; ++s )
+        {
+            shard& from = m_shards[ ( home + s ) % m_numShards ];
+            boost::lock_guard< boost::mutex > lock( from.guard );
+            collect( from );
+            evicted += evict( from, maxSize );
+        }
+
+        return evicted;
+    }
+
+    void BufferPool::setMaxSize( size_t maxSize )
+    {
+        m_maxSize = maxSize;
+        m_evictions += trim( threadShard( ), maxSize );
+    }
+
+    size_t BufferPool::getMaxSize( ) const
+    {
+        return m_maxSize;
+    }
+
+    size_t BufferPool::totalSize( )
+    {
+        return m_bytesHeld;
+    }
+
+    void BufferPool::clear( )
+    {
+        trim( threadShard( ), 0 );
+    }
+
+    BufferPool::statistics BufferPool::getStatistics( )
+    {
+        //  Buffers still on a released list count as in use until they are collected
+        for( size_t s = 0; s < m_numShards; ++s )
+        {
+            boost::lock_guard< boost::mutex > lock( m_shards[ s ].guard );
+            collect( m_shards[ s ] );
+        }
+
+        statistics stats = { m_hits, m_misses, m_evictions, m_bytesHeld, m_bytesInUse };
+        return stats;
+    }
+
+    void BufferPool::resetStatistics( )
+    {
+        m_hits = 0;
+        m_misses = 0;
+        m_evictions = 0;
+    }
+
+    }; //namespace bolt::cl
+}; // namespace bolt
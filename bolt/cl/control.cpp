@@ -444,71 +444,55 @@ namespace cl
 
     size_t control::totalBufferSize( )
     {
-        size_t totalSize = 0;
-
-        for( mapBufferType::iterator it = mapBuffer.begin( ); it != mapBuffer.end( ); ++it )
-        {
-            totalSize += it->second.buffSize;
-        }
-
-        return totalSize;
+        return m_bufferPool->totalSize( );
     };
 
     control::buffPointer control::acquireBuffer( size_t reqSize, cl_mem_flags flags, const void* host_ptr )
     {
-        boost::lock_guard< boost::mutex > lock( mapGuard );
+        buffPointer buffer = m_bufferPool->acquire( m_commandQueue, reqSize, flags, host_ptr );
 
-        ::cl::Context myContext = m_commandQueue.getInfo< CL_QUEUE_CONTEXT >( );
+        //  The commands of an asynchronous call may still use the buffer after the algorithm returns
+        if( m_deferred )
+            m_deferred->scratch.push_back( buffer );
 
-        descBufferKey myDesc = { myContext, flags , host_ptr };
-        mapBufferType::iterator itLowerBound = mapBuffer.find( myDesc );
-        if( itLowerBound == mapBuffer.end( ) || host_ptr != NULL )
-        {
-            ::cl::Buffer tmp( myContext, flags, reqSize, const_cast< void*>( host_ptr ) );
-            descBufferValue myValue = { reqSize, true, tmp };
-            mapBufferType::iterator itInserted = mapBuffer.insert( std::make_pair( myDesc, myValue ) );
+        return buffer;
+    };
 
-            buffPointer buffPtr( &(itInserted->second.buffBuff), UnlockBuffer( *this, itInserted ) );
-            return buffPtr;
-        }
+    void control::freeBuffers( )
+    {
+        m_bufferPool->clear( );
+    };
 
-        for( ; itLowerBound != mapBuffer.upper_bound( myDesc ); ++itLowerBound )
+    namespace detail
+    {
+        deferred_completion::~deferred_completion( )
         {
-            //  If the current buffer is already being used, keep searching
-            if( itLowerBound->second.inUse == true )
-                continue;
-
-            if( itLowerBound->second.buffSize >= reqSize )
+            //  The scratch buffers must not return to the pool while the commands use them; a destructor must not
+            //  throw, so a failed wait leaves them to the release of the queue
+            try
+            {
+                complete( );
+            }
+            catch( ... )
             {
-                itLowerBound->second.inUse = true;
-                buffPointer buffPtr( &(itLowerBound->second.buffBuff), UnlockBuffer( *this, itLowerBound ) );
-                return buffPtr;
             }
-
-            //  If here, we found a buffer with the appropriate flags, but not big enough.  Delete the old 
-            //  buffer and then create a bigger one to take it's place.
-
-            mapBuffer.erase( itLowerBound );
-            break;
         }
 
-        //  If here, either all available buffers are currently in use, or we need to replace an existing buffer
-        // create a new buffer and add it to the map
-        ::cl::Buffer tmp( myContext, flags, reqSize, const_cast< void* >( host_ptr ) );
-        descBufferValue myValue = { reqSize, true, tmp };
-
-        mapBufferType::iterator itInserted = mapBuffer.insert( std::make_pair( myDesc, myValue ) );
-        buffPointer buffPtr( &(itInserted->second.buffBuff), UnlockBuffer( *this, itInserted ) );
-        return buffPtr;
-    };
+        void deferred_completion::complete( )
+        {
+            if( event( ) != NULL )
+                V_OPENCL( event.wait( ), "failed to wait for the commands of an asynchronous call" );
 
-    void control::freeBuffers( )
-    {
-        //  std::multimap is not thread-safe; lock the map when clearing it out
-        boost::lock_guard< boost::mutex > lock( mapGuard );
+            if( finish )
+            {
+                boost::function< void ( ) > tail;
+                tail.swap( finish );
+                tail( );
+            }
 
-        mapBuffer.clear( );
-    };
+            scratch.clear( );
+        }
+    }
 
 }
 }
@@ -0,0 +1,446 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/cost_model.h"
+
+namespace bolt {
+    namespace cl {
+
+    namespace
+    {
+        typedef boost::chrono::steady_clock costClock;
+
+        //  The throughputs are measured over this many bytes, enough to leave the caches of the host
+        const size_t measureBytes = 16 << 20;
+
+        //  Every measurement is the best of this many runs; the first run of a kernel also pays for its upload
+        const int measureRuns = 3;
+
+        const char* measureKernel =
+            "__kernel void boltCostModel( __global const uint* in, __global uint* out )\n"
+            "{\n"
+            "    size_t i = get_global_id( 0 );\n"
+            "    out[ i ] = in[ i ] + 1u;\n"
+            "}\n";
+
+        const double unavailable = std::numeric_limits< double >::infinity( );
+
+        template< typename Body >
+        double bestOf( const Body& body )
+        {
+            double best = unavailable;
+            for( int run = 0; run < measureRuns; ++run )
+            {
+                const costClock::time_point start = costClock::now( );
+                body( );
+                best = std::min( best, boost::chrono::duration< double >( costClock::now( ) - start ).count( ) );
+            }
+
+            return std::max( best, 1e-9 );
+        }
+
+        //  Sums a slice of the buffer the host throughputs are measured with
+        struct sumSlice
+        {
+            const cl_uint* first;
+            const cl_uint* last;
+            cl_uint* sum;
+
+            void operator( )( ) const
+            {
+                *sum = std::accumulate( first, last, 0u );
+            }
+        };
+
+        //  The runtime is built without TBB, so the multicore backend is measured with plain threads that wait
+        //  between calls, as the workers of the TBB arena do; every call wakes them all and waits for them
+        class sliceWorkers
+        {
+        public:
+            sliceWorkers( const cl_uint* first, size_t numThreads ):
+                m_first( first ), m_length( 0 ), m_stop( false ), m_sums( numThreads ),
+                m_start( static_cast< unsigned >( numThreads + 1 ) ),
+                m_done( static_cast< unsigned >( numThreads + 1 ) )
+            {
+                for( size_t t = 0; t < numThreads; ++t )
+                    m_threads.create_thread( [ this, t ]( ) { work( t ); } );
+            }
+
+            ~sliceWorkers( )
+            {
+                m_stop = true;
+                m_start.wait( );
+                m_threads.join_all( );
+            }
+
+            //  Sums the first length elements of the buffer, split among the threads
+            void operator( )( size_t length )
+            {
+                m_length = length;
+                m_start.wait( );
+                m_done.wait( );
+            }
+
+        private:
+            void work( size_t t )
+            {
+                for( ;; )
+                {
+                    m_start.wait( );
+                    if( m_stop )
+                        return;
+
+                    const size_t slice = m_length / m_sums.size( );
+                    const sumSlice part = { m_first + t * slice,
+                                            t + 1 == m_sums.size( ) ? m_first + m_length : m_first + ( t + 1 ) * slice,
+                                            &m_sums[ t ] };
+                    part( );
+                    m_done.wait( );
+                }
+            }
+
+            const cl_uint* m_first;
+            size_t m_length;    // written before m_start, which orders it for the threads
+            bool m_stop;
+            std::vector< cl_uint > m_sums;
+            boost::barrier m_start;
+            boost::barrier m_done;
+            boost::thread_group m_threads;
+        };
+    }
+
+    cost_model& cost_model::getInstance( )
+    {
+        static cost_model _model;
+        return _model;
+    }
+
+    cost_model::cost_model( )
+    {
+        for( size_t slot = 0; slot < cacheSlots; ++slot )
+        {
+            m_cache[ slot ].device.store( NULL, boost::memory_order_relaxed );
+            m_cache[ slot ].p.store( NULL, boost::memory_order_relaxed );
+        }
+
+        const char* path = std::getenv( "BOLT_COST_PROFILE" );
+        if( path != NULL && *path != '\0' )
+        {
+            m_profilePath = path;
+            loadProfiles( m_profilePath );
+        }
+    }
+
+    std::string cost_model::deviceKey( const ::cl::Device& device )
+    {
+        if( device( ) == NULL )
+            return "host";
+
+        return device.getInfo< CL_DEVICE_NAME >( ) + " / " + device.getInfo< CL_DRIVER_VERSION >( );
+    }
+
+    //  The cached profile of device, a NULL device being the host, or NULL if there is none
+    const cost_model::profile* cost_model::cached( cl_device_id device ) const
+    {
+        if( device == NULL )
+            return m_cache[ 0 ].p.load( boost::memory_order_acquire );
+
+        for( size_t slot = 1; slot < cacheSlots; ++slot )
+        {
+            const cl_device_id known = m_cache[ slot ].device.load( boost::memory_order_acquire );
+            if( known == device )
+                return m_cache[ slot ].p.load( boost::memory_order_acquire );
+            if( known == NULL )
+                break;
+        }
+
+        return NULL;
+    }
+
+    //  Makes p the cached profile of device; m_guard must be held.  A device that finds no free slot is served
+    //  from m_profiles
+    void cost_model::publish( cl_device_id device, const profile& p )
+    {
+        size_t slot = 0;
+        if( device != NULL )
+        {
+            for( slot = 1; slot < cacheSlots; ++slot )
+            {
+                const cl_device_id known = m_cache[ slot ].device.load( boost::memory_order_relaxed );
+                if( known == device || known == NULL )
+                    break;
+            }
+            if( slot == cacheSlots )
+                return;
+        }
+
+        //  Readers may still hold the profile this one replaces, so every published profile lives as long as the
+        //  model
+        m_published.push_back( boost::shared_ptr< const profile >( new profile( p ) ) );
+        m_cache[ slot ].p.store( m_published.back( ).get( ), boost::memory_order_release );
+        m_cache[ slot ].device.store( device, boost::memory_order_release );
+    }
+
+    cost_model::profile cost_model::getProfile( const control& ctl )
+    {
+        const ::cl::CommandQueue& queue = ctl.getCommandQueue( );
+        const ::cl::Device device = queue( ) == NULL ? ::cl::Device( ) : ctl.getDevice( );
+
+        const profile* known = cached( device( ) );
+        if( known != NULL )
+            return *known;
+
+        const std::string key = deviceKey( device );
+        {
+            boost::lock_guard< boost::mutex > lock( m_guard );
+            std::map< std::string, profile >::const_iterator found = m_profiles.find( key );
+            if( found != m_profiles.end( ) )
+            {
+                publish( device( ), found->second );
+                return found->second;
+            }
+        }
+
+        //  Two threads may measure the same device at once; both get a valid profile and the last one is kept
+        const profile measured = measure( ctl );
+
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        m_profiles[ key ] = measured;
+        publish( device( ), measured );
+        if( !m_profilePath.empty( ) )
+        {
+            std::ofstream file( m_profilePath.c_str( ), std::ios::app );
+            file.precision( 17 );
+            file << key << '\t' << measured.serialBytesPerSecond << ' ' << measured.multicoreSecondsPerCall << ' '
+                 << measured.multicoreBytesPerSecond << ' ' << measured.openclSecondsPerCall << ' '
+                 << measured.openclBytesPerSecond << ' ' << measured.transferBytesPerSecond << ' '
+                 << measured.hostUnifiedMemory << '\n';
+        }
+
+        return measured;
+    }
+
+    void cost_model::setProfile( const ::cl::Device& device, const profile& p )
+    {
+        const std::string key = deviceKey( device );
+
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        m_profiles[ key ] = p;
+        publish( device( ), p );
+    }
+
+    //  A profile is a line of the device key, a tab, and the fields of the profile separated by spaces
+    bool cost_model::loadProfiles( const std::string& path )
+    {
+        std::ifstream file( path.c_str( ) );
+        if( !file )
+            return false;
+
+        std::string line;
+        while( std::getline( file, line ) )
+        {
+            const std::string::size_type tab = line.find( '\t' );
+            if( tab == std::string::npos )
+                continue;
+
+            profile p;
+            std::istringstream fields( line.substr( tab + 1 ) );
+            if( fields >> p.serialBytesPerSecond >> p.multicoreSecondsPerCall >> p.multicoreBytesPerSecond
+                       >> p.openclSecondsPerCall >> p.openclBytesPerSecond >> p.transferBytesPerSecond
+                       >> p.hostUnifiedMemory )
+            {
+                boost::lock_guard< boost::mutex > lock( m_guard );
+                m_profiles[ line.substr( 0, tab ) ] = p;
+            }
+        }
+
+        //  The file may replace profiles that are cached; the next call on every device reads m_profiles again
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        for( size_t slot = 0; slot < cacheSlots; ++slot )
+            m_cache[ slot ].p.store( NULL, boost::memory_order_release );
+
+        return true;
+    }
+
+    bool cost_model::saveProfiles( const std::string& path )
+    {
+        std::ofstream file( path.c_str( ) );
+        if( !file )
+            return false;
+
+        file.precision( 17 );
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        for( std::map< std::string, profile >::const_iterator p = m_profiles.begin( ); p != m_profiles.end( ); ++p )
+        {
+            file << p->first << '\t' << p->second.serialBytesPerSecond << ' ' << p->second.multicoreSecondsPerCall
+                 << ' ' << p->second.multicoreBytesPerSecond << ' ' << p->second.openclSecondsPerCall << ' '
+                 << p->second.openclBytesPerSecond << ' ' << p->second.transferBytesPerSecond << ' '
+                 << p->second.hostUnifiedMemory << '\n';
+        }
+
+        return static_cast< bool >( file );
+    }
+
+    cost_model::profile cost_model::measure( const control& ctl )
+    {
+        profile p;
+
+        const size_t elements = measureBytes / sizeof( cl_uint );
+        std::vector< cl_uint > host( elements, 1 );
+
+        cl_uint sum = 0;
+        const sumSlice all = { &host[ 0 ], &host[ 0 ] + elements, &sum };
+        p.serialBytesPerSecond = measureBytes / bestOf( all );
+
+        //  As for OpenCL below, a call without work costs what every call costs, and the rest of a call over the
+        //  whole buffer is the time its bytes take
+        {
+            sliceWorkers workers( &host[ 0 ], std::max( boost::thread::hardware_concurrency( ), 1u ) );
+            const double wake = bestOf( [ & ]( )
+            {
+                workers( 0 );
+            } );
+            const double stream = bestOf( [ & ]( )
+            {
+                workers( elements );
+            } );
+
+            p.multicoreSecondsPerCall = wake;
+            p.multicoreBytesPerSecond = measureBytes / std::max( stream - wake, 1e-9 );
+        }
+
+        p.openclSecondsPerCall = unavailable;
+        p.openclBytesPerSecond = 0;
+        p.transferBytesPerSecond = 0;
+        p.hostUnifiedMemory = false;
+
+        const ::cl::CommandQueue& queue = ctl.getCommandQueue( );
+        if( queue( ) == NULL )
+            return p;
+
+        //  A device that cannot run the benchmark is not chosen; calls forced onto it report their own errors
+        try
+        {
+            const ::cl::Context context = queue.getInfo< CL_QUEUE_CONTEXT >( );
+            const ::cl::Device device = queue.getInfo< CL_QUEUE_DEVICE >( );
+            p.hostUnifiedMemory = device.getInfo< CL_DEVICE_HOST_UNIFIED_MEMORY >( ) == CL_TRUE;
+
+            ::cl::Buffer in( context, CL_MEM_READ_ONLY, measureBytes );
+            ::cl::Buffer out( context, CL_MEM_WRITE_ONLY, measureBytes );
+
+            const double write = bestOf( [ & ]( )
+            {
+                queue.enqueueWriteBuffer( in, CL_TRUE, 0, measureBytes, &host[ 0 ] );
+            } );
+            const double read = bestOf( [ & ]( )
+            {
+                queue.enqueueReadBuffer( out, CL_TRUE, 0, measureBytes, &host[ 0 ] );
+            } );
+            p.transferBytesPerSecond = 2 * measureBytes / ( write + read );
+
+            ::cl::Program::Sources sources( 1, std::make_pair( measureKernel, std::strlen( measureKernel ) ) );
+            ::cl::Program program( context, sources );
+            program.build( std::vector< ::cl::Device >( 1, device ) );
+
+            ::cl::Kernel kernel( program, "boltCostModel" );
+            kernel.setArg( 0, in );
+            kernel.setArg( 1, out );
+
+            //  A launch over a single wavefront costs what every call costs; the difference to a launch over the
+            //  whole buffer is the time its bytes take
+            const double launch = bestOf( [ & ]( )
+            {
+                ::cl::Event e;
+                queue.enqueueNDRangeKernel( kernel, ::cl::NullRange, ::cl::NDRange( 64 ), ::cl::NullRange, NULL, &e );
+                e.wait( );
+            } );
+            const double stream = bestOf( [ & ]( )
+            {
+                ::cl::Event e;
+                queue.enqueueNDRangeKernel( kernel, ::cl::NullRange, ::cl::NDRange( elements ), ::cl::NullRange, NULL,
+                                            &e );
+                e.wait( );
+            } );
+
+            p.openclSecondsPerCall = launch;
+            p.openclBytesPerSecond = measureBytes / std::max( stream - launch, 1e-9 );
+        }
+        catch( ::cl::Error& )
+        {
+            p.openclSecondsPerCall = unavailable;
+            p.openclBytesPerSecond = 0;
+        }
+
+        return p;
+    }
+
+    cost_model::estimate cost_model::choose( const control& ctl, size_t elements, size_t elementBytes,
+                                             e_DataLocation location, e_Complexity complexity, bool multicore )
+    {
+        const profile p = getProfile( ctl );
+
+        const double bytes = static_cast< double >( elements ) * elementBytes;
+        const double passes = ( complexity == NLogN ) ? std::max( std::log( static_cast< double >( elements ) ) /
+                                                                  std::log( 2.0 ), 1.0 ) : 1.0;
+        const double transfer = ( p.hostUnifiedMemory || p.transferBytesPerSecond <= 0 ) ? 0.0 :
+                                bytes / p.transferBytesPerSecond;
+
+        estimate e;
+        e.serialSeconds = bytes * passes / p.serialBytesPerSecond;
+        e.multicoreSeconds = ( multicore && p.multicoreBytesPerSecond > 0 ) ?
+            p.multicoreSecondsPerCall + bytes * passes / p.multicoreBytesPerSecond : unavailable;
+        e.openclSeconds = ( p.openclBytesPerSecond > 0 ) ?
+            p.openclSecondsPerCall * passes + bytes * passes / p.openclBytesPerSecond : unavailable;
+
+        if( location == DeviceData )
+        {
+            e.serialSeconds += transfer;
+            e.multicoreSeconds += transfer;
+        }
+        else if( location == HostData )
+            e.openclSeconds += transfer;
+
+        e.runMode = control::SerialCpu;
+        double best = e.serialSeconds;
+        if( e.multicoreSeconds < best )
+        {
+            e.runMode = control::MultiCoreCpu;
+            best = e.multicoreSeconds;
+        }
+        if( e.openclSeconds < best )
+            e.runMode = control::OpenCL;
+
+        return e;
+    }
+
+    }; //namespace bolt::cl
+}; // namespace bolt
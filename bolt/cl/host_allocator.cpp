@@ -0,0 +1,195 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#include <cstdlib>
+#include <new>
+
+#if defined( _WIN32 )
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/host_allocator.h"
+
+namespace bolt {
+    namespace cl {
+
+    namespace
+    {
+        //  The memory behind a buffer made by createBuffer; it is given back by the destructor callback of the buffer
+        struct hostBlock
+        {
+            boost::shared_ptr< host_allocator > allocator;
+            void* ptr;
+            size_t bytes;
+        };
+
+        void CL_CALLBACK releaseHostBlock( cl_mem, void* userData )
+        {
+            hostBlock* block = static_cast< hostBlock* >( userData );
+            block->allocator->deallocate( block->ptr, block->bytes );
+            delete block;
+        }
+
+        size_t roundUp( size_t bytes, size_t multiple )
+        {
+            return ( bytes + multiple - 1 ) / multiple * multiple;
+        }
+    }
+
+    ::cl::Buffer host_allocator::createBuffer( const ::cl::Context& context, cl_mem_flags flags, size_t bytes )
+    {
+        hostBlock* block = new hostBlock;
+        block->allocator = shared_from_this( );
+        block->bytes = bytes;
+        try
+        {
+            block->ptr = allocate( bytes );
+        }
+        catch( ... )
+        {
+            delete block;
+            throw;
+        }
+
+        ::cl::Buffer buffer;
+        try
+        {
+            flags &= ~( CL_MEM_ALLOC_HOST_PTR | CL_MEM_COPY_HOST_PTR );
+            buffer = ::cl::Buffer( context, flags | CL_MEM_USE_HOST_PTR, bytes, block->ptr );
+            buffer.setDestructorCallback( releaseHostBlock, block );
+        }
+        catch( ... )
+        {
+            //  The runtime is done with the memory once the buffer, if it was created, is released
+            buffer = ::cl::Buffer( );
+            block->allocator->deallocate( block->ptr, block->bytes );
+            delete block;
+            throw;
+        }
+
+        return buffer;
+    }
+
+    boost::shared_ptr< host_allocator > host_allocator::pageAligned( )
+    {
+        static boost::shared_ptr< host_allocator > _allocator( new page_host_allocator( ) );
+        return _allocator;
+    }
+
+    boost::shared_ptr< host_allocator > host_allocator::hugePages( )
+    {
+        static boost::shared_ptr< host_allocator > _allocator( new huge_page_host_allocator( ) );
+        return _allocator;
+    }
+
+    size_t page_host_allocator::pageSize( )
+    {
+#if defined( _WIN32 )
+        SYSTEM_INFO info;
+        ::GetSystemInfo( &info );
+        return static_cast< size_t >( info.dwPageSize );
+#else
+        return static_cast< size_t >( ::sysconf( _SC_PAGESIZE ) );
+#endif
+    }
+
+    void* page_host_allocator::allocate( size_t bytes )
+    {
+        const size_t page = pageSize( );
+        bytes = roundUp( bytes, page );
+
+#if defined( _WIN32 )
+        void* ptr = ::_aligned_malloc( bytes, page );
+        if( ptr == NULL )
+            throw std::bad_alloc( );
+#else
+        void* ptr = NULL;
+        if( ::posix_memalign( &ptr, page, bytes ) != 0 )
+            throw std::bad_alloc( );
+#endif
+        return ptr;
+    }
+
+    void page_host_allocator::deallocate( void* ptr, size_t )
+    {
+#if defined( _WIN32 )
+        ::_aligned_free( ptr );
+#else
+        std::free( ptr );
+#endif
+    }
+
+    void* huge_page_host_allocator::allocate( size_t bytes )
+    {
+        bytes = roundUp( bytes, hugePageSize );
+
+#if defined( _WIN32 )
+        //  Large pages need the SeLockMemoryPrivilege; without it the request fails and regular pages are used
+        const size_t largePage = ::GetLargePageMinimum( );
+        void* ptr = NULL;
+        if( largePage != 0 )
+            ptr = ::VirtualAlloc( NULL, roundUp( bytes, largePage ), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                  PAGE_READWRITE );
+        if( ptr == NULL )
+            ptr = ::VirtualAlloc( NULL, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+        if( ptr == NULL )
+            throw std::bad_alloc( );
+
+        return ptr;
+#else
+#if defined( MAP_HUGETLB )
+        void* ptr = ::mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+        if( ptr != MAP_FAILED )
+            return ptr;
+#endif
+
+        //  No huge pages are reserved; map a huge page more than needed, and cut the mapping down to the huge
+        //  pages inside it, so that the kernel can back it with transparent huge pages
+        char* mapped = static_cast< char* >( ::mmap( NULL, bytes + hugePageSize, PROT_READ | PROT_WRITE,
+                                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) );
+        if( mapped == MAP_FAILED )
+            throw std::bad_alloc( );
+
+        char* aligned = mapped + ( hugePageSize - reinterpret_cast< size_t >( mapped ) % hugePageSize ) % hugePageSize;
+        if( aligned != mapped )
+            ::munmap( mapped, aligned - mapped );
+        if( aligned + bytes != mapped + bytes + hugePageSize )
+            ::munmap( aligned + bytes, ( mapped + bytes + hugePageSize ) - ( aligned + bytes ) );
+
+#if defined( MADV_HUGEPAGE )
+        ::madvise( aligned, bytes, MADV_HUGEPAGE );
+#endif
+        return aligned;
+#endif
+    }
+
+    void huge_page_host_allocator::deallocate( void* ptr, size_t bytes )
+    {
+#if defined( _WIN32 )
+        ::VirtualFree( ptr, 0, MEM_RELEASE );
+#else
+        ::munmap( ptr, roundUp( bytes, hugePageSize ) );
+#endif
+    }
+
+    }; //namespace bolt::cl
+}; // namespace bolt
@@ -0,0 +1,65 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "bolt/cl/precompile.h"
+
+namespace bolt {
+    namespace cl {
+
+    namespace
+    {
+        void runWarmup( const precompiler::warmup_function& warmup, control ctl )
+        {
+            //  The kernels are only built on the OpenCL path, whatever the default path of the device is
+            ctl.setForceRunMode( control::OpenCL );
+            warmup( ctl );
+        }
+
+        void waitForWarmups( const std::vector< boost::shared_future< void > >& warmups )
+        {
+            //  get( ) rethrows the error of a failed warm-up; the first one found is handed to the caller
+            for( size_t i = 0; i < warmups.size( ); ++i )
+                warmups[ i ].wait( );
+            for( size_t i = 0; i < warmups.size( ); ++i )
+                warmups[ i ].get( );
+        }
+    }
+
+    boost::shared_future< void > precompiler::start( const control& ctl ) const
+    {
+        std::vector< boost::shared_future< void > > warmups;
+        warmups.reserve( m_warmups.size( ) );
+
+        for( size_t i = 0; i < m_warmups.size( ); ++i )
+        {
+            boost::packaged_task< void > task( boost::bind( &runWarmup, m_warmups[ i ], ctl ) );
+            warmups.push_back( boost::shared_future< void >( task.get_future( ) ) );
+            boost::thread( boost::move( task ) ).detach( );
+        }
+
+        boost::packaged_task< void > all( boost::bind( &waitForWarmups, warmups ) );
+        boost::shared_future< void > ready( all.get_future( ) );
+        boost::thread( boost::move( all ) ).detach( );
+
+        return ready;
+    }
+
+    }; //namespace bolt::cl
+}; // namespace bolt
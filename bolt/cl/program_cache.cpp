@@ -0,0 +1,443 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/program_cache.h"
+
+namespace bolt {
+    namespace cl {
+
+    namespace
+    {
+        //  Every entry starts with this header; the digest is repeated inside the file so that a renamed or
+        //  truncated file is never handed to the OpenCL runtime
+        const char cacheMagic[ 8 ] = { 'B', 'O', 'L', 'T', 'P', 'C', '0', '1' };
+        const char* const cacheExtension = ".clbin";
+
+        struct cacheHeader
+        {
+            char     magic[ 8 ];
+            cl_ulong digestHigh;
+            cl_ulong digestLow;
+            cl_ulong binarySize;
+        };
+
+        struct cacheEntry
+        {
+            std::time_t lastUse;
+            size_t size;
+            boost::filesystem::path path;
+
+            bool operator<( const cacheEntry& rhs ) const { return lastUse < rhs.lastUse; }
+        };
+
+        std::string defaultCacheDirectory( )
+        {
+            namespace fs = boost::filesystem;
+
+            const char* userDir = std::getenv( "BOLT_PROGRAM_CACHE_DIR" );
+            if( userDir != NULL && *userDir != '\0' )
+                return userDir;
+
+#if defined( _WIN32 )
+            const char* appData = std::getenv( "LOCALAPPDATA" );
+            if( appData != NULL && *appData != '\0' )
+                return ( fs::path( appData ) / "AMD" / "Bolt" / "ProgramCache" ).string( );
+#else
+            const char* xdgCache = std::getenv( "XDG_CACHE_HOME" );
+            if( xdgCache != NULL && *xdgCache != '\0' )
+                return ( fs::path( xdgCache ) / "bolt" ).string( );
+
+            const char* home = std::getenv( "HOME" );
+            if( home != NULL && *home != '\0' )
+                return ( fs::path( home ) / ".cache" / "bolt" ).string( );
+#endif
+            boost::system::error_code ec;
+            fs::path tmp = fs::temp_directory_path( ec );
+            if( ec )
+                return std::string( );
+
+            return ( tmp / "bolt-program-cache" ).string( );
+        }
+
+        //  Copies the binary that the OpenCL runtime holds for 'device' out of 'program'.  The C API is used
+        //  directly, because a program created from a context with several devices returns one binary per device
+        bool extractBinary( const ::cl::Program& program, const ::cl::Device& device, std::vector< char >& binary )
+        {
+            cl_uint numDevices = 0;
+            if( ::clGetProgramInfo( program( ), CL_PROGRAM_NUM_DEVICES, sizeof( numDevices ), &numDevices, NULL )
+                != CL_SUCCESS || numDevices == 0 )
+                return false;
+
+            std::vector< cl_device_id > devices( numDevices );
+            if( ::clGetProgramInfo( program( ), CL_PROGRAM_DEVICES, numDevices * sizeof( cl_device_id ),
+                &devices[ 0 ], NULL ) != CL_SUCCESS )
+                return false;
+
+            std::vector< size_t > sizes( numDevices );
+            if( ::clGetProgramInfo( program( ), CL_PROGRAM_BINARY_SIZES, numDevices * sizeof( size_t ),
+                &sizes[ 0 ], NULL ) != CL_SUCCESS )
+                return false;
+
+            std::vector< cl_device_id >::iterator found = std::find( devices.begin( ), devices.end( ), device( ) );
+            if( found == devices.end( ) )
+                return false;
+
+            size_t index = found - devices.begin( );
+            if( sizes[ index ] == 0 )
+                return false;
+
+            //  Only the binary of our device is requested; a NULL entry tells the runtime to skip that device
+            std::vector< unsigned char* > pointers( numDevices, static_cast< unsigned char* >( NULL ) );
+            binary.resize( sizes[ index ] );
+            pointers[ index ] = reinterpret_cast< unsigned char* >( &binary[ 0 ] );
+
+            return ::clGetProgramInfo( program( ), CL_PROGRAM_BINARIES, numDevices * sizeof( unsigned char* ),
+                &pointers[ 0 ], NULL ) == CL_SUCCESS;
+        }
+    }
+
+    ProgramCache& ProgramCache::getInstance( )
+    {
+        static ProgramCache _programCache;
+        return _programCache;
+    }
+
+    ProgramCache::ProgramCache( ) :
+        m_enabled( true ),
+        m_directory( defaultCacheDirectory( ) ),
+        m_maxSize( 256 << 20 )
+    {
+        const char* enabled = std::getenv( "BOLT_PROGRAM_CACHE" );
+        if( enabled != NULL && ( std::string( enabled ) == "0" || std::string( enabled ) == "off" ) )
+            m_enabled = false;
+
+        const char* sizeMB = std::getenv( "BOLT_PROGRAM_CACHE_SIZE_MB" );
+        if( sizeMB != NULL && *sizeMB != '\0' )
+            m_maxSize = static_cast< size_t >( std::strtoul( sizeMB, NULL, 10 ) ) << 20;
+
+        if( m_directory.empty( ) )
+            m_enabled = false;
+
+        resetStatistics( );
+    }
+
+    void ProgramCache::setEnabled( bool enabled )
+    {
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        m_enabled = enabled;
+    }
+
+    bool ProgramCache::getEnabled( ) const
+    {
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        return m_enabled;
+    }
+
+    void ProgramCache::setDirectory( const ::std::string& directory )
+    {
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        m_directory = directory;
+    }
+
+    ::std::string ProgramCache::getDirectory( ) const
+    {
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        return m_directory;
+    }
+
+    void ProgramCache::setMaxSize( size_t maxSize )
+    {
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        m_maxSize = maxSize;
+    }
+
+    size_t ProgramCache::getMaxSize( ) const
+    {
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        return m_maxSize;
+    }
+
+    ProgramCache::statistics ProgramCache::getStatistics( ) const
+    {
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        return m_stats;
+    }
+
+    void ProgramCache::resetStatistics( )
+    {
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        statistics zero = { 0, 0, 0, 0, 0 };
+        m_stats = zero;
+    }
+
+    ProgramDigest ProgramCache::makeKey( const ::cl::Device& device, const ProgramDigest& programDigest )
+    {
+        //  The driver version is part of the key, so that a driver update never loads a stale binary
+        ProgramDigester digester;
+        digester.add( device.getInfo< CL_DEVICE_NAME >( ) );
+        digester.add( device.getInfo< CL_DEVICE_VENDOR >( ) );
+        digester.add( device.getInfo< CL_DEVICE_VERSION >( ) );
+        digester.add( device.getInfo< CL_DRIVER_VERSION >( ) );
+
+        cl_uint version[ 3 ] = { BoltVersionMajor, BoltVersionMinor, BoltVersionPatch };
+        digester.add( version, sizeof( version ) );
+
+        digester.add( &programDigest.high, sizeof( programDigest.high ) );
+        digester.add( &programDigest.low, sizeof( programDigest.low ) );
+        return digester.digest( );
+    }
+
+    ::std::string ProgramCache::entryPath( const ::std::string& directory, const ProgramDigest& key ) const
+    {
+        return ( boost::filesystem::path( directory ) / ( key.toString( ) + cacheExtension ) ).string( );
+    }
+
+    bool ProgramCache::load( const ::cl::Context& context,
+                             const ::cl::Device& device,
+                             const ::std::string& compileOptions,
+                             const ProgramDigest& key,
+                             ::cl::Program& program )
+    {
+        namespace fs = boost::filesystem;
+
+        std::string directory;
+        {
+            boost::lock_guard< boost::mutex > lock( m_guard );
+            if( !m_enabled )
+                return false;
+            directory = m_directory;
+        }
+
+        const fs::path path( entryPath( directory, key ) );
+        std::ifstream infile( path.string( ).c_str( ), std::ios::in | std::ios::binary );
+        if( infile.fail( ) )
+        {
+            boost::lock_guard< boost::mutex > lock( m_guard );
+            ++m_stats.misses;
+            return false;
+        }
+
+        cacheHeader header;
+        std::vector< char > binary;
+        bool valid = infile.read( reinterpret_cast< char* >( &header ), sizeof( header ) ).good( ) &&
+                     std::equal( cacheMagic, cacheMagic + sizeof( cacheMagic ), header.magic ) &&
+                     header.digestHigh == key.high && header.digestLow == key.low &&
+                     header.binarySize > 0;
+        if( valid )
+        {
+            binary.resize( static_cast< size_t >( header.binarySize ) );
+            valid = infile.read( &binary[ 0 ], binary.size( ) ).good( );
+        }
+        infile.close( );
+
+        if( valid )
+        {
+            try
+            {
+                std::vector< ::cl::Device > devices( 1, device );
+                ::cl::Program::Binaries binaries( 1, std::make_pair( static_cast< const void* >( &binary[ 0 ] ),
+                                                                     binary.size( ) ) );
+                std::vector< cl_int > binaryStatus;
+                cl_int l_err = CL_SUCCESS;
+
+                ::cl::Program cached( context, devices, binaries, &binaryStatus, &l_err );
+                V_OPENCL( l_err, "Program::constructor() from binary failed" );
+                V_OPENCL( cached.build( devices, compileOptions.c_str( ) ), "Program::build() from binary failed" );
+                program = cached;
+            }
+            catch( const ::cl::Error& )
+            {
+                //  Binaries can be refused for reasons the key does not capture, i.e. a runtime that changed its
+                //  binary format without changing its version strings; the entry is dropped below
+                valid = false;
+            }
+        }
+
+        boost::system::error_code ec;
+        if( !valid )
+        {
+            fs::remove( path, ec );
+            boost::lock_guard< boost::mutex > lock( m_guard );
+            ++m_stats.rejected;
+            ++m_stats.misses;
+            return false;
+        }
+
+        //  The modification time doubles as the last use time for the LRU eviction
+        fs::last_write_time( path, std::time( NULL ), ec );
+
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        ++m_stats.hits;
+        return true;
+    }
+
+    void ProgramCache::store( const ::cl::Device& device, const ProgramDigest& key, const ::cl::Program& program )
+    {
+        namespace fs = boost::filesystem;
+
+        std::string directory;
+        size_t maxSize;
+        {
+            boost::lock_guard< boost::mutex > lock( m_guard );
+            if( !m_enabled )
+                return;
+            directory = m_directory;
+            maxSize = m_maxSize;
+        }
+
+        std::vector< char > binary;
+        if( !extractBinary( program, device, binary ) )
+            return;
+
+        boost::system::error_code ec;
+        fs::create_directories( fs::path( directory ), ec );
+        if( ec )
+            return;
+
+        //  Write to a unique temporary name and rename it into place, so that concurrent processes sharing
+        //  the directory never observe a partially written entry
+        const fs::path path( entryPath( directory, key ) );
+        const fs::path tmpPath = fs::path( directory ) / fs::unique_path( "%%%%-%%%%-%%%%-%%%%.tmp", ec );
+        if( ec )
+            return;
+
+        cacheHeader header;
+        std::copy( cacheMagic, cacheMagic + sizeof( cacheMagic ), header.magic );
+        header.digestHigh = key.high;
+        header.digestLow = key.low;
+        header.binarySize = binary.size( );
+
+        {
+            std::ofstream outfile( tmpPath.string( ).c_str( ), std::ios::out | std::ios::binary | std::ios::trunc );
+            outfile.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+            outfile.write( &binary[ 0 ], binary.size( ) );
+            if( outfile.fail( ) )
+            {
+                outfile.close( );
+                fs::remove( tmpPath, ec );
+                return;
+            }
+        }
+
+        fs::rename( tmpPath, path, ec );
+        if( ec )
+        {
+            fs::remove( tmpPath, ec );
+            return;
+        }
+
+        {
+            boost::lock_guard< boost::mutex > lock( m_guard );
+            ++m_stats.stores;
+        }
+
+        trim( directory, maxSize );
+    }
+
+    void ProgramCache::trim( const ::std::string& directory, size_t maxSize )
+    {
+        namespace fs = boost::filesystem;
+        boost::lock_guard< boost::mutex > trimLock( m_trimGuard );
+
+        std::vector< cacheEntry > entries;
+        size_t total = 0;
+
+        boost::system::error_code ec;
+        for( fs::directory_iterator it( directory, ec ), end; !ec && it != end; it.increment( ec ) )
+        {
+            if( it->path( ).extension( ) != cacheExtension )
+                continue;
+
+            boost::system::error_code entryEc;
+            cacheEntry entry;
+            entry.path = it->path( );
+            entry.size = static_cast< size_t >( fs::file_size( entry.path, entryEc ) );
+            entry.lastUse = fs::last_write_time( entry.path, entryEc );
+            if( entryEc )
+                continue;
+
+            total += entry.size;
+            entries.push_back( entry );
+        }
+
+        if( total <= maxSize )
+            return;
+
+        //  Oldest entries first
+        std::sort( entries.begin( ), entries.end( ) );
+
+        size_t evicted = 0;
+        for( std::vector< cacheEntry >::iterator it = entries.begin( ); it != entries.end( ) && total > maxSize; ++it )
+        {
+            //  Another process may have removed the entry already; its bytes are gone either way
+            fs::remove( it->path, ec );
+            total -= it->size;
+            ++evicted;
+        }
+
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        m_stats.evictions += evicted;
+    }
+
+    size_t ProgramCache::totalSize( ) const
+    {
+        namespace fs = boost::filesystem;
+
+        size_t total = 0;
+        boost::system::error_code ec;
+        for( fs::directory_iterator it( getDirectory( ), ec ), end; !ec && it != end; it.increment( ec ) )
+        {
+            if( it->path( ).extension( ) != cacheExtension )
+                continue;
+
+            boost::system::error_code entryEc;
+            size_t size = static_cast< size_t >( fs::file_size( it->path( ), entryEc ) );
+            if( !entryEc )
+                total += size;
+        }
+
+        return total;
+    }
+
+    void ProgramCache::clear( )
+    {
+        namespace fs = boost::filesystem;
+        boost::lock_guard< boost::mutex > trimLock( m_trimGuard );
+
+        std::vector< fs::path > entries;
+        boost::system::error_code ec;
+        for( fs::directory_iterator it( getDirectory( ), ec ), end; !ec && it != end; it.increment( ec ) )
+        {
+            if( it->path( ).extension( ) == cacheExtension )
+                entries.push_back( it->path( ) );
+        }
+
+        for( std::vector< fs::path >::iterator it = entries.begin( ); it != entries.end( ); ++it )
+            fs::remove( *it, ec );
+    }
+
+    }; //namespace bolt::cl
+}; // namespace bolt
@@ -0,0 +1,185 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <boost/thread/locks.hpp>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/tuner.h"
+
+namespace bolt {
+    namespace cl {
+
+    namespace
+    {
+        //  The shapes the tuner tries; work-group sizes larger than the device allows are left out
+        const size_t gpuWgSizes[ ] = { 64, 128, 256 };
+        const size_t cpuWgSizes[ ] = { 1, 8, 64, 256 };
+        const int wgPerComputeUnits[ ] = { 1, 4, 16, 64 };
+        const int unrolls[ ] = { 1, 2, 4 };
+    }
+
+    work_shape_tuner& work_shape_tuner::getInstance( )
+    {
+        static work_shape_tuner _tuner;
+        return _tuner;
+    }
+
+    work_shape_tuner::work_shape_tuner( )
+    {
+        const char* path = std::getenv( "BOLT_TUNING_DB" );
+        if( path != NULL && *path != '\0' )
+        {
+            m_databasePath = path;
+            loadDatabase( m_databasePath );
+        }
+    }
+
+    //  The size bucket is the largest power of four that is not larger than elements
+    std::string work_shape_tuner::makeKey( const control& ctl, const std::string& algorithm,
+                                           const std::string& types, size_t elements )
+    {
+        int log2Bucket = 0;
+        while( elements >> ( log2Bucket + 2 ) )
+            log2Bucket += 2;
+
+        const ::cl::Device device = ctl.getDevice( );
+        std::ostringstream key;
+        key << algorithm << " < " << types << " > n 2^" << log2Bucket << " / " << device.getInfo< CL_DEVICE_NAME >( )
+            << " / " << device.getInfo< CL_DRIVER_VERSION >( );
+        return key.str( );
+    }
+
+    std::vector< work_shape_tuner::work_shape > work_shape_tuner::candidates( const control& ctl )
+    {
+        const ::cl::Device device = ctl.getDevice( );
+        const size_t maxWgSize = device.getInfo< CL_DEVICE_MAX_WORK_GROUP_SIZE >( );
+        const bool cpuDevice = ( device.getInfo< CL_DEVICE_TYPE >( ) & CL_DEVICE_TYPE_CPU ) != 0;
+
+        const size_t* wgSizes = cpuDevice ? cpuWgSizes : gpuWgSizes;
+        const size_t numWgSizes = cpuDevice ? sizeof( cpuWgSizes ) / sizeof( cpuWgSizes[ 0 ] ) :
+                                              sizeof( gpuWgSizes ) / sizeof( gpuWgSizes[ 0 ] );
+
+        std::vector< work_shape > shapes;
+        for( size_t w = 0; w < numWgSizes; ++w )
+        {
+            if( wgSizes[ w ] > maxWgSize )
+                continue;
+
+            for( size_t c = 0; c < sizeof( wgPerComputeUnits ) / sizeof( wgPerComputeUnits[ 0 ] ); ++c )
+            {
+                for( size_t u = 0; u < sizeof( unrolls ) / sizeof( unrolls[ 0 ] ); ++u )
+                {
+                    const work_shape shape = { wgSizes[ w ], wgPerComputeUnits[ c ], unrolls[ u ] };
+                    shapes.push_back( shape );
+                }
+            }
+        }
+
+        return shapes;
+    }
+
+    std::vector< work_shape_tuner::work_shape > work_shape_tuner::wgSizeCandidates( const control& ctl,
+                                                                                    const work_shape& base )
+    {
+        const std::vector< work_shape > all = candidates( ctl );
+
+        std::vector< work_shape > shapes;
+        for( size_t s = 0; s < all.size( ); ++s )
+        {
+            if( !shapes.empty( ) && shapes.back( ).wgSize == all[ s ].wgSize )
+                continue;
+
+            work_shape shape = base;
+            shape.wgSize = all[ s ].wgSize;
+            shapes.push_back( shape );
+        }
+
+        return shapes;
+    }
+
+    bool work_shape_tuner::findShape( const std::string& key, work_shape& shape )
+    {
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        std::map< std::string, work_shape >::const_iterator known = m_shapes.find( key );
+        if( known == m_shapes.end( ) )
+            return false;
+
+        shape = known->second;
+        return true;
+    }
+
+    void work_shape_tuner::setShape( const std::string& key, const work_shape& shape )
+    {
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        m_shapes[ key ] = shape;
+        if( !m_databasePath.empty( ) )
+        {
+            std::ofstream file( m_databasePath.c_str( ), std::ios::app );
+            file << key << '\t' << shape.wgSize << ' ' << shape.wgPerComputeUnit << ' ' << shape.unroll << '\n';
+        }
+    }
+
+    //  A shape is a line of the key, a tab, and the fields of the shape separated by spaces
+    bool work_shape_tuner::loadDatabase( const std::string& path )
+    {
+        std::ifstream file( path.c_str( ) );
+        if( !file )
+            return false;
+
+        std::string line;
+        while( std::getline( file, line ) )
+        {
+            const std::string::size_type tab = line.rfind( '\t' );
+            if( tab == std::string::npos )
+                continue;
+
+            work_shape shape;
+            std::istringstream fields( line.substr( tab + 1 ) );
+            if( fields >> shape.wgSize >> shape.wgPerComputeUnit >> shape.unroll &&
+                shape.wgSize > 0 && ( shape.wgSize & ( shape.wgSize - 1 ) ) == 0 &&
+                shape.wgPerComputeUnit > 0 && shape.unroll > 0 )
+            {
+                boost::lock_guard< boost::mutex > lock( m_guard );
+                m_shapes[ line.substr( 0, tab ) ] = shape;
+            }
+        }
+
+        return true;
+    }
+
+    bool work_shape_tuner::saveDatabase( const std::string& path )
+    {
+        std::ofstream file( path.c_str( ) );
+        if( !file )
+            return false;
+
+        boost::lock_guard< boost::mutex > lock( m_guard );
+        for( std::map< std::string, work_shape >::const_iterator s = m_shapes.begin( ); s != m_shapes.end( ); ++s )
+        {
+            file << s->first << '\t' << s->second.wgSize << ' ' << s->second.wgPerComputeUnit << ' '
+                 << s->second.unroll << '\n';
+        }
+
+        return static_cast< bool >( file );
+    }
+
+    }; //namespace bolt::cl
+}; // namespace bolt
@@ -55,7 +55,8 @@ namespace BOLTLOG{
         BOLT_STABLESORTBYKEY,
         BOLT_TRANSFORMREDUCE,
         BOLT_TRANSFORMSCAN,
-        BOLT_TRANSFORM
+        BOLT_TRANSFORM,
+        BOLT_AUTOMATIC      // the backend the cost model picked for a call in Automatic mode
     };
 
     class FunPaths
@@ -0,0 +1,149 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_BTBB_ARENA_H )
+#define BOLT_BTBB_ARENA_H
+#pragma once
+
+#include "tbb/task_arena.h"
+#include "tbb/version.h"
+#if TBB_INTERFACE_VERSION >= 12010
+#include "tbb/info.h"
+#include <vector>
+#endif
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+/*! \file bolt/btbb/arena.h
+    \brief The TBB task arena that every MultiCoreCpu algorithm of Bolt runs in.
+*/
+
+namespace bolt {
+    namespace btbb {
+
+        /*! \addtogroup miscellaneous
+        */
+
+        /*! \addtogroup TBB-arena
+        *   \ingroup miscellaneous
+        *   \{
+        */
+
+        /*! \brief The process wide tbb::task_arena of the btbb backend
+        *   \details All btbb algorithms execute their parallel loops inside this arena, instead of creating a TBB
+        *   scheduler per call.  Its concurrency bounds the number of threads Bolt occupies, which lets Bolt share
+        *   the cores of a process predictably with other TBB users.  With TBB 2021 or later, the arena can also be
+        *   constrained to the cores of one NUMA node; older TBB versions ignore the NUMA node.
+        *
+        *   The arena is normally configured through bolt::cl::control::setCpuConcurrency.
+        */
+        class arena
+        {
+        public:
+            static const int automatic = -1;    // let TBB decide
+            static const int anyNumaNode = -1;  // do not constrain the placement of the threads
+
+            //! Returns the arena that the btbb algorithms use
+            static arena& getInstance( )
+            {
+                static arena _arena;
+                return _arena;
+            }
+
+            /*! \brief Sets the concurrency and placement of the arena
+            *   \details The arena is re-created lazily by the next algorithm; calls that are running in the old arena
+            *   finish there.
+            *   \param concurrency Maximum number of threads, including the calling thread, or \p automatic
+            *   \param numaNode Index of the NUMA node, in the order reported by tbb::info::numa_nodes( ), or
+            *   \p anyNumaNode
+            */
+            void initialize( int concurrency = automatic, int numaNode = anyNumaNode )
+            {
+                boost::lock_guard< boost::mutex > lock( m_guard );
+                if( concurrency == m_concurrency && numaNode == m_numaNode )
+                    return;
+
+                m_concurrency = concurrency;
+                m_numaNode = numaNode;
+                m_arena.reset( );
+            }
+
+            int getConcurrency( ) const
+            {
+                boost::lock_guard< boost::mutex > lock( m_guard );
+                return m_concurrency;
+            }
+
+            int getNumaNode( ) const
+            {
+                boost::lock_guard< boost::mutex > lock( m_guard );
+                return m_numaNode;
+            }
+
+            //! Runs \p f inside the arena, on the calling thread and the worker threads of the arena
+            template< typename Function >
+            void execute( const Function& f )
+            {
+                //  The arena is held by a shared_ptr, so that a concurrent initialize( ) does not destroy it while
+                //  f is running; the mutex only protects the pointer itself
+                boost::shared_ptr< tbb::task_arena > current;
+                {
+                    boost::lock_guard< boost::mutex > lock( m_guard );
+                    if( !m_arena )
+                        m_arena.reset( createArena( m_concurrency, m_numaNode ) );
+                    current = m_arena;
+                }
+                current->execute( f );
+            }
+
+        private:
+            arena( ): m_concurrency( automatic ), m_numaNode( anyNumaNode )
+            {}
+            arena( const arena& );
+            arena& operator=( const arena& );
+
+            static tbb::task_arena* createArena( int concurrency, int numaNode )
+            {
+#if TBB_INTERFACE_VERSION >= 12010
+                if( numaNode != anyNumaNode )
+                {
+                    std::vector< tbb::numa_node_id > nodes = tbb::info::numa_nodes( );
+                    if( numaNode >= 0 && static_cast< size_t >( numaNode ) < nodes.size( ) )
+                    {
+                        return new tbb::task_arena( tbb::task_arena::constraints( nodes[ numaNode ], concurrency ) );
+                    }
+                }
+#else
+                (void)numaNode;
+#endif
+                return new tbb::task_arena( concurrency );
+            }
+
+            mutable boost::mutex m_guard;
+            int m_concurrency;
+            int m_numaNode;
+            boost::shared_ptr< tbb::task_arena > m_arena;
+        };
+
+        /*!   \}  */
+
+    }
+}
+
+#endif
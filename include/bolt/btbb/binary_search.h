@@ -20,7 +20,8 @@
 #define BOLT_BTBB_BINARY_SEARCH_H
 
 /*! \file bolt/tbb/binary_search.h
-    \brief Searches the input vector for the specified value and returns true if present and false otherwise
+    \brief Searches the input vector for the specified value and returns true if present and false otherwise,
+    or searches it for a whole range of values in parallel.
 */
 
 
@@ -33,6 +34,56 @@ namespace bolt {
        template<typename ForwardIterator, typename T, typename StrictWeakOrdering>
        bool binary_search( ForwardIterator first, ForwardIterator last, const T & value, StrictWeakOrdering comp);
        
+       /*! \brief Batched \p lower_bound: writes to \p result the index, in the sorted range [first, last), of the
+       *   lower bound of every value in [values_first, values_last).
+       *
+       * \details The values are searched in parallel, each with a branchless binary search.  Queries given in
+       * sorted order are answered faster, as every task then searches only the part of the range its values fall in.
+       *
+       * \param first The beginning of the sorted range; it must be a random access range.
+       * \param last The end of the sorted range.
+       * \param values_first The beginning of the values to search for.
+       * \param values_last The end of the values to search for.
+       * \param result The beginning of the indices, one per value.
+       * \param comp The order [first, last) is sorted with; \p std::less by default.
+       * \return The end of the indices.
+       *
+       * \code
+       * #include <bolt/btbb/binary_search.h>
+       *
+       * int table[5] = {0, 2, 4, 6, 8};
+       * int values[4] = {8, 0, 3, 9};
+       * int indices[4];
+       * bolt::btbb::lower_bound(table, table+5, values, values+4, indices);
+       * // indices = 4, 0, 2, 5
+       *  \endcode
+       */
+       template<typename ForwardIterator, typename InputIterator, typename OutputIterator>
+       OutputIterator lower_bound( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                   InputIterator values_last, OutputIterator result );
+
+       template<typename ForwardIterator, typename InputIterator, typename OutputIterator, typename StrictWeakOrdering>
+       OutputIterator lower_bound( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                   InputIterator values_last, OutputIterator result, StrictWeakOrdering comp );
+
+       //! Batched \p upper_bound; see the batched \p lower_bound.
+       template<typename ForwardIterator, typename InputIterator, typename OutputIterator>
+       OutputIterator upper_bound( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                   InputIterator values_last, OutputIterator result );
+
+       template<typename ForwardIterator, typename InputIterator, typename OutputIterator, typename StrictWeakOrdering>
+       OutputIterator upper_bound( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                   InputIterator values_last, OutputIterator result, StrictWeakOrdering comp );
+
+       //! Batched \p binary_search: writes to \p result whether every value is in [first, last).
+       template<typename ForwardIterator, typename InputIterator, typename OutputIterator>
+       OutputIterator binary_search( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                     InputIterator values_last, OutputIterator result );
+
+       template<typename ForwardIterator, typename InputIterator, typename OutputIterator, typename StrictWeakOrdering>
+       OutputIterator binary_search( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                     InputIterator values_last, OutputIterator result, StrictWeakOrdering comp );
+
     };
 };
 
@@ -19,132 +19,231 @@
 #define BOLT_BTBB_BINARY_SEARCH_INL
 #pragma once
 
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/arena.h"
+#include "bolt/btbb/simd_reduce.h"
 #include "tbb/parallel_for.h"
 #include "tbb/blocked_range.h"
+#include <algorithm>
+#include <functional>
 #include <iterator>
+#include <type_traits>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __x86_64__ ) || defined( __i386__ )
+#include <xmmintrin.h>
+#define BOLT_BTBB_PREFETCH( address ) _mm_prefetch( reinterpret_cast< const char* >( address ), _MM_HINT_T0 )
+#elif defined( __GNUC__ )
+#define BOLT_BTBB_PREFETCH( address ) __builtin_prefetch( address )
+#else
+#define BOLT_BTBB_PREFETCH( address )
+#endif
 
 namespace bolt{
     namespace btbb {
 
-             template<typename ForwardIterator, typename T>
-             struct BS {
+        namespace detail
+        {
+            //  Queries per TBB task
+            static const size_t searchGrainSize = 1 << 12;
 
-                bool result;
+            //  An element comes before the lower bound of value when it is less than value
+            template< typename StrictWeakOrdering >
+            struct lower_bound_order
+            {
+                StrictWeakOrdering comp;
+                template< typename T1, typename T2 >
+                bool operator( )( const T1& element, const T2& value ) const { return comp( element, value ); }
+            };
 
-                BS () {result=false;}
+            //  An element comes before the upper bound of value when value is not less than it
+            template< typename StrictWeakOrdering >
+            struct upper_bound_order
+            {
+                StrictWeakOrdering comp;
+                template< typename T1, typename T2 >
+                bool operator( )( const T1& element, const T2& value ) const { return !comp( value, element ); }
+            };
 
-				void operator()( ForwardIterator first, int n, const T & val)
-                {
+            template< typename RandomAccessIterator >
+            void prefetch_probes( RandomAccessIterator, size_t, size_t, size_t, std::false_type )
+            {
+            }
 
-                    tbb::parallel_for(  tbb::blocked_range<int>(0, (int) n) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
-                        {
+            //  Of the n elements from base, the next step reads either the middle of the first half or the middle
+            //  of the second half
+            template< typename RandomAccessIterator >
+            void prefetch_probes( RandomAccessIterator first, size_t base, size_t half, size_t n, std::true_type )
+            {
+                const typename std::iterator_traits< RandomAccessIterator >::value_type* p = &first[ base ];
+                BOLT_BTBB_PREFETCH( p + ( n - half ) / 2 );
+                BOLT_BTBB_PREFETCH( p + half + ( n - half ) / 2 );
+            }
 
-                              int low=r.begin();
-                              int high=r.end();
-                              int mid;
-                              T midVal, firstVal;
-
-                              while(low<high)
-                              {
-                                     mid = (low + high) / 2;
-
-                                     midVal = first[mid];
-                                     firstVal = first[low];
-
-                                     if( midVal == val)
-                                     {
-                                            result = true;
-                                            break;
-                                     }
-                                     else if (midVal < val)
-                                            low = mid + 1;
-                                     else
-                                            high = mid;
-                              }
-
-                              //result = std::binary_search(first+r.begin(), first+r.end(), val);
-                          });
-                 }
+            /*! \brief Returns the index of the first of the \p n elements at \p first that does not come \p before
+            *   \p value.  The range halves whatever the comparisons give, so that the loop compiles to conditional
+            *   moves; for arithmetic elements in memory, both elements the next step may read are prefetched.
+            */
+            template< typename RandomAccessIterator, typename T, typename Before >
+            size_t branchless_search( RandomAccessIterator first, size_t n, const T& value, Before before )
+            {
+                typedef typename std::iterator_traits< RandomAccessIterator >::value_type element_type;
+                typedef std::integral_constant< bool, std::is_arithmetic< element_type >::value &&
+                    is_contiguous_iterator< RandomAccessIterator, element_type >::value > prefetch;
 
-            };
+                if( n == 0 )
+                    return 0;
 
-             template<typename ForwardIterator, typename T, typename StrictWeakOrdering>
-             struct BS_comp {
+                size_t base = 0;
+                while( n > 1 )
+                {
+                    const size_t half = n / 2;
+                    prefetch_probes( first, base, half, n, prefetch( ) );
+                    base = before( first[ base + half ], value ) ? base + half : base;
+                    n -= half;
+                }
+                return base + ( before( first[ base ], value ) ? 1 : 0 );
+            }
 
-                bool result;
+            /*! \brief Writes to \p result the index that \p branchless_search finds for every value, in parallel
+            *   over the values.  A task whose values are sorted first finds the bounds of its first and last
+            *   value, and searches only the elements between them, which stay in the cache.
+            */
+            template< typename ForwardIterator, typename InputIterator, typename OutputIterator, typename Before,
+                      typename StrictWeakOrdering >
+            OutputIterator search_batch( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                         InputIterator values_last, OutputIterator result, Before before,
+                                         StrictWeakOrdering comp )
+            {
+                typedef typename std::iterator_traits< ForwardIterator >::difference_type difference_type;
 
-                BS_comp () {result=false;}
+                const size_t n = static_cast< size_t >( std::distance( first, last ) );
+                const size_t numValues = static_cast< size_t >( std::distance( values_first, values_last ) );
 
-				void operator()( ForwardIterator first, int n, const T & val, StrictWeakOrdering comp)
+                bolt::btbb::arena::getInstance( ).execute( [&]( )
                 {
-
-                    tbb::parallel_for(  tbb::blocked_range<int>(0, (int) n) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
+                    tbb::parallel_for( tbb::blocked_range< size_t >( 0, numValues, searchGrainSize ),
+                        [&]( const tbb::blocked_range< size_t >& r )
+                    {
+                        size_t low = 0, high = n;
+                        if( r.size( ) > 2 &&
+                            std::is_sorted( values_first + r.begin( ), values_first + r.end( ), comp ) )
                         {
+                            low = branchless_search( first, n, values_first[ r.begin( ) ], before );
+                            high = branchless_search( first, n, values_first[ r.end( ) - 1 ], before );
+                        }
 
-                              int low=r.begin();
-                              int high=r.end();
-                              int mid;
-                              T midVal, firstVal;
-
-                              while(low<high)
-                              {
-                                     mid = (low + high) / 2;
-
-                                     midVal = first[mid];
-                                     firstVal = first[low];
-
-                                     if( (!comp(midVal, val)) && (!comp(val, midVal)) )
-                                     {
-                                            this->result = true;
-                                            break;
-                                     }
-                                     else if ( comp(midVal, val) )
-                                            low = mid + 1;
-                                     else
-                                            high = mid;
-                              }
-
-                              //result = std::binary_search(first+r.begin(), first+r.end(), val, comp);
-                          });
-                 }
+                        for( size_t i = r.begin( ); i != r.end( ); ++i )
+                        {
+                            result[ i ] = static_cast< difference_type >(
+                                low + branchless_search( first + low, high - low, values_first[ i ], before ) );
+                        }
+                    } );
+                } );
 
-            };
+                return result + numValues;
+            }
 
-            template<typename ForwardIterator, typename T, typename StrictWeakOrdering>
-            bool binary_search( ForwardIterator first, ForwardIterator last, const T & value, StrictWeakOrdering comp)
+            template< typename ForwardIterator, typename InputIterator, typename OutputIterator,
+                      typename StrictWeakOrdering >
+            OutputIterator binary_search_batch( ForwardIterator first, ForwardIterator last,
+                                                InputIterator values_first, InputIterator values_last,
+                                                OutputIterator result, StrictWeakOrdering comp )
             {
+                const size_t n = static_cast< size_t >( std::distance( first, last ) );
+                const size_t numValues = static_cast< size_t >( std::distance( values_first, values_last ) );
+                lower_bound_order< StrictWeakOrdering > before = { comp };
 
-               //This allows TBB to choose the number of threads to spawn.
-               tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+                bolt::btbb::arena::getInstance( ).execute( [&]( )
+                {
+                    tbb::parallel_for( tbb::blocked_range< size_t >( 0, numValues, searchGrainSize ),
+                        [&]( const tbb::blocked_range< size_t >& r )
+                    {
+                        for( size_t i = r.begin( ); i != r.end( ); ++i )
+                        {
+                            size_t index = branchless_search( first, n, values_first[ i ], before );
+                            result[ i ] = index < n && !comp( values_first[ i ], first[ index ] );
+                        }
+                    } );
+                } );
 
-               int n = (int)std::distance(first, last);
+                return result + numValues;
+            }
+        }
 
-               BS_comp <ForwardIterator, T, StrictWeakOrdering> bs_op;
-               bs_op(first, n, value, comp);
+            //  A single search is too short to split over tasks; it runs on the calling thread
+            template<typename ForwardIterator, typename T, typename StrictWeakOrdering>
+            bool binary_search( ForwardIterator first, ForwardIterator last, const T & value, StrictWeakOrdering comp)
+            {
+               size_t n = static_cast< size_t >( std::distance(first, last) );
+               detail::lower_bound_order< StrictWeakOrdering > before = { comp };
 
-               return bs_op.result;
+               size_t index = detail::branchless_search( first, n, value, before );
+               return index < n && !comp( value, first[ index ] );
             }
 
             template<typename ForwardIterator, typename T>
             bool binary_search( ForwardIterator first, ForwardIterator last, const T & value)
             {
+               typedef typename std::iterator_traits< ForwardIterator >::value_type element_type;
+               return bolt::btbb::binary_search( first, last, value, std::less< element_type >( ) );
+            }
 
-               //This allows TBB to choose the number of threads to spawn.
-               tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
+            template<typename ForwardIterator, typename InputIterator, typename OutputIterator,
+                     typename StrictWeakOrdering>
+            OutputIterator lower_bound( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                        InputIterator values_last, OutputIterator result, StrictWeakOrdering comp )
+            {
+               detail::lower_bound_order< StrictWeakOrdering > before = { comp };
+               return detail::search_batch( first, last, values_first, values_last, result, before, comp );
+            }
 
-               int n = (int)std::distance(first, last);
+            template<typename ForwardIterator, typename InputIterator, typename OutputIterator>
+            OutputIterator lower_bound( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                        InputIterator values_last, OutputIterator result )
+            {
+               typedef typename std::iterator_traits< ForwardIterator >::value_type element_type;
+               return bolt::btbb::lower_bound( first, last, values_first, values_last, result,
+                                               std::less< element_type >( ) );
+            }
 
-               BS <ForwardIterator, T> bs_op;
-               bs_op(first, n, value);
+            template<typename ForwardIterator, typename InputIterator, typename OutputIterator,
+                     typename StrictWeakOrdering>
+            OutputIterator upper_bound( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                        InputIterator values_last, OutputIterator result, StrictWeakOrdering comp )
+            {
+               detail::upper_bound_order< StrictWeakOrdering > before = { comp };
+               return detail::search_batch( first, last, values_first, values_last, result, before, comp );
+            }
+
+            template<typename ForwardIterator, typename InputIterator, typename OutputIterator>
+            OutputIterator upper_bound( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                        InputIterator values_last, OutputIterator result )
+            {
+               typedef typename std::iterator_traits< ForwardIterator >::value_type element_type;
+               return bolt::btbb::upper_bound( first, last, values_first, values_last, result,
+                                               std::less< element_type >( ) );
+            }
 
-               return bs_op.result;
+            template<typename ForwardIterator, typename InputIterator, typename OutputIterator,
+                     typename StrictWeakOrdering>
+            OutputIterator binary_search( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                          InputIterator values_last, OutputIterator result, StrictWeakOrdering comp )
+            {
+               return detail::binary_search_batch( first, last, values_first, values_last, result, comp );
+            }
+
+            template<typename ForwardIterator, typename InputIterator, typename OutputIterator>
+            OutputIterator binary_search( ForwardIterator first, ForwardIterator last, InputIterator values_first,
+                                          InputIterator values_last, OutputIterator result )
+            {
+               typedef typename std::iterator_traits< ForwardIterator >::value_type element_type;
+               return bolt::btbb::binary_search( first, last, values_first, values_last, result,
+                                                 std::less< element_type >( ) );
             }
 
 
     } //tbb
 } // bolt
 
+#undef BOLT_BTBB_PREFETCH
+
 #endif //BTBB_BINARY_SEARCH__INL
\ No newline at end of file
@@ -19,7 +19,7 @@
 #define BOLT_BTBB_COPY_INL
 #pragma once
 
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/arena.h"
 #include "tbb/parallel_for.h"
 #include "tbb/blocked_range.h"
 #include <iterator>
@@ -34,11 +34,11 @@ namespace bolt{
 
 				void operator()( InputIterator first, Size n, OutputIterator result)
                 {
-                    tbb::parallel_for(  tbb::blocked_range<int>(0, (int) n) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
+                    tbb::parallel_for(  tbb::blocked_range<size_t>(0, static_cast< size_t >( n )) ,
+                        [&] (const tbb::blocked_range<size_t> &r) -> void
                         {
                               
-                              for(int i = r.begin(); i!=r.end(); i++)
+                              for(size_t i = r.begin(); i!=r.end(); i++)
                               {
                                  
                                    *(result+i) = *(first+i);
@@ -55,17 +55,11 @@ namespace bolt{
             template<typename InputIterator, typename Size, typename OutputIterator>
             OutputIterator copy_n(InputIterator first, Size n, OutputIterator result)
             {
-               //Gets the number of concurrent threads supported by the underlying platform
-               //unsigned int concurentThreadsSupported = std::thread::hardware_concurrency();
-
-               //This allows TBB to choose the number of threads to spawn.
-               tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-
-               //Explicitly setting the number of threads to spawn
-               //tbb::task_scheduler_init((int) concurentThreadsSupported);
-
                Copy_n <InputIterator, Size, OutputIterator> copy_op;
-               copy_op(first, n, result);
+               bolt::btbb::arena::getInstance( ).execute( [&]( )
+               {
+                   copy_op(first, n, result);
+               } );
 
                return result;
             }
@@ -19,7 +19,7 @@
 #define BOLT_BTBB_FILL_INL
 #pragma once
 
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/arena.h"
 #include "tbb/parallel_for.h"
 #include "tbb/blocked_range.h"
 //#include <thread>
@@ -54,17 +54,11 @@ namespace bolt{
            template<typename ForwardIterator, typename T>
            void fill( ForwardIterator first, ForwardIterator last, const T & value)
            {
-             //Gets the number of concurrent threads supported by the underlying platform
-             //unsigned int concurentThreadsSupported = std::thread::hardware_concurrency();
-
-             //This allows TBB to choose the number of threads to spawn.
-             tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-
-             //Explicitly setting the number of threads to spawn
-             //tbb::task_scheduler_init((int) concurentThreadsSupported);
-
              Fill <ForwardIterator, T> fill_op(value);
-             fill_op(first, last, value);
+             bolt::btbb::arena::getInstance( ).execute( [&]( )
+             {
+                 fill_op(first, last, value);
+             } );
 
              //Fill <ForwardIterator, T> fill_op_split(fill_op);
              //fill_op_split(first, last, value);
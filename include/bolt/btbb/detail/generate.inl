@@ -19,7 +19,7 @@
 #define BOLT_BTBB_GENERATE_INL
 #pragma once
 
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/arena.h"
 #include "tbb/parallel_for.h"
 #include "tbb/blocked_range.h"
 
@@ -51,10 +51,11 @@ namespace bolt{
             template<typename ForwardIterator, typename Generator>
             void generate( ForwardIterator first, ForwardIterator last, Generator gen)
             {
-               //This allows TBB to choose the number of threads to spawn.
-               tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
                Generate <ForwardIterator, Generator> generate_obj(gen);
-               generate_obj(first, last, gen);
+               bolt::btbb::arena::getInstance( ).execute( [&]( )
+               {
+                   generate_obj(first, last, gen);
+               } );
             }       
     } //tbb
 } // bolt
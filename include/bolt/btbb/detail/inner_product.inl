@@ -19,7 +19,7 @@
 #define BOLT_BTBB_INNER_PRODUCT_INL
 #pragma once
 
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/arena.h"
 #include "tbb/parallel_for.h"
 #include "tbb/blocked_range.h"
 //#include <thread>
@@ -44,14 +44,14 @@ namespace bolt{
                         result = init;
                     else
                     {  
-                      int n = (int) std::distance(first1, last1);
+                      size_t n = static_cast< size_t >( std::distance(first1, last1) );
                       std::vector<OutputType> res_vector(n);
                       typename std::vector<OutputType>::iterator res = res_vector.begin();
 
-                      tbb::parallel_for(  tbb::blocked_range<int>(0, n) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
+                      tbb::parallel_for(  tbb::blocked_range<size_t>(0, n) ,
+                        [&] (const tbb::blocked_range<size_t> &r) -> void
                         {
-                              for(int i = r.begin(); i!=r.end(); ++i)
+                              for(size_t i = r.begin(); i!=r.end(); ++i)
                               { 
                                       //Stores the result of applying f2 to the two input vectors
                                       *(res + i) = f2(*(first1 + i), *(first2 + i));  
@@ -72,17 +72,11 @@ namespace bolt{
             OutputType inner_product( InputIterator first1, InputIterator last1, InputIterator first2, OutputType init,
             BinaryFunction1 f1, BinaryFunction2 f2 )
             {
-              //Gets the number of concurrent threads supported by the underlying platform
-              //unsigned int concurentThreadsSupported = std::thread::hardware_concurrency();
-
-              //This allows TBB to choose the number of threads to spawn.
-              tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-
-              //Explicitly setting the number of threads to spawn
-              //tbb::task_scheduler_init((int) concurentThreadsSupported);
-
               Inner_Product_Op <InputIterator, OutputType,BinaryFunction1, BinaryFunction2 > inner_prod_op;
-              inner_prod_op(first1, last1, first2, init, f1, f2);
+              bolt::btbb::arena::getInstance( ).execute( [&]( )
+              {
+                  inner_prod_op(first1, last1, first2, init, f1, f2);
+              } );
 
               return inner_prod_op.result;
            }
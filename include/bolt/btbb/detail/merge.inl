@@ -21,119 +21,152 @@
 
 
 #include "tbb/parallel_for.h"
-#include "tbb/parallel_invoke.h"
-#include "tbb/task_scheduler_init.h"
+#include "tbb/blocked_range.h"
+#include "bolt/btbb/arena.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <type_traits>
 
 namespace bolt{
     namespace btbb {
 
-        
-		template<typename T1,typename T2>
-		struct CompareOp
-		{
-			bool operator()(const T1 &lhs, const T2 &rhs) const  {return (lhs < rhs) ? true:false;}
-		};
-
-            using namespace tbb;
-
-            template<typename InputIterator1 , typename InputIterator2 , typename OutputIterator,
-            typename StrictWeakCompare>
-            struct ParallelMerge {
-                static size_t grainsize;
-                InputIterator1 begin1, end1; // [begin1,end1) is 1st sequence to be merged
-                InputIterator2 begin2, end2; // [begin2,end2) is 2nd sequence to be merged
-                OutputIterator out;               // where to put merged sequence   
-                StrictWeakCompare comp;
-
-                bool empty()   const {return (end1-begin1)+(end2-begin2)==0;}
-                
-                bool is_divisible() const 
+        namespace detail
+        {
+            //  Merges split their output into pieces of about this size, one task each
+            static const size_t parallelMergeChunk = 8192;
+
+            /*! \brief Returns how many of the first \p k elements of the stable merge of [a, a+m) and [b, b+n) come
+            *   from \p a.  Equivalent elements are taken from \p a first, as std::merge does.
+            */
+            template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename StrictWeakOrdering >
+            size_t co_rank( size_t k, RandomAccessIterator1 a, size_t m, RandomAccessIterator2 b, size_t n,
+                            StrictWeakOrdering comp )
+            {
+                size_t low = k > n ? k - n : 0;
+                size_t high = std::min( k, m );
+
+                //  a[ i ] belongs to the first k elements when it does not come after b[ k - i - 1 ]
+                while( low < high )
                 {
-			
-		  size_t min;
- 		   min = end1-begin1 < end2-begin2?end1-begin1:end2-begin2;
-                    return  min > grainsize;
+                    size_t i = low + ( high - low ) / 2;
+                    if( !comp( b[ k - i - 1 ], a[ i ] ) )
+                        low = i + 1;
+                    else
+                        high = i;
                 }
+                return low;
+            }
 
+            //  Arithmetic elements of one type are merged without branching on the comparison
+            template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIterator >
+            struct is_branchless_mergeable
+            {
+                typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type T1;
+                typedef typename std::iterator_traits< RandomAccessIterator2 >::value_type T2;
 
-                ParallelMerge( ParallelMerge& r, split ) 
-                {
-                    if( r.end1-r.begin1 < r.end2-r.begin2 ) {
-                        std::swap(r.begin1,r.begin2);
-                        std::swap(r.end1,r.end2);
-                    }
-                    begin1 = r.begin1 + (r.end1-r.begin1)/2;
-                    begin2 = std::lower_bound( r.begin2, r.end2, *begin1,comp );
-                    end1 = r.end1;
-                    end2 = r.end2;
-                    r.end1 = begin1;
-                    r.end2 = begin2;
-
-                    out = r.out + ( r.end1-r.begin1) + ( r.end2-r.begin2);
-                }
-                ParallelMerge( InputIterator1 begin1_, InputIterator1 end1_, 
-                                    InputIterator2 begin2_, InputIterator2 end2_, 
-                                    OutputIterator out_,StrictWeakCompare _comp ) :
-                    begin1(begin1_), end1(end1_), 
-                    begin2(begin2_), end2(end2_), out(out_),comp(comp)
-                {}
+                static const bool value = std::is_arithmetic< T1 >::value && std::is_same< T1, T2 >::value &&
+                    std::is_base_of< std::random_access_iterator_tag,
+                        typename std::iterator_traits< OutputIterator >::iterator_category >::value;
             };
 
-            template<typename InputIterator1 , typename InputIterator2 , typename OutputIterator,
-            typename StrictWeakCompare>
-            size_t ParallelMerge<InputIterator1,InputIterator2,OutputIterator,
-            StrictWeakCompare>::grainsize = 1000;
+            template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIterator,
+                      typename StrictWeakOrdering >
+            void serial_merge( RandomAccessIterator1 a, size_t m, RandomAccessIterator2 b, size_t n,
+                               OutputIterator out, StrictWeakOrdering comp, std::false_type )
+            {
+                std::merge( a, a + m, b, b + n, out, comp );
+            }
 
-            template<typename InputIterator1 , typename InputIterator2 , typename OutputIterator,
-            typename StrictWeakCompare>
-            struct ParallelMergeCode {
-                void operator()( ParallelMerge<InputIterator1,InputIterator2,OutputIterator,
-            StrictWeakCompare> & r ) const {
-                    std::merge( r.begin1, r.end1, r.begin2, r.end2, r.out,r.comp );
+            /*! \brief Stable merge that selects each output element and advances both inputs with arithmetic, so
+            *   that the loop compiles to conditional moves and does not mispredict on interleaved inputs.
+            */
+            template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIterator,
+                      typename StrictWeakOrdering >
+            void serial_merge( RandomAccessIterator1 a, size_t m, RandomAccessIterator2 b, size_t n,
+                               OutputIterator out, StrictWeakOrdering comp, std::true_type )
+            {
+                typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type T;
+
+                size_t i = 0, j = 0, k = 0;
+                while( i < m && j < n )
+                {
+                    const T x = a[ i ];
+                    const T y = b[ j ];
+                    const bool fromB = comp( y, x );
+                    out[ k++ ] = fromB ? y : x;
+                    j += fromB;
+                    i += !fromB;
                 }
-            };
-
-        template<typename InputIterator1 , typename InputIterator2 , typename OutputIterator,
-            typename StrictWeakCompare>
-            void PMerge( InputIterator1 begin1, InputIterator1 end1, InputIterator2 begin2, 
-            InputIterator2 end2, OutputIterator out,StrictWeakCompare comp ) 
-        {
-
-            tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-
-                parallel_for(     
-                   btbb::ParallelMerge<InputIterator1,InputIterator2,OutputIterator,
-            StrictWeakCompare>(begin1,end1,begin2,end2,out,comp),
-                   btbb::ParallelMergeCode<InputIterator1,InputIterator2,OutputIterator,
-            StrictWeakCompare> (),
-                   simple_partitioner() 
-                );
-
+                out = std::copy( a + i, a + m, out + k );
+                std::copy( b + j, b + n, out );
             }
 
+            template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIterator,
+                      typename StrictWeakOrdering >
+            void serial_merge( RandomAccessIterator1 a, size_t m, RandomAccessIterator2 b, size_t n,
+                               OutputIterator out, StrictWeakOrdering comp )
+            {
+                serial_merge( a, m, b, n, out, comp, std::integral_constant< bool,
+                    is_branchless_mergeable< RandomAccessIterator1, RandomAccessIterator2, OutputIterator >::value >( ) );
+            }
 
+            /*! \brief Stable merge of [a, a+m) and [b, b+n) into \p out.  The output is cut into equal pieces, and
+            *   co_rank finds where each piece starts in both inputs, so that all pieces merge in parallel and take
+            *   the same time however the inputs interleave.  Runs in the caller's arena.
+            */
+            template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIterator,
+                      typename StrictWeakOrdering >
+            void parallel_merge( RandomAccessIterator1 a, size_t m, RandomAccessIterator2 b, size_t n,
+                                 OutputIterator out, StrictWeakOrdering comp )
+            {
+                const size_t total = m + n;
+                if( total <= parallelMergeChunk )
+                {
+                    serial_merge( a, m, b, n, out, comp );
+                    return;
+                }
 
+                const size_t numChunks = ( total + parallelMergeChunk - 1 ) / parallelMergeChunk;
+                tbb::parallel_for( tbb::blocked_range< size_t >( 0, numChunks, 1 ),
+                    [&]( const tbb::blocked_range< size_t >& r )
+                {
+                    for( size_t chunk = r.begin( ); chunk != r.end( ); ++chunk )
+                    {
+                        size_t k0 = chunk * parallelMergeChunk;
+                        size_t k1 = std::min( total, k0 + parallelMergeChunk );
+                        size_t i0 = co_rank( k0, a, m, b, n, comp );
+                        size_t i1 = co_rank( k1, a, m, b, n, comp );
+
+                        serial_merge( a + i0, i1 - i0, b + ( k0 - i0 ), ( k1 - k0 ) - ( i1 - i0 ), out + k0, comp );
+                    }
+                } );
+            }
+        }
 
         template<typename InputIterator1 , typename InputIterator2 , typename OutputIterator,
             typename StrictWeakCompare>
         OutputIterator merge (InputIterator1 first1, InputIterator1 last1, InputIterator2 first2,
         InputIterator2 last2, OutputIterator result,StrictWeakCompare comp)
         {
+            const size_t m = static_cast< size_t >( std::distance( first1, last1 ) );
+            const size_t n = static_cast< size_t >( std::distance( first2, last2 ) );
 
-            btbb::PMerge(first1,last1,first2,last2,result,comp);
-            return result + (last1 - first1) + (last2 - first2);
-
-		}
+            bolt::btbb::arena::getInstance( ).execute( [&]( )
+            {
+                detail::parallel_merge( first1, m, first2, n, result, comp );
+            } );
+            return result + m + n;
+        }
 
 
         template<typename InputIterator1 , typename InputIterator2 , typename OutputIterator >
         OutputIterator merge (InputIterator1 first1, InputIterator1 last1, InputIterator2 first2,
         InputIterator2 last2, OutputIterator result)
         {
-
-			return merge(first1,last1,first2,last2,result,CompareOp<InputIterator1,InputIterator2>());
-
-		}
+            typedef typename std::iterator_traits< InputIterator1 >::value_type T;
+            return bolt::btbb::merge( first1, last1, first2, last2, result, std::less< T >( ) );
+        }
 
 
     } //tbb
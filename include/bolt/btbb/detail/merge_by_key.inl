@@ -0,0 +1,132 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_BTBB_MERGE_BY_KEY_INL )
+#define BOLT_BTBB_MERGE_BY_KEY_INL
+#pragma once
+
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+#include "bolt/btbb/arena.h"
+#include "bolt/btbb/merge.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+namespace bolt {
+    namespace btbb {
+
+        namespace detail
+        {
+            //  Merges the keys [a, a+m) and [b, b+n), and their values, into out[ 0, m+n )
+            template< typename KeyIterator1, typename KeyIterator2, typename ValueIterator1, typename ValueIterator2,
+                      typename KeyOutputIterator, typename ValueOutputIterator, typename StrictWeakOrdering >
+            void serial_merge_by_key( KeyIterator1 a, size_t m, KeyIterator2 b, size_t n,
+                                      ValueIterator1 va, ValueIterator2 vb,
+                                      KeyOutputIterator keysOut, ValueOutputIterator valuesOut,
+                                      StrictWeakOrdering comp )
+            {
+                size_t i = 0, j = 0, k = 0;
+                for( ; i < m && j < n; ++k )
+                {
+                    if( comp( b[ j ], a[ i ] ) )
+                    {
+                        keysOut[ k ] = b[ j ];
+                        valuesOut[ k ] = vb[ j++ ];
+                    }
+                    else
+                    {
+                        keysOut[ k ] = a[ i ];
+                        valuesOut[ k ] = va[ i++ ];
+                    }
+                }
+                std::copy( vb + j, vb + n, std::copy( va + i, va + m, valuesOut + k ) );
+                std::copy( b + j, b + n, std::copy( a + i, a + m, keysOut + k ) );
+            }
+
+            //  The pieces of the output are found by co_rank on the keys, as in parallel_merge
+            template< typename KeyIterator1, typename KeyIterator2, typename ValueIterator1, typename ValueIterator2,
+                      typename KeyOutputIterator, typename ValueOutputIterator, typename StrictWeakOrdering >
+            void parallel_merge_by_key( KeyIterator1 a, size_t m, KeyIterator2 b, size_t n,
+                                        ValueIterator1 va, ValueIterator2 vb,
+                                        KeyOutputIterator keysOut, ValueOutputIterator valuesOut,
+                                        StrictWeakOrdering comp )
+            {
+                const size_t total = m + n;
+                const size_t numChunks = ( total + parallelMergeChunk - 1 ) / parallelMergeChunk;
+                tbb::parallel_for( tbb::blocked_range< size_t >( 0, numChunks, 1 ),
+                    [&]( const tbb::blocked_range< size_t >& r )
+                {
+                    for( size_t chunk = r.begin( ); chunk != r.end( ); ++chunk )
+                    {
+                        size_t k0 = chunk * parallelMergeChunk;
+                        size_t k1 = std::min( total, k0 + parallelMergeChunk );
+                        size_t i0 = co_rank( k0, a, m, b, n, comp );
+                        size_t i1 = co_rank( k1, a, m, b, n, comp );
+                        size_t j0 = k0 - i0;
+
+                        serial_merge_by_key( a + i0, i1 - i0, b + j0, ( k1 - k0 ) - ( i1 - i0 ), va + i0, vb + j0,
+                                             keysOut + k0, valuesOut + k0, comp );
+                    }
+                } );
+            }
+        }
+
+        template< typename InputIterator1, typename InputIterator2, typename InputIterator3, typename InputIterator4,
+                  typename OutputIterator1, typename OutputIterator2, typename StrictWeakCompare >
+        std::pair< OutputIterator1, OutputIterator2 >
+        merge_by_key( InputIterator1 keys_first1, InputIterator1 keys_last1,
+                      InputIterator2 keys_first2, InputIterator2 keys_last2,
+                      InputIterator3 values_first1, InputIterator4 values_first2,
+                      OutputIterator1 keys_result, OutputIterator2 values_result, StrictWeakCompare comp )
+        {
+            const size_t m = static_cast< size_t >( std::distance( keys_first1, keys_last1 ) );
+            const size_t n = static_cast< size_t >( std::distance( keys_first2, keys_last2 ) );
+
+            if( m + n <= detail::parallelMergeChunk )
+            {
+                detail::serial_merge_by_key( keys_first1, m, keys_first2, n, values_first1, values_first2,
+                                             keys_result, values_result, comp );
+            }
+            else
+            {
+                bolt::btbb::arena::getInstance( ).execute( [&]( )
+                {
+                    detail::parallel_merge_by_key( keys_first1, m, keys_first2, n, values_first1, values_first2,
+                                                   keys_result, values_result, comp );
+                } );
+            }
+            return std::make_pair( keys_result + ( m + n ), values_result + ( m + n ) );
+        }
+
+        template< typename InputIterator1, typename InputIterator2, typename InputIterator3, typename InputIterator4,
+                  typename OutputIterator1, typename OutputIterator2 >
+        std::pair< OutputIterator1, OutputIterator2 >
+        merge_by_key( InputIterator1 keys_first1, InputIterator1 keys_last1,
+                      InputIterator2 keys_first2, InputIterator2 keys_last2,
+                      InputIterator3 values_first1, InputIterator4 values_first2,
+                      OutputIterator1 keys_result, OutputIterator2 values_result )
+        {
+            typedef typename std::iterator_traits< InputIterator1 >::value_type T;
+            return bolt::btbb::merge_by_key( keys_first1, keys_last1, keys_first2, keys_last2, values_first1, values_first2,
+                                             keys_result, values_result, std::less< T >( ) );
+        }
+
+    } //btbb
+} // bolt
+
+#endif //BTBB_MERGE_BY_KEY_INL
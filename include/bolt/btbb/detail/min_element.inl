@@ -19,7 +19,7 @@
 #define BOLT_BTBB_MIN_ELEMENT_INL
 #pragma once
 
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/arena.h"
 #include "tbb/parallel_for.h"
 #include "tbb/blocked_range.h"
 #include <iterator>
@@ -96,9 +96,11 @@ namespace bolt{
             ForwardIterator min_element(ForwardIterator first, ForwardIterator last, BinaryPredicate binary_op)
             {
 
-               tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
                Min_Element_comp<ForwardIterator, BinaryPredicate> min_element_op(first, binary_op);
-               tbb::parallel_reduce( tbb::blocked_range<ForwardIterator>( first, last), min_element_op );
+               bolt::btbb::arena::getInstance( ).execute( [&]( )
+               {
+                   tbb::parallel_reduce( tbb::blocked_range<ForwardIterator>( first, last), min_element_op );
+               } );
                return min_element_op.value;
              
             }
@@ -107,9 +109,11 @@ namespace bolt{
             ForwardIterator max_element(ForwardIterator first, ForwardIterator last, BinaryPredicate binary_op)
             {
 
-              tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
               Max_Element_comp<ForwardIterator, BinaryPredicate> max_element_op(first, binary_op);
-              tbb::parallel_reduce( tbb::blocked_range<ForwardIterator>( first, last), max_element_op );
+              bolt::btbb::arena::getInstance( ).execute( [&]( )
+              {
+                  tbb::parallel_reduce( tbb::blocked_range<ForwardIterator>( first, last), max_element_op );
+              } );
               return max_element_op.value;  
             }
 
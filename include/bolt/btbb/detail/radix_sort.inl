@@ -0,0 +1,358 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_BTBB_RADIX_SORT_INL )
+#define BOLT_BTBB_RADIX_SORT_INL
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <cstring>
+#include <limits>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_array.hpp>
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
+namespace bolt {
+    namespace btbb {
+
+        namespace detail
+        {
+            static const unsigned radixBits = 8;
+            static const unsigned radixBuckets = 1 << radixBits;
+
+            //  Below this size std::sort beats the passes over the histograms
+            static const size_t radixSerialCutoff = 2048;
+
+            //  Elements per tile; every tile owns one histogram per pass.  Large inputs use larger tiles, so that
+            //  the serial prefix sum over the histograms stays small
+            static const size_t radixMinTileSize = 1 << 16;
+            static const size_t radixMaxTiles = 256;
+
+            template< size_t Size >
+            struct radix_bits;
+
+            template< >
+            struct radix_bits< 4 >
+            {
+                typedef boost::uint32_t type;
+            };
+
+            template< >
+            struct radix_bits< 8 >
+            {
+                typedef boost::uint64_t type;
+            };
+
+            //  Maps an integer to an unsigned key with the same order; signed types flip their sign bit
+            template< typename T >
+            struct radix_integer_traits
+            {
+                static const bool sortable = true;
+                typedef typename radix_bits< sizeof( T ) >::type key_type;
+
+                static key_type key( T value )
+                {
+                    key_type bits = static_cast< key_type >( value );
+                    if( std::numeric_limits< T >::is_signed )
+                        bits ^= key_type( 1 ) << ( sizeof( key_type ) * 8 - 1 );
+                    return bits;
+                }
+            };
+
+            //  Maps an IEEE-754 value to an unsigned key with the same order: positive values set the sign bit,
+            //  negative values invert all bits
+            template< typename T >
+            struct radix_float_traits
+            {
+                static const bool sortable = true;
+                typedef typename radix_bits< sizeof( T ) >::type key_type;
+
+                static key_type key( T value )
+                {
+                    key_type bits;
+                    std::memcpy( &bits, &value, sizeof( bits ) );
+                    const key_type sign = key_type( 1 ) << ( sizeof( key_type ) * 8 - 1 );
+                    return ( bits & sign ) ? ~bits : ( bits | sign );
+                }
+            };
+
+            template< > struct radix_traits< int >: radix_integer_traits< int > {};
+            template< > struct radix_traits< unsigned int >: radix_integer_traits< unsigned int > {};
+            template< > struct radix_traits< long >: radix_integer_traits< long > {};
+            template< > struct radix_traits< unsigned long >: radix_integer_traits< unsigned long > {};
+            template< > struct radix_traits< long long >: radix_integer_traits< long long > {};
+            template< > struct radix_traits< unsigned long long >: radix_integer_traits< unsigned long long > {};
+            template< > struct radix_traits< float >: radix_float_traits< float > {};
+            template< > struct radix_traits< double >: radix_float_traits< double > {};
+
+            //  Descending order sorts the inverted keys in ascending order
+            template< typename T, bool Descending >
+            struct radix_key
+            {
+                typedef typename radix_traits< T >::key_type key_type;
+
+                key_type operator( )( T value ) const
+                {
+                    key_type bits = radix_traits< T >::key( value );
+                    return Descending ? static_cast< key_type >( ~bits ) : bits;
+                }
+            };
+
+            //  Stands in for the values of a keys-only sort; reads and writes through it compile to nothing
+            struct radix_no_values
+            {
+                struct element
+                {
+                    element& operator=( const element& ) { return *this; }
+                };
+
+                element operator[ ]( size_t ) const { return element( ); }
+            };
+
+            /*! \brief One counting pass of the LSD radix sort: moves the n keys of \p srcKeys to \p dstKeys, ordered
+            *   by the digit at \p shift and keeping the order of keys with the same digit.  The values move along
+            *   with their keys.  \p histograms holds radixBuckets counters for each tile.
+            */
+            template< typename KeyFunction, typename InputIterator1, typename InputIterator2,
+                      typename OutputIterator1, typename OutputIterator2 >
+            void radix_pass( InputIterator1 srcKeys, InputIterator2 srcValues,
+                             OutputIterator1 dstKeys, OutputIterator2 dstValues,
+                             size_t n, unsigned shift, size_t tileSize,
+                             std::vector< size_t >& histograms, const KeyFunction& key )
+            {
+                const size_t numTiles = ( n + tileSize - 1 ) / tileSize;
+
+                tbb::parallel_for( tbb::blocked_range< size_t >( 0, numTiles, 1 ),
+                    [&]( const tbb::blocked_range< size_t >& r )
+                {
+                    for( size_t tile = r.begin( ); tile != r.end( ); ++tile )
+                    {
+                        size_t* counts = &histograms[ tile * radixBuckets ];
+                        std::fill( counts, counts + radixBuckets, size_t( 0 ) );
+
+                        const size_t tileEnd = std::min( n, ( tile + 1 ) * tileSize );
+                        for( size_t i = tile * tileSize; i < tileEnd; ++i )
+                            ++counts[ ( key( srcKeys[ i ] ) >> shift ) & ( radixBuckets - 1 ) ];
+                    }
+                } );
+
+                //  Exclusive scan in digit major order: all elements of digit d go after every smaller digit, and
+                //  within a digit the tiles keep their order
+                size_t offset = 0;
+                for( unsigned digit = 0; digit < radixBuckets; ++digit )
+                {
+                    for( size_t tile = 0; tile < numTiles; ++tile )
+                    {
+                        size_t count = histograms[ tile * radixBuckets + digit ];
+                        histograms[ tile * radixBuckets + digit ] = offset;
+                        offset += count;
+                    }
+                }
+
+                tbb::parallel_for( tbb::blocked_range< size_t >( 0, numTiles, 1 ),
+                    [&]( const tbb::blocked_range< size_t >& r )
+                {
+                    for( size_t tile = r.begin( ); tile != r.end( ); ++tile )
+                    {
+                        size_t* offsets = &histograms[ tile * radixBuckets ];
+
+                        const size_t tileEnd = std::min( n, ( tile + 1 ) * tileSize );
+                        for( size_t i = tile * tileSize; i < tileEnd; ++i )
+                        {
+                            size_t position = offsets[ ( key( srcKeys[ i ] ) >> shift ) & ( radixBuckets - 1 ) ]++;
+                            dstKeys[ position ] = srcKeys[ i ];
+                            dstValues[ position ] = srcValues[ i ];
+                        }
+                    }
+                } );
+            }
+
+            /*! \brief Returns, for every digit position, whether all keys share the same digit there.  Such passes
+            *   would not move any element and are skipped.
+            */
+            template< typename KeyFunction, typename RandomAccessIterator >
+            std::vector< bool > radix_constant_digits( RandomAccessIterator first, size_t n, size_t tileSize,
+                                                       const KeyFunction& key )
+            {
+                typedef typename KeyFunction::key_type key_type;
+                const size_t numTiles = ( n + tileSize - 1 ) / tileSize;
+
+                //  A digit is constant when the bits of every key match the bits of the first key
+                std::vector< key_type > differences( numTiles, key_type( 0 ) );
+                const key_type reference = key( first[ 0 ] );
+
+                tbb::parallel_for( tbb::blocked_range< size_t >( 0, numTiles, 1 ),
+                    [&]( const tbb::blocked_range< size_t >& r )
+                {
+                    for( size_t tile = r.begin( ); tile != r.end( ); ++tile )
+                    {
+                        key_type difference = 0;
+                        const size_t tileEnd = std::min( n, ( tile + 1 ) * tileSize );
+                        for( size_t i = tile * tileSize; i < tileEnd; ++i )
+                            difference |= key( first[ i ] ) ^ reference;
+                        differences[ tile ] = difference;
+                    }
+                } );
+
+                key_type difference = 0;
+                for( size_t tile = 0; tile < numTiles; ++tile )
+                    difference |= differences[ tile ];
+
+                const unsigned numPasses = sizeof( key_type ) * 8 / radixBits;
+                std::vector< bool > constant( numPasses );
+                for( unsigned pass = 0; pass < numPasses; ++pass )
+                    constant[ pass ] = ( ( difference >> ( pass * radixBits ) ) & ( radixBuckets - 1 ) ) == 0;
+
+                return constant;
+            }
+
+            /*! \brief Runs the passes of the radix sort over n keys and their values.  The passes ping-pong between
+            *   the input and the buffers, which have room for n elements each; the result ends up in the input.
+            */
+            template< bool Descending, typename KeyIterator, typename ValueIterator,
+                      typename KeyBuffer, typename ValueBuffer >
+            void radix_sort_passes( KeyIterator keys, ValueIterator values, KeyBuffer keyBuffer,
+                                    ValueBuffer valueBuffer, size_t n )
+            {
+                typedef typename std::iterator_traits< KeyIterator >::value_type T;
+                static_assert( is_radix_sortable< T >::value,
+                    "bolt::btbb::radix_sort only sorts 32 and 64 bit integer and floating point types" );
+
+                radix_key< T, Descending > key;
+                const size_t tileSize = std::max( radixMinTileSize, ( n + radixMaxTiles - 1 ) / radixMaxTiles );
+                std::vector< size_t > histograms( ( ( n + tileSize - 1 ) / tileSize ) * radixBuckets );
+
+                bolt::btbb::arena::getInstance( ).execute( [&]( )
+                {
+                    std::vector< bool > constant = radix_constant_digits( keys, n, tileSize, key );
+
+                    bool inBuffer = false;
+                    for( unsigned pass = 0; pass < constant.size( ); ++pass )
+                    {
+                        if( constant[ pass ] )
+                            continue;
+
+                        if( inBuffer )
+                            radix_pass( keyBuffer, valueBuffer, keys, values, n, pass * radixBits, tileSize,
+                                        histograms, key );
+                        else
+                            radix_pass( keys, values, keyBuffer, valueBuffer, n, pass * radixBits, tileSize,
+                                        histograms, key );
+                        inBuffer = !inBuffer;
+                    }
+
+                    if( inBuffer )
+                    {
+                        tbb::parallel_for( tbb::blocked_range< size_t >( 0, n, radixMinTileSize ),
+                            [&]( const tbb::blocked_range< size_t >& r )
+                        {
+                            for( size_t i = r.begin( ); i != r.end( ); ++i )
+                            {
+                                keys[ i ] = keyBuffer[ i ];
+                                values[ i ] = valueBuffer[ i ];
+                            }
+                        } );
+                    }
+                } );
+            }
+
+            template< bool Descending, typename RandomAccessIterator >
+            void radix_sort( RandomAccessIterator first, RandomAccessIterator last )
+            {
+                typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+                const size_t n = static_cast< size_t >( std::distance( first, last ) );
+                if( n < 2 )
+                    return;
+
+                if( n < radixSerialCutoff )
+                {
+                    if( Descending )
+                        std::sort( first, last, std::greater< T >( ) );
+                    else
+                        std::sort( first, last, std::less< T >( ) );
+                    return;
+                }
+
+                boost::scoped_array< T > buffer( new T[ n ] );
+                radix_sort_passes< Descending >( first, radix_no_values( ), buffer.get( ), radix_no_values( ), n );
+            }
+
+            template< bool Descending, typename RandomAccessIterator1, typename RandomAccessIterator2 >
+            void radix_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last,
+                                    RandomAccessIterator2 values_first )
+            {
+                typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type keyType;
+                typedef typename std::iterator_traits< RandomAccessIterator2 >::value_type valueType;
+
+                const size_t n = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+                if( n < 2 )
+                    return;
+
+                boost::scoped_array< keyType > keyBuffer( new keyType[ n ] );
+                boost::scoped_array< valueType > valueBuffer( new valueType[ n ] );
+                radix_sort_passes< Descending >( keys_first, values_first, keyBuffer.get( ), valueBuffer.get( ), n );
+            }
+        }
+
+        template< typename RandomAccessIterator >
+        void radix_sort( RandomAccessIterator first, RandomAccessIterator last )
+        {
+            detail::radix_sort< false >( first, last );
+        }
+
+        template< typename RandomAccessIterator, typename T >
+        void radix_sort( RandomAccessIterator first, RandomAccessIterator last, std::less< T > )
+        {
+            detail::radix_sort< false >( first, last );
+        }
+
+        template< typename RandomAccessIterator, typename T >
+        void radix_sort( RandomAccessIterator first, RandomAccessIterator last, std::greater< T > )
+        {
+            detail::radix_sort< true >( first, last );
+        }
+
+        template< typename RandomAccessIterator1, typename RandomAccessIterator2 >
+        void radix_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last,
+                                RandomAccessIterator2 values_first )
+        {
+            detail::radix_sort_by_key< false >( keys_first, keys_last, values_first );
+        }
+
+        template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename T >
+        void radix_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last,
+                                RandomAccessIterator2 values_first, std::less< T > )
+        {
+            detail::radix_sort_by_key< false >( keys_first, keys_last, values_first );
+        }
+
+        template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename T >
+        void radix_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last,
+                                RandomAccessIterator2 values_first, std::greater< T > )
+        {
+            detail::radix_sort_by_key< true >( keys_first, keys_last, values_first );
+        }
+
+    }
+}
+
+#endif
@@ -70,16 +70,12 @@ namespace bolt{
             BinaryFunction binary_op)
         {
             typedef typename std::iterator_traits<InputIterator>::value_type iType;
-            //tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-
-			//Gets the number of concurrent threads supported by the underlying platform
-            //unsigned int concurentThreadsSupported = std::thread::hardware_concurrency();
-			unsigned int concurentThreadsSupported = tbb::task_scheduler_init::default_num_threads();
-			//Explicitly setting the number of threads to spawn
-            tbb::task_scheduler_init((int) concurentThreadsSupported);
-
             Reduce<T,InputIterator, BinaryFunction> reduce_op(binary_op, init);
-            tbb::parallel_reduce( tbb::blocked_range<InputIterator>( first, last, 100000), reduce_op, tbb::auto_partitioner() );
+            bolt::btbb::arena::getInstance( ).execute( [&]( )
+            {
+                tbb::parallel_reduce( tbb::blocked_range<InputIterator>( first, last, 100000), reduce_op,
+                                      tbb::auto_partitioner() );
+            } );
             return reduce_op.value;
         }
 
@@ -0,0 +1,536 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_BTBB_SCAN_ENGINE_INL )
+#define BOLT_BTBB_SCAN_ENGINE_INL
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <boost/scoped_array.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/parallel_scan.h"
+#include "tbb/partitioner.h"
+#include "tbb/task_arena.h"
+#if TBB_INTERFACE_VERSION >= 12000
+#include <atomic>
+#else
+#include "tbb/atomic.h"
+#endif
+
+namespace bolt {
+    namespace btbb {
+
+        namespace detail
+        {
+            //  Elements per tile; small enough that a tile is still in the cache when it is read the second time
+            static const size_t scanTileSize = 1 << 14;
+
+            //  Look-back polls this often before it yields the thread to the tile it waits for
+            static const unsigned scanSpinCount = 64;
+
+            //  Acquire loads and release stores of a size_t; oneTBB dropped tbb::atomic for std::atomic
+            class scan_counter
+            {
+            public:
+#if TBB_INTERFACE_VERSION >= 12000
+                size_t load( ) const { return m_value.load( std::memory_order_acquire ); }
+                void store( size_t value ) { m_value.store( value, std::memory_order_release ); }
+                size_t fetch_add( size_t value ) { return m_value.fetch_add( value ); }
+            private:
+                std::atomic< size_t > m_value;
+#else
+                size_t load( ) const { return m_value; }
+                void store( size_t value ) { m_value = value; }
+                size_t fetch_add( size_t value ) { return m_value.fetch_and_add( value ); }
+            private:
+                tbb::atomic< size_t > m_value;
+#endif
+            };
+
+            //  What a tile has published so far; its values are written before the release store of its status
+            template< typename T >
+            struct scan_tile_state
+            {
+                enum { invalid, aggregateReady, prefixReady };
+
+                scan_counter status;
+                T aggregate;
+                T inclusivePrefix;
+            };
+
+            template< typename TileBody >
+            void lookback_scan_tile( size_t tile, size_t n, const TileBody& body,
+                                     scan_tile_state< typename TileBody::value_type >* tiles )
+            {
+                typedef typename TileBody::value_type T;
+                typedef scan_tile_state< T > state;
+
+                const size_t begin = tile * scanTileSize;
+                const size_t end = std::min( n, begin + scanTileSize );
+
+                //  Every tile publishes before it scans, so the tiles after it never wait for a whole tile scan;
+                //  the first tile has nothing to look back at and publishes its aggregate as its prefix
+                const T aggregate = body.reduce( begin, end );
+                if( tile == 0 )
+                {
+                    tiles[ tile ].inclusivePrefix = aggregate;
+                    tiles[ tile ].status.store( state::prefixReady );
+                    body.scan( begin, end, NULL );
+                    return;
+                }
+
+                tiles[ tile ].aggregate = aggregate;
+                tiles[ tile ].status.store( state::aggregateReady );
+
+                //  Walk back from the previous tile, folding in aggregates until a tile with its prefix is found.
+                //  Tiles are claimed in order, so every tile looked at is being worked on and tile 0 ends the walk
+                T exclusivePrefix;
+                bool haveAggregates = false;
+                for( size_t predecessor = tile; predecessor-- > 0; )
+                {
+                    size_t status;
+                    for( unsigned spin = 0; ( status = tiles[ predecessor ].status.load( ) ) == state::invalid; ++spin )
+                    {
+                        if( spin >= scanSpinCount )
+                            boost::this_thread::yield( );
+                    }
+
+                    const T& published = ( status == state::prefixReady ) ? tiles[ predecessor ].inclusivePrefix
+                                                                          : tiles[ predecessor ].aggregate;
+                    exclusivePrefix = haveAggregates ? body.combine( published, exclusivePrefix ) : published;
+                    haveAggregates = true;
+
+                    if( status == state::prefixReady )
+                        break;
+                }
+
+                tiles[ tile ].inclusivePrefix = body.combine( exclusivePrefix, aggregate );
+                tiles[ tile ].status.store( state::prefixReady );
+
+                body.scan( begin, end, &exclusivePrefix );
+            }
+        }
+
+        template< typename TileBody >
+        void lookback_scan( size_t n, const TileBody& body )
+        {
+            typedef detail::scan_tile_state< typename TileBody::value_type > state;
+
+            if( n == 0 )
+                return;
+
+            const size_t numTiles = ( n + detail::scanTileSize - 1 ) / detail::scanTileSize;
+            if( numTiles == 1 )
+            {
+                body.scan( 0, n, NULL );
+                return;
+            }
+
+            bolt::btbb::arena::getInstance( ).execute( [&]( )
+            {
+                //  Every worker claims the next tile from a shared counter, so the tiles are started in order and a
+                //  tile never waits for one that no thread has claimed yet
+                const size_t numWorkers = std::min( numTiles,
+                    static_cast< size_t >( tbb::this_task_arena::max_concurrency( ) ) );
+
+                //  A single thread has no tile to wait for, and scans the input in one pass
+                if( numWorkers == 1 )
+                {
+                    body.scan( 0, n, NULL );
+                    return;
+                }
+
+                boost::scoped_array< state > tiles( new state[ numTiles ] );
+                for( size_t tile = 0; tile < numTiles; ++tile )
+                    tiles[ tile ].status.store( state::invalid );
+
+                detail::scan_counter nextTile;
+                nextTile.store( 0 );
+
+                tbb::parallel_for( tbb::blocked_range< size_t >( 0, numWorkers, 1 ),
+                    [&]( const tbb::blocked_range< size_t >& r )
+                {
+                    for( size_t worker = r.begin( ); worker != r.end( ); ++worker )
+                    {
+                        for( size_t tile = nextTile.fetch_add( 1 ); tile < numTiles; tile = nextTile.fetch_add( 1 ) )
+                            detail::lookback_scan_tile( tile, n, body, tiles.get( ) );
+                    }
+                } );
+            } );
+        }
+
+        namespace detail
+        {
+            //  The tbb::parallel_scan body over a tile body; it is empty until it has seen the elements before it
+            template< typename TileBody >
+            class two_pass_scan_body
+            {
+            public:
+                typedef typename TileBody::value_type value_type;
+
+                explicit two_pass_scan_body( const TileBody& body ): m_body( body ), m_empty( true ) {}
+                two_pass_scan_body( two_pass_scan_body& other, tbb::split ): m_body( other.m_body ), m_empty( true ) {}
+
+                void operator()( const tbb::blocked_range< size_t >& r, tbb::pre_scan_tag )
+                {
+                    const value_type sum = m_body.reduce( r.begin( ), r.end( ) );
+                    m_sum = m_empty ? sum : m_body.combine( m_sum, sum );
+                    m_empty = false;
+                }
+
+                void operator()( const tbb::blocked_range< size_t >& r, tbb::final_scan_tag )
+                {
+                    m_sum = m_body.scan( r.begin( ), r.end( ), m_empty ? NULL : &m_sum );
+                    m_empty = false;
+                }
+
+                void reverse_join( two_pass_scan_body& left )
+                {
+                    if( left.m_empty )
+                        return;
+                    m_sum = m_empty ? left.m_sum : m_body.combine( left.m_sum, m_sum );
+                    m_empty = false;
+                }
+
+                void assign( two_pass_scan_body& other )
+                {
+                    m_sum = other.m_sum;
+                    m_empty = other.m_empty;
+                }
+
+            private:
+                const TileBody& m_body;
+                value_type m_sum;
+                bool m_empty;
+            };
+
+            //  Converts the input to the type the scan accumulates in
+            template< typename T >
+            struct scan_identity
+            {
+                template< typename U >
+                T operator()( const U& x ) const { return T( x ); }
+            };
+
+            //  What a run of elements contributes to the segments after it
+            template< typename T >
+            struct segment_sum
+            {
+                size_t heads;   // segments that start in the run
+                T value;        // the sum of the last segment of the run, from its head or from the start of the run
+            };
+
+            //  The sums of integer segments are left to the vector kernels when the input is contiguous and
+            //  needs no transform; floating point sums keep the order of a sequential sum within a tile
+            template< typename InputIterator, typename UnaryFunction, typename BinaryFunction, typename T >
+            struct simd_segment_sum: std::integral_constant< bool,
+                std::is_integral< T >::value && is_plus< BinaryFunction, T >::value &&
+                std::is_same< UnaryFunction, scan_identity< T > >::value &&
+                is_contiguous_iterator< InputIterator, T >::value && is_simd_reducible< T, simd::sum >::value > {};
+
+            /*! \brief The reducing half of the tile bodies of segmented_scan and segmented_reduce.  The aggregate of a
+            *   run is the number of segments that start in it and the sum of its last segment; combining with a run
+            *   that starts a segment drops the sum before it.
+            */
+            template< typename Heads, typename InputIterator, typename UnaryFunction, typename BinaryFunction,
+                      typename T >
+            struct segmented_tiles
+            {
+                typedef segment_sum< T > value_type;
+
+                segmented_tiles( const Heads& heads, InputIterator values, const UnaryFunction& unary_op,
+                                 const BinaryFunction& binary_op, bool seeded, const T& init ):
+                    heads( heads ), values( values ), unary_op( unary_op ), binary_op( binary_op ), seeded( seeded ),
+                    init( init )
+                {}
+
+                bool starts( size_t i ) const
+                {
+                    return i == 0 || heads( i );
+                }
+
+                //  Only the last segment of a run is summed.  A segment that starts in the run is seeded with init, so
+                //  the sum of the first tile, which starts one, is the prefix the engine publishes for it
+                value_type reduce( size_t begin, size_t end ) const
+                {
+                    value_type sum;
+                    sum.heads = 0;
+                    size_t last = begin;
+                    for( size_t i = begin; i < end; ++i )
+                    {
+                        if( starts( i ) )
+                        {
+                            ++sum.heads;
+                            last = i;
+                        }
+                    }
+
+                    const T x = unary_op( values[ last ] );
+                    sum.value = ( sum.heads > 0 && seeded ) ? binary_op( init, x ) : x;
+                    if( last + 1 < end )
+                        sum.value = sumValues( sum.value, last + 1, end,
+                            std::integral_constant< bool,
+                                simd_segment_sum< InputIterator, UnaryFunction, BinaryFunction, T >::value >( ) );
+                    return sum;
+                }
+
+                value_type combine( const value_type& left, const value_type& right ) const
+                {
+                    value_type sum = right;
+                    sum.heads += left.heads;
+                    if( right.heads == 0 )
+                        sum.value = binary_op( left.value, right.value );
+                    return sum;
+                }
+
+                T sumValues( T sum, size_t begin, size_t end, std::false_type ) const
+                {
+                    for( size_t i = begin; i < end; ++i )
+                        sum = binary_op( sum, unary_op( values[ i ] ) );
+                    return sum;
+                }
+
+                T sumValues( T sum, size_t begin, size_t end, std::true_type ) const
+                {
+                    const T* p = &values[ begin ];
+                    return binary_op( sum, simdReduceSlice< simd::sum >( p, end - begin ) );
+                }
+
+                Heads heads;
+                InputIterator values;
+                UnaryFunction unary_op;
+                BinaryFunction binary_op;
+                bool seeded;    // exclusive scans start every segment with init
+                T init;
+            };
+
+            //  The tile body of segmented_scan; every element is read before its output is written
+            template< typename Heads, typename InputIterator, typename OutputIterator, typename UnaryFunction,
+                      typename BinaryFunction, typename T >
+            struct segmented_scan_tiles: segmented_tiles< Heads, InputIterator, UnaryFunction, BinaryFunction, T >
+            {
+                typedef segmented_tiles< Heads, InputIterator, UnaryFunction, BinaryFunction, T > base;
+                typedef typename base::value_type value_type;
+
+                segmented_scan_tiles( const Heads& heads, InputIterator first, OutputIterator result,
+                                      const UnaryFunction& unary_op, const BinaryFunction& binary_op, bool inclusive,
+                                      const T& init ):
+                    base( heads, first, unary_op, binary_op, !inclusive, init ), result( result ),
+                    inclusive( inclusive )
+                {}
+
+                //  Without a prefix, begin is 0 and starts a segment; with one, the segment open at begin carries on
+                value_type scan( size_t begin, size_t end, const value_type* prefix ) const
+                {
+                    value_type sum;
+                    sum.heads = prefix ? prefix->heads : 0;
+                    T value = prefix ? prefix->value : this->init;
+
+                    if( inclusive )
+                    {
+                        for( size_t i = begin; i < end; ++i )
+                        {
+                            const T x = this->unary_op( this->values[ i ] );
+                            if( this->starts( i ) )
+                            {
+                                ++sum.heads;
+                                value = x;
+                            }
+                            else
+                                value = this->binary_op( value, x );
+                            result[ i ] = value;
+                        }
+                    }
+                    else
+                    {
+                        for( size_t i = begin; i < end; ++i )
+                        {
+                            const T x = this->unary_op( this->values[ i ] );
+                            if( this->starts( i ) )
+                            {
+                                ++sum.heads;
+                                value = this->init;
+                            }
+                            result[ i ] = value;
+                            value = this->binary_op( value, x );
+                        }
+                    }
+
+                    sum.value = value;
+                    return sum;
+                }
+
+                OutputIterator result;
+                bool inclusive;
+            };
+
+            /*! \brief The tile body of segmented_reduce.  The segments before a tile number its first output; a tile
+            *   writes the key of every segment that starts in it and the value of every segment that ends in it.
+            */
+            template< typename Heads, typename InputIterator1, typename InputIterator2, typename OutputIterator1,
+                      typename OutputIterator2, typename BinaryFunction, typename T >
+            struct segmented_reduce_tiles:
+                segmented_tiles< Heads, InputIterator2, scan_identity< T >, BinaryFunction, T >
+            {
+                typedef segmented_tiles< Heads, InputIterator2, scan_identity< T >, BinaryFunction, T > base;
+                typedef typename base::value_type value_type;
+
+                segmented_reduce_tiles( size_t n, const Heads& heads, InputIterator1 keys, InputIterator2 values,
+                                        OutputIterator1 keys_result, OutputIterator2 values_result,
+                                        const BinaryFunction& binary_op, size_t* segments ):
+                    base( heads, values, scan_identity< T >( ), binary_op, false, T( values[ 0 ] ) ), n( n ),
+                    keys( keys ), keys_result( keys_result ), values_result( values_result ), segments( segments )
+                {}
+
+                value_type scan( size_t begin, size_t end, const value_type* prefix ) const
+                {
+                    value_type sum;
+                    sum.heads = prefix ? prefix->heads : 0;
+                    T value = prefix ? prefix->value : this->init;
+
+                    bool head = this->starts( begin );
+                    for( size_t i = begin; i < end; ++i )
+                    {
+                        if( head )
+                        {
+                            keys_result[ sum.heads++ ] = keys[ i ];
+                            value = this->values[ i ];
+                        }
+                        else
+                            value = this->binary_op( value, this->values[ i ] );
+
+                        head = ( i + 1 == n ) || this->starts( i + 1 );
+                        if( head )
+                            values_result[ sum.heads - 1 ] = value;
+                    }
+
+                    if( end == n )
+                        *segments = sum.heads;
+                    sum.value = value;
+                    return sum;
+                }
+
+                size_t n;
+                InputIterator1 keys;
+                OutputIterator1 keys_result;
+                OutputIterator2 values_result;
+                size_t* segments;
+            };
+        }
+
+        template< typename TileBody >
+        void two_pass_scan( size_t n, const TileBody& body )
+        {
+            if( n == 0 )
+                return;
+
+            detail::two_pass_scan_body< TileBody > scanBody( body );
+            bolt::btbb::arena::getInstance( ).execute( [&]( )
+            {
+                tbb::parallel_scan( tbb::blocked_range< size_t >( 0, n, detail::scanTileSize ), scanBody,
+                                    tbb::simple_partitioner( ) );
+            } );
+        }
+
+        template< typename TileBody >
+        void tiled_two_pass_scan( size_t n, const TileBody& body )
+        {
+            typedef typename TileBody::value_type T;
+
+            if( n == 0 )
+                return;
+
+            const size_t tileSize = detail::scanTileSize;
+            const size_t numTiles = ( n + tileSize - 1 ) / tileSize;
+            if( numTiles == 1 )
+            {
+                body.scan( 0, n, NULL );
+                return;
+            }
+
+            //  The aggregate of every tile after the first pass, and the prefix up to its end after the serial pass
+            std::vector< T > tiles( numTiles );
+
+            bolt::btbb::arena::getInstance( ).execute( [&]( )
+            {
+                tbb::parallel_for( tbb::blocked_range< size_t >( 0, numTiles ),
+                    [&]( const tbb::blocked_range< size_t >& r )
+                {
+                    for( size_t t = r.begin( ); t != r.end( ); ++t )
+                        tiles[ t ] = body.reduce( t * tileSize, std::min( n, ( t + 1 ) * tileSize ) );
+                } );
+
+                //  Between the passes, over the tiles only
+                for( size_t t = 1; t < numTiles; ++t )
+                    tiles[ t ] = body.combine( tiles[ t - 1 ], tiles[ t ] );
+
+                tbb::parallel_for( tbb::blocked_range< size_t >( 0, numTiles ),
+                    [&]( const tbb::blocked_range< size_t >& r )
+                {
+                    for( size_t t = r.begin( ); t != r.end( ); ++t )
+                        body.scan( t * tileSize, std::min( n, ( t + 1 ) * tileSize ), t == 0 ? NULL : &tiles[ t - 1 ] );
+                } );
+            } );
+        }
+
+        template< typename TileBody >
+        void run_scan( size_t n, const TileBody& body )
+        {
+            if( getScanEngine( ) == LookbackScan )
+                lookback_scan( n, body );
+            else
+                two_pass_scan( n, body );
+        }
+
+        template< typename Heads, typename InputIterator, typename OutputIterator, typename UnaryFunction,
+                  typename BinaryFunction, typename T >
+        void segmented_scan( size_t n, const Heads& heads, InputIterator first, OutputIterator result,
+                             const UnaryFunction& unary_op, const BinaryFunction& binary_op, bool inclusive,
+                             const T& init )
+        {
+            detail::segmented_scan_tiles< Heads, InputIterator, OutputIterator, UnaryFunction, BinaryFunction, T >
+                tiles( heads, first, result, unary_op, binary_op, inclusive, init );
+            run_scan( n, tiles );
+        }
+
+        template< typename Heads, typename InputIterator1, typename InputIterator2, typename OutputIterator1,
+                  typename OutputIterator2, typename BinaryFunction >
+        size_t segmented_reduce( size_t n, const Heads& heads, InputIterator1 keys, InputIterator2 values,
+                                 OutputIterator1 keys_result, OutputIterator2 values_result,
+                                 const BinaryFunction& binary_op )
+        {
+            typedef typename std::iterator_traits< OutputIterator2 >::value_type T;
+
+            if( n == 0 )
+                return 0;
+
+            size_t segments = 0;
+            detail::segmented_reduce_tiles< Heads, InputIterator1, InputIterator2, OutputIterator1, OutputIterator2,
+                                            BinaryFunction, T >
+                tiles( n, heads, keys, values, keys_result, values_result, binary_op, &segments );
+            tiled_two_pass_scan( n, tiles );
+            return segments;
+        }
+
+    }
+}
+
+#endif
@@ -0,0 +1,190 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+//  The vectorized kernels of one level; simd_reduce.inl includes this file once per level, inside the region that
+//  compiles for the instructions of the level, with BOLT_BTBB_SIMD_NS naming the namespace of the level
+
+namespace bolt {
+    namespace btbb {
+        namespace detail {
+            namespace BOLT_BTBB_SIMD_NS {
+
+                //  The vector part of a reduction: how it takes in a vector of elements and how it combines two
+                //  accumulators
+                template< simd::op Op, typename V >
+                struct vector_op;
+
+                template< typename V >
+                struct vector_op< simd::sum, V >
+                {
+                    typedef typename V::reg reg;
+                    static reg first( reg x ) { return x; }
+                    static reg next( reg acc, reg x ) { return V::add( acc, x ); }
+                    static reg combine( reg a, reg b ) { return V::add( a, b ); }
+                };
+
+                template< typename V >
+                struct vector_op< simd::sum_of_squares, V >
+                {
+                    typedef typename V::reg reg;
+                    static reg first( reg x ) { return V::mul( x, x ); }
+                    static reg next( reg acc, reg x ) { return V::add( acc, V::mul( x, x ) ); }
+                    static reg combine( reg a, reg b ) { return V::add( a, b ); }
+                };
+
+                template< typename V >
+                struct vector_op< simd::minimum, V >
+                {
+                    typedef typename V::reg reg;
+                    static reg first( reg x ) { return x; }
+                    static reg next( reg acc, reg x ) { return V::min( acc, x ); }
+                    static reg combine( reg a, reg b ) { return V::min( a, b ); }
+                };
+
+                template< typename V >
+                struct vector_op< simd::maximum, V >
+                {
+                    typedef typename V::reg reg;
+                    static reg first( reg x ) { return x; }
+                    static reg next( reg acc, reg x ) { return V::max( acc, x ); }
+                    static reg combine( reg a, reg b ) { return V::max( a, b ); }
+                };
+
+                //  Reduces the n > 0 elements at p, without an initial value.  Four accumulators keep four
+                //  independent chains of additions in flight
+                template< simd::op Op, typename T >
+                T reduce( const T* p, size_t n )
+                {
+                    typedef vec< T > V;
+                    typedef vector_op< Op, V > VOp;
+                    typedef simd_op< Op, T > SOp;
+                    const size_t W = V::width;
+
+                    T result;
+                    size_t i = 0;
+                    if( n >= 4 * W )
+                    {
+                        typename V::reg a0 = VOp::first( V::load( p ) );
+                        typename V::reg a1 = VOp::first( V::load( p + W ) );
+                        typename V::reg a2 = VOp::first( V::load( p + 2 * W ) );
+                        typename V::reg a3 = VOp::first( V::load( p + 3 * W ) );
+                        for( i = 4 * W; i + 4 * W <= n; i += 4 * W )
+                        {
+                            a0 = VOp::next( a0, V::load( p + i ) );
+                            a1 = VOp::next( a1, V::load( p + i + W ) );
+                            a2 = VOp::next( a2, V::load( p + i + 2 * W ) );
+                            a3 = VOp::next( a3, V::load( p + i + 3 * W ) );
+                        }
+
+                        T lanes[ V::width ];
+                        V::store( lanes, VOp::combine( VOp::combine( a0, a1 ), VOp::combine( a2, a3 ) ) );
+                        result = lanes[ 0 ];
+                        for( size_t l = 1; l < W; ++l )
+                            result = SOp::combine( result, lanes[ l ] );
+                    }
+                    else
+                    {
+                        result = SOp::first( p[ 0 ] );
+                        i = 1;
+                    }
+
+                    for( ; i < n; ++i )
+                        result = SOp::next( result, p[ i ] );
+                    return result;
+                }
+
+                //  Counts the elements at p that equal value
+                template< typename T >
+                size_t count( const T* p, size_t n, T value )
+                {
+                    typedef vec< T > V;
+                    typedef typename V::count_lane count_lane;
+                    const size_t W = V::width;
+                    const size_t countLanes = sizeof( typename V::count_reg ) / sizeof( count_lane );
+                    const typename V::reg v = V::set1( value );
+
+                    size_t total = 0;
+                    size_t i = 0;
+                    while( n - i >= 4 * W )
+                    {
+                        const size_t block = ( n - i < simdCountBlock ) ? n - i : simdCountBlock;
+                        const size_t end = i + block / ( 4 * W ) * ( 4 * W );
+
+                        typename V::count_reg c0 = V::count_zero( );
+                        typename V::count_reg c1 = V::count_zero( );
+                        typename V::count_reg c2 = V::count_zero( );
+                        typename V::count_reg c3 = V::count_zero( );
+                        for( ; i < end; i += 4 * W )
+                        {
+                            c0 = V::count_eq( c0, V::load( p + i ), v );
+                            c1 = V::count_eq( c1, V::load( p + i + W ), v );
+                            c2 = V::count_eq( c2, V::load( p + i + 2 * W ), v );
+                            c3 = V::count_eq( c3, V::load( p + i + 3 * W ), v );
+                        }
+
+                        count_lane counts[ 4 * sizeof( typename V::count_reg ) / sizeof( count_lane ) ];
+                        V::count_store( counts, c0 );
+                        V::count_store( counts + countLanes, c1 );
+                        V::count_store( counts + 2 * countLanes, c2 );
+                        V::count_store( counts + 3 * countLanes, c3 );
+                        for( size_t l = 0; l < 4 * countLanes; ++l )
+                            total += static_cast< size_t >( counts[ l ] );
+                    }
+
+                    for( ; i < n; ++i )
+                    {
+                        if( p[ i ] == value )
+                            ++total;
+                    }
+                    return total;
+                }
+
+                //  Returns the index of the first of the n elements at p that equals value, or n
+                template< typename T >
+                size_t find( const T* p, size_t n, T value )
+                {
+                    typedef vec< T > V;
+                    const size_t W = V::width;
+                    const typename V::reg v = V::set1( value );
+
+                    size_t i = 0;
+                    for( ; i + W <= n; i += W )
+                    {
+                        int mask = V::match( V::load( p + i ), v );
+                        if( mask != 0 )
+                        {
+                            while( ( mask & 1 ) == 0 )
+                            {
+                                mask >>= 1;
+                                ++i;
+                            }
+                            return i;
+                        }
+                    }
+
+                    for( ; i < n; ++i )
+                    {
+                        if( p[ i ] == value )
+                            return i;
+                    }
+                    return n;
+                }
+
+            }
+        }
+    }
+}
@@ -0,0 +1,704 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_BTBB_SIMD_REDUCE_INL )
+#define BOLT_BTBB_SIMD_REDUCE_INL
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_reduce.h"
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __x86_64__ ) || defined( __i386__ )
+#define BOLT_BTBB_SIMD_X86 1
+#include <immintrin.h>
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#include <intrin.h>
+#endif
+//  Visual Studio knows the AVX-512 intrinsics from 2017 15.3 on
+#if !defined( _MSC_VER ) || defined( __clang__ ) || _MSC_VER >= 1911
+#define BOLT_BTBB_SIMD_AVX512 1
+#endif
+#endif
+
+namespace bolt {
+    namespace btbb {
+
+        namespace detail
+        {
+            //  Elements per TBB task; large enough to amortize the task, small enough to balance the cores
+            static const size_t simdGrainSize = 1 << 15;
+
+            //  The 32 bit lanes of a vector count at most one match per element they see; counting in blocks of
+            //  this many elements keeps them from overflowing
+            static const size_t simdCountBlock = 1 << 28;
+
+            inline simd::level detectSimdLevel( )
+            {
+#if defined( BOLT_BTBB_SIMD_X86 )
+#if defined( _MSC_VER ) && !defined( __clang__ )
+                int info[ 4 ];
+                __cpuid( info, 0 );
+                const int maxLeaf = info[ 0 ];
+                __cpuid( info, 1 );
+                if( ( info[ 3 ] & ( 1 << 26 ) ) == 0 )
+                    return simd::scalar;
+
+                //  The OS must save the AVX registers (XCR0 bits 1 and 2) and for AVX-512 also the mask and upper
+                //  registers (bits 5 to 7)
+                const bool osxsave = ( info[ 2 ] & ( 1 << 27 ) ) != 0 && ( info[ 2 ] & ( 1 << 28 ) ) != 0;
+                const unsigned long long xcr0 = osxsave ? _xgetbv( 0 ) : 0;
+                if( maxLeaf < 7 || ( xcr0 & 0x6 ) != 0x6 )
+                    return simd::sse2;
+
+                __cpuidex( info, 7, 0 );
+                if( ( info[ 1 ] & ( 1 << 5 ) ) == 0 )
+                    return simd::sse2;
+#if defined( BOLT_BTBB_SIMD_AVX512 )
+                if( ( info[ 1 ] & ( 1 << 16 ) ) != 0 && ( xcr0 & 0xe6 ) == 0xe6 )
+                    return simd::avx512;
+#endif
+                return simd::avx2;
+#else
+                __builtin_cpu_init( );
+#if defined( BOLT_BTBB_SIMD_AVX512 )
+                if( __builtin_cpu_supports( "avx512f" ) )
+                    return simd::avx512;
+#endif
+                if( __builtin_cpu_supports( "avx2" ) )
+                    return simd::avx2;
+                if( __builtin_cpu_supports( "sse2" ) )
+                    return simd::sse2;
+                return simd::scalar;
+#endif
+#else
+                return simd::scalar;
+#endif
+            }
+
+            inline std::atomic< int >& simdLevel( )
+            {
+                static std::atomic< int > level( simd::supportedLevel( ) );
+                return level;
+            }
+
+            //  The scalar part of a reduction: its identity, how it takes in an element and how it combines
+            //  partial results
+            template< simd::op Op, typename T >
+            struct simd_op;
+
+            template< typename T >
+            struct simd_op< simd::sum, T >
+            {
+                static T identity( ) { return T( 0 ); }
+                static T first( T x ) { return x; }
+                static T next( T acc, T x ) { return acc + x; }
+                static T combine( T a, T b ) { return a + b; }
+            };
+
+            template< typename T >
+            struct simd_op< simd::sum_of_squares, T >
+            {
+                static T identity( ) { return T( 0 ); }
+                static T first( T x ) { return x * x; }
+                static T next( T acc, T x ) { return acc + x * x; }
+                static T combine( T a, T b ) { return a + b; }
+            };
+
+            template< typename T >
+            struct simd_op< simd::minimum, T >
+            {
+                static T identity( ) { return std::numeric_limits< T >::max( ); }
+                static T first( T x ) { return x; }
+                static T next( T acc, T x ) { return ( x < acc ) ? x : acc; }
+                static T combine( T a, T b ) { return ( b < a ) ? b : a; }
+                static bool before( T a, T b ) { return a < b; }
+            };
+
+            template< typename T >
+            struct simd_op< simd::maximum, T >
+            {
+                static T identity( ) { return std::numeric_limits< T >::min( ); }
+                static T first( T x ) { return x; }
+                static T next( T acc, T x ) { return ( acc < x ) ? x : acc; }
+                static T combine( T a, T b ) { return ( a < b ) ? b : a; }
+                static bool before( T a, T b ) { return b < a; }
+            };
+        }
+
+        namespace simd
+        {
+            inline level supportedLevel( )
+            {
+                static const level supported = detail::detectSimdLevel( );
+                return supported;
+            }
+
+            inline level getLevel( )
+            {
+                return static_cast< level >( detail::simdLevel( ).load( std::memory_order_relaxed ) );
+            }
+
+            inline void setLevel( level l )
+            {
+                detail::simdLevel( ).store( std::min( l, supportedLevel( ) ), std::memory_order_relaxed );
+            }
+        }
+
+    }
+}
+
+#if defined( BOLT_BTBB_SIMD_X86 )
+
+//  The kernels of every level are compiled for the instructions of that level only, whatever the flags of the
+//  build; they run only on processors that have them.  The standard headers must be included above this point.
+#if defined( __clang__ )
+#pragma clang attribute push( __attribute__( ( target( "sse2" ) ) ), apply_to = function )
+#elif defined( __GNUC__ )
+#pragma GCC push_options
+#pragma GCC target( "sse2" )
+#endif
+
+namespace bolt {
+    namespace btbb {
+        namespace detail {
+            namespace sse2 {
+
+                template< typename T >
+                struct vec;
+
+                template< >
+                struct vec< float >
+                {
+                    typedef __m128 reg;
+                    typedef __m128i count_reg;
+                    typedef int count_lane;
+                    static const size_t width = 4;
+
+                    static reg load( const float* p ) { return _mm_loadu_ps( p ); }
+                    static void store( float* p, reg a ) { _mm_storeu_ps( p, a ); }
+                    static reg set1( float x ) { return _mm_set1_ps( x ); }
+                    static reg add( reg a, reg b ) { return _mm_add_ps( a, b ); }
+                    static reg mul( reg a, reg b ) { return _mm_mul_ps( a, b ); }
+
+                    //  Equal lanes compare to all ones, i.e. -1, so subtracting the comparison counts them
+                    static count_reg count_zero( ) { return _mm_setzero_si128( ); }
+                    static count_reg count_eq( count_reg c, reg a, reg b )
+                    {
+                        return _mm_sub_epi32( c, _mm_castps_si128( _mm_cmpeq_ps( a, b ) ) );
+                    }
+                    static void count_store( count_lane* p, count_reg c ) { _mm_storeu_si128( ( __m128i* )p, c ); }
+                };
+
+                template< >
+                struct vec< double >
+                {
+                    typedef __m128d reg;
+                    typedef __m128i count_reg;
+                    typedef long long count_lane;
+                    static const size_t width = 2;
+
+                    static reg load( const double* p ) { return _mm_loadu_pd( p ); }
+                    static void store( double* p, reg a ) { _mm_storeu_pd( p, a ); }
+                    static reg set1( double x ) { return _mm_set1_pd( x ); }
+                    static reg add( reg a, reg b ) { return _mm_add_pd( a, b ); }
+                    static reg mul( reg a, reg b ) { return _mm_mul_pd( a, b ); }
+
+                    static count_reg count_zero( ) { return _mm_setzero_si128( ); }
+                    static count_reg count_eq( count_reg c, reg a, reg b )
+                    {
+                        return _mm_sub_epi64( c, _mm_castpd_si128( _mm_cmpeq_pd( a, b ) ) );
+                    }
+                    static void count_store( count_lane* p, count_reg c ) { _mm_storeu_si128( ( __m128i* )p, c ); }
+                };
+
+                template< typename T >
+                struct vec_i32
+                {
+                    typedef __m128i reg;
+                    typedef __m128i count_reg;
+                    typedef int count_lane;
+                    static const size_t width = 4;
+
+                    static reg load( const T* p ) { return _mm_loadu_si128( ( const __m128i* )p ); }
+                    static void store( T* p, reg a ) { _mm_storeu_si128( ( __m128i* )p, a ); }
+                    static reg set1( T x ) { return _mm_set1_epi32( static_cast< int >( x ) ); }
+                    static reg add( reg a, reg b ) { return _mm_add_epi32( a, b ); }
+
+                    //  SSE2 has no 32 bit minimum or maximum; the lanes are selected with a comparison mask
+                    static reg select( reg mask, reg a, reg b )
+                    {
+                        return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+                    }
+
+                    static count_reg count_zero( ) { return _mm_setzero_si128( ); }
+                    static count_reg count_eq( count_reg c, reg a, reg b )
+                    {
+                        return _mm_sub_epi32( c, _mm_cmpeq_epi32( a, b ) );
+                    }
+                    static void count_store( count_lane* p, count_reg c ) { _mm_storeu_si128( ( __m128i* )p, c ); }
+
+                    //  One bit per lane, set where a and b are equal
+                    static int match( reg a, reg b )
+                    {
+                        return _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( a, b ) ) );
+                    }
+                };
+
+                template< >
+                struct vec< int >: vec_i32< int >
+                {
+                    static reg min( reg a, reg b ) { return select( _mm_cmpgt_epi32( a, b ), b, a ); }
+                    static reg max( reg a, reg b ) { return select( _mm_cmpgt_epi32( a, b ), a, b ); }
+                };
+
+                //  Flipping the sign bits orders unsigned lanes like the signed comparison does
+                template< >
+                struct vec< unsigned int >: vec_i32< unsigned int >
+                {
+                    static reg greater( reg a, reg b )
+                    {
+                        const reg bias = _mm_set1_epi32( static_cast< int >( 0x80000000u ) );
+                        return _mm_cmpgt_epi32( _mm_xor_si128( a, bias ), _mm_xor_si128( b, bias ) );
+                    }
+                    static reg min( reg a, reg b ) { return select( greater( a, b ), b, a ); }
+                    static reg max( reg a, reg b ) { return select( greater( a, b ), a, b ); }
+                };
+
+            }
+        }
+    }
+}
+
+#define BOLT_BTBB_SIMD_NS sse2
+#include "bolt/btbb/detail/simd_kernels.inl"
+#undef BOLT_BTBB_SIMD_NS
+
+#if defined( __clang__ )
+#pragma clang attribute pop
+#elif defined( __GNUC__ )
+#pragma GCC pop_options
+#endif
+
+#if defined( __clang__ )
+#pragma clang attribute push( __attribute__( ( target( "avx2" ) ) ), apply_to = function )
+#elif defined( __GNUC__ )
+#pragma GCC push_options
+#pragma GCC target( "avx2" )
+#endif
+
+namespace bolt {
+    namespace btbb {
+        namespace detail {
+            namespace avx2 {
+
+                template< typename T >
+                struct vec;
+
+                template< >
+                struct vec< float >
+                {
+                    typedef __m256 reg;
+                    typedef __m256i count_reg;
+                    typedef int count_lane;
+                    static const size_t width = 8;
+
+                    static reg load( const float* p ) { return _mm256_loadu_ps( p ); }
+                    static void store( float* p, reg a ) { _mm256_storeu_ps( p, a ); }
+                    static reg set1( float x ) { return _mm256_set1_ps( x ); }
+                    static reg add( reg a, reg b ) { return _mm256_add_ps( a, b ); }
+                    static reg mul( reg a, reg b ) { return _mm256_mul_ps( a, b ); }
+
+                    static count_reg count_zero( ) { return _mm256_setzero_si256( ); }
+                    static count_reg count_eq( count_reg c, reg a, reg b )
+                    {
+                        return _mm256_sub_epi32( c, _mm256_castps_si256( _mm256_cmp_ps( a, b, _CMP_EQ_OQ ) ) );
+                    }
+                    static void count_store( count_lane* p, count_reg c ) { _mm256_storeu_si256( ( __m256i* )p, c ); }
+                };
+
+                template< >
+                struct vec< double >
+                {
+                    typedef __m256d reg;
+                    typedef __m256i count_reg;
+                    typedef long long count_lane;
+                    static const size_t width = 4;
+
+                    static reg load( const double* p ) { return _mm256_loadu_pd( p ); }
+                    static void store( double* p, reg a ) { _mm256_storeu_pd( p, a ); }
+                    static reg set1( double x ) { return _mm256_set1_pd( x ); }
+                    static reg add( reg a, reg b ) { return _mm256_add_pd( a, b ); }
+                    static reg mul( reg a, reg b ) { return _mm256_mul_pd( a, b ); }
+
+                    static count_reg count_zero( ) { return _mm256_setzero_si256( ); }
+                    static count_reg count_eq( count_reg c, reg a, reg b )
+                    {
+                        return _mm256_sub_epi64( c, _mm256_castpd_si256( _mm256_cmp_pd( a, b, _CMP_EQ_OQ ) ) );
+                    }
+                    static void count_store( count_lane* p, count_reg c ) { _mm256_storeu_si256( ( __m256i* )p, c ); }
+                };
+
+                template< typename T >
+                struct vec_i32
+                {
+                    typedef __m256i reg;
+                    typedef __m256i count_reg;
+                    typedef int count_lane;
+                    static const size_t width = 8;
+
+                    static reg load( const T* p ) { return _mm256_loadu_si256( ( const __m256i* )p ); }
+                    static void store( T* p, reg a ) { _mm256_storeu_si256( ( __m256i* )p, a ); }
+                    static reg set1( T x ) { return _mm256_set1_epi32( static_cast< int >( x ) ); }
+                    static reg add( reg a, reg b ) { return _mm256_add_epi32( a, b ); }
+
+                    static count_reg count_zero( ) { return _mm256_setzero_si256( ); }
+                    static count_reg count_eq( count_reg c, reg a, reg b )
+                    {
+                        return _mm256_sub_epi32( c, _mm256_cmpeq_epi32( a, b ) );
+                    }
+                    static void count_store( count_lane* p, count_reg c ) { _mm256_storeu_si256( ( __m256i* )p, c ); }
+
+                    static int match( reg a, reg b )
+                    {
+                        return _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpeq_epi32( a, b ) ) );
+                    }
+                };
+
+                template< >
+                struct vec< int >: vec_i32< int >
+                {
+                    static reg min( reg a, reg b ) { return _mm256_min_epi32( a, b ); }
+                    static reg max( reg a, reg b ) { return _mm256_max_epi32( a, b ); }
+                };
+
+                template< >
+                struct vec< unsigned int >: vec_i32< unsigned int >
+                {
+                    static reg min( reg a, reg b ) { return _mm256_min_epu32( a, b ); }
+                    static reg max( reg a, reg b ) { return _mm256_max_epu32( a, b ); }
+                };
+
+            }
+        }
+    }
+}
+
+#define BOLT_BTBB_SIMD_NS avx2
+#include "bolt/btbb/detail/simd_kernels.inl"
+#undef BOLT_BTBB_SIMD_NS
+
+#if defined( __clang__ )
+#pragma clang attribute pop
+#elif defined( __GNUC__ )
+#pragma GCC pop_options
+#endif
+
+#if defined( BOLT_BTBB_SIMD_AVX512 )
+
+#if defined( __clang__ )
+#pragma clang attribute push( __attribute__( ( target( "avx512f" ) ) ), apply_to = function )
+#elif defined( __GNUC__ )
+#pragma GCC push_options
+#pragma GCC target( "avx512f" )
+#endif
+
+namespace bolt {
+    namespace btbb {
+        namespace detail {
+            namespace avx512 {
+
+                template< typename T >
+                struct vec;
+
+                //  AVX-512 compares into mask registers; the counts add one under the mask
+                template< >
+                struct vec< float >
+                {
+                    typedef __m512 reg;
+                    typedef __m512i count_reg;
+                    typedef int count_lane;
+                    static const size_t width = 16;
+
+                    static reg load( const float* p ) { return _mm512_loadu_ps( p ); }
+                    static void store( float* p, reg a ) { _mm512_storeu_ps( p, a ); }
+                    static reg set1( float x ) { return _mm512_set1_ps( x ); }
+                    static reg add( reg a, reg b ) { return _mm512_add_ps( a, b ); }
+                    static reg mul( reg a, reg b ) { return _mm512_mul_ps( a, b ); }
+
+                    static count_reg count_zero( ) { return _mm512_setzero_si512( ); }
+                    static count_reg count_eq( count_reg c, reg a, reg b )
+                    {
+                        return _mm512_mask_add_epi32( c, _mm512_cmp_ps_mask( a, b, _CMP_EQ_OQ ), c,
+                                                      _mm512_set1_epi32( 1 ) );
+                    }
+                    static void count_store( count_lane* p, count_reg c ) { _mm512_storeu_si512( p, c ); }
+                };
+
+                template< >
+                struct vec< double >
+                {
+                    typedef __m512d reg;
+                    typedef __m512i count_reg;
+                    typedef long long count_lane;
+                    static const size_t width = 8;
+
+                    static reg load( const double* p ) { return _mm512_loadu_pd( p ); }
+                    static void store( double* p, reg a ) { _mm512_storeu_pd( p, a ); }
+                    static reg set1( double x ) { return _mm512_set1_pd( x ); }
+                    static reg add( reg a, reg b ) { return _mm512_add_pd( a, b ); }
+                    static reg mul( reg a, reg b ) { return _mm512_mul_pd( a, b ); }
+
+                    static count_reg count_zero( ) { return _mm512_setzero_si512( ); }
+                    static count_reg count_eq( count_reg c, reg a, reg b )
+                    {
+                        return _mm512_mask_add_epi64( c, _mm512_cmp_pd_mask( a, b, _CMP_EQ_OQ ), c,
+                                                      _mm512_set1_epi64( 1 ) );
+                    }
+                    static void count_store( count_lane* p, count_reg c ) { _mm512_storeu_si512( p, c ); }
+                };
+
+                template< typename T >
+                struct vec_i32
+                {
+                    typedef __m512i reg;
+                    typedef __m512i count_reg;
+                    typedef int count_lane;
+                    static const size_t width = 16;
+
+                    static reg load( const T* p ) { return _mm512_loadu_si512( p ); }
+                    static void store( T* p, reg a ) { _mm512_storeu_si512( p, a ); }
+                    static reg set1( T x ) { return _mm512_set1_epi32( static_cast< int >( x ) ); }
+                    static reg add( reg a, reg b ) { return _mm512_add_epi32( a, b ); }
+
+                    static count_reg count_zero( ) { return _mm512_setzero_si512( ); }
+                    static count_reg count_eq( count_reg c, reg a, reg b )
+                    {
+                        return _mm512_mask_add_epi32( c, _mm512_cmpeq_epi32_mask( a, b ), c, _mm512_set1_epi32( 1 ) );
+                    }
+                    static void count_store( count_lane* p, count_reg c ) { _mm512_storeu_si512( p, c ); }
+
+                    static int match( reg a, reg b ) { return static_cast< int >( _mm512_cmpeq_epi32_mask( a, b ) ); }
+                };
+
+                template< >
+                struct vec< int >: vec_i32< int >
+                {
+                    static reg min( reg a, reg b ) { return _mm512_min_epi32( a, b ); }
+                    static reg max( reg a, reg b ) { return _mm512_max_epi32( a, b ); }
+                };
+
+                template< >
+                struct vec< unsigned int >: vec_i32< unsigned int >
+                {
+                    static reg min( reg a, reg b ) { return _mm512_min_epu32( a, b ); }
+                    static reg max( reg a, reg b ) { return _mm512_max_epu32( a, b ); }
+                };
+
+            }
+        }
+    }
+}
+
+#define BOLT_BTBB_SIMD_NS avx512
+#include "bolt/btbb/detail/simd_kernels.inl"
+#undef BOLT_BTBB_SIMD_NS
+
+#if defined( __clang__ )
+#pragma clang attribute pop
+#elif defined( __GNUC__ )
+#pragma GCC pop_options
+#endif
+
+#endif // BOLT_BTBB_SIMD_AVX512
+
+#endif // BOLT_BTBB_SIMD_X86
+
+namespace bolt {
+    namespace btbb {
+
+        namespace detail
+        {
+            //  Reduces the n > 0 elements at p with the kernels of the current level
+            template< simd::op Op, typename T >
+            T simdReduceSlice( const T* p, size_t n )
+            {
+                switch( simd::getLevel( ) )
+                {
+#if defined( BOLT_BTBB_SIMD_AVX512 )
+                case simd::avx512:
+                    return avx512::reduce< Op >( p, n );
+#endif
+#if defined( BOLT_BTBB_SIMD_X86 )
+                case simd::avx2:
+                    return avx2::reduce< Op >( p, n );
+                case simd::sse2:
+                    return sse2::reduce< Op >( p, n );
+#endif
+                default:
+                    {
+                        T result = simd_op< Op, T >::first( p[ 0 ] );
+                        for( size_t i = 1; i < n; ++i )
+                            result = simd_op< Op, T >::next( result, p[ i ] );
+                        return result;
+                    }
+                }
+            }
+
+            template< typename T >
+            size_t simdCountSlice( const T* p, size_t n, T value )
+            {
+                switch( simd::getLevel( ) )
+                {
+#if defined( BOLT_BTBB_SIMD_AVX512 )
+                case simd::avx512:
+                    return avx512::count( p, n, value );
+#endif
+#if defined( BOLT_BTBB_SIMD_X86 )
+                case simd::avx2:
+                    return avx2::count( p, n, value );
+                case simd::sse2:
+                    return sse2::count( p, n, value );
+#endif
+                default:
+                    return static_cast< size_t >( std::count( p, p + n, value ) );
+                }
+            }
+
+            template< typename T >
+            size_t simdFindSlice( const T* p, size_t n, T value )
+            {
+                switch( simd::getLevel( ) )
+                {
+#if defined( BOLT_BTBB_SIMD_AVX512 )
+                case simd::avx512:
+                    return avx512::find( p, n, value );
+#endif
+#if defined( BOLT_BTBB_SIMD_X86 )
+                case simd::avx2:
+                    return avx2::find( p, n, value );
+                case simd::sse2:
+                    return sse2::find( p, n, value );
+#endif
+                default:
+                    return static_cast< size_t >( std::find( p, p + n, value ) - p );
+                }
+            }
+
+            //  Every slice finds its extremum and the first position of it; of two slices, the one with the
+            //  extremum that comes first in the order of Op wins, and the earlier one on ties
+            template< simd::op Op, typename T >
+            const T* simdExtremum( const T* first, const T* last )
+            {
+                typedef simd_op< Op, T > SOp;
+                const size_t none = std::numeric_limits< size_t >::max( );
+                const size_t n = static_cast< size_t >( last - first );
+                if( n == 0 )
+                    return last;
+
+                auto better = [ = ]( size_t a, size_t b ) -> size_t
+                {
+                    if( a == none || b == none )
+                        return ( a == none ) ? b : a;
+                    if( SOp::before( first[ b ], first[ a ] ) )
+                        return b;
+                    if( SOp::before( first[ a ], first[ b ] ) )
+                        return a;
+                    return std::min( a, b );
+                };
+
+                size_t found = none;
+                bolt::btbb::arena::getInstance( ).execute( [ & ]( )
+                {
+                    found = tbb::parallel_reduce( tbb::blocked_range< size_t >( 0, n, simdGrainSize ), none,
+                        [ = ]( const tbb::blocked_range< size_t >& r, size_t acc ) -> size_t
+                        {
+                            const T* p = first + r.begin( );
+                            const T extremum = simdReduceSlice< Op >( p, r.size( ) );
+                            return better( acc, r.begin( ) + simdFindSlice( p, r.size( ), extremum ) );
+                        },
+                        better );
+                } );
+                return first + found;
+            }
+        }
+
+        template< simd::op Op, typename T >
+        T simd_reduce( const T* first, const T* last, T init )
+        {
+            typedef detail::simd_op< Op, T > SOp;
+            const size_t n = static_cast< size_t >( last - first );
+
+            T result = SOp::identity( );
+            bolt::btbb::arena::getInstance( ).execute( [ & ]( )
+            {
+                result = tbb::parallel_reduce( tbb::blocked_range< size_t >( 0, n, detail::simdGrainSize ),
+                    SOp::identity( ),
+                    [ = ]( const tbb::blocked_range< size_t >& r, T acc ) -> T
+                    {
+                        return SOp::combine( acc, detail::simdReduceSlice< Op >( first + r.begin( ), r.size( ) ) );
+                    },
+                    []( T a, T b ) -> T
+                    {
+                        return SOp::combine( a, b );
+                    } );
+            } );
+            return SOp::combine( init, result );
+        }
+
+        template< typename T >
+        std::ptrdiff_t simd_count( const T* first, const T* last, T value )
+        {
+            const size_t n = static_cast< size_t >( last - first );
+
+            size_t result = 0;
+            bolt::btbb::arena::getInstance( ).execute( [ & ]( )
+            {
+                result = tbb::parallel_reduce( tbb::blocked_range< size_t >( 0, n, detail::simdGrainSize ),
+                    size_t( 0 ),
+                    [ = ]( const tbb::blocked_range< size_t >& r, size_t acc ) -> size_t
+                    {
+                        return acc + detail::simdCountSlice( first + r.begin( ), r.size( ), value );
+                    },
+                    []( size_t a, size_t b ) -> size_t
+                    {
+                        return a + b;
+                    } );
+            } );
+            return static_cast< std::ptrdiff_t >( result );
+        }
+
+        template< typename T >
+        const T* simd_min_element( const T* first, const T* last )
+        {
+            return detail::simdExtremum< simd::minimum >( first, last );
+        }
+
+        template< typename T >
+        const T* simd_max_element( const T* first, const T* last )
+        {
+            return detail::simdExtremum< simd::maximum >( first, last );
+        }
+
+    }
+}
+
+#endif //BOLT_BTBB_SIMD_REDUCE_INL
@@ -29,8 +29,10 @@ namespace bolt {
             RandomAccessIterator last)
         {
 
-        tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-        tbb::parallel_sort(first,last);
+        bolt::btbb::arena::getInstance( ).execute( [&]( )
+        {
+            tbb::parallel_sort(first,last);
+        } );
         }
 
         template<typename RandomAccessIterator, typename StrictWeakOrdering>
@@ -39,8 +41,10 @@ namespace bolt {
             StrictWeakOrdering comp)
         {
 
-        tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-        tbb::parallel_sort(first,last, comp);
+        bolt::btbb::arena::getInstance( ).execute( [&]( )
+        {
+            tbb::parallel_sort(first,last, comp);
+        } );
 
         }
 
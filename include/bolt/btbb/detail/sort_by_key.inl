@@ -19,11 +19,18 @@
 #define BOLT_BTBB_SORT_BY_KEY_INL
 #pragma once
 
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/arena.h"
 //#include <thread>
+#include <atomic>
 #include <iterator>
 
+#include <functional>
+#include <type_traits>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_array.hpp>
+
 #include "bolt/btbb/sort.h"
+#include "bolt/btbb/radix_sort.h"
 #include "tbb/blocked_range.h"
 #include "tbb/parallel_for.h"
 
@@ -52,94 +59,171 @@ namespace bolt{
                      }
               };
 
-              template< typename RandomAccessIterator1, typename RandomAccessIterator2>
-              void Parallel_sort_by_key(const RandomAccessIterator1 keys_first, const RandomAccessIterator1 keys_last, 
-                                      const RandomAccessIterator2 values_first)
+              namespace detail
               {
-                     typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type keyType;
-                     typedef typename std::iterator_traits< RandomAccessIterator2 >::value_type valType;
-                     typedef tbb_sort<keyType, valType> KeyValuePair;
-       
-                     size_t vecSize = std::distance( keys_first, keys_last ); 
-                     std::vector<KeyValuePair> KeyValuePairVector(vecSize);
-
-                     //Zip the key and values iterators into a tbb_sort vector.
-                     tbb::parallel_for(  tbb::blocked_range<int>(0, (int) vecSize) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
-                     {
-                              
-                              for(int i = r.begin(); i!=r.end(); i++)
-                              {
-                                 
-                                   KeyValuePairVector[i].key   = *(keys_first + i);
-                                   KeyValuePairVector[i].value = *(values_first + i);
-                              }   
-                          
-                     });
-
-                     //Sort the tbb_sort vector using TBB sort
-                     bolt::btbb::sort(KeyValuePairVector.begin(), KeyValuePairVector.end());
-
-                     //Extract the keys and values from the KeyValuePair and fill the respective iterators. 
-                     tbb::parallel_for(  tbb::blocked_range<int>(0, (int) vecSize) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
-                     {
-                              
-                              for(int i = r.begin(); i!=r.end(); i++)
+                  //  Read and written by any thread; a sort reads it once, when it picks its strategy
+                  inline std::atomic< size_t >& sortByKeyMemoryLimit( )
+                  {
+                      static std::atomic< size_t > limit( 0 );
+                      return limit;
+                  }
+
+                  //  Temporary bytes of an optional buffer; the limit applies when it is not 0
+                  inline bool fitsSortByKeyMemoryLimit( size_t bytes, size_t limit )
+                  {
+                      return limit == 0 || bytes <= limit;
+                  }
+
+                  /*! \brief Sorts ( key, index ) pairs, then writes the keys back and applies the sorted indices to
+                  *   the values: through one gather buffer when it fits into the memory limit, in place otherwise.
+                  */
+                  template< typename Index, typename RandomAccessIterator1, typename RandomAccessIterator2,
+                            typename StrictWeakOrdering >
+                  void permutation_sort_by_key( RandomAccessIterator1 keys_first, size_t n,
+                                                RandomAccessIterator2 values_first, StrictWeakOrdering comp,
+                                                size_t limit )
+                  {
+                      typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type keyType;
+                      typedef typename std::iterator_traits< RandomAccessIterator2 >::value_type valType;
+                      typedef tbb_sort< keyType, Index > KeyIndexPair;
+
+                      boost::scoped_array< KeyIndexPair > pairs( new KeyIndexPair[ n ] );
+                      KeyIndexPair* sorted = pairs.get( );
+
+                      tbb::parallel_for( tbb::blocked_range< size_t >( 0, n ),
+                          [&]( const tbb::blocked_range< size_t >& r )
+                      {
+                          for( size_t i = r.begin( ); i != r.end( ); ++i )
+                          {
+                              sorted[ i ].key = keys_first[ i ];
+                              sorted[ i ].value = static_cast< Index >( i );
+                          }
+                      } );
+
+                      tbb::parallel_sort( sorted, sorted + n, tbb_sort_comp< keyType, Index, StrictWeakOrdering >( comp ) );
+
+                      tbb::parallel_for( tbb::blocked_range< size_t >( 0, n ),
+                          [&]( const tbb::blocked_range< size_t >& r )
+                      {
+                          for( size_t i = r.begin( ); i != r.end( ); ++i )
+                              keys_first[ i ] = sorted[ i ].key;
+                      } );
+
+                      //  The pairs are the working set of this sort, so only the gather buffer counts against the limit
+                      if( fitsSortByKeyMemoryLimit( n * sizeof( valType ), limit ) )
+                      {
+                          boost::scoped_array< valType > gathered( new valType[ n ] );
+                          valType* values = gathered.get( );
+
+                          tbb::parallel_for( tbb::blocked_range< size_t >( 0, n ),
+                              [&]( const tbb::blocked_range< size_t >& r )
+                          {
+                              for( size_t i = r.begin( ); i != r.end( ); ++i )
+                                  values[ i ] = values_first[ sorted[ i ].value ];
+                          } );
+
+                          tbb::parallel_for( tbb::blocked_range< size_t >( 0, n ),
+                              [&]( const tbb::blocked_range< size_t >& r )
+                          {
+                              for( size_t i = r.begin( ); i != r.end( ); ++i )
+                                  values_first[ i ] = values[ i ];
+                          } );
+                      }
+                      else
+                      {
+                          //  Follow each cycle of the permutation; an index is reset to its own position once the
+                          //  value in that position is final.  This is serial, O( n ) moves with no extra memory
+                          for( size_t i = 0; i < n; ++i )
+                          {
+                              if( sorted[ i ].value == i )
+                                  continue;
+
+                              valType first = values_first[ i ];
+                              size_t j = i;
+                              for( ;; )
                               {
-                                 
-                                   *(keys_first + i)   = KeyValuePairVector[i].key;
-                                   *(values_first + i) = KeyValuePairVector[i].value;
-                              }   
-                          
-                     });
+                                  size_t k = sorted[ j ].value;
+                                  sorted[ j ].value = static_cast< Index >( j );
+                                  if( k == i )
+                                  {
+                                      values_first[ j ] = first;
+                                      break;
+                                  }
+                                  values_first[ j ] = values_first[ k ];
+                                  j = k;
+                              }
+                          }
+                      }
+                  }
+
+                  template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename StrictWeakOrdering >
+                  void permutation_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last,
+                                                RandomAccessIterator2 values_first, StrictWeakOrdering comp,
+                                                size_t limit )
+                  {
+                      size_t n = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+                      if( n <= 0xFFFFFFFFu )
+                          permutation_sort_by_key< boost::uint32_t >( keys_first, n, values_first, comp, limit );
+                      else
+                          permutation_sort_by_key< size_t >( keys_first, n, values_first, comp, limit );
+                  }
+
+                  template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename StrictWeakOrdering >
+                  void pick_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last,
+                                         RandomAccessIterator2 values_first, StrictWeakOrdering comp,
+                                         std::integral_constant< int, 0 > )
+                  {
+                      permutation_sort_by_key( keys_first, keys_last, values_first, comp,
+                                               sortByKeyMemoryLimit( ).load( std::memory_order_relaxed ) );
+                  }
+
+                  //  Radix sortable keys in ascending ( 1 ) or descending ( 2 ) order
+                  template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename StrictWeakOrdering,
+                            int Order >
+                  void pick_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last,
+                                         RandomAccessIterator2 values_first, StrictWeakOrdering comp,
+                                         std::integral_constant< int, Order > )
+                  {
+                      typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type keyType;
+                      typedef typename std::iterator_traits< RandomAccessIterator2 >::value_type valType;
+
+                      size_t n = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+                      const size_t limit = sortByKeyMemoryLimit( ).load( std::memory_order_relaxed );
+                      if( fitsSortByKeyMemoryLimit( n * ( sizeof( keyType ) + sizeof( valType ) ), limit ) )
+                          bolt::btbb::detail::radix_sort_by_key< Order == 2 >( keys_first, keys_last, values_first );
+                      else
+                          permutation_sort_by_key( keys_first, keys_last, values_first, comp, limit );
+                  }
               }
 
+              inline void setSortByKeyMemoryLimit( size_t bytes )
+              {
+                  detail::sortByKeyMemoryLimit( ).store( bytes, std::memory_order_relaxed );
+              }
+
+              inline size_t getSortByKeyMemoryLimit( )
+              {
+                  return detail::sortByKeyMemoryLimit( ).load( std::memory_order_relaxed );
+              }
+
+              //Sorts the keys and values in place in their own arrays; see setSortByKeyMemoryLimit
               template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename StrictWeakOrdering >
-              void Parallel_sort_by_key_comp(const RandomAccessIterator1 keys_first, const RandomAccessIterator1 keys_last, 
+              void Parallel_sort_by_key_comp(const RandomAccessIterator1 keys_first, const RandomAccessIterator1 keys_last,
                                       const RandomAccessIterator2 values_first, StrictWeakOrdering comp )
               {
                      typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type keyType;
-                     typedef typename std::iterator_traits< RandomAccessIterator2 >::value_type valType;
-                     typedef tbb_sort<keyType, valType> KeyValuePair;
-                     typedef tbb_sort_comp<keyType, valType, StrictWeakOrdering> KeyValuePairFunctor;
-       
-                     size_t vecSize = std::distance( keys_first, keys_last ); 
-                     std::vector<KeyValuePair> KeyValuePairVector(vecSize);
-                     KeyValuePairFunctor functor(comp);
-
-                     //Zip the key and values iterators into a tbb_sort vector.
-                     tbb::parallel_for(  tbb::blocked_range<int>(0, (int) vecSize) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
-                     {
-                              
-                              for(int i = r.begin(); i!=r.end(); i++)
-                              {
-                                 
-                                   KeyValuePairVector[i].key   = *(keys_first + i);
-                                   KeyValuePairVector[i].value = *(values_first + i);
-                              }   
-                          
-                     });
-
-                     //Sort the tbb_sort vector using TBB sort
-                     bolt::btbb::sort(KeyValuePairVector.begin(), KeyValuePairVector.end(), functor);
-
-                     //Extract the keys and values from the KeyValuePair and fill the respective iterators.
-                     tbb::parallel_for(  tbb::blocked_range<int>(0, (int) vecSize) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
-                     {
-                              
-                              for(int i = r.begin(); i!=r.end(); i++)
-                              {
-                                 
-                                   *(keys_first + i)   = KeyValuePairVector[i].key;
-                                   *(values_first + i) = KeyValuePairVector[i].value;
-                              }   
-                          
-                     });
+                     detail::pick_sort_by_key( keys_first, keys_last, values_first, comp,
+                         std::integral_constant< int, radix_sort_order< keyType, StrictWeakOrdering >::value >( ) );
              }
 
+              template< typename RandomAccessIterator1, typename RandomAccessIterator2 >
+              void Parallel_sort_by_key(const RandomAccessIterator1 keys_first, const RandomAccessIterator1 keys_last,
+                                      const RandomAccessIterator2 values_first)
+              {
+                     typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type keyType;
+                     Parallel_sort_by_key_comp( keys_first, keys_last, values_first, std::less< keyType >( ) );
+              }
+
              template< typename RandomAccessIterator1, typename RandomAccessIterator2 > 
              struct SortByKey
              {
@@ -148,7 +232,7 @@ namespace bolt{
 
                void operator() ( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last, RandomAccessIterator2 values_first)
                {
-                    int n = (int) std::distance(keys_first, keys_last);
+                    size_t n = static_cast< size_t >( std::distance(keys_first, keys_last) );
 
                     if(n == 1)  // Only one element
                          return; // Nothing to Sort!
@@ -167,7 +251,7 @@ namespace bolt{
 
                void operator() (RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last, RandomAccessIterator2 values_first, StrictWeakOrdering comp )
                {
-                    int n = (int) std::distance(keys_first, keys_last);
+                    size_t n = static_cast< size_t >( std::distance(keys_first, keys_last) );
 
                     if(n == 1)  // Only one element
                          return; // Nothing to Sort!
@@ -182,34 +266,22 @@ namespace bolt{
            void sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last, 
            RandomAccessIterator2 values_first)
            {
-                //Gets the number of concurrent threads supported by the underlying platform
-                //unsigned int concurentThreadsSupported = std::thread::hardware_concurrency();
-
-                //This allows TBB to choose the number of threads to spawn.
-                tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-
-                //Explicitly setting the number of threads to spawn
-                //tbb::task_scheduler_init((int) concurentThreadsSupported);
-
                 SortByKey <RandomAccessIterator1, RandomAccessIterator2 > sort_by_key_op;
-                sort_by_key_op(keys_first, keys_last, values_first);
+                bolt::btbb::arena::getInstance( ).execute( [&]( )
+                {
+                    sort_by_key_op(keys_first, keys_last, values_first);
+                } );
            }
 
            template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename StrictWeakOrdering> 
            void sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last, RandomAccessIterator2 values_first, 
            StrictWeakOrdering comp)
            {
-                //Gets the number of concurrent threads supported by the underlying platform
-                //unsigned int concurentThreadsSupported = std::thread::hardware_concurrency();
-
-                //This allows TBB to choose the number of threads to spawn.
-                tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-
-                //Explicitly setting the number of threads to spawn
-                //tbb::task_scheduler_init((int) concurentThreadsSupported);
-
                 SortByKey_comp <RandomAccessIterator1, RandomAccessIterator2, StrictWeakOrdering >sort_by_key_op;
-                sort_by_key_op(keys_first, keys_last, values_first, comp);
+                bolt::btbb::arena::getInstance( ).execute( [&]( )
+                {
+                    sort_by_key_op(keys_first, keys_last, values_first, comp);
+                } );
           }
        
     } //tbb
@@ -19,105 +19,120 @@
 #define BOLT_BTBB_STABLE_SORT_INL
 #pragma once
 
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/arena.h"
+#include "bolt/btbb/merge.h"
 #include "tbb/parallel_invoke.h"
+#include <algorithm>
+#include <functional>
 #include <iterator>
+#include <memory>
+#include <new>
 
 namespace bolt{
     namespace btbb {
-       
-             template<typename RandomAccessIterator>
-             struct StableSort
-             {
-
-               StableSort () {}  
-
-               void operator() (RandomAccessIterator first, RandomAccessIterator last)
-               {
-                    int n = (int) std::distance(first, last);
-
-                    if(n == 1)  // Only one element
-                         return; // Nothing to Sort!
-                    else
-                         Parallel_Merge_Sort(first, last);
-                    
-               }    
-
-               void Parallel_Merge_Sort(RandomAccessIterator beg, RandomAccessIterator end)
-               {
-                       if (end - beg > 1)
-                       {
-                             RandomAccessIterator mid = beg + (end - beg) / 2;
-
-                              tbb::parallel_invoke(
-                                [&] { Parallel_Merge_Sort( beg, mid); }, 
-                                [&] { Parallel_Merge_Sort( mid, end); }  
-                              );
-
-                             std::inplace_merge(beg, mid, end);
-                       }
-                   
-               }
-
-           };
-
- template<typename RandomAccessIterator, typename StrictWeakOrdering>
-        void Parallel_Merge_Sort(RandomAccessIterator beg, RandomAccessIterator end,  StrictWeakOrdering comp)
-       {
-               if (end - beg > 1)
-               {
-                     RandomAccessIterator mid = beg + (end - beg) / 2;
-
-                      tbb::parallel_invoke(
-                        [&] { Parallel_Merge_Sort( beg, mid, comp); }, 
-                        [&] { Parallel_Merge_Sort( mid, end, comp); }  
-                      );
-
-                     std::inplace_merge(beg, mid, end, comp);
-               }
-           
-       }
-
-
-           template<typename RandomAccessIterator, typename StrictWeakOrdering>
-           struct StableSort_comp
-           {
-
-               StableSort_comp () {}  
-
-
-
-               void operator() (RandomAccessIterator first, RandomAccessIterator last, StrictWeakOrdering comp )
-               {
-                    int n = (int) std::distance(first, last);
-
-                    if(n == 1)  // Only one element
-                         return; // Nothing to Sort!
-                    else   
-                         Parallel_Merge_Sort(first, last, comp);
-                    
-               }    
-
-
 
-           };
+        namespace detail
+        {
+            //  Ranges up to this size are sorted with std::stable_sort by one task
+            static const size_t stableSortSerialCutoff = 4096;
+
+            /*! \brief The merge buffer of stable_sort, copy-constructed from the input, so that the elements need
+            *   not be default constructible and are not constructed twice.  Every later write into it assigns.
+            */
+            template< typename T >
+            class stable_sort_buffer
+            {
+            public:
+                template< typename RandomAccessIterator >
+                stable_sort_buffer( RandomAccessIterator first, size_t n ):
+                    m_data( static_cast< T* >( ::operator new( n * sizeof( T ) ) ) ), m_size( n )
+                {
+                    try
+                    {
+                        std::uninitialized_copy( first, first + n, m_data );
+                    }
+                    catch( ... )
+                    {
+                        ::operator delete( m_data );
+                        throw;
+                    }
+                }
+
+                ~stable_sort_buffer( )
+                {
+                    for( size_t i = 0; i < m_size; ++i )
+                        m_data[ i ].~T( );
+                    ::operator delete( m_data );
+                }
+
+                T* get( ) const { return m_data; }
+
+            private:
+                stable_sort_buffer( const stable_sort_buffer& );
+                stable_sort_buffer& operator=( const stable_sort_buffer& );
+
+                T* m_data;
+                size_t m_size;
+            };
+
+            /*! \brief Sorts the n elements at \p data, leaving the result at \p buffer when \p toBuffer is set and
+            *   at \p data otherwise.  Both halves are sorted into the other array, so that every level merges from
+            *   one array into the other and no level copies.
+            */
+            template< typename RandomAccessIterator, typename T, typename StrictWeakOrdering >
+            void merge_sort( RandomAccessIterator data, T* buffer, size_t n, bool toBuffer, StrictWeakOrdering comp )
+            {
+                if( n <= stableSortSerialCutoff )
+                {
+                    std::stable_sort( data, data + n, comp );
+                    if( toBuffer )
+                        std::copy( data, data + n, buffer );
+                    return;
+                }
+
+                const size_t half = n / 2;
+                tbb::parallel_invoke(
+                    [&] { merge_sort( data, buffer, half, !toBuffer, comp ); },
+                    [&] { merge_sort( data + half, buffer + half, n - half, !toBuffer, comp ); }
+                );
+
+                if( toBuffer )
+                    parallel_merge( data, half, data + half, n - half, buffer, comp );
+                else
+                    parallel_merge( buffer, half, buffer + half, n - half, data, comp );
+            }
+
+            template< typename RandomAccessIterator, typename StrictWeakOrdering >
+            void stable_sort( RandomAccessIterator first, RandomAccessIterator last, StrictWeakOrdering comp )
+            {
+                typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+
+                const size_t n = static_cast< size_t >( std::distance( first, last ) );
+                if( n <= stableSortSerialCutoff )
+                {
+                    std::stable_sort( first, last, comp );
+                    return;
+                }
+
+                stable_sort_buffer< T > buffer( first, n );
+                bolt::btbb::arena::getInstance( ).execute( [&]( )
+                {
+                    merge_sort( first, buffer.get( ), n, false, comp );
+                } );
+            }
+        }
 
            template<typename RandomAccessIterator>
            void stable_sort(RandomAccessIterator first, RandomAccessIterator last)
            {
-                //This allows TBB to choose the number of threads to spawn.
-                tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-                StableSort <RandomAccessIterator > stable_sort_op;
-                stable_sort_op(first, last);
+                typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+                detail::stable_sort( first, last, std::less< T >( ) );
            }
 
            template<typename RandomAccessIterator, typename StrictWeakOrdering>
            void stable_sort(RandomAccessIterator first, RandomAccessIterator last, StrictWeakOrdering comp)
            {
-               //This allows TBB to choose the number of threads to spawn.
-                tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic); 			   
-                StableSort_comp <RandomAccessIterator, StrictWeakOrdering > stable_sort_op;
-                stable_sort_op(first, last, comp);
+                detail::stable_sort( first, last, comp );
            }
        
     } //tbb
@@ -19,10 +19,11 @@
 #define BOLT_BTBB_STABLE_SORT_BY_KEY_INL
 #pragma once
 
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/arena.h"
 #include "tbb/parallel_invoke.h"
 //#include <thread>
 #include <iterator>
+#include <functional>
 
 #include "bolt/btbb/stable_sort.h"
 #include "tbb/blocked_range.h"
@@ -61,15 +62,15 @@ namespace bolt{
                      typedef typename std::iterator_traits< RandomAccessIterator2 >::value_type valType;
                      typedef tbb_stable_sort<keyType, valType> KeyValuePair;
        
-                     size_t vecSize = std::distance( keys_first, keys_last ); 
+                     size_t vecSize = static_cast< size_t >( std::distance( keys_first, keys_last ) ); 
                      std::vector<KeyValuePair> KeyValuePairVector(vecSize);
 
                      //Zip the key and values iterators into a tbb_stable_sort vector.
-                     tbb::parallel_for(  tbb::blocked_range<int>(0, (int) vecSize) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
+                     tbb::parallel_for(  tbb::blocked_range<size_t>(0, vecSize) ,
+                        [&] (const tbb::blocked_range<size_t> &r) -> void
                      {
                               
-                              for(int i = r.begin(); i!=r.end(); i++)
+                              for(size_t i = r.begin(); i!=r.end(); i++)
                               {
                                  
                                    KeyValuePairVector[i].key   = *(keys_first + i);
@@ -78,15 +79,16 @@ namespace bolt{
                           
                      });
 
-                     //Sort the tbb_stable_sort vector using TBB stable_sort
-                     bolt::btbb::stable_sort(KeyValuePairVector.begin(), KeyValuePairVector.end());
+                     //Sort the tbb_stable_sort vector using TBB stable_sort; the pairs compare by their keys
+                     bolt::btbb::stable_sort(KeyValuePairVector.begin(), KeyValuePairVector.end(),
+                         tbb_stable_sort_comp< keyType, valType, std::less< keyType > >( std::less< keyType >( ) ));
 
                      //Extract the keys and values from the KeyValuePair and fill the respective iterators. 
-                     tbb::parallel_for(  tbb::blocked_range<int>(0, (int) vecSize) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
+                     tbb::parallel_for(  tbb::blocked_range<size_t>(0, vecSize) ,
+                        [&] (const tbb::blocked_range<size_t> &r) -> void
                      {
                               
-                              for(int i = r.begin(); i!=r.end(); i++)
+                              for(size_t i = r.begin(); i!=r.end(); i++)
                               {
                                  
                                    *(keys_first + i)   = KeyValuePairVector[i].key;
@@ -105,16 +107,16 @@ namespace bolt{
                      typedef tbb_stable_sort<keyType, valType> KeyValuePair;
                      typedef tbb_stable_sort_comp<keyType, valType, StrictWeakOrdering> KeyValuePairFunctor;
        
-                     size_t vecSize = std::distance( keys_first, keys_last ); 
+                     size_t vecSize = static_cast< size_t >( std::distance( keys_first, keys_last ) ); 
                      std::vector<KeyValuePair> KeyValuePairVector(vecSize);
                      KeyValuePairFunctor functor(comp);
 
                      //Zip the key and values iterators into a tbb_stable_sort vector.
-                     tbb::parallel_for(  tbb::blocked_range<int>(0, (int) vecSize) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
+                     tbb::parallel_for(  tbb::blocked_range<size_t>(0, vecSize) ,
+                        [&] (const tbb::blocked_range<size_t> &r) -> void
                      {
                               
-                              for(int i = r.begin(); i!=r.end(); i++)
+                              for(size_t i = r.begin(); i!=r.end(); i++)
                               {
                                  
                                    KeyValuePairVector[i].key   = *(keys_first + i);
@@ -127,11 +129,11 @@ namespace bolt{
                      bolt::btbb::stable_sort(KeyValuePairVector.begin(), KeyValuePairVector.end(), functor);
 
                      //Extract the keys and values from the KeyValuePair and fill the respective iterators.
-                     tbb::parallel_for(  tbb::blocked_range<int>(0, (int) vecSize) ,
-                        [&] (const tbb::blocked_range<int> &r) -> void
+                     tbb::parallel_for(  tbb::blocked_range<size_t>(0, vecSize) ,
+                        [&] (const tbb::blocked_range<size_t> &r) -> void
                      {
                               
-                              for(int i = r.begin(); i!=r.end(); i++)
+                              for(size_t i = r.begin(); i!=r.end(); i++)
                               {
                                  
                                    *(keys_first + i)   = KeyValuePairVector[i].key;
@@ -149,7 +151,7 @@ namespace bolt{
 
                void operator() ( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last, RandomAccessIterator2 values_first)
                {
-                    int n = (int) std::distance(keys_first, keys_last);
+                    size_t n = static_cast< size_t >( std::distance(keys_first, keys_last) );
 
                     if(n == 1)  // Only one element
                          return; // Nothing to Sort!
@@ -168,7 +170,7 @@ namespace bolt{
 
                void operator() (RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last, RandomAccessIterator2 values_first, StrictWeakOrdering comp )
                {
-                    int n = (int) std::distance(keys_first, keys_last);
+                    size_t n = static_cast< size_t >( std::distance(keys_first, keys_last) );
 
                     if(n == 1)  // Only one element
                          return; // Nothing to Sort!
@@ -185,34 +187,22 @@ namespace bolt{
            void stable_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last, 
            RandomAccessIterator2 values_first)
            {
-                //Gets the number of concurrent threads supported by the underlying platform
-                //unsigned int concurentThreadsSupported = std::thread::hardware_concurrency();
-
-                //This allows TBB to choose the number of threads to spawn.
-                tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-
-                //Explicitly setting the number of threads to spawn
-                //tbb::task_scheduler_init((int) concurentThreadsSupported);
-
                 StableSortByKey <RandomAccessIterator1, RandomAccessIterator2 > stable_sort_by_key_op;
-                stable_sort_by_key_op(keys_first, keys_last, values_first);
+                bolt::btbb::arena::getInstance( ).execute( [&]( )
+                {
+                    stable_sort_by_key_op(keys_first, keys_last, values_first);
+                } );
            }
 
            template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename StrictWeakOrdering> 
            void stable_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last, RandomAccessIterator2 values_first, 
            StrictWeakOrdering comp)
            {
-                //Gets the number of concurrent threads supported by the underlying platform
-                //unsigned int concurentThreadsSupported = std::thread::hardware_concurrency();
-
-                //This allows TBB to choose the number of threads to spawn.
-                tbb::task_scheduler_init initialize(tbb::task_scheduler_init::automatic);
-
-                //Explicitly setting the number of threads to spawn
-                //tbb::task_scheduler_init((int) concurentThreadsSupported);
-
                 StableSortByKey_comp <RandomAccessIterator1, RandomAccessIterator2, StrictWeakOrdering > stable_sort_by_key_op;
-                stable_sort_by_key_op(keys_first, keys_last, values_first, comp);
+                bolt::btbb::arena::getInstance( ).execute( [&]( )
+                {
+                    stable_sort_by_key_op(keys_first, keys_last, values_first, comp);
+                } );
           }
        
     } //tbb
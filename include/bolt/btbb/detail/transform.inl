@@ -58,7 +58,7 @@ namespace bolt
 		transformBinaryRange( transformBinaryRange& r, tbb::split ): first1( r.first1 ), last1( r.last1 ), first2( r.first2 ),
 			result( r.result ), func( r.func )
 		{
-			int halfSize = static_cast<int>(std::distance( r.first1, r.last1 ) >> 1);
+			typename std::iterator_traits< tbbInputIterator1 >::difference_type halfSize = std::distance( r.first1, r.last1 ) / 2;
 			r.last1 = r.first1 + halfSize;
 
 			first1 = r.last1;
@@ -92,7 +92,7 @@ namespace bolt
 		transformUnaryRange( transformUnaryRange& r, tbb::split ): first1( r.first1 ), last1( r.last1 ),
 			 result( r.result ), func( r.func )
 		{
-			int halfSize = static_cast<int>(std::distance( r.first1, r.last1 ) >> 1);
+			typename std::iterator_traits< tbbInputIterator1 >::difference_type halfSize = std::distance( r.first1, r.last1 ) / 2;
 			r.last1 = r.first1 + halfSize;
 
 			first1 = r.last1;
@@ -110,7 +110,7 @@ namespace bolt
             if (sz == 0)
                 return;
             //std::transform( first, last, result, f );
-            for(int index=0; index < (int)(sz); index++)
+            for(size_t index=0; index < sz; index++)
             {
                 *(r.result + index) = r.func( *(r.first1+index), *(r.first2+index) );
             }
@@ -123,7 +123,7 @@ namespace bolt
 		void operator( )( transformUnaryRange< tbbInputIterator1, tbbOutputIterator, tbbFunctor >& r ) const
 		{
 			size_t sz = std::distance( r.first1, r.last1 );
-            for(int index=0; index < (int)(sz); index++)
+            for(size_t index=0; index < sz; index++)
             {
                 *(r.result + index) = r.func( *(r.first1+index) );
             }
@@ -0,0 +1,66 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_BTBB_TRANSFORM_SCAN_INL )
+#define BOLT_BTBB_TRANSFORM_SCAN_INL
+#pragma once
+
+namespace bolt {
+    namespace btbb {
+
+        namespace detail
+        {
+            //  Both engines transform every element as they read it; the transformed values are never stored
+            template< typename InputIterator, typename OutputIterator, typename UnaryFunction,
+                      typename BinaryFunction, typename T >
+            void transform_scan( InputIterator first, size_t numElements, OutputIterator result,
+                                 const UnaryFunction& unary_op, const BinaryFunction& binary_op, bool inclusive,
+                                 const T& init )
+            {
+                segmented_scan( numElements, single_segment( ), first, result, unary_op, binary_op, inclusive, init );
+            }
+        }
+
+        template< typename InputIterator, typename OutputIterator, typename UnaryFunction, typename BinaryFunction >
+        OutputIterator
+        transform_inclusive_scan( InputIterator first, InputIterator last, OutputIterator result,
+                                  UnaryFunction unary_op, BinaryFunction binary_op )
+        {
+            typedef typename std::iterator_traits< OutputIterator >::value_type oType;
+
+            size_t numElements = static_cast< size_t >( std::distance( first, last ) );
+            detail::transform_scan( first, numElements, result, unary_op, binary_op, true, oType( ) );
+            return result + numElements;
+        }
+
+        template< typename InputIterator, typename OutputIterator, typename UnaryFunction, typename T,
+                  typename BinaryFunction >
+        OutputIterator
+        transform_exclusive_scan( InputIterator first, InputIterator last, OutputIterator result,
+                                  UnaryFunction unary_op, T init, BinaryFunction binary_op )
+        {
+            typedef typename std::iterator_traits< OutputIterator >::value_type oType;
+
+            size_t numElements = static_cast< size_t >( std::distance( first, last ) );
+            detail::transform_scan( first, numElements, result, unary_op, binary_op, false, oType( init ) );
+            return result + numElements;
+        }
+
+    }
+}
+
+#endif
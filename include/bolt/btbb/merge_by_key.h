@@ -0,0 +1,92 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_BTBB_MERGE_BY_KEY_H )
+#define BOLT_BTBB_MERGE_BY_KEY_H
+#pragma once
+
+#include <utility>
+
+/*! \file bolt/btbb/merge_by_key.h
+    \brief Merges two ranges of keys sorted with the same order, and moves their values with them.
+*/
+
+
+namespace bolt {
+    namespace btbb {
+
+        /*! \addtogroup TBB-merge
+        *   \{
+        */
+
+
+        /*! \brief \p merge_by_key merges the sorted keys [keys_first1, keys_last1) and [keys_first2, keys_last2)
+        * into [keys_result, keys_result + (keys_last1-keys_first1) + (keys_last2-keys_first2)), and writes the value
+        * of every key at the same position from \p values_result.
+        *
+        * \details The merge is stable: of two equivalent keys, the one of the first range comes first.  The output
+        * is cut into equal pieces that merge in parallel, wherever the keys of the two ranges interleave.
+        *
+        * \param keys_first1 The beginning of the first range of keys.
+        * \param keys_last1  The end of the first range of keys.
+        * \param keys_first2 The beginning of the second range of keys.
+        * \param keys_last2  The end of the second range of keys.
+        * \param values_first1 The beginning of the values of the first range of keys.
+        * \param values_first2 The beginning of the values of the second range of keys.
+        * \param keys_result The beginning of the merged keys.
+        * \param values_result The beginning of the merged values.
+        * \param comp Comparison operator of the keys.
+        * \tparam StrictWeakCompare is a model of Strict Weak Ordering.
+        * \return The ends of the merged keys and of the merged values.
+        *
+        * \code
+        * #include <bolt/btbb/merge_by_key.h>
+        *
+        * int a[3] = {1, 4, 6};      char va[3] = {'a', 'b', 'c'};
+        * int b[3] = {2, 4, 5};      char vb[3] = {'x', 'y', 'z'};
+        * int keys[6];               char values[6];
+        * bolt::btbb::merge_by_key(a, a+3, b, b+3, va, vb, keys, values, std::less<int>());
+        * // keys = 1,2,4,4,5,6 and values = a,x,b,y,z,c
+        *  \endcode
+        */
+        template< typename InputIterator1, typename InputIterator2, typename InputIterator3, typename InputIterator4,
+                  typename OutputIterator1, typename OutputIterator2, typename StrictWeakCompare >
+        std::pair< OutputIterator1, OutputIterator2 >
+        merge_by_key( InputIterator1 keys_first1, InputIterator1 keys_last1,
+                      InputIterator2 keys_first2, InputIterator2 keys_last2,
+                      InputIterator3 values_first1, InputIterator4 values_first2,
+                      OutputIterator1 keys_result, OutputIterator2 values_result, StrictWeakCompare comp );
+
+        //! \p merge_by_key that orders the keys with \p operator<.
+        template< typename InputIterator1, typename InputIterator2, typename InputIterator3, typename InputIterator4,
+                  typename OutputIterator1, typename OutputIterator2 >
+        std::pair< OutputIterator1, OutputIterator2 >
+        merge_by_key( InputIterator1 keys_first1, InputIterator1 keys_last1,
+                      InputIterator2 keys_first2, InputIterator2 keys_last2,
+                      InputIterator3 values_first1, InputIterator4 values_first2,
+                      OutputIterator1 keys_result, OutputIterator2 values_result );
+
+
+        /*!   \}  */
+
+    }
+}
+
+#include <bolt/btbb/detail/merge_by_key.inl>
+
+
+#endif //BTBB_MERGE_BY_KEY_H
@@ -0,0 +1,166 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_BTBB_RADIX_SORT_H )
+#define BOLT_BTBB_RADIX_SORT_H
+#pragma once
+
+#include <functional>
+#include <type_traits>
+
+#include "bolt/btbb/arena.h"
+
+/*! \file bolt/btbb/radix_sort.h
+    \brief Parallel LSD radix sort of 32 and 64 bit integer and floating point keys.
+*/
+
+//  Declared here so that radix_sort_order knows the built-in comparisons of Bolt; defined in bolt/cl/functional.h
+namespace bolt {
+    namespace cl {
+        template< typename T >
+        struct less;
+
+        template< typename T >
+        struct greater;
+    }
+}
+
+namespace bolt {
+    namespace btbb {
+
+        namespace detail
+        {
+            //! Keys the radix sort does not know; \p sortable is false
+            template< typename T >
+            struct radix_traits
+            {
+                static const bool sortable = false;
+            };
+        }
+
+        /*! \addtogroup algorithms
+         */
+
+        /*! \addtogroup sorting
+        *   \ingroup algorithms
+        */
+
+        /*! \addtogroup TBB-radix_sort
+        *   \ingroup sorting
+        *   \{
+        */
+
+        /*! \brief True for the value types bolt::btbb::radix_sort accepts: \c int, \c unsigned \c int, \c long,
+        *   \c unsigned \c long, \c long \c long, \c unsigned \c long \c long, \c float and \c double.
+        */
+        template< typename T >
+        struct is_radix_sortable: std::integral_constant< bool, detail::radix_traits< T >::sortable >
+        {
+        };
+
+        /*! \brief Sorts the elements between \p first and \p last into ascending order with a parallel radix sort.
+        *
+        * \details The keys are split into 8 bit digits, which are sorted from the least significant one upwards.
+        * Every digit takes one pass over the data: each TBB task counts the digits of its tile, a prefix sum over the
+        * counts gives every tile its output offsets, and the tasks then scatter their tiles.  Digits that are the same
+        * for all keys are skipped.  The sort needs a temporary buffer as large as the input.  Negative zero sorts
+        * before positive zero; NaNs sort by their bit pattern.
+        *
+        *  \tparam RandomAccessIterator Is a model of http://www.sgi.com/tech/stl/RandomAccessIterator.html whose
+        *  \c value_type satisfies bolt::btbb::is_radix_sortable.
+        * \param first The first position in the sequence to be sorted.
+        * \param last  The last position in the sequence to be sorted.
+        *
+        * \code
+        * #include <bolt/btbb/radix_sort.h>
+        *
+        * float a[8] = {2.f, 9.f, -3.f, 7.f, 5.f, 6.f, 3.f, 8.f};
+        *
+        * bolt::btbb::radix_sort(a, a+8);
+        * // a => {-3.f, 2.f, 3.f, 5.f, 6.f, 7.f, 8.f, 9.f}
+        *  \endcode
+        */
+        template< typename RandomAccessIterator >
+        void radix_sort( RandomAccessIterator first, RandomAccessIterator last );
+
+        //! \brief Same as radix_sort( first, last ); \p comp only selects the ascending order.
+        template< typename RandomAccessIterator, typename T >
+        void radix_sort( RandomAccessIterator first, RandomAccessIterator last, std::less< T > comp );
+
+        //! \brief Sorts the elements between \p first and \p last into descending order with a parallel radix sort.
+        template< typename RandomAccessIterator, typename T >
+        void radix_sort( RandomAccessIterator first, RandomAccessIterator last, std::greater< T > comp );
+
+        /*! \brief Sorts the keys between \p keys_first and \p keys_last into ascending order with a parallel radix
+        *   sort, and moves every value of \p values_first along with its key.
+        *
+        * \details The keys and values stay in separate arrays; the sort needs one temporary buffer for the keys and
+        * one for the values.  Keys that compare equal keep the order of their values.
+        */
+        template< typename RandomAccessIterator1, typename RandomAccessIterator2 >
+        void radix_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last,
+                                RandomAccessIterator2 values_first );
+
+        //! \brief Same as radix_sort_by_key( keys_first, keys_last, values_first ); \p comp only selects the order.
+        template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename T >
+        void radix_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last,
+                                RandomAccessIterator2 values_first, std::less< T > comp );
+
+        //! \brief Sorts the keys into descending order and moves every value along with its key.
+        template< typename RandomAccessIterator1, typename RandomAccessIterator2, typename T >
+        void radix_sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last,
+                                RandomAccessIterator2 values_first, std::greater< T > comp );
+
+        /*! \brief 1 when \p StrictWeakOrdering sorts \p T ascending and radix_sort can be used, 2 when it sorts
+        *   descending, and 0 when only a comparison sort can be used.  The less and greater of std and of
+        *   bolt::cl are known.
+        */
+        template< typename T, typename StrictWeakOrdering >
+        struct radix_sort_order: std::integral_constant< int, 0 >
+        {
+        };
+
+        template< typename T >
+        struct radix_sort_order< T, std::less< T > >:
+            std::integral_constant< int, is_radix_sortable< T >::value ? 1 : 0 >
+        {
+        };
+
+        template< typename T >
+        struct radix_sort_order< T, std::greater< T > >:
+            std::integral_constant< int, is_radix_sortable< T >::value ? 2 : 0 >
+        {
+        };
+
+        template< typename T >
+        struct radix_sort_order< T, bolt::cl::less< T > >: radix_sort_order< T, std::less< T > >
+        {
+        };
+
+        template< typename T >
+        struct radix_sort_order< T, bolt::cl::greater< T > >: radix_sort_order< T, std::greater< T > >
+        {
+        };
+
+        /*!   \}  */
+
+    }// end of bolt::btbb namespace
+}// end of bolt namespace
+
+#include <bolt/btbb/detail/radix_sort.inl>
+
+#endif
@@ -19,9 +19,7 @@
 #define BOLT_BTBB_REDUCE_BY_KEY_H
 #pragma once
 
-#include "tbb/parallel_scan.h"
-#include "tbb/blocked_range.h"
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/scan_engine.h"
 
 
 
@@ -37,7 +35,7 @@ namespace bolt {
                 typename InputIterator2,
                 typename OutputIterator1,
                 typename OutputIterator2>
-                unsigned int
+                size_t
                 reduce_by_key(
                 InputIterator1  keys_first,
                 InputIterator1  keys_last,
@@ -51,7 +49,7 @@ namespace bolt {
                 typename OutputIterator1,
                 typename OutputIterator2,
                 typename BinaryPredicate>
-                unsigned int
+                size_t
                 reduce_by_key(
                 InputIterator1  keys_first,
                 InputIterator1  keys_last,
@@ -60,7 +58,13 @@ namespace bolt {
                 OutputIterator2  values_output,
                 BinaryPredicate binary_pred);
 
-       
+
+            /*! \brief Reduces every run of consecutive equal keys to one key and one value, and returns the number
+            *   of runs.
+            *   \details The runs are the segments of segmented_reduce.  A first parallel pass counts the runs that
+            *   start in every tile and reduces the run still open at its end; a second writes every key where its
+            *   run starts and every value where its run ends.  Besides the output, one record per tile is stored.
+            */
             template<
                 typename InputIterator1,
                 typename InputIterator2,
@@ -68,7 +72,7 @@ namespace bolt {
                 typename OutputIterator2,
                 typename BinaryPredicate,
                 typename BinaryFunction>
-                unsigned int reduce_by_key(  InputIterator1  keys_first,
+                size_t reduce_by_key(  InputIterator1  keys_first,
                                              InputIterator1  keys_last,
                                              InputIterator2  values_first,
                                              OutputIterator1  keys_output,
@@ -0,0 +1,185 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_BTBB_SCAN_ENGINE_H )
+#define BOLT_BTBB_SCAN_ENGINE_H
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+#include "bolt/btbb/arena.h"
+#include "bolt/btbb/simd_reduce.h"
+
+/*! \file bolt/btbb/scan_engine.h
+    \brief The segmented scan engine behind the btbb prefix sums, and how it splits the work between the threads of
+    the arena.
+*/
+
+//  Declared here so that is_plus is specialized for it wherever the engine is seen; defined in bolt/cl/functional.h
+namespace bolt {
+    namespace cl {
+        template< typename T >
+        struct plus;
+    }
+}
+
+namespace bolt {
+    namespace btbb {
+
+        /*! \addtogroup algorithms
+         */
+
+        /*! \addtogroup PrefixSums Prefix Sums
+         *   \ingroup algorithms
+         */
+
+        /*! \addtogroup TBB-scan_engine
+        *   \ingroup PrefixSums
+        *   \{
+        */
+
+        /*! \brief The implementations behind inclusive_scan, exclusive_scan, transform_inclusive_scan,
+        *   transform_exclusive_scan and the scan_by_key variants of the btbb backend
+        *   \details \p LookbackScan splits the input into tiles that the threads claim in order.  Every tile reduces
+        *   its elements, publishes the aggregate, and looks back over the tiles before it until it finds a published
+        *   prefix, before it scans; a tile is read a second time from the cache, so the input is read once from
+        *   memory and the output written once.  \p TwoPassScan is the tbb::parallel_scan implementation, which
+        *   reduces the input in one pass over memory and scans it in another; it is kept for comparison.
+        */
+        enum e_ScanEngine { LookbackScan, TwoPassScan };
+
+        namespace detail
+        {
+            inline e_ScanEngine& scanEngine( )
+            {
+                static e_ScanEngine engine = LookbackScan;
+                return engine;
+            }
+        }
+
+        //! Selects the implementation of the btbb prefix sums for the whole process; the default is LookbackScan
+        inline void setScanEngine( e_ScanEngine engine )
+        {
+            detail::scanEngine( ) = engine;
+        }
+
+        inline e_ScanEngine getScanEngine( )
+        {
+            return detail::scanEngine( );
+        }
+
+        /*! \brief Runs a single pass prefix sum over n elements with decoupled look-back
+        *   \details The tile body \p body provides
+        *   \li \c value_type, the aggregate of a run of elements;
+        *   \li <tt>value_type reduce( size_t begin, size_t end ) const</tt>, the aggregate of the elements
+        *       [begin, end);
+        *   \li <tt>value_type combine( const value_type& left, const value_type& right ) const</tt>, the aggregate
+        *       of two adjacent runs;
+        *   \li <tt>value_type scan( size_t begin, size_t end, const value_type* prefix ) const</tt>, which writes
+        *       the output of [begin, end) given the prefix of all elements before \p begin, or NULL for the first
+        *       tile, and returns the prefix of all elements up to \p end.
+        *
+        *   The prefix of the first tile is its aggregate, so a body that folds an initial value into its output
+        *   must fold it into <tt>reduce( 0, end )</tt> too; every later prefix combines it with the aggregates of
+        *   the tiles in between.  Every tile is reduced before its output is written, so an in-place scan must
+        *   read every element before it writes its output.
+        */
+        template< typename TileBody >
+        void lookback_scan( size_t n, const TileBody& body );
+
+        //! Runs the tile body of lookback_scan through tbb::parallel_scan, which reduces the tiles before it scans them
+        template< typename TileBody >
+        void two_pass_scan( size_t n, const TileBody& body );
+
+        /*! \brief Runs the tile body of lookback_scan in two parallel passes over the tiles: the first reduces every
+        *   tile, a serial pass combines the aggregates of the tiles in order, and the second scans every tile with
+        *   the prefix before it.  Besides the output, one aggregate per tile is stored.
+        */
+        template< typename TileBody >
+        void tiled_two_pass_scan( size_t n, const TileBody& body );
+
+        //! Runs the tile body of lookback_scan through the engine picked by setScanEngine
+        template< typename TileBody >
+        void run_scan( size_t n, const TileBody& body );
+
+        //! The segments of a scan without keys: the whole input is one segment
+        struct single_segment
+        {
+            bool operator()( size_t ) const { return false; }
+        };
+
+        //! The segments of the by-key algorithms: element \p i starts a segment when its key differs from key \p i-1
+        template< typename InputIterator, typename BinaryPredicate >
+        struct key_segments
+        {
+            key_segments( InputIterator keys, const BinaryPredicate& binary_pred ):
+                keys( keys ), binary_pred( binary_pred )
+            {}
+
+            bool operator()( size_t i ) const { return !binary_pred( keys[ i ], keys[ i - 1 ] ); }
+
+            InputIterator keys;
+            BinaryPredicate binary_pred;
+        };
+
+        /*! \brief True when \p BinaryFunction adds two \p T.  The segments of integer sums over contiguous input are
+        *   then reduced with the vector kernels of simd_reduce.h; specialize it for other functors that add.
+        */
+        template< typename BinaryFunction, typename T >
+        struct is_plus: std::false_type {};
+
+        template< typename T >
+        struct is_plus< std::plus< T >, T >: std::true_type {};
+
+        template< typename T >
+        struct is_plus< bolt::cl::plus< T >, T >: std::true_type {};
+
+        /*! \brief Scans every segment of the n elements from \p first into \p result, through the engine picked by
+        *   setScanEngine.
+        *   \details \p heads( i ), for 0 < i < n, is true when element \p i starts a segment; single_segment and
+        *   key_segments cover the scans and the scans by key.  Every element is transformed by \p unary_op before it
+        *   is summed with \p binary_op.  An exclusive scan starts every segment with \p init.  \p result may be
+        *   \p first.
+        */
+        template< typename Heads, typename InputIterator, typename OutputIterator, typename UnaryFunction,
+                  typename BinaryFunction, typename T >
+        void segmented_scan( size_t n, const Heads& heads, InputIterator first, OutputIterator result,
+                             const UnaryFunction& unary_op, const BinaryFunction& binary_op, bool inclusive,
+                             const T& init );
+
+        /*! \brief Reduces every segment of the n values from \p values to one value, writes the key that starts it and
+        *   the value in order, and returns the number of segments.
+        *   \details The segments are given by \p heads, as for segmented_scan; the values are summed with
+        *   \p binary_op in the type of the output values.  It runs on tiled_two_pass_scan, whatever the engine:
+        *   the first pass counts the segments of every tile and sums its last one, the second writes them.
+        */
+        template< typename Heads, typename InputIterator1, typename InputIterator2, typename OutputIterator1,
+                  typename OutputIterator2, typename BinaryFunction >
+        size_t segmented_reduce( size_t n, const Heads& heads, InputIterator1 keys, InputIterator2 values,
+                                 OutputIterator1 keys_result, OutputIterator2 values_result,
+                                 const BinaryFunction& binary_op );
+
+        /*!   \}  */
+
+    }
+}
+
+#include <bolt/btbb/detail/scan_engine.inl>
+
+#endif
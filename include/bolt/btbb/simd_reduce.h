@@ -0,0 +1,165 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_BTBB_SIMD_REDUCE_H )
+#define BOLT_BTBB_SIMD_REDUCE_H
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "bolt/btbb/arena.h"
+
+/*! \file bolt/btbb/simd_reduce.h
+    \brief Vectorized parallel sums, minima, maxima and counts over contiguous arrays of built-in types.
+*/
+
+namespace bolt {
+    namespace btbb {
+
+        namespace simd
+        {
+            //! The reductions the vectorized kernels implement
+            enum op { sum, sum_of_squares, minimum, maximum };
+
+            //! The instruction sets the kernels are written for, from the least to the most capable
+            enum level { scalar, sse2, avx2, avx512 };
+
+            //! The most capable level this processor and build support
+            inline level supportedLevel( );
+
+            //! The level the kernels use; by default the supported one
+            inline level getLevel( );
+
+            /*! \brief Makes the kernels use \p l, or the supported level if \p l is more capable; mostly useful to
+            *   compare the levels with each other
+            */
+            inline void setLevel( level l );
+        }
+
+        namespace detail
+        {
+            template< typename T >
+            struct simd_type: std::integral_constant< bool,
+                std::is_same< T, int >::value || std::is_same< T, unsigned int >::value ||
+                std::is_same< T, float >::value || std::is_same< T, double >::value >
+            {
+            };
+        }
+
+        /*! \addtogroup algorithms
+         */
+
+        /*! \addtogroup reductions
+        *   \ingroup algorithms
+        */
+
+        /*! \addtogroup TBB-simd_reduce
+        *   \ingroup reductions
+        *   \{
+        */
+
+        /*! \brief True when bolt::btbb::simd_reduce implements \p Op for \p T: sums of \c int, \c unsigned \c int,
+        *   \c float and \c double, sums of squares of \c float and \c double, and minima and maxima of \c int and
+        *   \c unsigned \c int.  Floating point minima are left out, because the vector instructions do not order
+        *   NaNs the way the < operator does.
+        */
+        template< typename T, simd::op Op >
+        struct is_simd_reducible: std::integral_constant< bool,
+            ( Op == simd::sum && detail::simd_type< T >::value ) ||
+            ( Op == simd::sum_of_squares && std::is_floating_point< T >::value && detail::simd_type< T >::value ) ||
+            ( ( Op == simd::minimum || Op == simd::maximum ) && std::is_integral< T >::value &&
+                detail::simd_type< T >::value ) >
+        {
+        };
+
+        //! \brief True for the types bolt::btbb::simd_count counts: \c int, \c unsigned \c int, \c float and \c double.
+        template< typename T >
+        struct is_simd_countable: detail::simd_type< T >
+        {
+        };
+
+        /*! \brief True for the iterators whose elements are contiguous in memory and can be handed to the
+        *   vectorized kernels as a pointer: pointers and the iterators of std::vector.
+        */
+        template< typename Iterator, typename T = typename std::iterator_traits< Iterator >::value_type >
+        struct is_contiguous_iterator: std::integral_constant< bool,
+            !std::is_same< T, bool >::value &&
+            ( std::is_same< Iterator, typename std::vector< T >::iterator >::value ||
+              std::is_same< Iterator, typename std::vector< T >::const_iterator >::value ) >
+        {
+        };
+
+        template< typename T >
+        struct is_contiguous_iterator< T*, T >: std::true_type
+        {
+        };
+
+        template< typename T >
+        struct is_contiguous_iterator< const T*, T >: std::true_type
+        {
+        };
+
+        /*! \brief Combines \p init with all the elements between \p first and \p last, in parallel and with the
+        *   widest vector instructions of the processor.
+        *
+        * \details Every TBB task reduces its slice with several vector accumulators, which are combined at the end
+        * of the slice.  Floating point sums are therefore rounded differently from a sequential sum.  The level of
+        * the kernels is picked at runtime; see simd::getLevel.
+        *
+        * \tparam Op The reduction; \p T must satisfy is_simd_reducible< T, Op >.
+        * \return \p init plus the sum, or plus the sum of the squares, of the elements; or the minimum or maximum
+        * of \p init and the elements.
+        *
+        * \code
+        * #include <bolt/btbb/simd_reduce.h>
+        *
+        * float a[4] = {1.f, 2.f, 3.f, 4.f};
+        *
+        * float sum = bolt::btbb::simd_reduce< bolt::btbb::simd::sum >(a, a+4, 0.f);
+        * // sum = 10.f
+        *  \endcode
+        */
+        template< simd::op Op, typename T >
+        T simd_reduce( const T* first, const T* last, T init );
+
+        //! \brief Returns how many of the elements between \p first and \p last compare equal to \p value.
+        template< typename T >
+        std::ptrdiff_t simd_count( const T* first, const T* last, T value );
+
+        /*! \brief Returns the first of the smallest elements between \p first and \p last, like std::min_element
+        *   with the < operator; \p T must satisfy is_simd_reducible< T, simd::minimum >.
+        */
+        template< typename T >
+        const T* simd_min_element( const T* first, const T* last );
+
+        /*! \brief Returns the first of the largest elements between \p first and \p last, like std::max_element
+        *   with the < operator; \p T must satisfy is_simd_reducible< T, simd::maximum >.
+        */
+        template< typename T >
+        const T* simd_max_element( const T* first, const T* last );
+
+        /*!   \}  */
+
+    }// end of bolt::btbb namespace
+}// end of bolt namespace
+
+#include <bolt/btbb/detail/simd_reduce.inl>
+
+#endif
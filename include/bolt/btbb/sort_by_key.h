@@ -19,16 +19,36 @@
 #define BOLT_BTBB_SORT_BY_KEY_H
 #pragma once
 
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/arena.h"
+#include "bolt/btbb/radix_sort.h"
 
 
-/*! \file bolt/btbb/stable_sort_by_key.h
+/*! \file bolt/btbb/sort_by_key.h
     \brief Returns the sorted result of all the elements in input according to key values.
 */
 
 namespace bolt {
     namespace btbb {
 
+        /*! \brief Limits, in bytes, the optional buffers of sort_by_key: the radix buffers and the gather buffer of
+        *   the values.  0, the default, is no limit.
+        *
+        * \details sort_by_key moves the values along with the keys in a radix sort when the keys are 32 or 64 bit
+        * integers or floating point values compared with less or greater.  That needs
+        * n * ( sizeof( key ) + sizeof( value ) ) temporary bytes.  Other keys, and inputs for which the radix sort
+        * would exceed the limit, are sorted as ( key, 32 bit index ) pairs, after which the values are gathered
+        * once, in parallel, through a buffer of n * sizeof( value ) bytes, or permuted in place by a serial pass of
+        * O( n ) moves when that buffer would exceed the limit too.  The n pairs are the working set of that sort and
+        * are allocated whatever the limit, so the limit does not bound the memory of sort_by_key below
+        * n * ( sizeof( key ) + sizeof( index ) ).
+        *
+        * The limit is shared by all threads and may be changed while they sort; every sort reads it once.
+        */
+        inline void setSortByKeyMemoryLimit( size_t bytes );
+
+        //! Returns the limit set by setSortByKeyMemoryLimit
+        inline size_t getSortByKeyMemoryLimit( );
+
         template< typename RandomAccessIterator1, typename RandomAccessIterator2 > 
         void sort_by_key( RandomAccessIterator1 keys_first, RandomAccessIterator1 keys_last, 
         RandomAccessIterator2 values_first);
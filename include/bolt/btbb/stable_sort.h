@@ -19,7 +19,7 @@
 #define BOLT_BTBB_STABLE_SORT_H
 #pragma once
 
-#include "tbb/task_scheduler_init.h"
+#include "bolt/btbb/arena.h"
 
 
 /*! \file bolt/btbb/stable_sort.h
@@ -0,0 +1,95 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_BTBB_TRANSFORM_SCAN_H )
+#define BOLT_BTBB_TRANSFORM_SCAN_H
+#pragma once
+
+#include "bolt/btbb/scan.h"
+#include "bolt/btbb/transform.h"
+
+/*! \file bolt/btbb/transform_scan.h
+    \brief Transforms a range of values and calculates a running sum over the results, inclusive or exclusive
+*/
+
+namespace bolt {
+    namespace btbb {
+
+        /*! \addtogroup algorithms
+         */
+
+        /*! \addtogroup PrefixSums Prefix Sums
+         *   \ingroup algorithms
+         */
+
+        /*! \addtogroup TBB-transform_scan
+        *   \ingroup PrefixSums
+        *   \{
+        */
+
+        /*! \brief \p transform_inclusive_scan applies \p unary_op to every input value and calculates the inclusive
+        *   running sum of the results.
+        *
+        * \details With the LookbackScan engine the transformed values are never stored; every input value is read
+        * once from memory and every result written once.  The input and output ranges may coincide.
+        *
+        * \param first The first iterator in the input range.
+        * \param last  The last iterator in the input range.
+        * \param result  The first iterator in the output range.
+        * \param unary_op The transformation applied to every input value.
+        * \param binary_op The associative function that sums the transformed values.
+        * \return result + ( last - first ).
+        *
+        * \code
+        * #include <bolt/btbb/transform_scan.h>
+        *
+        * int a[5] = {1, -2, 3, -4, 5};
+        *
+        * bolt::btbb::transform_inclusive_scan( a, a+5, a, std::negate< int >( ), std::plus< int >( ) );
+        * // a => {-1, 1, -2, 2, -3}
+        *  \endcode
+        */
+        template< typename InputIterator, typename OutputIterator, typename UnaryFunction, typename BinaryFunction >
+        OutputIterator
+        transform_inclusive_scan( InputIterator first, InputIterator last, OutputIterator result,
+                                  UnaryFunction unary_op, BinaryFunction binary_op );
+
+        /*! \brief \p transform_exclusive_scan applies \p unary_op to every input value and calculates the exclusive
+        *   running sum of the results, starting at \p init.
+        *
+        * \param first The first iterator in the input range.
+        * \param last  The last iterator in the input range.
+        * \param result  The first iterator in the output range.
+        * \param unary_op The transformation applied to every input value.
+        * \param init The value of the first output element.
+        * \param binary_op The associative function that sums the transformed values.
+        * \return result + ( last - first ).
+        */
+        template< typename InputIterator, typename OutputIterator, typename UnaryFunction, typename T,
+                  typename BinaryFunction >
+        OutputIterator
+        transform_exclusive_scan( InputIterator first, InputIterator last, OutputIterator result,
+                                  UnaryFunction unary_op, T init, BinaryFunction binary_op );
+
+        /*!   \}  */
+
+    }
+}
+
+#include <bolt/btbb/detail/transform_scan.inl>
+
+#endif
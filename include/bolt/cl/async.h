@@ -0,0 +1,186 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_CL_ASYNC_H )
+#define BOLT_CL_ASYNC_H
+#pragma once
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/functional.h"
+#include "bolt/cl/reduce.h"
+#include "bolt/cl/scan.h"
+#include "bolt/cl/sort.h"
+#include "bolt/cl/transform.h"
+
+/*! \file bolt/cl/async.h
+    \brief Variants of the Bolt algorithms that return before their commands are done.
+*/
+
+namespace bolt {
+    namespace cl {
+        namespace async {
+
+        /*! \addtogroup miscellaneous
+        */
+
+        /*! \addtogroup CL-async
+        *   \ingroup miscellaneous
+        *   \{
+        */
+
+        /*! \brief Events an asynchronous call waits for before its commands start
+        */
+        typedef std::vector< ::cl::Event > event_list;
+
+        /*! \brief The handle of an asynchronous call.
+        *   \details getEvent( ) returns an event that completes with the last command of the call; it can be passed
+        *   to the next call in a pipeline, or to any OpenCL command, to run after it without waiting on the host.
+        *   get( ) waits for the call and returns its result, which for a reduce is computed on the host at that
+        *   point.  The scratch buffers of the call go back to the buffer pool when it is waited for; a future that
+        *   is destroyed before then waits for the call itself.  A future is shared by its copies, and is not meant
+        *   to be waited for by several threads at once.
+        */
+        template< typename T >
+        class future
+        {
+        public:
+            future( )
+            {}
+
+            explicit future( const boost::shared_ptr< ::bolt::cl::detail::deferred_completion >& state ): m_state( state )
+            {}
+
+            //! The event that completes with the last command of the call
+            const ::cl::Event& getEvent( ) const
+            {
+                return m_state->event;
+            }
+
+            //! True when every command of the call is done; the result may still have to be computed by get( )
+            bool ready( ) const
+            {
+                return m_state->event( ) == NULL ||
+                       m_state->event.getInfo< CL_EVENT_COMMAND_EXECUTION_STATUS >( ) == CL_COMPLETE;
+            }
+
+            //! Waits for the call to finish
+            void wait( ) const
+            {
+                m_state->complete( );
+            }
+
+            //! Waits for the call to finish and returns its result
+            T get( ) const
+            {
+                wait( );
+                return *boost::static_pointer_cast< T >( m_state->result );
+            }
+
+        private:
+            boost::shared_ptr< ::bolt::cl::detail::deferred_completion > m_state;
+        };
+
+        template< >
+        class future< void >
+        {
+        public:
+            future( )
+            {}
+
+            explicit future( const boost::shared_ptr< ::bolt::cl::detail::deferred_completion >& state ): m_state( state )
+            {}
+
+            const ::cl::Event& getEvent( ) const
+            {
+                return m_state->event;
+            }
+
+            bool ready( ) const
+            {
+                return m_state->event( ) == NULL ||
+                       m_state->event.getInfo< CL_EVENT_COMMAND_EXECUTION_STATUS >( ) == CL_COMPLETE;
+            }
+
+            void wait( ) const
+            {
+                m_state->complete( );
+            }
+
+            void get( ) const
+            {
+                wait( );
+            }
+
+        private:
+            boost::shared_ptr< ::bolt::cl::detail::deferred_completion > m_state;
+        };
+
+        /*! \brief Enqueues a bolt::cl::transform and returns without waiting for it.
+        *   \details The commands run after the events in \p dependencies, and after everything enqueued before on
+        *   the command queue of \p ctl.  Only the device paths of ranges in device_vectors are asynchronous; ranges
+        *   in host memory, and runs on the host, are done when the call returns.
+        */
+        template< typename InputIterator, typename OutputIterator, typename UnaryFunction >
+        future< void > transform( control& ctl, const InputIterator& first, const InputIterator& last,
+                                  const OutputIterator& result, const UnaryFunction& f,
+                                  const event_list& dependencies = event_list( ), const std::string& user_code = "" );
+
+        //! Enqueues a binary bolt::cl::transform and returns without waiting for it
+        template< typename InputIterator1, typename InputIterator2, typename OutputIterator, typename BinaryFunction >
+        future< void > transform( control& ctl, const InputIterator1& first1, const InputIterator1& last1,
+                                  const InputIterator2& first2, const OutputIterator& result, const BinaryFunction& f,
+                                  const event_list& dependencies = event_list( ), const std::string& user_code = "" );
+
+        //! Enqueues a bolt::cl::inclusive_scan and returns without waiting for it
+        template< typename InputIterator, typename OutputIterator, typename BinaryFunction >
+        future< void > inclusive_scan( control& ctl, const InputIterator& first, const InputIterator& last,
+                                       const OutputIterator& result, const BinaryFunction& binary_op,
+                                       const event_list& dependencies = event_list( ), const std::string& user_code = "" );
+
+        //! Enqueues a bolt::cl::exclusive_scan and returns without waiting for it
+        template< typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction >
+        future< void > exclusive_scan( control& ctl, const InputIterator& first, const InputIterator& last,
+                                       const OutputIterator& result, const T& init, const BinaryFunction& binary_op,
+                                       const event_list& dependencies = event_list( ), const std::string& user_code = "" );
+
+        /*! \brief Enqueues a bolt::cl::reduce and returns without waiting for it.
+        *   \details The device reduces the range to one value per work group; future::get( ) reduces those on the
+        *   host.
+        */
+        template< typename InputIterator, typename T, typename BinaryFunction >
+        future< T > reduce( control& ctl, const InputIterator& first, const InputIterator& last, const T& init,
+                            const BinaryFunction& binary_op, const event_list& dependencies = event_list( ),
+                            const std::string& user_code = "" );
+
+        //! Enqueues a bolt::cl::sort and returns without waiting for it
+        template< typename RandomAccessIterator, typename StrictWeakOrdering >
+        future< void > sort( control& ctl, const RandomAccessIterator& first, const RandomAccessIterator& last,
+                             const StrictWeakOrdering& comp, const event_list& dependencies = event_list( ),
+                             const std::string& user_code = "" );
+
+        /*!   \}  */
+
+        }
+    }
+}
+
+#include <bolt/cl/detail/async.inl>
+
+#endif
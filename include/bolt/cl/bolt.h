@@ -35,6 +35,9 @@
 #include <string>
 #include <map>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
 #include "bolt/BoltVersion.h"
 #include "bolt/cl/control.h"
 #include "bolt/cl/clcode.h"
@@ -145,6 +148,12 @@ namespace bolt {
             const std::string&  compileOptions = ""
                  );
 
+        /*! \brief Releases the kernels that getKernels cached for the calling thread
+            *  \details getKernels remembers the kernels it returns for each kernel specialization, so that repeated
+            *  calls skip assembling the kernel string and creating the kernels.  The cache is private to each thread.
+            */
+        void clearKernelCache( );
+
         /*! \brief Query the Bolt library for version information
             *  \details Return the major, minor and patch version numbers associated with the Bolt library
             *  \param[out] major Major functionality change
@@ -193,88 +202,151 @@ namespace bolt {
         }
         #define V_OPENCL( status, message ) V_OpenCL( status, message, __LINE__ )
 
-        void wait( const bolt::cl::control &ctl, ::cl::Event &e );
+        /*! \brief Waits for \p e to complete with the wait mode of \p ctl
+        *   \param site Names the call that waits, e.g. the algorithm whose kernel \p e belongs to.  BalancedWait
+        *   keeps the completion times of every site, device and command type apart, and sizes the time it spins
+        *   from them; waits without a site share the history of their command type.
+        *   \details BalancedWait spins, pausing the core between polls, for about twice as long as the waits of the
+        *   site took so far, bounded by 200 microseconds, and only briefly for sites whose waits took longer.  If
+        *   the command is not done by then, the thread blocks until the completion callback of the event wakes it.
+        */
+        void wait( const bolt::cl::control &ctl, ::cl::Event &e, const char* site = NULL );
+
+        /*! \brief Counters describing the balanced waits since the last resetWaitStatistics( ) */
+        struct waitStatistics
+        {
+            cl_ulong waits;                 // waits in BalancedWait mode
+            cl_ulong spinCompletions;       // waits whose command completed while they spun
+            cl_ulong blockingWaits;         // waits that blocked after their spin window
+            cl_ulong spinNanoseconds;       // time spent spinning, over all waits
+            cl_ulong wakeupNanoseconds;     // time from the completion callback to the blocked thread running, summed
+            cl_ulong maxWakeupNanoseconds;  // the longest of those
+        };
+
+        waitStatistics getWaitStatistics( );
+        void resetWaitStatistics( );
+
+        /******************************************************************
+         * Program Digest - compact identity of a compiled program
+         *****************************************************************/
+        /*! \brief A 128-bit digest that identifies a program by the strings it was built from.
+        *   \details Two independent 64-bit lanes are accumulated over every string passed to add(); the length
+        *   of each string is folded in as well, so that the concatenation boundaries are part of the digest.
+        *   This is not a cryptographic hash; it is only used to name and look up compiled programs.
+        */
+        struct ProgramDigest
+        {
+            cl_ulong high;
+            cl_ulong low;
+
+            bool operator==( const ProgramDigest& rhs ) const { return ( high == rhs.high ) && ( low == rhs.low ); }
+            bool operator!=( const ProgramDigest& rhs ) const { return !( *this == rhs ); }
+            bool operator<( const ProgramDigest& rhs ) const
+            {
+                return ( high < rhs.high ) || ( ( high == rhs.high ) && ( low < rhs.low ) );
+            }
+
+            //! Returns the digest as 32 lower case hexadecimal characters
+            ::std::string toString( ) const;
+        };
+
+        class ProgramDigester
+        {
+            public:
+                ProgramDigester( );
+
+                //! Folds a string, and its length, into the digest
+                ProgramDigester& add( const ::std::string& str );
+
+                //! Folds raw bytes into the digest
+                ProgramDigester& add( const void* data, size_t size );
+
+                //! Returns the digest of everything added so far; the digester may continue to be used
+                ProgramDigest digest( ) const;
+
+            private:
+                cl_ulong m_lane0;
+                cl_ulong m_lane1;
+                cl_ulong m_length;
+        };
 
         /******************************************************************
          * Program Map - so each kernel is only compiled once
          *****************************************************************/
-        /*! \brief This structure ensures that a kernel is compiled only once for specified devices.
+        /*! \brief Identifies a compiled program within this process.
+        *   \details The context and device are compared by handle; the compile options and the complete kernel
+        *   string are represented by their ProgramDigest, so that a lookup never compares the kernel source.
         */
         struct ProgramMapKey
         {
-            ::cl::Context context;
-            ::std::string device;
-            ::std::string compileOptions;
-            ::std::string kernelSource;
+            cl_context context;
+            cl_device_id device;
+            ProgramDigest digest;
+
+            bool operator<( const ProgramMapKey& rhs ) const
+            {
+                if( context != rhs.context )
+                    return context < rhs.context;
+                if( device != rhs.device )
+                    return device < rhs.device;
+                return digest < rhs.digest;
+            }
         };
 
         struct ProgramMapValue
         {
+            //  The context and device are retained, so that their handles are not reused while the entry lives
+            ::cl::Context context;
+            ::cl::Device device;
             ::cl::Program program;
         };
 
-        struct ProgramMapKeyComp
+        /*! \brief This map ensures that a kernel is compiled only once for specified devices.
+        *   \details The map is split into shards selected by the digest of the key, each guarded by its own
+        *   reader/writer lock.  Lookups of programs that are already built take a shared lock only.  A program that
+        *   is missing is built by exactly one caller; other callers asking for the same key wait for that build,
+        *   while callers asking for different keys are not held up by it.
+        */
+        class ProgramMap
         {
-            bool operator( )( const ProgramMapKey& lhs, const ProgramMapKey& rhs ) const
+        public:
+            typedef boost::function< ::cl::Program ( ) > builder;
+
+            //! Copies the program stored under \p key into \p program; returns false if it is not built yet
+            bool find( const ProgramMapKey& key, ::cl::Program& program ) const;
+
+            /*! \brief Returns the program stored under \p key, calling \p build to create it if it is missing
+            *   \details \p build is called at most once per key at a time; if it throws, the exception is
+            *   propagated to its caller and the next caller of acquire( ) for the same key tries again.
+            */
+            ::cl::Program acquire( const ProgramMapKey& key,
+                                   const ::cl::Context& context,
+                                   const ::cl::Device& device,
+                                   const builder& build );
+
+            //! Removes every program from the map; programs that are being built are not affected
+            void clear( );
+
+            //! Returns the number of programs in the map
+            size_t size( ) const;
+
+        private:
+            static const size_t shardCount = 16;
+
+            struct shard
             {
-                int comparison;
-                // context
-                // Do I really need to compare the context? Yes, required by OpenCL. -DT
-                if( lhs.context() < rhs.context() )
-                    return true;
-                else if( lhs.context() > rhs.context() )
-                    return false;
-                // else equal; compare using next element of key
-
-                // device
-                comparison = lhs.device.compare(rhs.device);
-                //std::cout << "Compare Device: " << comparison << std::endl;
-                if( comparison < 0 )
-                {
-                    return true;
-                }
-                else if( comparison > 0 )
-                {
-                    return false;
-                }
-                // else equal; compare using next element of key
+                mutable boost::shared_mutex guard;
+                ::std::map< ProgramMapKey, ProgramMapValue > programs;
+                ::std::map< ProgramMapKey, boost::shared_ptr< boost::mutex > > pending;
+            };
 
-                // compileOptions
-                comparison = lhs.compileOptions.compare(rhs.compileOptions);
-                //std::cout << "Compare Options: " << comparison << std::endl;
-                if( comparison < 0 )
-                {
-                    return true;
-                }
-                else if( comparison > 0 )
-                {
-                    return false;
-                }
-                //else
-                //    std::cout << "<" << lhs.compileOptions << "> == <" << rhs.compileOptions << ">" << std::endl;
-                // else equal; compare using next element of key
-
-                // kernelSource
-                comparison = lhs.kernelSource.compare(rhs.kernelSource);
-                //std::cout << "Compare Source: " << comparison << std::endl;
-                if( comparison < 0 )
-                    return true;
-                else if( comparison > 0 )
-                    return false;
-                //else
-                //    std::cout << "<lhs.kernelSource> == <rhs.kernelSource>" << std::endl;
-                // else equal; compare using next element of key
-
-                // all elements equal
-                return false;
-            }
-        };
+            shard& shardOf( const ProgramMapKey& key ) { return m_shards[ key.digest.low % shardCount ]; }
+            const shard& shardOf( const ProgramMapKey& key ) const { return m_shards[ key.digest.low % shardCount ]; }
 
-        typedef ::std::map< ProgramMapKey, ProgramMapValue, ProgramMapKeyComp > ProgramMap;
-        //typedef ::std::map< ::std::string, ProgramMapValue> ProgramMap;
+            shard m_shards[ shardCount ];
+        };
 
         // declared in bolt.cpp
-        extern boost::mutex programMapMutex;
         extern ProgramMap programMap;
 
     };
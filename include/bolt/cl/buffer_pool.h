@@ -0,0 +1,181 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+/*! \file bolt/cl/buffer_pool.h
+    \brief Caching allocator for the scratch buffers of the Bolt algorithms.
+*/
+
+//  bolt.h includes this header through control.h, after the OpenCL headers; when this header comes first, the
+//  pool is declared by that nested include
+#include "bolt/cl/bolt.h"
+
+#pragma once
+#if !defined( BOLT_CL_BUFFER_POOL_H )
+#define BOLT_CL_BUFFER_POOL_H
+
+#include <list>
+#include <map>
+#include <boost/atomic.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace bolt {
+    namespace cl {
+
+        /*! \addtogroup miscellaneous
+        */
+
+        /*! \addtogroup CL-bufferpool
+        * \ingroup miscellaneous
+        * \{
+        */
+
+        /*! \brief The \p BufferPool hands out the temporary device buffers that the algorithms acquire through
+        *   control::acquireBuffer, and keeps them for later requests when they are released.
+        *   \details There is one pool for every OpenCL context, shared by all the controls whose command queue
+        *   belongs to that context, so a control made for a single request reuses the buffers of the requests
+        *   before it.  The pool lives as long as one of these controls, or one of its buffers, is in use; then it
+        *   frees its cached buffers, and the next control of the context gets a new pool.
+        *
+        *   Buffers are allocated in power of two size classes, starting at \p minBufferSize bytes, and are kept
+        *   apart by memory flags.  A request is served by a cached buffer of its own size class, or else of the
+        *   next larger one; only when neither is free is a new buffer created.  The bytes held by the pool, whether
+        *   in use or cached, are bounded by a high-water mark: before a new buffer is created, the cached buffers
+        *   that were released longest ago are freed until the new buffer fits.  Buffers in use are never freed,
+        *   so the mark can be exceeded while they are outstanding.
+        *
+        *   The cached buffers are split into shards, and every thread works on the shard its id hashes to, so
+        *   threads that run algorithms at the same time rarely wait for each other.  A buffer returns to the shard
+        *   of the thread that acquired it; a thread looks into the other shards only when its own has no buffer
+        *   that fits, and the high-water mark frees the oldest buffers of its own shard first.  Releasing a buffer
+        *   does not take a lock; the buffer is pushed on a lock-free list of its shard, which the next acquire
+        *   moves back into the size classes.
+        *
+        *   Read only buffers that are initialized from host memory, which is how the algorithms pass their
+        *   functors to the kernels, are served from the pool and filled with a blocking write.  Every other
+        *   buffer that wraps host memory is created for the request and released with it.
+        *
+        *   The default high-water mark can be set with the environment variable BOLT_BUFFER_POOL_SIZE_MB.
+        */
+        class BufferPool: public boost::enable_shared_from_this< BufferPool >
+        {
+        public:
+            typedef boost::shared_ptr< ::cl::Buffer > buffPointer;
+
+            /*! \brief Counters describing how the pool has been used since the last resetStatistics( ) */
+            struct statistics
+            {
+                size_t hits;        // requests served by a cached buffer
+                size_t misses;      // requests that created a new buffer
+                size_t evictions;   // cached buffers freed to honor the high-water mark
+                size_t bytesHeld;   // bytes of all buffers owned by the pool, in use or cached
+                size_t bytesInUse;  // bytes of the buffers currently handed out
+            };
+
+            //! The smallest size class
+            static const size_t minBufferSize = 256;
+
+            /*! \brief Returns the pool of the context of \p queue, creating it on first use
+            *   \details A queue that is not initialized gets a pool of its own.
+            */
+            static boost::shared_ptr< BufferPool > getPool( const ::cl::CommandQueue& queue );
+
+            BufferPool( );
+            ~BufferPool( );
+
+            /*! \brief Returns a buffer of at least \p reqSize bytes; it goes back to the pool when the last copy
+            *   of the returned pointer is destroyed
+            *   \param queue The command queue whose context the buffer belongs to; read only buffers that are
+            *   initialized from \p host_ptr are written through it
+            */
+            buffPointer acquire( const ::cl::CommandQueue& queue, size_t reqSize, cl_mem_flags flags,
+                                 const void* host_ptr );
+
+            //! Sets the number of bytes the pool may hold before it frees cached buffers
+            void setMaxSize( size_t maxSize );
+            size_t getMaxSize( ) const;
+
+            //! Returns the number of bytes held by the pool, in use or cached
+            size_t totalSize( );
+
+            //! Frees every cached buffer; buffers in use return to the pool when they are released
+            void clear( );
+
+            statistics getStatistics( );
+            void resetStatistics( );
+
+            //! Returns the size class of a request; buffers of class \p c hold 2^c bytes
+            static unsigned sizeClass( size_t reqSize );
+
+        private:
+            BufferPool( const BufferPool& );
+            BufferPool& operator=( const BufferPool& );
+
+            struct pooledBuffer;
+            class recycleBuffer;
+
+            struct freeKey
+            {
+                cl_context context;
+                cl_mem_flags flags;
+                unsigned sizeClass;
+
+                bool operator<( const freeKey& rhs ) const;
+            };
+
+            typedef std::list< pooledBuffer* > bufferList;
+            typedef std::map< freeKey, bufferList > freeMap;
+
+            //  The cached buffers of the threads whose ids hash to the same shard
+            struct shard
+            {
+                shard( ): released( NULL ) {}
+
+                boost::atomic< pooledBuffer* > released;  // lock-free list of the buffers released since the last collect( )
+
+                boost::mutex guard; // protects everything below
+                freeMap     free;   // cached buffers by context, flags and size class
+                bufferList  lru;    // cached buffers, the least recently released first
+            };
+
+            size_t threadShard( ) const;
+            pooledBuffer* take( size_t home, cl_context context, cl_mem_flags flags, unsigned sizeClass );
+            pooledBuffer* create( size_t home, const ::cl::Context& context, cl_mem_flags flags, unsigned sizeClass );
+            void recycle( pooledBuffer* buffer );
+            void collect( shard& from );
+            size_t evict( shard& from, size_t maxSize );
+            size_t trim( size_t home, size_t maxSize );
+
+            cl_context                  m_context;  // the context the pool is registered for, or NULL
+            size_t                      m_numShards;
+            boost::scoped_array< shard > m_shards;
+
+            boost::atomic< size_t >     m_maxSize;
+            boost::atomic< size_t >     m_bytesHeld;
+            boost::atomic< size_t >     m_bytesInUse;
+            boost::atomic< size_t >     m_hits;
+            boost::atomic< size_t >     m_misses;
+            boost::atomic< size_t >     m_evictions;
+        };
+
+        /*!   \}  */
+
+    };
+};
+
+#endif
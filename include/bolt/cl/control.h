@@ -28,10 +28,16 @@
 #include <bolt/cl/bolt.h>
 #include <string>
 #include <map>
+#include <vector>
 
+#include <boost/function.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/shared_ptr.hpp>
+#include "bolt/cl/buffer_pool.h"
+#ifdef ENABLE_TBB
+#include "bolt/btbb/arena.h"
+#endif
 
 /*! \file control.h
 */
@@ -51,6 +57,28 @@ namespace bolt {
         * \{
         */
 
+        namespace detail
+        {
+            /*! \brief What an asynchronous call leaves to be done after it returns; see bolt/cl/async.h
+            *   \details The algorithms of the call enqueue their commands and return without waiting for them.  The
+            *   scratch buffers they acquire stay out of the buffer pool until the commands are done, and an algorithm
+            *   whose result is computed on the host leaves that step in \p finish.
+            */
+            class deferred_completion
+            {
+            public:
+                ~deferred_completion( );
+
+                //! Waits for the commands, runs finish and releases the scratch buffers; later calls return at once
+                void complete( );
+
+                ::cl::Event event;                              // completes with the last command of the call
+                std::vector< BufferPool::buffPointer > scratch; // buffers the commands use
+                boost::function< void ( ) > finish;             // the host side tail of the algorithm, if it has one
+                boost::shared_ptr< void > result;               // what finish computes, for algorithms with a result
+            };
+        }
+
         /*! The \p control class lets you control the parameters of a specific Bolt algorithm call,
          such as the command-queue where GPU kernels run, debug information, load-balancing with
          the host, and more.  Each Bolt Algorithm call accepts the
@@ -110,7 +138,7 @@ namespace bolt {
             enum e_AutoTuneMode{NoAutoTune=0x0,
                                 AutoTuneDevice=0x1,
                                 AutoTuneWorkShape=0x2,
-                                AutoTuneAll=0x3}; // FIXME, experimental
+                                AutoTuneAll=0x3};
             struct debug {
                 static const unsigned None=0;
                 static const unsigned Compile = 0x1;
@@ -120,7 +148,7 @@ namespace bolt {
                 static const unsigned AutoTune = 0x10;
             };
 
-            enum e_WaitMode {BalancedWait,	// Balance of Busy and Nice: tries to use Busy for short-running kernels.  \todo: Balanced currently maps to nice.
+            enum e_WaitMode {BalancedWait,	// Balance of Busy and Nice: spins for kernels that have completed quickly before, then blocks.  See bolt::cl::wait.
                              NiceWait,		// Use an OS semaphore to detect completion status.
                              BusyWait,		// Busy a CPU core continuously monitoring results.  Lowest-latency, but requires a dedicated core.
                              ClFinish,      // Call clFinish on the queue.
@@ -144,7 +172,8 @@ namespace bolt {
                 m_compileOptions(getDefault().m_compileOptions),
                 m_compileForAllDevices(getDefault().m_compileForAllDevices),
                 m_waitMode(getDefault().m_waitMode),
-                m_unroll(getDefault().m_unroll)
+                m_unroll(getDefault().m_unroll),
+                m_bufferPool(BufferPool::getPool(m_commandQueue))
             {};
 
 
@@ -159,7 +188,9 @@ namespace bolt {
                 m_compileOptions(ref.m_compileOptions),
                 m_compileForAllDevices(ref.m_compileForAllDevices),
                 m_waitMode(ref.m_waitMode),
-                m_unroll(ref.m_unroll)
+                m_unroll(ref.m_unroll),
+                m_bufferPool(ref.m_bufferPool),
+                m_deferred(ref.m_deferred)
             {
                 //printf("control::copy construcor\n");
             };
@@ -169,7 +200,11 @@ namespace bolt {
             //! Only one command-queue can be specified for each call; Bolt does not load-balance across
             //! multiple command queues.  Bolt also uses the specified command queue to determine the OpenCL context and
             //! device.
-            void setCommandQueue(::cl::CommandQueue commandQueue) { m_commandQueue = commandQueue; };
+            void setCommandQueue(::cl::CommandQueue commandQueue)
+            {
+                m_commandQueue = commandQueue;
+                m_bufferPool = BufferPool::getPool( m_commandQueue );
+            };
 
             //! If enabled, Bolt can use the host CPU to run parts of the algorithm.  If false, Bolt runs the
             //! entire algorithm using the device specified by the command-queue. This can be appropriate
@@ -203,9 +238,22 @@ namespace bolt {
                 the optimal point for a given algorithm and device; typically 8-12 will deliver good results */
             void setWGPerComputeUnit(int wgPerComputeUnit) { m_wgPerComputeUnit = wgPerComputeUnit; };
 
+            /*! Set what Bolt tunes.  With AutoTuneWorkShape, the OpenCL path of reduce times a range of work-group
+                sizes, work-groups per compute unit and unroll factors on the first call for each type, device
+                and input size, and reuses the fastest afterwards; scan, unless it works in place, and the
+                bitonic sort of types that are not radix sorted tune their work-group size the same way.  See
+                bolt::cl::work_shape_tuner.  Automatic run mode chooses the device regardless of this setting. */
+            void setAutoTuneMode(e_AutoTuneMode autoTune) { m_autoTune = autoTune; };
+
             /*! Set the method used to detect completion at the end of a Bolt routine. */
             void setWaitMode(e_WaitMode waitMode) { m_waitMode = waitMode; };
 
+            /*! \brief Makes the algorithms run with this control return without waiting for their commands, and
+            *   record what is left to do in \p deferred; an empty pointer makes them block again.  The functions of
+            *   bolt/cl/async.h set it on a copy of the control of their caller.
+            */
+            void setDeferred( const boost::shared_ptr< detail::deferred_completion >& deferred ) { m_deferred = deferred; };
+
             /*! unroll assignment */
             void setUnroll(int unroll) { m_unroll = unroll; };
 
@@ -213,6 +261,19 @@ namespace bolt {
             //! Specify the compile options passed to the OpenCL(TM) compiler.
             void setCompileOptions(std::string &compileOptions) { m_compileOptions = compileOptions; };
 
+#ifdef ENABLE_TBB
+            /*! \brief Sets the number of threads and the NUMA node of the MultiCoreCpu path.
+            *   \details The MultiCoreCpu algorithms of every control run in one TBB task arena, so this setting is
+            *   process wide rather than per control.  The NUMA node is honored with TBB 2021 or later.
+            *   \param concurrency Maximum number of threads, or bolt::btbb::arena::automatic to let TBB decide
+            *   \param numaNode Index of the NUMA node, or bolt::btbb::arena::anyNumaNode
+            */
+            void setCpuConcurrency( int concurrency, int numaNode = bolt::btbb::arena::anyNumaNode )
+            {
+                bolt::btbb::arena::getInstance( ).initialize( concurrency, numaNode );
+            };
+#endif
+
             // getters:
             ::cl::CommandQueue&         getCommandQueue( ) { return m_commandQueue; };
             const ::cl::CommandQueue&   getCommandQueue( ) const { return m_commandQueue; };
@@ -222,11 +283,17 @@ namespace bolt {
             e_RunMode                   getForceRunMode() const { return m_forceRunMode; };
             e_RunMode                   getDefaultPathToRun() const { return m_defaultRunMode; };
             unsigned                    getDebugMode() const { return m_debug;};
+            e_AutoTuneMode              getAutoTuneMode() const { return m_autoTune; };
             int const                   getWGPerComputeUnit() const { return m_wgPerComputeUnit; };
             const ::std::string         getCompileOptions() const { return m_compileOptions; };
             e_WaitMode                  getWaitMode() const { return m_waitMode; };
             int                         getUnroll() const { return m_unroll; };
             bool                        getCompileForAllDevices() const { return m_compileForAllDevices; };
+            detail::deferred_completion* getDeferred() const { return m_deferred.get( ); };
+#ifdef ENABLE_TBB
+            int                         getCpuConcurrency() const { return bolt::btbb::arena::getInstance( ).getConcurrency( ); };
+            int                         getCpuNumaNode() const { return bolt::btbb::arena::getInstance( ).getNumaNode( ); };
+#endif
 
             /*!
               * Return default default \p control structure.  This is used for Bolt API calls when the user
@@ -264,14 +331,18 @@ namespace bolt {
 
             /*! \brief Buffer pool support functions
              */
-            typedef boost::shared_ptr< ::cl::Buffer > buffPointer;
+            typedef BufferPool::buffPointer buffPointer;
 
-            /*! Return device memory size */
+            /*! The buffer pool is shared by all controls whose command queues belong to the same context */
+
+            /*! Return the number of bytes held by the buffer pool, in use or cached */
             size_t totalBufferSize( );
-            /*! Return a pointer to memory from per allocated memory pool */
+            /*! Return a buffer of at least reqSize bytes from the buffer pool; it returns to the pool when released */
             buffPointer acquireBuffer( size_t reqSize, cl_mem_flags flags = CL_MEM_READ_WRITE, const void* host_ptr = NULL );
-            /*! Freeing memory*/
+            /*! Free the cached buffers of the buffer pool, for every control that shares it */
             void freeBuffers( );
+            /*! Return the buffer pool of this control, to read its statistics or set its high-water mark */
+            BufferPool& getBufferPool( ) const { return *m_bufferPool; };
 
         private:
 
@@ -280,11 +351,12 @@ namespace bolt {
                 m_commandQueue( getDefaultCommandQueue( ) ),
                 m_useHost(UseHost),
                 m_debug(debug::None),
-                m_autoTune(AutoTuneAll),
+                m_autoTune(NoAutoTune),
                 m_wgPerComputeUnit(8),
                 m_compileForAllDevices(true),
-                m_waitMode(BusyWait),
-                m_unroll(1)
+                m_waitMode(BalancedWait),
+                m_unroll(1),
+                m_bufferPool(BufferPool::getPool(m_commandQueue))
             {
                 ::cl_device_type dType = CL_DEVICE_TYPE_CPU;
                 if(m_commandQueue() != NULL)
@@ -324,89 +396,8 @@ namespace bolt {
             e_WaitMode          m_waitMode;
             int                 m_unroll;
 
-            struct descBufferKey
-            {
-                ::cl::Context buffContext;
-                cl_mem_flags memFlags;
-                const void* host_ptr;
-            };
-
-            struct descBufferValue
-            {
-                size_t buffSize;
-                bool inUse;
-                ::cl::Buffer buffBuff;
-            };
-
-            struct descBufferComp
-            {
-                bool operator( )( const descBufferKey& lhs, const descBufferKey& rhs ) const
-                {
-                    if( lhs.memFlags < rhs.memFlags )
-                    {
-                        return true;
-                    }
-                    else if( lhs.memFlags == rhs.memFlags )
-                    {
-                        if( lhs.buffContext( ) < rhs.buffContext( ) )
-                        {
-                            return true;
-                        }
-                        else if( lhs.buffContext( ) == rhs.buffContext( ) )
-                        {
-                            if( lhs.host_ptr < rhs.host_ptr )
-                            {
-                                return true;
-                            }
-                            else
-                            {
-                                return false;
-                            }
-                        }
-                        else
-                        {
-                            return false;
-                        }
-                    }
-                    else
-                    {
-                        return false;
-                    }
-                }
-            };
-
-            typedef std::multimap< descBufferKey, descBufferValue, descBufferComp > mapBufferType;
-
-            /*! \brief Class used with shared_ptr<> as a custom deleter, to signal to the context object when
-             * a buffer is finished being used by a client.  We want to remove the ability to destroy the buffer
-             * from the caller; only the context object shall control the lifetime of these scratch
-             * buffers.  This most likely will happen in the default destructor
-             * generated by the smart_ptr<> class, however, a client also has the option of calling reset()
-             * directly on the smart_ptr<>.  In order for this class to work, the iterator that we store
-             * MUST NOT BE INVALIDATED BY INSERTIONS OR DELETIONS INTO THE UNDERLYING CONTAINER
-            */
-            class UnlockBuffer
-            {
-                mapBufferType::iterator m_iter;
-                control& m_control;
-
-            public:
-                //  Basic constructor requires a reference to the container and a positional element
-                UnlockBuffer( control& p_control, mapBufferType::iterator it ): m_iter( it ), m_control( p_control )
-                {}
-
-                void operator( )( const void* pBuff )
-                {
-                    //  TODO: I think a general mutex is overkill here; we should try to use an interlocked instruction to modify the
-                    //  inUse flag
-                    boost::lock_guard< boost::mutex > lock( m_control.mapGuard );
-                    m_iter->second.inUse = false;
-                }
-            };
-
-            friend class UnlockBuffer;
-            mapBufferType mapBuffer;
-            boost::mutex mapGuard;
+            boost::shared_ptr< BufferPool > m_bufferPool;
+            boost::shared_ptr< detail::deferred_completion > m_deferred;  // set while an asynchronous call runs
 
         }; // end class control
 
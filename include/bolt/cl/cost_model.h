@@ -0,0 +1,215 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+/*! \file bolt/cl/cost_model.h
+    \brief Picks the backend of the calls whose control is in Automatic mode.
+*/
+
+#pragma once
+#if !defined( BOLT_CL_COST_MODEL_H )
+#define BOLT_CL_COST_MODEL_H
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/device_vector.h"
+#include "bolt/cl/iterator/permutation_iterator.h"
+#include "bolt/cl/iterator/transform_iterator.h"
+
+namespace bolt {
+    namespace cl {
+
+        /*! \addtogroup miscellaneous
+        */
+
+        /*! \addtogroup CL-costmodel
+        * \ingroup miscellaneous
+        * \{
+        */
+
+        /*! \brief The \p cost_model estimates how long a call takes on the serial, multicore and OpenCL backends, and
+        *   runs the calls whose control is in Automatic mode on the one that is expected to be fastest.
+        *   \details The estimate of a backend is its fixed cost per call, plus the bytes the call works on divided
+        *   by the throughput of the backend.  Sorts work on every byte about log2( n ) times, and pay the OpenCL
+        *   launch cost as often.  Data that is not where a backend works on it is transferred first: ranges in host
+        *   memory are copied to the device for OpenCL, and ranges in device_vectors are mapped to the host for the
+        *   CPU backends.  Transfers are free on devices that share the memory of the host.
+        *
+        *   The costs and throughputs of a device are measured with a few small benchmarks when the device is first
+        *   used in Automatic mode.  The fixed cost of a backend is the time of a call that has no work, which for
+        *   the multicore backend is waking a set of waiting threads and waiting for them to finish.  Once a device
+        *   has a profile, the calls on it look the profile up by device id without taking a lock.
+        *
+        *   If the environment variable BOLT_COST_PROFILE names a file, the profiles of the devices are read from it
+        *   instead, and the profiles of devices that are not in it are measured once and added to it.
+        */
+        class cost_model
+        {
+        public:
+            enum e_Complexity { Linear, NLogN };
+            enum e_DataLocation { HostData, DeviceData, NoData };
+
+            //! What the model knows of a device and of the host it runs with
+            struct profile
+            {
+                double serialBytesPerSecond;
+                double multicoreSecondsPerCall;
+                double multicoreBytesPerSecond;
+                double openclSecondsPerCall;
+                double openclBytesPerSecond;
+                double transferBytesPerSecond;
+                bool hostUnifiedMemory;
+            };
+
+            //! The choice of the model for one call, and the time it expected of every backend, in seconds
+            struct estimate
+            {
+                control::e_RunMode runMode;
+                double serialSeconds;
+                double multicoreSeconds;
+                double openclSeconds;
+            };
+
+            static cost_model& getInstance( );
+
+            /*! \brief Estimates a call over \p elements elements of \p elementBytes bytes each
+            *   \param multicore Whether the multicore backend was built; it is not considered otherwise
+            */
+            estimate choose( const control& ctl, size_t elements, size_t elementBytes, e_DataLocation location,
+                             e_Complexity complexity, bool multicore );
+
+            //! Returns the profile of the device of \p ctl, measuring it if it is not known yet
+            profile getProfile( const control& ctl );
+
+            //! Replaces the profile of \p device, e.g. with one measured by the application
+            void setProfile( const ::cl::Device& device, const profile& p );
+
+            //! Reads the profiles in \p path, in addition to the known ones; returns false if it cannot be read
+            bool loadProfiles( const std::string& path );
+
+            //! Writes all known profiles to \p path
+            bool saveProfiles( const std::string& path );
+
+        private:
+            cost_model( );
+            cost_model( const cost_model& );
+            cost_model& operator=( const cost_model& );
+
+            //  The profile of a device as the calls read it; device is set once, p may be replaced, or reset to
+            //  send the next call to m_profiles again
+            struct cachedProfile
+            {
+                boost::atomic< cl_device_id > device;
+                boost::atomic< const profile* > p;
+            };
+
+            //  The number of devices whose profiles are cached; slot 0 is the host
+            static const size_t cacheSlots = 16;
+
+            static std::string deviceKey( const ::cl::Device& device );
+            static profile measure( const control& ctl );
+
+            const profile* cached( cl_device_id device ) const;
+            void publish( cl_device_id device, const profile& p );
+
+            boost::mutex m_guard;   // protects everything below; m_cache is read without it
+            std::map< std::string, profile > m_profiles;
+            std::string m_profilePath;
+            cachedProfile m_cache[ cacheSlots ];
+            std::vector< boost::shared_ptr< const profile > > m_published;  // what m_cache points to, ever
+        };
+
+        /*!   \}  */
+
+        namespace detail
+        {
+            //  Where the elements behind an iterator category live; fancy iterators compute theirs, except those
+            //  that adapt a device_vector
+            inline cost_model::e_DataLocation dataLocation( std::input_iterator_tag )
+            {
+                return cost_model::HostData;
+            }
+
+            inline cost_model::e_DataLocation dataLocation( device_vector_tag )
+            {
+                return cost_model::DeviceData;
+            }
+
+            inline cost_model::e_DataLocation dataLocation( fancy_iterator_tag )
+            {
+                return cost_model::NoData;
+            }
+
+            inline cost_model::e_DataLocation dataLocation( transform_iterator_tag )
+            {
+                return cost_model::DeviceData;
+            }
+
+            inline cost_model::e_DataLocation dataLocation( permutation_iterator_tag )
+            {
+                return cost_model::DeviceData;
+            }
+
+            /*! \brief The run mode of a call whose control is in Automatic mode, over \p elements elements from
+            *   \p first; the decision is logged with BOLTLOG::CaptureLog when BOLT_DEBUG_LOG is defined
+            */
+            template< typename Iterator >
+            control::e_RunMode selectRunMode( const control& ctl, const char* algorithm, const Iterator& first,
+                                              size_t elements, cost_model::e_Complexity complexity = cost_model::Linear )
+            {
+                typedef typename std::iterator_traits< Iterator >::value_type value_type;
+                typedef typename std::iterator_traits< Iterator >::iterator_category iterator_category;
+
+#if defined( ENABLE_TBB )
+                const bool multicore = true;
+#else
+                const bool multicore = false;
+#endif
+                const cost_model::e_DataLocation location = dataLocation( iterator_category( ) );
+                const cost_model::estimate choice = cost_model::getInstance( ).choose( ctl, elements,
+                    sizeof( value_type ), location, complexity, multicore );
+
+#if defined( BOLT_DEBUG_LOG )
+                std::ostringstream msg;
+                msg << algorithm << ": " << elements << " x " << sizeof( value_type ) << " bytes"
+                    << ( location == cost_model::HostData ? " in host memory" :
+                         location == cost_model::DeviceData ? " in device memory" : "" )
+                    << "; serial " << choice.serialSeconds * 1e6 << " us, multicore " << choice.multicoreSeconds * 1e6
+                    << " us, opencl " << choice.openclSeconds * 1e6 << " us";
+
+                BOLTLOG::CodePaths path = BOLTLOG::BOLT_OPENCL_GPU;
+                if( choice.runMode == control::SerialCpu )
+                    path = BOLTLOG::BOLT_SERIAL_CPU;
+                else if( choice.runMode == control::MultiCoreCpu )
+                    path = BOLTLOG::BOLT_MULTICORE_CPU;
+                BOLTLOG::CaptureLog::getInstance( )->CodePathTaken( BOLTLOG::BOLT_AUTOMATIC, path, msg.str( ) );
+#else
+                (void)algorithm;
+#endif
+                return choice.runMode;
+            }
+        }
+
+    };
+};
+
+#endif
@@ -61,6 +61,8 @@ namespace bolt {
                    return x == temp;
             };
 
+            T getTargetValue() const { return _targetValue; }
+
         private:
             T _targetValue;
         };
@@ -0,0 +1,133 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_CL_ASYNC_INL )
+#define BOLT_CL_ASYNC_INL
+#pragma once
+
+namespace bolt {
+    namespace cl {
+        namespace async {
+
+        namespace detail
+        {
+            /*! \brief Runs \p call with a copy of \p ctl that does not wait for the commands it enqueues, after the
+            *   events in \p dependencies; returns what is left to be done
+            */
+            template< typename Call >
+            boost::shared_ptr< ::bolt::cl::detail::deferred_completion > defer( control& ctl,
+                const event_list& dependencies, const Call& call )
+            {
+                boost::shared_ptr< ::bolt::cl::detail::deferred_completion > state(
+                    new ::bolt::cl::detail::deferred_completion );
+
+                control l_ctl( ctl );
+                l_ctl.setDeferred( state );
+
+                ::cl::CommandQueue& queue = l_ctl.getCommandQueue( );
+                if( !dependencies.empty( ) )
+                    V_OPENCL( queue.enqueueWaitForEvents( dependencies ), "failed to enqueue the dependencies of an asynchronous call" );
+
+                call( l_ctl );
+
+                //  The marker completes after every command the call enqueued, whichever of them came last
+                V_OPENCL( queue.enqueueMarker( &state->event ), "failed to enqueue the marker of an asynchronous call" );
+                V_OPENCL( queue.flush( ), "failed to flush the command queue of an asynchronous call" );
+
+                return state;
+            }
+        }
+
+        template< typename InputIterator, typename OutputIterator, typename UnaryFunction >
+        future< void > transform( control& ctl, const InputIterator& first, const InputIterator& last,
+                                  const OutputIterator& result, const UnaryFunction& f,
+                                  const event_list& dependencies, const std::string& user_code )
+        {
+            return future< void >( detail::defer( ctl, dependencies, [ & ]( control& l_ctl )
+            {
+                bolt::cl::transform( l_ctl, first, last, result, f, user_code );
+            } ) );
+        }
+
+        template< typename InputIterator1, typename InputIterator2, typename OutputIterator, typename BinaryFunction >
+        future< void > transform( control& ctl, const InputIterator1& first1, const InputIterator1& last1,
+                                  const InputIterator2& first2, const OutputIterator& result, const BinaryFunction& f,
+                                  const event_list& dependencies, const std::string& user_code )
+        {
+            return future< void >( detail::defer( ctl, dependencies, [ & ]( control& l_ctl )
+            {
+                bolt::cl::transform( l_ctl, first1, last1, first2, result, f, user_code );
+            } ) );
+        }
+
+        template< typename InputIterator, typename OutputIterator, typename BinaryFunction >
+        future< void > inclusive_scan( control& ctl, const InputIterator& first, const InputIterator& last,
+                                       const OutputIterator& result, const BinaryFunction& binary_op,
+                                       const event_list& dependencies, const std::string& user_code )
+        {
+            return future< void >( detail::defer( ctl, dependencies, [ & ]( control& l_ctl )
+            {
+                bolt::cl::inclusive_scan( l_ctl, first, last, result, binary_op, user_code );
+            } ) );
+        }
+
+        template< typename InputIterator, typename OutputIterator, typename T, typename BinaryFunction >
+        future< void > exclusive_scan( control& ctl, const InputIterator& first, const InputIterator& last,
+                                       const OutputIterator& result, const T& init, const BinaryFunction& binary_op,
+                                       const event_list& dependencies, const std::string& user_code )
+        {
+            return future< void >( detail::defer( ctl, dependencies, [ & ]( control& l_ctl )
+            {
+                bolt::cl::exclusive_scan( l_ctl, first, last, result, init, binary_op, user_code );
+            } ) );
+        }
+
+        template< typename InputIterator, typename T, typename BinaryFunction >
+        future< T > reduce( control& ctl, const InputIterator& first, const InputIterator& last, const T& init,
+                            const BinaryFunction& binary_op, const event_list& dependencies,
+                            const std::string& user_code )
+        {
+            boost::shared_ptr< ::bolt::cl::detail::deferred_completion > state;
+            T value = init;
+            state = detail::defer( ctl, dependencies, [ & ]( control& l_ctl )
+            {
+                value = bolt::cl::reduce( l_ctl, first, last, init, binary_op, user_code );
+            } );
+
+            //  Only the device path leaves its tail to the future; the others have their result already
+            if( !state->result )
+                state->result.reset( new T( value ) );
+
+            return future< T >( state );
+        }
+
+        template< typename RandomAccessIterator, typename StrictWeakOrdering >
+        future< void > sort( control& ctl, const RandomAccessIterator& first, const RandomAccessIterator& last,
+                             const StrictWeakOrdering& comp, const event_list& dependencies,
+                             const std::string& user_code )
+        {
+            return future< void >( detail::defer( ctl, dependencies, [ & ]( control& l_ctl )
+            {
+                bolt::cl::sort( l_ctl, first, last, comp, user_code );
+            } ) );
+        }
+
+        }
+    }
+}
+
+#endif
@@ -176,7 +176,7 @@ namespace bolt {
                             NULL,
                             &kernelEvent);
                         V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for kernel" );
-                        bolt::cl::wait(ctl, kernelEvent);
+                        bolt::cl::wait(ctl, kernelEvent, "binary_search");
                     }
 
 
@@ -202,7 +202,7 @@ namespace bolt {
                             NULL,
                             &residueKernelEvent);
                         V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for kernel" );
-                        bolt::cl::wait(ctl, residueKernelEvent);
+                        bolt::cl::wait(ctl, residueKernelEvent, "binary_search_residue");
                     }
                 }
                 catch( const ::cl::Error& e)
@@ -218,7 +218,7 @@ namespace bolt {
                 int *h_result = (int*)ctl.getCommandQueue().enqueueMapBuffer(*result, false, CL_MAP_READ, 0,
                     sizeof(int)* totalThreads, NULL, &l_mapEvent, &l_Error );
                 V_OPENCL( l_Error, "Error calling map on the result buffer" );
-                bolt::cl::wait(ctl, l_mapEvent);
+                bolt::cl::wait(ctl, l_mapEvent, "binary_search_result");
 
                 bool r = false;
                 for(int i=0; i<totalThreads; i++)
@@ -256,8 +256,8 @@ namespace bolt {
             {
 
                 typedef typename std::iterator_traits<ForwardIterator>::value_type Type;
-                int sz = static_cast<int>(last - first);
-                if (sz < 1)
+                size_t sz = static_cast< size_t >(last - first);
+                if (sz == 0)
                      return false;
 
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode(); // could be dynamic choice some day.
@@ -312,7 +312,8 @@ namespace bolt {
                 bolt::cl::device_vector_tag )
             {
                 typedef typename std::iterator_traits<DVForwardIterator>::value_type iType;
-                int szElements = static_cast<int>(std::distance(first, last) );
+                size_t szElements = static_cast< size_t >(std::distance(first, last) );
+
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode(); // could be dynamic choice some day.
                 if(runMode == bolt::cl::control::Automatic)
                 {
@@ -362,7 +363,8 @@ namespace bolt {
             {
 
                 typedef typename std::iterator_traits<DVForwardIterator>::value_type iType;
-                int szElements = static_cast<int>(std::distance(first, last) );
+                size_t szElements = static_cast< size_t >(std::distance(first, last) );
+
                 if (szElements == 0)
                     return false;
 
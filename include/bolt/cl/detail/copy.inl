@@ -70,6 +70,8 @@ bool roundUpDivide( Type1& dividend, Type2 divisor, Type3& quotient)
     }
 }
 
+#include "bolt/cl/cost_model.h"
+
 namespace bolt {
 namespace cl {
 
@@ -266,7 +268,7 @@ void copy_enqueue(const bolt::cl::control &ctrl, const DVInputIterator& first, c
     }
 
     // wait for results
-    bolt::cl::wait(ctrl, kernelEvent);
+    bolt::cl::wait(ctrl, kernelEvent, "copy");
 
     // profiling
     cl_command_queue_properties queueProperties;
@@ -306,7 +308,7 @@ void copy_pick_iterator(const bolt::cl::control &ctrl,  const InputIterator& fir
 
      if( runMode == bolt::cl::control::Automatic )
      {
-                runMode = ctrl.getDefaultPathToRun( );
+                runMode = bolt::cl::detail::selectRunMode( ctrl, "copy", first, static_cast< size_t >( n ) );
      }
      #if defined(BOLT_DEBUG_LOG)
      BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -366,7 +368,7 @@ void copy_pick_iterator(const bolt::cl::control &ctrl,  const InputIterator& fir
 
      if( runMode == bolt::cl::control::Automatic )
      {
-         runMode = ctrl.getDefaultPathToRun( );
+         runMode = bolt::cl::detail::selectRunMode( ctrl, "copy", first, static_cast< size_t >( n ) );
      }
      #if defined(BOLT_DEBUG_LOG)
      BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -423,7 +425,7 @@ void copy_pick_iterator(const bolt::cl::control &ctrl,  const DVInputIterator& f
 
      if( runMode == bolt::cl::control::Automatic )
      {
-               runMode = ctrl.getDefaultPathToRun( );
+               runMode = bolt::cl::detail::selectRunMode( ctrl, "copy", first, static_cast< size_t >( n ) );
      }
 
 	 #if defined(BOLT_DEBUG_LOG)
@@ -483,7 +485,7 @@ void copy_pick_iterator(const bolt::cl::control &ctrl,  const DVInputIterator& f
 
      if( runMode == bolt::cl::control::Automatic )
      {
-               runMode = ctrl.getDefaultPathToRun( );
+               runMode = bolt::cl::detail::selectRunMode( ctrl, "copy", first, static_cast< size_t >( n ) );
      }
 
 	 #if defined(BOLT_DEBUG_LOG)
@@ -546,7 +548,7 @@ void copy_pick_iterator(const bolt::cl::control &ctrl,  const DVInputIterator& f
 
      if( runMode == bolt::cl::control::Automatic )
      {
-               runMode = ctrl.getDefaultPathToRun( );
+               runMode = bolt::cl::detail::selectRunMode( ctrl, "copy", first, static_cast< size_t >( n ) );
      }
 
 	 #if defined(BOLT_DEBUG_LOG)
@@ -606,7 +608,7 @@ void copy_pick_iterator(const bolt::cl::control &ctrl,  const DVInputIterator& f
 
      if( runMode == bolt::cl::control::Automatic )
      {
-         runMode = ctrl.getDefaultPathToRun( );
+         runMode = bolt::cl::detail::selectRunMode( ctrl, "copy", first, static_cast< size_t >( n ) );
      }
      
 	 #if defined(BOLT_DEBUG_LOG)
@@ -720,7 +722,8 @@ template<typename InputIterator, typename OutputIterator>
 OutputIterator copy(const bolt::cl::control &ctrl,  InputIterator first, InputIterator last, OutputIterator result,
             const std::string& user_code)
 {
-    int n = static_cast<int>( std::distance( first, last ) );
+    typename std::iterator_traits< InputIterator >::difference_type n = std::distance( first, last );
+
     return detail::copy_detect_random_access( ctrl, first, n, result, user_code,
          typename std::iterator_traits< InputIterator >::iterator_category( ) );
 }
@@ -730,7 +733,8 @@ template<typename InputIterator, typename OutputIterator>
 OutputIterator copy( InputIterator first, InputIterator last, OutputIterator result,
             const std::string& user_code)
 {
-    int n = static_cast<int>( std::distance( first, last ) );
+    typename std::iterator_traits< InputIterator >::difference_type n = std::distance( first, last );
+
             return detail::copy_detect_random_access( control::getDefault(), first, n, result, user_code,
                 typename std::iterator_traits< InputIterator >::iterator_category( ) );
 }
@@ -22,6 +22,7 @@
 #ifdef ENABLE_TBB
 //TBB Includes
 #include "bolt/btbb/count.h"
+#include "bolt/btbb/simd_reduce.h"
 #endif
 
 
@@ -30,7 +31,8 @@
 #include "bolt/cl/distance.h"
 #include "bolt/cl/iterator/iterator_traits.h"
 #include "bolt/cl/iterator/transform_iterator.h"
-#include "bolt/cl/iterator/addressof.h"
+#include "bolt/cl/iterator/mapped_range.h"
+#include "bolt/cl/cost_model.h"
 
 namespace bolt{
 namespace cl{
@@ -68,28 +70,16 @@ namespace serial{
 
 		size_t n = (last - first);
 
-        typedef typename std::iterator_traits< InputIterator >::value_type iType;
 		typedef typename bolt::cl::iterator_traits<InputIterator>::difference_type rType;
 
-	    /*Get The associated OpenCL buffer for each of the iterators*/
-        ::cl::Buffer inputBuffer = first.base().getContainer( ).getBuffer( );
-        /*Get The size of each OpenCL buffer*/
-        size_t input_sz = inputBuffer.getInfo<CL_MEM_SIZE>();
-	    
-        cl_int map_err;
-        iType *inputPtr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(inputBuffer, true, CL_MAP_READ, 0, 
-                                                                            input_sz, NULL, NULL, &map_err);
-        auto mapped_ip_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(),
-                                                        ctl, first, inputPtr); 
+        mapped_range
+< InputIterator > input( ctl, first, n, CL_MAP_READ );
+        auto mapped_ip_itr = input.begin( );
 		
 
 	    std::iterator_traits<std::vector<int>::iterator>::difference_type output = std::count_if(mapped_ip_itr,
-			mapped_ip_itr + (int)n, predicate);
+			mapped_ip_itr + n, predicate);
 		
-	    ::cl::Event unmap_event[1];
-        ctl.getCommandQueue().enqueueUnmapMemObject(inputBuffer, inputPtr, NULL, &unmap_event[0] );
-        unmap_event[0].wait(); 		
-
 
 		return (rType)output;
 
@@ -116,6 +106,40 @@ namespace serial{
 #ifdef ENABLE_TBB
 namespace btbb{
 
+    /*! \brief True when the vectorized count of btbb can take the place of count_if: bolt::cl::count compares with
+    *   CountIfEqual, over contiguous elements of a type the count knows.
+    */
+    template< typename InputIterator, typename Predicate >
+    struct simd_count_select: std::false_type {};
+
+    template< typename InputIterator, typename T >
+    struct simd_count_select< InputIterator, bolt::cl::detail::CountIfEqual< T > >: std::integral_constant< bool,
+        bolt::btbb::is_contiguous_iterator< InputIterator, T >::value && bolt::btbb::is_simd_countable< T >::value > {};
+
+    template<typename InputIterator, typename Predicate>
+    std::ptrdiff_t btbb_count( const InputIterator& first, const InputIterator& last, const Predicate& predicate,
+                               std::false_type )
+    {
+        return bolt::btbb::count_if( first, last, predicate );
+    }
+
+    template<typename InputIterator, typename Predicate>
+    std::ptrdiff_t btbb_count( const InputIterator& first, const InputIterator& last, const Predicate& predicate,
+                               std::true_type )
+    {
+        if( first == last )
+            return 0;
+        const auto* p = &*first;
+        return bolt::btbb::simd_count( p, p + ( last - first ), predicate.getTargetValue( ) );
+    }
+
+    template<typename InputIterator, typename Predicate>
+    std::ptrdiff_t btbb_count( const InputIterator& first, const InputIterator& last, const Predicate& predicate )
+    {
+        return btbb_count( first, last, predicate,
+            std::integral_constant< bool, simd_count_select< InputIterator, Predicate >::value >( ) );
+    }
+
 	template<typename InputIterator, typename Predicate>
     typename bolt::cl::iterator_traits<InputIterator>::difference_type
         count(bolt::cl::control &ctl,
@@ -126,7 +150,7 @@ namespace btbb{
 		std::random_access_iterator_tag)
     {
 
-		return bolt::btbb::count_if(first,last,predicate);
+		return btbb_count(first,last,predicate);
 
 	}
 
@@ -143,27 +167,16 @@ namespace btbb{
 
 		size_t n = (last - first);
 
-        typedef typename std::iterator_traits< InputIterator >::value_type iType;
 		typedef typename bolt::cl::iterator_traits<InputIterator>::difference_type rType;
 
-	    /*Get The associated OpenCL buffer for each of the iterators*/
-        ::cl::Buffer inputBuffer = first.base().getContainer( ).getBuffer( );
-        /*Get The size of each OpenCL buffer*/
-        size_t input_sz = inputBuffer.getInfo<CL_MEM_SIZE>();
-	    
-        cl_int map_err;
-        iType *inputPtr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(inputBuffer, true, CL_MAP_READ, 0, 
-                                                                            input_sz, NULL, NULL, &map_err);
-        auto mapped_ip_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-                                                        ctl, first, inputPtr); 
+        mapped_range
+< InputIterator > input( ctl, first, n, CL_MAP_READ );
+        auto mapped_ip_itr = input.begin( );
 		
 
-	    std::iterator_traits<std::vector<int>::iterator>::difference_type output = bolt::btbb::count_if(mapped_ip_itr,
-			mapped_ip_itr + (int)n, predicate);
+	    std::iterator_traits<std::vector<int>::iterator>::difference_type output = btbb_count(mapped_ip_itr,
+			mapped_ip_itr + n, predicate);
 		
-	    ::cl::Event unmap_event[1];
-        ctl.getCommandQueue().enqueueUnmapMemObject(inputBuffer, inputPtr, NULL, &unmap_event[0] );
-        unmap_event[0].wait();
 
 
 		return (rType)output;
@@ -315,7 +328,7 @@ namespace cl{
         bolt::cl::minimum<size_t>  count_size_t;
         size_t numTailReduce = count_size_t( ceilNumWG, numWG );
 
-        bolt::cl::wait(ctl, l_mapEvent);
+        bolt::cl::wait(ctl, l_mapEvent, "count");
 
         rType count =  h_result[0] ;
         for(unsigned int i = 1; i < numTailReduce; ++i)
@@ -346,7 +359,7 @@ namespace cl{
 		std::random_access_iterator_tag)
     {
 
-		 int sz = static_cast<int>(last - first);
+		 size_t sz = static_cast< size_t >(last - first);
 
          typedef typename std::iterator_traits<InputIterator>::value_type  iType;
        	 
@@ -410,7 +423,7 @@ namespace cl{
         bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
         if(runMode == bolt::cl::control::Automatic)
         {
-            runMode = ctl.getDefaultPathToRun();
+            runMode = bolt::cl::detail::selectRunMode( ctl, "count", first, szElements );
         }
         #if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -25,6 +25,8 @@
 #include "bolt/btbb/fill.h"
 #endif
 
+#include "bolt/cl/cost_model.h"
+
 namespace bolt {
     namespace cl {
 
@@ -172,7 +174,7 @@ namespace detail {
                 }
 
                 // wait for results
-                bolt::cl::wait(ctl, kernelEvent);
+                bolt::cl::wait(ctl, kernelEvent, "fill");
 
 
                 // profiling
@@ -215,14 +217,14 @@ namespace detail {
 
                 typedef typename  std::iterator_traits<ForwardIterator>::value_type Type;
 
-                int sz = static_cast<int>(last - first);
-                if (sz < 1)
+                size_t sz = static_cast< size_t >(last - first);
+                if (sz == 0)
                     return;
 
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
                 if(runMode == bolt::cl::control::Automatic)
                 {
-                     runMode = ctl.getDefaultPathToRun();
+                     runMode = bolt::cl::detail::selectRunMode( ctl, "fill", first, sz );
                 }
       
 	            #if defined(BOLT_DEBUG_LOG)
@@ -276,7 +278,8 @@ namespace detail {
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
                 if(runMode == bolt::cl::control::Automatic)
                 {
-                     runMode = ctl.getDefaultPathToRun();
+                     runMode = bolt::cl::detail::selectRunMode( ctl, "fill", first,
+                         static_cast< size_t >( std::distance( first, last ) ) );
                 }
 				#if defined(BOLT_DEBUG_LOG)
                 BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -34,7 +34,8 @@
 #include "bolt/cl/distance.h"
 #include "bolt/cl/iterator/iterator_traits.h"
 #include "bolt/cl/iterator/transform_iterator.h"
-#include "bolt/cl/iterator/addressof.h"
+#include "bolt/cl/iterator/mapped_range.h"
+#include "bolt/cl/cost_model.h"
 
 
 namespace bolt {
@@ -59,13 +60,13 @@ gather(bolt::cl::control &ctl,
        InputIterator2 input,
        OutputIterator result)
 {
-   int numElements = static_cast< int >( std::distance( mapfirst, maplast ) );
+   size_t numElements = static_cast< size_t >( std::distance( mapfirst, maplast ) );
    typedef typename  std::iterator_traits<InputIterator1>::value_type iType1;
    iType1 temp;
-   for(int iter = 0; iter < numElements; iter++)
+   for(size_t iter = 0; iter < numElements; iter++)
    {
-                   temp = *(mapfirst + (int)iter);
-                  *(result + (int)iter) = *(input + (int)temp);
+                   temp = *(mapfirst + iter);
+                  *(result + iter) = *(input + temp);
    }
 }
 
@@ -88,43 +89,23 @@ gather(bolt::cl::control &ctl,
     if (sz == 0)
         return;
     typedef typename std::iterator_traits<InputIterator1>::value_type iType1;
-    typedef typename std::iterator_traits<InputIterator2>::value_type iType2;
-    typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-    /*Get The associated OpenCL buffer for each of the iterators*/
-    ::cl::Buffer first1Buffer = mapfirst.base().getContainer( ).getBuffer( );
-    ::cl::Buffer first2Buffer = input.base().getContainer( ).getBuffer( );
-    ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-    /*Get The size of each OpenCL buffer*/
-    size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-    size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
-    size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-    
-    cl_int map_err;
-    iType1 *first1Ptr = (iType1*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                     first1_sz, NULL, NULL, &map_err);
-    iType2 *first2Ptr = (iType2*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                     first2_sz, NULL, NULL, &map_err);
-    oType *resultPtr  = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                     result_sz, NULL, NULL, &map_err);
-    auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-                                                   ctl, mapfirst, first1Ptr);
-    auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-                                                   ctl, input, first2Ptr);
-    auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                   ctl, result, resultPtr);
+
+    //  The map picks the input elements at random, so the input is mapped from its first element to its end
+    mapped_range< InputIterator1 > indices( ctl, mapfirst, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator2 > in( ctl, input, mapped_elements( input ), CL_MAP_READ );
+    mapped_range< OutputIterator > out( ctl, result, static_cast< size_t >( sz ),
+                                        overwrite_flags( result, mapfirst, input ) );
+    auto mapped_first1_itr = indices.begin( );
+    auto mapped_first2_itr = in.begin( );
+    auto mapped_result_itr = out.begin( );
 
 	iType1 temp;
-    for(int iter = 0; iter < sz; iter++)
+    for(typename InputIterator1::difference_type iter = 0; iter < sz; iter++)
     {
-           temp = *(mapped_first1_itr + (int)iter);
-           *(mapped_result_itr + (int)iter) = *(mapped_first2_itr+ (int)temp);
+           temp = *(mapped_first1_itr + iter);
+           *(mapped_result_itr + iter) = *(mapped_first2_itr + temp);
     }
 
-    ::cl::Event unmap_event[3];
-    ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[2] );
-    unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait();
     return;
 }
 
@@ -148,11 +129,11 @@ gather_if(bolt::cl::control &ctl,
           Predicate pred)
 {
 
-   unsigned int numElements = static_cast< unsigned int >( std::distance( mapfirst, maplast ) );
-   for(unsigned int iter = 0; iter < numElements; iter++)
+   size_t numElements = static_cast< size_t >( std::distance( mapfirst, maplast ) );
+   for(size_t iter = 0; iter < numElements; iter++)
    {
-        if(pred(*(stencil + (int)iter)))
-             result[(int)iter] = input[mapfirst[(int)iter]];
+        if(pred(*(stencil + iter)))
+             result[iter] = input[mapfirst[iter]];
    }
 }
 
@@ -178,52 +159,24 @@ gather_if(bolt::cl::control &ctl,
 	typename InputIterator1::difference_type sz = (maplast - mapfirst);
     if (sz == 0)
         return;
-    typedef typename std::iterator_traits<InputIterator1>::value_type iType1;
-    typedef typename std::iterator_traits<InputIterator2>::value_type iType2;
-	typedef typename std::iterator_traits<InputIterator3>::value_type iType3;
-    typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-    /*Get The associated OpenCL buffer for each of the iterators*/
-    ::cl::Buffer first1Buffer = mapfirst.base().getContainer( ).getBuffer( );
-    ::cl::Buffer first2Buffer = stencil.base().getContainer( ).getBuffer( );
-	::cl::Buffer first3Buffer = input.base().getContainer( ).getBuffer( );
-    ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-    /*Get The size of each OpenCL buffer*/
-    size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-    size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
-	size_t first3_sz = first3Buffer.getInfo<CL_MEM_SIZE>();
-    size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-    
-    cl_int map_err;
-    iType1 *first1Ptr = (iType1*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                     first1_sz, NULL, NULL, &map_err);
-    iType2 *first2Ptr = (iType2*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                     first2_sz, NULL, NULL, &map_err);
-	iType3 *first3Ptr = (iType3*)ctl.getCommandQueue().enqueueMapBuffer(first3Buffer, true, CL_MAP_READ, 0, 
-                                                                     first3_sz, NULL, NULL, &map_err);
-    oType *resultPtr  = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                     result_sz, NULL, NULL, &map_err);
-    auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-                                                   ctl, mapfirst, first1Ptr);
-    auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-                                                   ctl, stencil, first2Ptr);
-	auto mapped_first3_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator3>::iterator_category(), 
-                                                   ctl, input, first3Ptr);
-    auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                   ctl, result, resultPtr);
-
-	for(int iter = 0; iter < sz; iter++)
+    //  The map picks the input elements at random, so the input is mapped from its first element to its end; only
+    //  the outputs whose stencil passes are written, so the others are kept
+    mapped_range< InputIterator1 > indices( ctl, mapfirst, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator2 > stencils( ctl, stencil, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator3 > in( ctl, input, mapped_elements( input ), CL_MAP_READ );
+    mapped_range< OutputIterator > out( ctl, result, static_cast< size_t >( sz ), CL_MAP_READ | CL_MAP_WRITE );
+    auto mapped_first1_itr = indices.begin( );
+    auto mapped_first2_itr = stencils.begin( );
+    auto mapped_first3_itr = in.begin( );
+    auto mapped_result_itr = out.begin( );
+
+	for(typename InputIterator1::difference_type iter = 0; iter < sz; iter++)
     {
-        if(pred(*(mapped_first2_itr + (int)iter)))
-             mapped_result_itr[(int)iter] = mapped_first3_itr[mapped_first1_itr[(int)iter]];
-    }
+        if(pred(*(mapped_first2_itr + iter)))
+             mapped_result_itr[iter] = mapped_first3_itr[mapped_first1_itr[iter]];
 
+    }
 
-    ::cl::Event unmap_event[4];
-    ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-	ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first3Ptr, NULL, &unmap_event[2] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[3] );
-    unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait(); unmap_event[3].wait();
     return;
    
 }
@@ -270,38 +223,18 @@ gather(bolt::cl::control &ctl,
     if (sz == 0)
         return;
     typedef typename std::iterator_traits<InputIterator1>::value_type iType1;
-    typedef typename std::iterator_traits<InputIterator2>::value_type iType2;
-    typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-    /*Get The associated OpenCL buffer for each of the iterators*/
-    ::cl::Buffer first1Buffer = mapfirst.base().getContainer( ).getBuffer( );
-    ::cl::Buffer first2Buffer = input.base().getContainer( ).getBuffer( );
-    ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-    /*Get The size of each OpenCL buffer*/
-    size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-    size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
-    size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-    
-    cl_int map_err;
-    iType1 *first1Ptr = (iType1*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                     first1_sz, NULL, NULL, &map_err);
-    iType2 *first2Ptr = (iType2*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                     first2_sz, NULL, NULL, &map_err);
-    oType *resultPtr  = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                     result_sz, NULL, NULL, &map_err);
-    auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-                                                   ctl, mapfirst, first1Ptr);
-    auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-                                                   ctl, input, first2Ptr);
-    auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                   ctl, result, resultPtr);
+
+    //  The map picks the input elements at random, so the input is mapped from its first element to its end
+    mapped_range< InputIterator1 > indices( ctl, mapfirst, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator2 > in( ctl, input, mapped_elements( input ), CL_MAP_READ );
+    mapped_range< OutputIterator > out( ctl, result, static_cast< size_t >( sz ),
+                                        overwrite_flags( result, mapfirst, input ) );
+    auto mapped_first1_itr = indices.begin( );
+    auto mapped_first2_itr = in.begin( );
+    auto mapped_result_itr = out.begin( );
 
 	bolt::btbb::gather(mapped_first1_itr, mapped_first1_itr + sz, mapped_first2_itr, mapped_result_itr);
 
-    ::cl::Event unmap_event[3];
-    ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[2] );
-    unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait();
     return;
 }
 
@@ -350,48 +283,19 @@ gather_if(bolt::cl::control &ctl,
 	typename InputIterator1::difference_type sz = (maplast - mapfirst);
     if (sz == 0)
         return;
-    typedef typename std::iterator_traits<InputIterator1>::value_type iType1;
-    typedef typename std::iterator_traits<InputIterator2>::value_type iType2;
-	typedef typename std::iterator_traits<InputIterator3>::value_type iType3;
-    typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-    /*Get The associated OpenCL buffer for each of the iterators*/
-    ::cl::Buffer first1Buffer = mapfirst.base().getContainer( ).getBuffer( );
-    ::cl::Buffer first2Buffer = stencil.base().getContainer( ).getBuffer( );
-	::cl::Buffer first3Buffer = input.base().getContainer( ).getBuffer( );
-    ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-    /*Get The size of each OpenCL buffer*/
-    size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-    size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
-	size_t first3_sz = first3Buffer.getInfo<CL_MEM_SIZE>();
-    size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-    
-    cl_int map_err;
-    iType1 *first1Ptr = (iType1*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                     first1_sz, NULL, NULL, &map_err);
-    iType2 *first2Ptr = (iType2*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                     first2_sz, NULL, NULL, &map_err);
-	iType3 *first3Ptr = (iType3*)ctl.getCommandQueue().enqueueMapBuffer(first3Buffer, true, CL_MAP_READ, 0, 
-                                                                     first3_sz, NULL, NULL, &map_err);
-    oType *resultPtr  = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                     result_sz, NULL, NULL, &map_err);
-    auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-                                                   ctl, mapfirst, first1Ptr);
-    auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-                                                   ctl, stencil, first2Ptr);
-	auto mapped_first3_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator3>::iterator_category(), 
-                                                   ctl, input, first3Ptr);
-    auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                   ctl, result, resultPtr);
+    //  The map picks the input elements at random, so the input is mapped from its first element to its end; only
+    //  the outputs whose stencil passes are written, so the others are kept
+    mapped_range< InputIterator1 > indices( ctl, mapfirst, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator2 > stencils( ctl, stencil, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator3 > in( ctl, input, mapped_elements( input ), CL_MAP_READ );
+    mapped_range< OutputIterator > out( ctl, result, static_cast< size_t >( sz ), CL_MAP_READ | CL_MAP_WRITE );
+    auto mapped_first1_itr = indices.begin( );
+    auto mapped_first2_itr = stencils.begin( );
+    auto mapped_first3_itr = in.begin( );
+    auto mapped_result_itr = out.begin( );
 
 	bolt::btbb::gather_if(mapped_first1_itr, mapped_first1_itr + sz, mapped_first2_itr, mapped_first3_itr, mapped_result_itr, pred);
 
-
-    ::cl::Event unmap_event[4];
-    ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-	ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first3Ptr, NULL, &unmap_event[2] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[3] );
-    unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait(); unmap_event[3].wait();
     return;
    
 }
@@ -613,7 +517,7 @@ public:
             &gatherIfEvent );
         V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for gather_if() kernel" );
 
-        ::bolt::cl::wait(ctl, gatherIfEvent);
+        ::bolt::cl::wait(ctl, gatherIfEvent, "gather_if");
 
     };
 
@@ -641,7 +545,7 @@ public:
 		typedef typename std::iterator_traits<InputIterator3>::value_type iType3;
         typedef typename std::iterator_traits<OutputIterator>::value_type oType;
 
-        int sz = static_cast<int>( std::distance( map_first, map_last ) );
+        size_t sz = static_cast< size_t >( std::distance( map_first, map_last ) );
 
         device_vector< oType > dvResult( result, sz, CL_MEM_USE_HOST_PTR|CL_MEM_WRITE_ONLY, false, ctl );
 
@@ -806,7 +710,7 @@ public:
             &gatherEvent );
         V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for gather_if() kernel" );
 
-        ::bolt::cl::wait(ctl, gatherEvent);
+        ::bolt::cl::wait(ctl, gatherEvent, "gather");
 
     };
 
@@ -830,7 +734,7 @@ public:
         typedef typename std::iterator_traits<InputIterator2>::value_type iType2;
         typedef typename std::iterator_traits<OutputIterator>::value_type oType;
 
-        int sz = static_cast<int>( std::distance( map_first, map_last ) );
+        size_t sz = static_cast< size_t >( std::distance( map_first, map_last ) );
 
         device_vector< oType > dvResult( result, sz, CL_MEM_USE_HOST_PTR|CL_MEM_WRITE_ONLY, false, ctl );
 
@@ -891,7 +795,7 @@ public:
                const std::string& user_code )
     {
         
-		int sz = static_cast<int>( std::distance( map_first, map_last ) );
+		size_t sz = static_cast< size_t >( std::distance( map_first, map_last ) );
         if (sz == 0)
             return;
 
@@ -899,7 +803,7 @@ public:
         bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
         if(runMode == bolt::cl::control::Automatic)
         {
-          runMode = ctl.getDefaultPathToRun();
+          runMode = bolt::cl::detail::selectRunMode( ctl, "gather", map_first, sz );
         }
 		#if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -987,7 +891,7 @@ public:
             const std::string& user_code)
     {
         
-        int sz = static_cast<int>( std::distance( map_first, map_last ) );
+        size_t sz = static_cast< size_t >( std::distance( map_first, map_last ) );
         if (sz == 0)
             return;
 
@@ -995,7 +899,7 @@ public:
         bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
         if(runMode == bolt::cl::control::Automatic)
         {
-          runMode = ctl.getDefaultPathToRun();
+          runMode = bolt::cl::detail::selectRunMode( ctl, "gather", map_first, sz );
         }
 		#if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -25,6 +25,8 @@
 #endif
 #define BURST 1
 
+#include "bolt/cl/cost_model.h"
+
 namespace bolt {
 namespace cl {
 
@@ -223,7 +225,7 @@ aProfiler.set(AsyncProfiler::memory, 1*numElements*sizeof(oType)
                 V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for generate() kernel" );
 
                 // wait to kernel completion
-    bolt::cl::wait(ctrl, generateEvent);
+    bolt::cl::wait(ctrl, generateEvent, "generate");
 #if 0
 #ifdef BOLT_ENABLE_PROFILING
 aProfiler.nextStep();
@@ -313,14 +315,14 @@ aProfiler.stopTrial();
             {
                 typedef typename std::iterator_traits<ForwardIterator>::value_type Type;
 
-                int sz = static_cast<int>(last - first);
-                if (sz < 1)
+                size_t sz = static_cast< size_t >(last - first);
+                if (sz == 0)
                     return;
 
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
                 if(runMode == bolt::cl::control::Automatic)
                 {
-                     runMode = ctl.getDefaultPathToRun();
+                     runMode = bolt::cl::detail::selectRunMode( ctl, "generate", first, sz );
                 }
                 #if defined(BOLT_DEBUG_LOG)
                 BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -374,7 +376,8 @@ aProfiler.stopTrial();
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
                 if(runMode == bolt::cl::control::Automatic)
                 {
-                     runMode = ctl.getDefaultPathToRun();
+                     runMode = bolt::cl::detail::selectRunMode( ctl, "generate", first,
+                         static_cast< size_t >( std::distance( first, last ) ) );
                 }
                 #if defined(BOLT_DEBUG_LOG)
                 BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
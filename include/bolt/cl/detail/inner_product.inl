@@ -29,7 +29,8 @@ TODO:
 #include "bolt/cl/reduce.h"
 
 #include <bolt/cl/iterator/iterator_traits.h>
-#include <bolt/cl/iterator/addressof.h>
+#include <bolt/cl/iterator/mapped_range.h>
+#include "bolt/cl/cost_model.h"
 
 
 //TBB Includes
@@ -53,48 +54,25 @@ namespace serial{
 		bolt::cl::device_vector_tag)
     {
 
-         typename std::iterator_traits<InputIterator>::difference_type sz = (last1 - first1);
-
-         typedef typename std::iterator_traits<InputIterator>::value_type iType;
-
-         /*Get The associated OpenCL buffer for each of the iterators*/
-         ::cl::Buffer first1Buffer = first1.base().getContainer( ).getBuffer( );
-         ::cl::Buffer first2Buffer = first2.base().getContainer( ).getBuffer( );
+         size_t sz = static_cast< size_t >(last1 - first1);
 
-         /*Get The size of each OpenCL buffer*/
-         size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-         size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
- 
-         
-         cl_int map_err;
-         iType *first1Ptr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                          first1_sz, NULL, NULL, &map_err);
-         iType *first2Ptr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                          first2_sz, NULL, NULL, &map_err);
-
-         auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-                                                        ctl, first1, first1Ptr);
-         auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-                                                        ctl, first2, first2Ptr);
+         mapped_range< InputIterator > input1( ctl, first1, static_cast< size_t >( sz ), CL_MAP_READ );
+         mapped_range< InputIterator > input2( ctl, first2, static_cast< size_t >( sz ), CL_MAP_READ );
+         auto mapped_first1_itr = input1.begin( );
+         auto mapped_first2_itr = input2.begin( );
 
 		 OutputType output = init;
 
 		 std::vector<OutputType> result(sz);
-         for(int index=0; index < (int)(sz); index++)
+         for(size_t index=0; index < sz; index++)
          {
-             result[index] = (OutputType)  f2( *(first1+index), *(first2+index) );	
+             result[index] = (OutputType)  f2( *(mapped_first1_itr+index), *(mapped_first2_itr+index) );	
          }
-		 for(int index=0; index < (int)(sz); index++)
+		 for(size_t index=0; index < sz; index++)
          {
              output = (OutputType) f1( output, result[index] );	
          }
 
-         ::cl::Event unmap_event[2];
-         ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-         ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-
-         unmap_event[0].wait(); unmap_event[1].wait();
-
          return output;
 
     }
@@ -110,11 +88,11 @@ namespace serial{
 
 		size_t sz = (last1 - first1);
 		std::vector<OutputType> result(sz);
-        for(int index=0; index < (int)(sz); index++)
+        for(size_t index=0; index < sz; index++)
         {
             result[index] = (OutputType)  f2( *(first1+index), *(first2+index) );	
         }
-		for(int index=0; index < (int)(sz); index++)
+		for(size_t index=0; index < sz; index++)
         {
             res = (OutputType) f1( res, result[index] );	
         }
@@ -133,11 +111,11 @@ namespace serial{
 
 		size_t sz = (last1 - first1);
 		std::vector<OutputType> result(sz);
-        for(int index=0; index < (int)(sz); index++)
+        for(size_t index=0; index < sz; index++)
         {
             result[index] = (OutputType) f2( *(first1+index), *(first2+index) );	
         }
-		for(int index=0; index < (int)(sz); index++)
+		for(size_t index=0; index < sz; index++)
         {
             res = (OutputType)  f1( res, result[index] );	
         }
@@ -159,35 +137,13 @@ namespace btbb{
 
          typename std::iterator_traits<InputIterator>::difference_type sz = (last1 - first1);
 
-         typedef typename std::iterator_traits<InputIterator>::value_type iType;
-
-         /*Get The associated OpenCL buffer for each of the iterators*/
-         ::cl::Buffer first1Buffer = first1.base().getContainer( ).getBuffer( );
-         ::cl::Buffer first2Buffer = first2.base().getContainer( ).getBuffer( );
-
-         /*Get The size of each OpenCL buffer*/
-         size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-         size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
- 
-         
-         cl_int map_err;
-         iType *first1Ptr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                          first1_sz, NULL, NULL, &map_err);
-         iType *first2Ptr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                          first2_sz, NULL, NULL, &map_err);
-
-         auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-                                                        ctl, first1, first1Ptr);
-         auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-                                                        ctl, first2, first2Ptr);
+         mapped_range< InputIterator > input1( ctl, first1, static_cast< size_t >( sz ), CL_MAP_READ );
+         mapped_range< InputIterator > input2( ctl, first2, static_cast< size_t >( sz ), CL_MAP_READ );
+         auto mapped_first1_itr = input1.begin( );
+         auto mapped_first2_itr = input2.begin( );
 
          OutputType output = bolt::btbb::inner_product(  mapped_first1_itr, mapped_first1_itr + sz, mapped_first2_itr, init, f1, f2  );
 
-         ::cl::Event unmap_event[2];
-         ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-         ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-
-         unmap_event[0].wait(); unmap_event[1].wait();
 
          return output;
 
@@ -277,7 +233,7 @@ namespace cl{
                 std::random_access_iterator_tag )
     {
 		
-		int sz = static_cast<int>(last1 - first1);
+		size_t sz = static_cast< size_t >(last1 - first1);
 
         typedef typename std::iterator_traits<InputIterator>::value_type  iType;
               
@@ -328,7 +284,7 @@ namespace cl{
                 BinaryFunction1 f1, BinaryFunction2 f2, const std::string& user_code )
     {
         typedef typename std::iterator_traits<InputIterator>::value_type iType;
-        int sz = static_cast<int>( std::distance( first1, last1 ) );
+        size_t sz = static_cast< size_t >( std::distance( first1, last1 ) );
 
         if( sz == 0 )
             return init;
@@ -336,7 +292,7 @@ namespace cl{
         bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
         if(runMode == bolt::cl::control::Automatic)
         {
-             runMode = ctl.getDefaultPathToRun();
+             runMode = bolt::cl::detail::selectRunMode( ctl, "inner_product", first1, sz );
         }
         #if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -26,6 +26,8 @@
 #endif
 
 
+#include "bolt/cl/cost_model.h"
+
 namespace bolt {
     namespace cl {
 
@@ -193,7 +195,7 @@ namespace bolt {
                     &mergeEvent);
 
                 V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for merge() kernel" );
-                bolt::cl::wait(ctl, mergeEvent);
+                bolt::cl::wait(ctl, mergeEvent, "merge");
 
                 return (result + szElements1 + szElements2);
             }
@@ -224,7 +226,8 @@ namespace bolt {
 
                 if(runMode == bolt::cl::control::Automatic)
                 {
-                    runMode = ctl.getDefaultPathToRun();
+                    runMode = bolt::cl::detail::selectRunMode( ctl, "merge", first1,
+                        static_cast< size_t >( std::distance( first1, last1 ) + std::distance( first2, last2 ) ) );
                 }
 
 				#if defined(BOLT_DEBUG_LOG)
@@ -238,7 +241,7 @@ namespace bolt {
 					  #if defined(BOLT_DEBUG_LOG)
                       dblog->CodePathTaken(BOLTLOG::BOLT_MERGE,BOLTLOG::BOLT_OPENCL_GPU,"::Merge::OPENCL_GPU");
                       #endif
-                      int sz = static_cast<int> ( (last1-first1) + (last2-first2) );
+                      size_t sz = static_cast< size_t > ( (last1-first1) + (last2-first2) );
                       device_vector< iType1 > dvInput1( first1, last1, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, ctl );
                       device_vector< iType2 > dvInput2( first2, last2, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, ctl );
                       device_vector< oType >  dvresult(  result, sz, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, false, ctl );
@@ -299,7 +302,8 @@ namespace bolt {
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
                 if(runMode == bolt::cl::control::Automatic)
                 {
-                    runMode = ctl.getDefaultPathToRun();
+                    runMode = bolt::cl::detail::selectRunMode( ctl, "merge", first1,
+                        static_cast< size_t >( std::distance( first1, last1 ) + std::distance( first2, last2 ) ) );
                 }
                 #if defined(BOLT_DEBUG_LOG)
                 BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -414,7 +418,8 @@ namespace bolt {
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
                 if(runMode == bolt::cl::control::Automatic)
                 {
-                    runMode = ctl.getDefaultPathToRun();
+                    runMode = bolt::cl::detail::selectRunMode( ctl, "merge", first1,
+                        static_cast< size_t >( std::distance( first1, last1 ) + std::distance( first2, last2 ) ) );
                 }
 				#if defined(BOLT_DEBUG_LOG)
                 BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -21,10 +21,12 @@
 #pragma once
 
 #include "bolt/cl/functional.h"
+#include "bolt/cl/cost_model.h"
 
 #ifdef ENABLE_TBB
 //TBB Includes
 #include "bolt/btbb/min_element.h"
+#include "bolt/btbb/simd_reduce.h"
 #endif
 
 namespace bolt {
@@ -173,7 +175,7 @@ namespace bolt {
                 bolt::cl::minimum<size_t>  min_size_t;
                 size_t numTailReduce = min_size_t( ceilNumWG, numWG );
 
-                bolt::cl::wait(ctl, l_mapEvent);
+                bolt::cl::wait(ctl, l_mapEvent, "min_element");
 
                 int minele_indx =  h_result[0] ;
                 iType minele =  *(first + h_result[0]) ;
@@ -208,6 +210,50 @@ namespace bolt {
 
 
 
+#ifdef ENABLE_TBB
+            /*! \brief True when the vectorized min_element and max_element of btbb can take the place of those of
+            *   TBB: the built-in less, over contiguous elements of a type they know.
+            */
+            template< typename ForwardIterator, typename BinaryPredicate >
+            struct simd_min_element_select: std::false_type {};
+
+            template< typename ForwardIterator, typename T >
+            struct simd_min_element_select< ForwardIterator, bolt::cl::less< T > >: std::integral_constant< bool,
+                bolt::btbb::is_contiguous_iterator< ForwardIterator, T >::value &&
+                bolt::btbb::is_simd_reducible< T, bolt::btbb::simd::minimum >::value > {};
+
+            template< typename ForwardIterator, typename T >
+            struct simd_min_element_select< ForwardIterator, std::less< T > >:
+                simd_min_element_select< ForwardIterator, bolt::cl::less< T > > {};
+
+            template<typename ForwardIterator, typename BinaryPredicate>
+            ForwardIterator btbb_min_element( const ForwardIterator& first, const ForwardIterator& last,
+                const BinaryPredicate& binary_op, bool max, std::false_type )
+            {
+                if( max )
+                    return bolt::btbb::max_element( first, last, binary_op );
+                return bolt::btbb::min_element( first, last, binary_op );
+            }
+
+            template<typename ForwardIterator, typename BinaryPredicate>
+            ForwardIterator btbb_min_element( const ForwardIterator& first, const ForwardIterator& last,
+                const BinaryPredicate&, bool max, std::true_type )
+            {
+                const auto* p = &*first;
+                const auto* found = max ? bolt::btbb::simd_max_element( p, p + ( last - first ) )
+                                        : bolt::btbb::simd_min_element( p, p + ( last - first ) );
+                return first + ( found - p );
+            }
+
+            template<typename ForwardIterator, typename BinaryPredicate>
+            ForwardIterator btbb_min_element( const ForwardIterator& first, const ForwardIterator& last,
+                const BinaryPredicate& binary_op, bool max )
+            {
+                return btbb_min_element( first, last, binary_op, max,
+                    std::integral_constant< bool, simd_min_element_select< ForwardIterator, BinaryPredicate >::value >( ) );
+            }
+#endif
+
             // This template is called after we detect random access iterators
             // This is called strictly for any non-device_vector iterator
             template<typename ForwardIterator, typename BinaryPredicate>
@@ -234,7 +280,7 @@ namespace bolt {
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
                 if(runMode == bolt::cl::control::Automatic)
                 {
-                    runMode = ctl.getDefaultPathToRun();
+                    runMode = bolt::cl::detail::selectRunMode( ctl, "min_element", first, szElements );
                 }
 
                 const char * str = "MAX_KERNEL";
@@ -267,10 +313,7 @@ namespace bolt {
 						else
 						  dblog->CodePathTaken(BOLTLOG::BOLT_MINELEMENT,BOLTLOG::BOLT_MULTICORE_CPU,"::Min_Element::MULTICORE_CPU");
                         #endif
-                        if(std::strcmp(min_max,str) == 0)
-                              return bolt::btbb::max_element(first, last, binary_op);
-                        else
-                              return bolt::btbb::min_element(first, last, binary_op);
+                        return btbb_min_element(first, last, binary_op, std::strcmp(min_max,str) == 0);
                     #else
                         throw std::runtime_error( "The MultiCoreCpu version of Max-Min is not enabled to be built! \n" );
                     #endif
@@ -322,7 +365,7 @@ namespace bolt {
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
                 if(runMode == bolt::cl::control::Automatic)
                 {
-                    runMode = ctl.getDefaultPathToRun();
+                    runMode = bolt::cl::detail::selectRunMode( ctl, "min_element", first, szElements );
                 }
 
                 const char * str = "MAX_KERNEL";
@@ -357,10 +400,8 @@ namespace bolt {
                         #endif
 						typename bolt::cl::device_vector< iType >::pointer InputBuffer =  first.getContainer( ).data( );
 						iType* stlPtr;
-                        if(std::strcmp(min_max,str) == 0)
-                              stlPtr = bolt::btbb::max_element(&InputBuffer[first.m_Index], &InputBuffer[last.m_Index], binary_op);
-                        else
-                              stlPtr = bolt::btbb::min_element(&InputBuffer[first.m_Index], &InputBuffer[last.m_Index], binary_op);
+                        stlPtr = btbb_min_element(&InputBuffer[first.m_Index], &InputBuffer[last.m_Index], binary_op,
+                                                  std::strcmp(min_max,str) == 0);
 						return first+(unsigned int)(stlPtr-&InputBuffer[first.m_Index]);
                     #else
                         throw std::runtime_error( "The MultiCoreCpu version of Max-Min is not enabled to be built! \n" );
@@ -413,7 +454,8 @@ namespace bolt {
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
                 if(runMode == bolt::cl::control::Automatic)
                 {
-                    runMode = ctl.getDefaultPathToRun();
+                    runMode = bolt::cl::detail::selectRunMode( ctl, "min_element", first,
+                        static_cast< size_t >( std::distance( first, last ) ) );
                 }
 
                 const char * str = "MAX_KERNEL";
@@ -20,10 +20,13 @@
 #define BOLT_CL_REDUCE_INL
 #pragma once
 #include <bolt/cl/iterator/iterator_traits.h>
-#include <bolt/cl/iterator/addressof.h>
+#include <bolt/cl/iterator/mapped_range.h>
+#include "bolt/cl/cost_model.h"
+#include "bolt/cl/tuner.h"
 #ifdef ENABLE_TBB
 //TBB Includes
 #include "bolt/btbb/reduce.h"
+#include "bolt/btbb/simd_reduce.h"
 #endif
 
 
@@ -67,26 +70,12 @@ namespace serial{
     {
 		size_t n = (last - first);
 
-        typedef typename std::iterator_traits< InputIterator >::value_type iType;
+        mapped_range< InputIterator > input( ctl, first, n, CL_MAP_READ );
+        auto mapped_ip_itr = input.begin( );
+	    T output = std::accumulate(mapped_ip_itr, mapped_ip_itr + n, init, binary_op);
 
-	    /*Get The associated OpenCL buffer for each of the iterators*/
-        ::cl::Buffer inputBuffer = first.base().getContainer( ).getBuffer( );
-        /*Get The size of each OpenCL buffer*/
-        size_t input_sz = inputBuffer.getInfo<CL_MEM_SIZE>();
-	    
-        cl_int map_err;
-        iType *inputPtr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(inputBuffer, true, CL_MAP_READ, 0, 
-                                                                            input_sz, NULL, NULL, &map_err);
-        auto mapped_ip_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-                                                        ctl, first, inputPtr);  
-	    T output = std::accumulate(mapped_ip_itr, mapped_ip_itr + (int) n, init, binary_op);
-
-	    ::cl::Event unmap_event[1];
-        ctl.getCommandQueue().enqueueUnmapMemObject(inputBuffer, inputPtr, NULL, &unmap_event[0] );
-        unmap_event[0].wait();  
-			
-			
 		return output;
+
     }
 
 } // end of namespace serial
@@ -94,6 +83,54 @@ namespace serial{
 #ifdef ENABLE_TBB
 namespace btbb{
 
+    /*! \brief Selects the vectorized reduction of btbb for the built-in plus, minimum and maximum of the types it
+    *   knows, when the elements are contiguous and of the type of the functor; -1 keeps the reduction of TBB.
+    */
+    template< typename InputIterator, typename T, bolt::btbb::simd::op Op >
+    struct simd_reduce_select: std::integral_constant< int,
+        ( bolt::btbb::is_contiguous_iterator< InputIterator, T >::value &&
+          bolt::btbb::is_simd_reducible< T, Op >::value ) ? Op : -1 > {};
+
+    template< typename InputIterator, typename T, typename BinaryFunction >
+    struct simd_reduce_op: std::integral_constant< int, -1 > {};
+
+    template< typename InputIterator, typename T >
+    struct simd_reduce_op< InputIterator, T, bolt::cl::plus< T > >:
+        simd_reduce_select< InputIterator, T, bolt::btbb::simd::sum > {};
+
+    template< typename InputIterator, typename T >
+    struct simd_reduce_op< InputIterator, T, bolt::cl::minimum< T > >:
+        simd_reduce_select< InputIterator, T, bolt::btbb::simd::minimum > {};
+
+    template< typename InputIterator, typename T >
+    struct simd_reduce_op< InputIterator, T, bolt::cl::maximum< T > >:
+        simd_reduce_select< InputIterator, T, bolt::btbb::simd::maximum > {};
+
+    template<typename T, typename InputIterator, typename BinaryFunction>
+    T btbb_reduce( const InputIterator& first, const InputIterator& last, const T& init,
+                   const BinaryFunction& binary_op, std::integral_constant< int, -1 > )
+    {
+        return bolt::btbb::reduce(first, last, init, binary_op);
+    }
+
+    template<typename T, typename InputIterator, typename BinaryFunction, int Op>
+    T btbb_reduce( const InputIterator& first, const InputIterator& last, const T& init,
+                   const BinaryFunction&, std::integral_constant< int, Op > )
+    {
+        if( first == last )
+            return init;
+        const T* p = &*first;
+        return bolt::btbb::simd_reduce< static_cast< bolt::btbb::simd::op >( Op ) >( p, p + ( last - first ), init );
+    }
+
+    template<typename T, typename InputIterator, typename BinaryFunction>
+    T btbb_reduce( const InputIterator& first, const InputIterator& last, const T& init,
+                   const BinaryFunction& binary_op )
+    {
+        return btbb_reduce( first, last, init, binary_op,
+            std::integral_constant< int, simd_reduce_op< InputIterator, T, BinaryFunction >::value >( ) );
+    }
+
 	template<typename T, typename InputIterator, typename BinaryFunction>
     T reduce(bolt::cl::control &ctl,
                 const InputIterator& first,
@@ -102,7 +139,7 @@ namespace btbb{
                 const BinaryFunction& binary_op,
 				std::random_access_iterator_tag)
     {
-		return bolt::btbb::reduce(first, last, init, binary_op);
+		return btbb_reduce(first, last, init, binary_op);
     }
 
 	template<typename T, typename InputIterator, typename BinaryFunction>
@@ -129,26 +166,12 @@ namespace btbb{
     {
 		size_t n = (last - first);
 
-        typedef typename std::iterator_traits< InputIterator >::value_type iType;
+        mapped_range< InputIterator > input( ctl, first, n, CL_MAP_READ );
+        auto mapped_ip_itr = input.begin( );
+	    T output = btbb_reduce(mapped_ip_itr, mapped_ip_itr + n, init, binary_op);
 
-	    /*Get The associated OpenCL buffer for each of the iterators*/
-        ::cl::Buffer inputBuffer = first.base().getContainer( ).getBuffer( );
-        /*Get The size of each OpenCL buffer*/
-        size_t input_sz = inputBuffer.getInfo<CL_MEM_SIZE>();
-	    
-        cl_int map_err;
-        iType *inputPtr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(inputBuffer, true, CL_MAP_READ, 0, 
-                                                                            input_sz, NULL, NULL, &map_err);
-        auto mapped_ip_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-                                                        ctl, first, inputPtr);  
-	    T output = bolt::btbb::reduce(mapped_ip_itr, mapped_ip_itr + (int) n, init, binary_op);
-
-	    ::cl::Event unmap_event[1];
-        ctl.getCommandQueue().enqueueUnmapMemObject(inputBuffer, inputPtr, NULL, &unmap_event[0] );
-        unmap_event[0].wait();  
-			
-			
 		return output;
+
     }
 } // end of namespace btbb
 #endif
@@ -173,7 +196,7 @@ namespace cl{
             const std::string templateSpecializationString =
                     "// Host generates this instantiation string with user-specified value type and functor\n"
                     "template __attribute__((mangled_name(" + name(0) + "Instantiated)))\n"
-                    "__attribute__((reqd_work_group_size(256,1,1)))\n"
+                    "__attribute__((reqd_work_group_size(REDUCE_WGSIZE,1,1)))\n"
                     "kernel void reduceTemplate(\n"
                     "global " + typeNames[reduce_iValueType] + "* input_ptr,\n"
                         + typeNames[reduce_iIterType] + " output_iter,\n"
@@ -200,7 +223,7 @@ namespace cl{
                 bolt::cl::device_vector_tag)
     {
 
-        int sz = static_cast<int>(last - first);
+        size_t sz = static_cast< size_t >(last - first);
         if (sz == 0)
             return init;
         typedef typename std::iterator_traits< InputIterator >::value_type iType;
@@ -217,35 +240,6 @@ namespace cl{
         PUSH_BACK_UNIQUE( typeDefinitions, ClCode< BinaryFunction  >::get() )
         PUSH_BACK_UNIQUE( typeDefinitions, ClCode< T >::get() )
 
-        //bool cpuDevice = ctl.device().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
-        /*\TODO - Do CPU specific kernel work group size selection here*/
-        //const size_t kernel0_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
-        std::string compileOptions;
-        //std::ostringstream oss;
-        //oss << " -DKERNEL0WORKGROUPSIZE=" << kernel0_WgSize;
-
-        Reduce_KernelTemplateSpecializer ts_kts;
-        std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
-            ctl,
-            typeNames,
-            &ts_kts,
-            typeDefinitions,
-            reduce_kernels,
-            compileOptions);
-
-        // Set up shape of launch grid and buffers:
-        cl_uint computeUnits = ctl.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
-        int wgPerComputeUnit = 64; 
-        //ctl.getWGPerComputeUnit();  // This boosts up the performance
-        size_t numWG = computeUnits * wgPerComputeUnit;
-
-        cl_int l_Error = CL_SUCCESS;
-
-        // Bumped up wgSize to achieve higher ALU usage and occupancy
-        const size_t wgSize  = 256;
-
-        V_OPENCL( l_Error, "Error querying kernel for CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE" );
-
         // Create buffer wrappers so we can access the host functors, for read or writing in the kernel
         ALIGNED( 256 ) BinaryFunction aligned_reduce( binary_op );
         //::cl::Buffer userFunctor(ctl.context(), CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, sizeof(aligned_reduce),
@@ -253,32 +247,74 @@ namespace cl{
         control::buffPointer userFunctor = ctl.acquireBuffer( sizeof( aligned_reduce ),
             CL_MEM_USE_HOST_PTR|CL_MEM_READ_ONLY, &aligned_reduce );
 
-        // ::cl::Buffer result(ctl.context(), CL_MEM_ALLOC_HOST_PTR|CL_MEM_WRITE_ONLY, sizeof( iType )*numWG);
-        control::buffPointer result = ctl.acquireBuffer( sizeof( T ) * numWG,
-            CL_MEM_ALLOC_HOST_PTR|CL_MEM_WRITE_ONLY );
-
         typename InputIterator::Payload first_payload = first.gpuPayload( ) ;
 
         const ::cl::Buffer &first_buffer = first.base().getContainer().getBuffer();
 
-        V_OPENCL( kernels[0].setArg(0, first_buffer ), "Error setting kernel argument" );
-        V_OPENCL( kernels[0].setArg(1, first.gpuPayloadSize( ),&first_payload),"Error setting a kernel argument" );
-        V_OPENCL( kernels[0].setArg(2, sz),   "Error setting kernel argument" );
-        V_OPENCL( kernels[0].setArg(3, *userFunctor), "Error setting kernel argument" );
-        V_OPENCL( kernels[0].setArg(4, *result),      "Error setting kernel argument" );
-
-        ::cl::LocalSpaceArg loc;
-        loc.size_ = wgSize*sizeof(T);
-        V_OPENCL( kernels[0].setArg(5, loc), "Error setting kernel argument" );
+        cl_uint computeUnits = ctl.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+        control::buffPointer result;
+        size_t numWG = 0;
+        size_t wgSize = 0;
 
-        l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
-            kernels[0],
-            ::cl::NullRange,
-            ::cl::NDRange(numWG * wgSize),
-            ::cl::NDRange(wgSize));
+        //  Enqueues the reduction within the workgroups of shape, one result per workgroup
+        auto launch = [ & ]( const work_shape_tuner::work_shape& shape )
+        {
+            std::ostringstream compileOptions;
+            compileOptions << " -DREDUCE_WGSIZE=" << shape.wgSize << " -DREDUCE_UNROLL=" << shape.unroll;
+
+            Reduce_KernelTemplateSpecializer ts_kts;
+            std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels(
+                ctl,
+                typeNames,
+                &ts_kts,
+                typeDefinitions,
+                reduce_kernels,
+                compileOptions.str( ) );
+
+            // Set up shape of launch grid and buffers:
+            numWG = computeUnits * shape.wgPerComputeUnit;
+            wgSize = shape.wgSize;
+
+            // ::cl::Buffer result(ctl.context(), CL_MEM_ALLOC_HOST_PTR|CL_MEM_WRITE_ONLY, sizeof( iType )*numWG);
+            result = ctl.acquireBuffer( sizeof( T ) * numWG,
+                CL_MEM_ALLOC_HOST_PTR|CL_MEM_WRITE_ONLY );
+
+            V_OPENCL( kernels[0].setArg(0, first_buffer ), "Error setting kernel argument" );
+            V_OPENCL( kernels[0].setArg(1, first.gpuPayloadSize( ),&first_payload),"Error setting a kernel argument" );
+            V_OPENCL( kernels[0].setArg(2, static_cast< cl_int >( sz ) ),   "Error setting kernel argument" );
+            V_OPENCL( kernels[0].setArg(3, *userFunctor), "Error setting kernel argument" );
+            V_OPENCL( kernels[0].setArg(4, *result),      "Error setting kernel argument" );
+
+            ::cl::LocalSpaceArg loc;
+            loc.size_ = wgSize*sizeof(T);
+            V_OPENCL( kernels[0].setArg(5, loc), "Error setting kernel argument" );
+
+            cl_int l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
+                kernels[0],
+                ::cl::NullRange,
+                ::cl::NDRange(numWG * wgSize),
+                ::cl::NDRange(wgSize));
+
+            V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for reduce() kernel" );
+        };
+
+        // Bumped up wgSize and the workgroups per compute unit to achieve higher ALU usage and occupancy
+        work_shape_tuner::work_shape shape = { 256, 64, 1 };
+        if( ctl.getAutoTuneMode( ) & control::AutoTuneWorkShape )
+        {
+            const std::string key = work_shape_tuner::makeKey( ctl, "reduce", typeNames[ reduce_iIterType ] + ", " +
+                typeNames[ reduce_BinaryFunction ] + ", " + typeNames[ reduce_resType ], sz );
+            shape = work_shape_tuner::getInstance( ).tune( ctl, key, shape,
+                [ & ]( const work_shape_tuner::work_shape& candidate )
+                {
+                    launch( candidate );
+                    V_OPENCL( ctl.getCommandQueue( ).finish( ), "Error waiting for a tuning run of reduce()" );
+                } );
+        }
 
-        V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for reduce() kernel" );
+        launch( shape );
 
+        cl_int l_Error = CL_SUCCESS;
         ::cl::Event l_mapEvent;
         T *h_result = (T*)ctl.getCommandQueue().enqueueMapBuffer(*result, false, CL_MAP_READ, 0,
             sizeof(T)*numWG, NULL, &l_mapEvent, &l_Error );
@@ -290,7 +326,27 @@ namespace cl{
         bolt::cl::minimum<size_t>  min_size_t;
         size_t numTailReduce = min_size_t( ceilNumWG, numWG );
 
-        bolt::cl::wait(ctl, l_mapEvent);
+        //  An asynchronous reduce finishes the tail when its result is asked for; the result buffer stays mapped
+        //  until then
+        if( detail::deferred_completion* deferred = ctl.getDeferred( ) )
+        {
+            boost::shared_ptr< T > acc( new T( init ) );
+            ::cl::CommandQueue queue = ctl.getCommandQueue( );
+            deferred->result = acc;
+            deferred->finish = [ = ]( )
+            {
+                for( size_t i = 0; i < numTailReduce; ++i )
+                    *acc = (T) binary_op( *acc, h_result[ i ] );
+
+                ::cl::Event unmapEvent;
+                V_OPENCL( queue.enqueueUnmapMemObject( *result, h_result, NULL, &unmapEvent ),
+                    "shared_ptr failed to unmap host memory back to device memory" );
+                V_OPENCL( unmapEvent.wait( ), "failed to wait for unmap event" );
+            };
+            return init;
+        }
+
+        bolt::cl::wait(ctl, l_mapEvent, "reduce");
 
         T acc = init;
         for(unsigned int i = 0; i < numTailReduce; ++i)
@@ -319,7 +375,7 @@ namespace cl{
                 const std::string& cl_code, 
                 std::random_access_iterator_tag)
     {
-        int sz = static_cast<int>(last - first);
+        size_t sz = static_cast< size_t >(last - first);
         if (sz == 0)
             return init;
         typedef typename std::iterator_traits<InputIterator>::value_type  iType;
@@ -366,14 +422,14 @@ namespace cl{
                 BinaryFunction& binary_op,
                 const std::string& cl_code)
     {
-        int sz = static_cast<int>( std::distance(first, last ) );
+        size_t sz = static_cast< size_t >( std::distance(first, last ) );
         if (sz == 0)
             return init;
 
         bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
         if(runMode == bolt::cl::control::Automatic)
         {
-           runMode = ctl.getDefaultPathToRun();
+           runMode = bolt::cl::detail::selectRunMode( ctl, "reduce", first, sz );
         }
         #if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
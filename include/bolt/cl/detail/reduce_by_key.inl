@@ -29,10 +29,11 @@
 #include "bolt/cl/scan.h"
 
 #include <bolt/cl/iterator/iterator_traits.h>
-#include <bolt/cl/iterator/addressof.h>
+#include <bolt/cl/iterator/mapped_range.h>
 #include "bolt/cl/device_vector.h"
 #include "bolt/cl/distance.h"
 #include "bolt/cl/iterator/transform_iterator.h"
+#include "bolt/cl/cost_model.h"
 
 #ifdef ENABLE_TBB
 //TBB Includes
@@ -69,7 +70,7 @@ typename std::enable_if< (std::is_same< typename std::iterator_traits< OutputIte
                                      >::value &&
 						  std::is_same< typename std::iterator_traits< OutputIterator2 >::iterator_category ,
                                        std::random_access_iterator_tag
-                                     >::value), unsigned int
+                                     >::value), size_t
                            >::type
 reduce_by_key( ::bolt::cl::control &ctl, 
                InputIterator1 keys_first,
@@ -86,12 +87,12 @@ reduce_by_key( ::bolt::cl::control &ctl,
     typedef typename std::iterator_traits< OutputIterator1 >::value_type koType;
     typedef typename std::iterator_traits< OutputIterator2 >::value_type voType;
 
-    unsigned int numElements = static_cast< unsigned int >( std::distance( keys_first, keys_last ) );
+    size_t numElements = static_cast< size_t >( std::distance( keys_first, keys_last ) );
 
     // do zeroeth element
     *values_output = *values_first;
     *keys_output = *keys_first;
-    unsigned int count = 1;
+    size_t count = 1;
     // rbk oneth element and beyond
 
     values_first++;
@@ -143,7 +144,7 @@ typename std::enable_if< (std::is_same< typename std::iterator_traits< DVOutputI
                          std::is_same< typename std::iterator_traits< DVOutputIterator1 >::iterator_category ,
                                        bolt::cl::device_vector_tag
                                      >::value),
-					     unsigned int
+					     size_t
                        >::type
 reduce_by_key(
     ::bolt::cl::control &ctl, 
@@ -156,56 +157,33 @@ reduce_by_key(
     BinaryFunction& binary_op)
 {
 
-	typedef typename std::iterator_traits< DVInputIterator1 >::value_type kType;
-    typedef typename std::iterator_traits< DVInputIterator2 >::value_type vType;
-    typedef typename std::iterator_traits< DVOutputIterator1 >::value_type koType;
     typedef typename std::iterator_traits< DVOutputIterator2 >::value_type voType;
 
-    unsigned int sz = static_cast< unsigned int >( std::distance( keys_first, keys_last ) );
-
-    /*Get The associated OpenCL buffer for each of the iterators*/
-    ::cl::Buffer keyfirstBuffer  = keys_first.base().getContainer( ).getBuffer( );
-	::cl::Buffer valfirstBuffer  = values_first.base().getContainer( ).getBuffer( );
-    ::cl::Buffer keyresultBuffer = keys_output.getContainer( ).getBuffer( );
-	::cl::Buffer valresultBuffer = values_output.getContainer( ).getBuffer( );
-
-    /*Get The size of each OpenCL buffer*/
-    size_t keyfirst_sz  = keyfirstBuffer.getInfo<CL_MEM_SIZE>();
-	size_t valfirst_sz = valfirstBuffer.getInfo<CL_MEM_SIZE>();
-    size_t keyresult_sz = keyresultBuffer.getInfo<CL_MEM_SIZE>();
-	size_t valresult_sz = valresultBuffer.getInfo<CL_MEM_SIZE>();
-
-    cl_int map_err;
-    kType *keyfirstPtr  = (kType*)ctl.getCommandQueue().enqueueMapBuffer(keyfirstBuffer, true, CL_MAP_READ, 0, 
-                                                                        keyfirst_sz, NULL, NULL, &map_err);
-	vType *valfirstPtr  = (vType*)ctl.getCommandQueue().enqueueMapBuffer(valfirstBuffer, true, CL_MAP_READ, 0, 
-                                                                        valfirst_sz, NULL, NULL, &map_err);
-    koType *keyresultPtr = (koType*)ctl.getCommandQueue().enqueueMapBuffer(keyresultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                        keyresult_sz, NULL, NULL, &map_err);
-	voType *valresultPtr = (voType*)ctl.getCommandQueue().enqueueMapBuffer(valresultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                        valresult_sz, NULL, NULL, &map_err);
-
-    auto mapped_keyfirst_itr = create_mapped_iterator(typename std::iterator_traits<DVInputIterator1>::
-	                                          iterator_category(), 
-                                                    ctl, keys_first, keyfirstPtr);
-	auto mapped_valfirst_itr = create_mapped_iterator(typename std::iterator_traits<DVInputIterator2>::
-	                                          iterator_category(), 
-                                                    ctl, values_first,valfirstPtr);
-    auto mapped_keyresult_itr = create_mapped_iterator(typename std::iterator_traits<DVOutputIterator1>::
-	                                          iterator_category(), 
-                                                    ctl, keys_output, keyresultPtr);
-	auto mapped_valresult_itr = create_mapped_iterator(typename std::iterator_traits<DVOutputIterator2>::
-	                                          iterator_category(), 
-                                                    ctl, values_output, valresultPtr);
+    size_t sz = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+
+    //  There are at most as many segments as keys, but the outputs may be shorter than the input; the elements
+    //  past the last segment are not written, so the outputs are not invalidated
+    size_t keys_out_sz = std::min( sz, mapped_elements( keys_output ) );
+    size_t values_out_sz = std::min( sz, mapped_elements( values_output ) );
+
+
+    mapped_range< DVInputIterator1 > keys( ctl, keys_first, sz, CL_MAP_READ );
+    mapped_range< DVInputIterator2 > values( ctl, values_first, sz, CL_MAP_READ );
+    mapped_range< DVOutputIterator1 > keys_out( ctl, keys_output, keys_out_sz, CL_MAP_READ | CL_MAP_WRITE );
+    mapped_range< DVOutputIterator2 > values_out( ctl, values_output, values_out_sz, CL_MAP_READ | CL_MAP_WRITE );
+    auto mapped_keyfirst_itr = keys.begin( );
+    auto mapped_valfirst_itr = values.begin( );
+    auto mapped_keyresult_itr = keys_out.begin( );
+    auto mapped_valresult_itr = values_out.begin( );
 
 	// do zeroeth element
     mapped_valresult_itr[0] = mapped_valfirst_itr[0];
     mapped_keyresult_itr[0] = mapped_keyfirst_itr[0];
-    unsigned int count = 1;
+    size_t count = 1;
     // rbk oneth element and beyond
 
-    unsigned int vi=1, vo=0, ko=0;
-    for ( unsigned int i = 1; i < sz; i++)
+    size_t vi=1, vo=0, ko=0;
+    for ( size_t i = 1; i < sz; i++)
     {
         // load keys
         //kType currentKey  = mapped_keyfirst_itr[i];
@@ -235,13 +213,6 @@ reduce_by_key(
 		vi++;
     }
 
-    ::cl::Event unmap_event[4];
-    ctl.getCommandQueue().enqueueUnmapMemObject(keyfirstBuffer, keyfirstPtr, NULL, &unmap_event[0] );
-	ctl.getCommandQueue().enqueueUnmapMemObject(valfirstBuffer, valfirstPtr, NULL, &unmap_event[1] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(keyresultBuffer, keyresultPtr, NULL, &unmap_event[2] );
-	ctl.getCommandQueue().enqueueUnmapMemObject(valresultBuffer, valresultPtr, NULL, &unmap_event[3] );
-    unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait(); unmap_event[3].wait(); 
-
     return count;
 
 }
@@ -265,7 +236,7 @@ typename std::enable_if< (std::is_same< typename std::iterator_traits< OutputIte
                                      >::value &&
 						  std::is_same< typename std::iterator_traits< OutputIterator2 >::iterator_category ,
                                        std::random_access_iterator_tag
-                                     >::value), unsigned int
+                                     >::value), size_t
                            >::type
 reduce_by_key( ::bolt::cl::control &ctl, 
                InputIterator1 keys_first,
@@ -294,7 +265,7 @@ typename std::enable_if< (std::is_same< typename std::iterator_traits< DVOutputI
                          std::is_same< typename std::iterator_traits< DVOutputIterator1 >::iterator_category ,
                                        bolt::cl::device_vector_tag
                                      >::value),
-					     unsigned int
+					     size_t
 					  >::type
 reduce_by_key(
     ::bolt::cl::control &ctl, 
@@ -306,60 +277,31 @@ reduce_by_key(
     BinaryPredicate& binary_pred,
     BinaryFunction& binary_op)
 {
-	typedef typename std::iterator_traits< DVInputIterator1 >::value_type kType;
-    typedef typename std::iterator_traits< DVInputIterator2 >::value_type vType;
-    typedef typename std::iterator_traits< DVOutputIterator1 >::value_type koType;
     typedef typename std::iterator_traits< DVOutputIterator2 >::value_type voType;
 
-    unsigned int sz = static_cast< unsigned int >( std::distance( keys_first, keys_last ) );
-
-    /*Get The associated OpenCL buffer for each of the iterators*/
-    ::cl::Buffer keyfirstBuffer  = keys_first.base().getContainer( ).getBuffer( );
-	::cl::Buffer valfirstBuffer  = values_first.base().getContainer( ).getBuffer( );
-    ::cl::Buffer keyresultBuffer = keys_output.getContainer( ).getBuffer( );
-	::cl::Buffer valresultBuffer = values_output.getContainer( ).getBuffer( );
-
-    /*Get The size of each OpenCL buffer*/
-    size_t keyfirst_sz  = keyfirstBuffer.getInfo<CL_MEM_SIZE>();
-	size_t valfirst_sz = valfirstBuffer.getInfo<CL_MEM_SIZE>();
-    size_t keyresult_sz = keyresultBuffer.getInfo<CL_MEM_SIZE>();
-	size_t valresult_sz = valresultBuffer.getInfo<CL_MEM_SIZE>();
-
-    cl_int map_err;
-    kType *keyfirstPtr  = (kType*)ctl.getCommandQueue().enqueueMapBuffer(keyfirstBuffer, true, CL_MAP_READ, 0, 
-                                                                        keyfirst_sz, NULL, NULL, &map_err);
-	vType *valfirstPtr  = (vType*)ctl.getCommandQueue().enqueueMapBuffer(valfirstBuffer, true, CL_MAP_READ, 0, 
-                                                                        valfirst_sz, NULL, NULL, &map_err);
-    koType *keyresultPtr = (koType*)ctl.getCommandQueue().enqueueMapBuffer(keyresultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                        keyresult_sz, NULL, NULL, &map_err);
-	voType *valresultPtr = (voType*)ctl.getCommandQueue().enqueueMapBuffer(valresultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                        valresult_sz, NULL, NULL, &map_err);
-
-    auto mapped_keyfirst_itr = create_mapped_iterator(typename std::iterator_traits<DVInputIterator1>::
-	                                          iterator_category(), 
-                                                    ctl, keys_first, keyfirstPtr);
-	auto mapped_valfirst_itr = create_mapped_iterator(typename std::iterator_traits<DVInputIterator2>::
-	                                          iterator_category(), 
-                                                    ctl, values_first,valfirstPtr);
-    auto mapped_keyresult_itr = create_mapped_iterator(typename std::iterator_traits<DVOutputIterator1>::
-	                                          iterator_category(), 
-                                                    ctl, keys_output, keyresultPtr);
-	auto mapped_valresult_itr = create_mapped_iterator(typename std::iterator_traits<DVOutputIterator2>::
-	                                          iterator_category(), 
-                                                    ctl, values_output, valresultPtr);
-
-	unsigned int count = bolt::btbb::reduce_by_key( mapped_keyfirst_itr,  mapped_keyfirst_itr + sz, mapped_valfirst_itr, 
-		mapped_keyresult_itr, mapped_valresult_itr, binary_pred, binary_op);
+    size_t sz = static_cast< size_t >( std::distance( keys_first, keys_last ) );
+
+    //  There are at most as many segments as keys, but the outputs may be shorter than the input; the elements
+    //  past the last segment are not written, so the outputs are not invalidated
+    size_t keys_out_sz = std::min( sz, mapped_elements( keys_output ) );
+    size_t values_out_sz = std::min( sz, mapped_elements( values_output ) );
+
 
-    ::cl::Event unmap_event[4];
-    ctl.getCommandQueue().enqueueUnmapMemObject(keyfirstBuffer, keyfirstPtr, NULL, &unmap_event[0] );
-	ctl.getCommandQueue().enqueueUnmapMemObject(valfirstBuffer, valfirstPtr, NULL, &unmap_event[1] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(keyresultBuffer, keyresultPtr, NULL, &unmap_event[2] );
-	ctl.getCommandQueue().enqueueUnmapMemObject(valresultBuffer, valresultPtr, NULL, &unmap_event[3] );
-    unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait(); unmap_event[3].wait(); 
+    mapped_range< DVInputIterator1 > keys( ctl, keys_first, sz, CL_MAP_READ );
+    mapped_range< DVInputIterator2 > values( ctl, values_first, sz, CL_MAP_READ );
+    mapped_range< DVOutputIterator1 > keys_out( ctl, keys_output, keys_out_sz, CL_MAP_READ | CL_MAP_WRITE );
+    mapped_range< DVOutputIterator2 > values_out( ctl, values_output, values_out_sz, CL_MAP_READ | CL_MAP_WRITE );
+    auto mapped_keyfirst_itr = keys.begin( );
+    auto mapped_valfirst_itr = values.begin( );
+    auto mapped_keyresult_itr = keys_out.begin( );
+    auto mapped_valresult_itr = values_out.begin( );
+
+	size_t count = bolt::btbb::reduce_by_key( mapped_keyfirst_itr,  mapped_keyfirst_itr + sz, mapped_valfirst_itr, 
+		mapped_keyresult_itr, mapped_valresult_itr, binary_pred, binary_op);
 
     return count;
 
+
 }
 
 }//end of namespace btbb
@@ -481,7 +423,7 @@ typename std::enable_if< (std::is_same< typename std::iterator_traits< DVOutputI
                                      >::value &&
 						  std::is_same< typename std::iterator_traits< DVOutputIterator2 >::iterator_category ,
                                        bolt::cl::device_vector_tag
-                                     >::value), unsigned int
+                                     >::value), size_t
                            >::type
 reduce_by_key(
     control& ctl,
@@ -767,7 +709,7 @@ reduce_by_key(
                                                                     &l_Error );
     V_OPENCL( l_Error, "Error calling map on the result buffer" );
 
-    bolt::cl::wait(ctl, l_mapEvent);
+    bolt::cl::wait(ctl, l_mapEvent, "reduce_by_key");
 
     unsigned int count_number_of_sections = *(h_result);
 	
@@ -794,7 +736,7 @@ reduce_by_key(
     }
     result_val_after_launch.close();
     std::cout<<"Myval-------------------------ends"<<std::endl;
-    bolt::cl::wait(ctl, l_mapEvent3);
+    bolt::cl::wait(ctl, l_mapEvent3, "reduce_by_key");
     //delete this code -end
 
 #endif
@@ -815,7 +757,7 @@ template<
                                      >::value &&
 						  std::is_same< typename std::iterator_traits< OutputIterator2 >::iterator_category ,
                                        std::random_access_iterator_tag
-                                     >::value), unsigned int
+                                     >::value), size_t
                            >::type
 reduce_by_key(
     control& ctl,
@@ -829,7 +771,7 @@ reduce_by_key(
     const std::string& user_code)
 {
 
-	int sz = static_cast<int>(keys_last - keys_first);
+	size_t sz = static_cast< size_t >(keys_last - keys_first);
     if (sz == 1)
         return 1;
 
@@ -906,11 +848,12 @@ reduce_by_key(
     typename std::iterator_traits<InputIterator1>::difference_type numElements = bolt::cl::distance(keys_first, keys_last);
 
     if( (numElements == 1) || (numElements == 0) )
-        return bolt::cl::make_pair( keys_output+(int)numElements, values_output+(int)numElements );// keys_last, values_first+numElements );
+        return bolt::cl::make_pair( keys_output+numElements, values_output+numElements );// keys_last, values_first+numElements );
 
     bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
     if(runMode == bolt::cl::control::Automatic) {
-        runMode = ctl.getDefaultPathToRun();
+        runMode = bolt::cl::detail::selectRunMode( ctl, "reduce_by_key", keys_first,
+            static_cast< size_t >( numElements ) );
     }
 	#if defined(BOLT_DEBUG_LOG)
     BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -920,7 +863,7 @@ reduce_by_key(
             #if defined(BOLT_DEBUG_LOG)
             dblog->CodePathTaken(BOLTLOG::BOLT_REDUCEBYKEY,BOLTLOG::BOLT_SERIAL_CPU,"::Reduce_By_Key::SERIAL_CPU");
             #endif
-            int sizeOfOut = serial::reduce_by_key(ctl, keys_first, keys_last, values_first,keys_output, values_output, binary_pred, binary_op);
+            size_t sizeOfOut = serial::reduce_by_key(ctl, keys_first, keys_last, values_first,keys_output, values_output, binary_pred, binary_op);
 			return bolt::cl::make_pair(keys_output+sizeOfOut, values_output+sizeOfOut);
 		
     } 
@@ -930,7 +873,7 @@ reduce_by_key(
 		    #if defined(BOLT_DEBUG_LOG)
             dblog->CodePathTaken(BOLTLOG::BOLT_REDUCEBYKEY,BOLTLOG::BOLT_MULTICORE_CPU,"::Reduce_By_Key::MULTICORE_CPU");
             #endif
-            unsigned int sizeOfOut = btbb::reduce_by_key(ctl, keys_first, keys_last, values_first,keys_output, values_output, binary_pred, binary_op);
+            size_t sizeOfOut = btbb::reduce_by_key(ctl, keys_first, keys_last, values_first,keys_output, values_output, binary_pred, binary_op);
 			return bolt::cl::make_pair(keys_output+sizeOfOut, values_output+sizeOfOut);
         #else
             throw std::runtime_error("MultiCoreCPU Version of ReduceByKey not Enabled! \n");
@@ -942,7 +885,7 @@ reduce_by_key(
         dblog->CodePathTaken(BOLTLOG::BOLT_REDUCEBYKEY,BOLTLOG::BOLT_OPENCL_GPU,"::Reduce_By_Key::OPENCL_GPU");
         #endif
 	    
-	    unsigned int sizeOfOut = cl::reduce_by_key(ctl, keys_first, keys_last, values_first, keys_output, values_output, binary_pred, binary_op, user_code);
+	    size_t sizeOfOut = cl::reduce_by_key(ctl, keys_first, keys_last, values_first, keys_output, values_output, binary_pred, binary_op, user_code);
 	    return bolt::cl::make_pair(keys_output+sizeOfOut, values_output+sizeOfOut);
 
 	}
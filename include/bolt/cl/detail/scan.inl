@@ -49,7 +49,9 @@
 #include "bolt/cl/distance.h"
 #include "bolt/cl/iterator/iterator_traits.h"
 #include "bolt/cl/iterator/transform_iterator.h"
-#include "bolt/cl/iterator/addressof.h"
+#include "bolt/cl/iterator/mapped_range.h"
+#include "bolt/cl/cost_model.h"
+#include "bolt/cl/tuner.h"
 
 #ifdef ENABLE_TBB
 //TBB Includes
@@ -102,24 +104,12 @@ namespace detail
 				size_t sz = (last - first);
 				if (sz == 0)
 					return; 
-				typedef typename std::iterator_traits<InputIterator>::value_type iType;
 				typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-				/*Get The associated OpenCL buffer for each of the iterators*/
-				::cl::Buffer firstBuffer  = first.base().getContainer( ).getBuffer( );
-				::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-				/*Get The size of each OpenCL buffer*/
-				size_t first_sz  = firstBuffer.getInfo<CL_MEM_SIZE>();
-				size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-
-				cl_int map_err;
-				iType *firstPtr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(firstBuffer, true, CL_MAP_READ, 0, 
-																					first_sz, NULL, NULL, &map_err);
-				oType *resultPtr = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-																					result_sz, NULL, NULL, &map_err);
-				auto mapped_fst_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-																ctl, first, firstPtr);
-				auto mapped_res_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-																ctl, result, resultPtr);
+
+				mapped_range< InputIterator > input( ctl, first, sz, CL_MAP_READ );
+				mapped_range< OutputIterator > output( ctl, result, sz, overwrite_flags( result, first ) );
+				auto mapped_fst_itr = input.begin( );
+				auto mapped_res_itr = output.begin( );
 
 				oType  sum, temp;
 				if(inclusive)
@@ -134,7 +124,7 @@ namespace detail
 				   mapped_res_itr[0] = static_cast<oType>( init );
 				   sum = binary_op( mapped_res_itr[0], temp);
 				}
-				 for ( unsigned int index= 1; index<sz; index++)
+				 for ( size_t index= 1; index<sz; index++)
 				{
 					oType currentValue =  static_cast<oType>( *(mapped_fst_itr+index) ); 
 					if (inclusive)
@@ -149,11 +139,6 @@ namespace detail
 						sum = binary_op( sum, currentValue);
 					}
 				}
-				 
-				::cl::Event unmap_event[2];
-				ctl.getCommandQueue().enqueueUnmapMemObject(firstBuffer, firstPtr, NULL, &unmap_event[0] );
-				ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[1] );
-				unmap_event[0].wait(); unmap_event[1].wait(); 
 				return ;
 
 			}
@@ -197,7 +182,7 @@ namespace detail
 				  sum = binary_op( *result, temp);  
 				}
 
-				for ( unsigned int index= 1; index<sz; index++)
+				for ( size_t index= 1; index<sz; index++)
 				{
 				  oType currentValue =  static_cast<oType>( *(first + index) ); // convertible
 				  if (inclusive)
@@ -242,37 +227,20 @@ namespace detail
 				size_t sz = (last - first);
 				if (sz == 0)
 					return; 
-				typedef typename std::iterator_traits<InputIterator>::value_type iType;
-				typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-				/*Get The associated OpenCL buffer for each of the iterators*/
-				::cl::Buffer firstBuffer  = first.base().getContainer( ).getBuffer( );
-				::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-				/*Get The size of each OpenCL buffer*/
-				size_t first_sz  = firstBuffer.getInfo<CL_MEM_SIZE>();
-				size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-
-				cl_int map_err;
-				iType *firstPtr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(firstBuffer, true, CL_MAP_READ, 0, 
-																					first_sz, NULL, NULL, &map_err);
-				oType *resultPtr = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-																					result_sz, NULL, NULL, &map_err);
-				auto mapped_fst_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-																ctl, first, firstPtr);
-				auto mapped_res_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(),
-																ctl, result, resultPtr);
+				mapped_range< InputIterator > input( ctl, first, sz, CL_MAP_READ );
+				mapped_range< OutputIterator > output( ctl, result, sz, overwrite_flags( result, first ) );
+				auto mapped_fst_itr = input.begin( );
+				auto mapped_res_itr = output.begin( );
 
 				
 				if(inclusive)
-					bolt::btbb::inclusive_scan( mapped_fst_itr, mapped_fst_itr  + (int)sz,  mapped_res_itr, binary_op);
+					bolt::btbb::inclusive_scan( mapped_fst_itr, mapped_fst_itr  + sz,  mapped_res_itr, binary_op);
 				else
-					bolt::btbb::exclusive_scan( mapped_fst_itr,  mapped_fst_itr  + (int)sz , mapped_res_itr, init, binary_op);   
+					bolt::btbb::exclusive_scan( mapped_fst_itr,  mapped_fst_itr  + sz , mapped_res_itr, init, binary_op);   
 
-				::cl::Event unmap_event[2];
-				ctl.getCommandQueue().enqueueUnmapMemObject(firstBuffer, firstPtr, NULL, &unmap_event[0] );
-				ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[1] );
-				unmap_event[0].wait(); unmap_event[1].wait(); 
 				return ;
 
+
 			}
 
 	
@@ -294,7 +262,7 @@ namespace detail
 			const bool& inclusive,
 			const BinaryFunction& binary_op)
 	        {
-				int sz = static_cast<int>( std::distance (first, last));
+				size_t sz = static_cast< size_t >( std::distance (first, last));
 				if (sz == 0)
 					return;
 				if(inclusive)
@@ -396,16 +364,13 @@ namespace detail
 		};
 
 		//  All calls to inclusive_scan end up here, unless an exception was thrown
-//  This is the function that sets up the kernels to compile (once only) and execute
+//  This is the function that sets up the kernels to compile (once only) and execute, with work-groups of wgSize
 	  template< typename InputIterator, 
 				typename OutputIterator,
 				typename T, 
 				typename BinaryFunction >
-				typename std::enable_if< std::is_same< typename std::iterator_traits< OutputIterator >::iterator_category ,
-											bolt::cl::device_vector_tag
-											>::value
-							>::type
-			scan(
+				void
+			scan_enqueue(
 			control &ctrl,
 			const InputIterator& first,
 			const InputIterator& last,
@@ -413,7 +378,8 @@ namespace detail
 			const T& init_T,
 			const bool& inclusive,
 			const BinaryFunction& binary_op,
-			const std::string& user_code)
+			const std::string& user_code,
+			const int wgSize)
 			{
 			#ifdef BOLT_PROFILER_ENABLED
 			aProfiler.nextStep();
@@ -454,11 +420,11 @@ namespace detail
 				/**********************************************************************************
 				 * Compile Options
 				 *********************************************************************************/
-				bool cpuDevice = ctrl.getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
-				//std::cout << "Device is CPU: " << (cpuDevice?"TRUE":"FALSE") << std::endl;
-				const int kernel0_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
-				const int kernel1_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL1WAVES;
-				const int kernel2_WgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
+				//  Kernel 1 scans the block sums in local memory sized by the work-group of kernel 0, so the three
+				//  kernels run with the same work-group size
+				const int kernel0_WgSize = wgSize;
+				const int kernel1_WgSize = wgSize;
+				const int kernel2_WgSize = wgSize;
 				std::string compileOptions;
 				std::ostringstream oss;
 				oss << " -DKERNEL0WORKGROUPSIZE=" << kernel0_WgSize;
@@ -833,8 +799,7 @@ namespace detail
 								std::cout << e.what() << std::endl;
 								return;
 							}
-							l_Error = kernel2Event.wait( );
-							V_OPENCL( l_Error, "perBlockInclusiveScan failed to wait" );
+							bolt::cl::wait( ctrl, kernel2Event, "scan" );
 
 			#ifdef BOLT_PROFILER_ENABLED
 			aProfiler.nextStep();
@@ -944,6 +909,49 @@ namespace detail
 
 			}   //end of inclusive_scan_enqueue( )
 
+			template< typename InputIterator, 
+				typename OutputIterator,
+				typename T, 
+				typename BinaryFunction >
+				typename std::enable_if< std::is_same< typename std::iterator_traits< OutputIterator >::iterator_category ,
+											bolt::cl::device_vector_tag
+											>::value
+							>::type
+			scan(
+			control &ctrl,
+			const InputIterator& first,
+			const InputIterator& last,
+			const OutputIterator& result,
+			const T& init_T,
+			const bool& inclusive,
+			const BinaryFunction& binary_op,
+			const std::string& user_code)
+			{
+				const bool cpuDevice = ctrl.getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
+				int wgSize = (cpuDevice) ? 1 : WAVESIZE*KERNEL02WAVES;
+
+				//  The work-group size is all the kernels leave to tune.  The tuning runs write the output again and
+				//  again from the input, so a scan in place keeps the default
+				const bool inPlace = result.getContainer( ).getBuffer( )( ) == first.base( ).getContainer( ).getBuffer( )( );
+				if( ( ctrl.getAutoTuneMode( ) & control::AutoTuneWorkShape ) && !inPlace )
+				{
+					const work_shape_tuner::work_shape fallback = { static_cast< size_t >( wgSize ), ctrl.getWGPerComputeUnit( ), 1 };
+					const std::string key = work_shape_tuner::makeKey( ctrl, "scan", TypeName< InputIterator >::get( ) + ", " +
+						TypeName< OutputIterator >::get( ) + ", " + TypeName< BinaryFunction >::get( ),
+						static_cast< size_t >( std::distance( first, last ) ) );
+					wgSize = static_cast< int >( work_shape_tuner::getInstance( ).tune( ctrl, key, fallback,
+						work_shape_tuner::wgSizeCandidates( ctrl, fallback ),
+						[ & ]( const work_shape_tuner::work_shape& candidate )
+						{
+							scan_enqueue( ctrl, first, last, result, init_T, inclusive, binary_op, user_code,
+								static_cast< int >( candidate.wgSize ) );
+							V_OPENCL( ctrl.getCommandQueue( ).finish( ), "Error waiting for a tuning run of scan()" );
+						} ).wgSize );
+				}
+
+				scan_enqueue( ctrl, first, last, result, init_T, inclusive, binary_op, user_code, wgSize );
+			}
+
 			template< typename InputIterator, 
 				typename OutputIterator,
 				typename T, 
@@ -965,7 +973,7 @@ namespace detail
 				typedef typename std::iterator_traits< InputIterator >::value_type iType;
 				typedef typename std::iterator_traits< OutputIterator >::value_type oType;	    
 	    
-				int numElements = static_cast< int >( std::distance( first, last ) );
+				size_t numElements = static_cast< size_t >( std::distance( first, last ) );
 				if( numElements == 0 )
 					return;
 	    
@@ -1016,7 +1024,7 @@ namespace detail
 	    typedef typename std::iterator_traits< InputIterator >::value_type iType;
         typedef typename std::iterator_traits< OutputIterator >::value_type oType;
 
-        unsigned int numElements = static_cast< unsigned int >( std::distance( first, last ) );
+        size_t numElements = static_cast< size_t >( std::distance( first, last ) );
         if( numElements == 0 )
             return result;
 
@@ -1024,7 +1032,7 @@ namespace detail
 
         if( runMode == bolt::cl::control::Automatic )
         {
-            runMode = ctl.getDefaultPathToRun();
+            runMode = bolt::cl::detail::selectRunMode( ctl, "scan", first, numElements );
         }
         #if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -29,7 +29,8 @@
 #include "bolt/cl/distance.h"
 #include "bolt/cl/iterator/iterator_traits.h"
 #include "bolt/cl/iterator/transform_iterator.h"
-#include "bolt/cl/iterator/addressof.h"
+#include "bolt/cl/iterator/mapped_range.h"
+#include "bolt/cl/cost_model.h"
 
 
 #ifdef ENABLE_TBB
@@ -87,38 +88,21 @@ namespace detail
 				if (sz == 0)
 					return; 
 				
-				typedef typename std::iterator_traits<InputIterator1>::value_type kType;
-				typedef typename std::iterator_traits<InputIterator2>::value_type iType;
 				typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-				/*Get The associated OpenCL buffer for each of the iterators*/
-				::cl::Buffer first1Buffer  = first1.base().getContainer( ).getBuffer( );
-				::cl::Buffer first2Buffer  = first2.base().getContainer( ).getBuffer( );
-				::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-				/*Get The size of each OpenCL buffer*/
-				size_t first1_sz  = first1Buffer.getInfo<CL_MEM_SIZE>();
-				size_t first2_sz  = first2Buffer.getInfo<CL_MEM_SIZE>();
-				size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-
-				cl_int map_err;
-				kType *first1Ptr = (kType*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-																					first1_sz, NULL, NULL, &map_err);
-				iType *first2Ptr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-																					first2_sz, NULL, NULL, &map_err);
-				oType *resultPtr = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-																					result_sz, NULL, NULL, &map_err);
-				auto mapped_fst1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-																ctl, first1, first1Ptr);
-				auto mapped_fst2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-																ctl, first2, first2Ptr);
-				auto mapped_res_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-																ctl, result, resultPtr);
+
+				mapped_range< InputIterator1 > keys( ctl, first1, sz, CL_MAP_READ );
+				mapped_range< InputIterator2 > values( ctl, first2, sz, CL_MAP_READ );
+				mapped_range< OutputIterator > output( ctl, result, sz, overwrite_flags( result, first1, first2 ) );
+				auto mapped_fst1_itr = keys.begin( );
+				auto mapped_fst2_itr = values.begin( );
+				auto mapped_res_itr = output.begin( );
 
 				if(inclusive)
 				{					
 					// do zeroeth element
 					*mapped_res_itr = (*mapped_fst2_itr); // assign value
 					// scan oneth element and beyond
-					for ( unsigned int i=1; i< sz;  i++)
+					for ( size_t i=1; i< sz;  i++)
 					{
 						// load value
 						oType currentValue = *(mapped_fst2_itr +i ); 
@@ -141,7 +125,7 @@ namespace detail
 					oType temp = *mapped_fst2_itr;
 					*mapped_res_itr = static_cast<oType>( init );
 					// scan oneth element and beyond
-					for ( unsigned int i= 1; i<sz; i++)
+					for ( size_t i= 1; i<sz; i++)
 					{
 						// load value
 						oType currentValue = temp; // convertible
@@ -162,12 +146,7 @@ namespace detail
 				
 				    }		
 			    }
-				 
-				::cl::Event unmap_event[3];
-				ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-				ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-				ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[2] );
-				unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait(); 
+
 				return ;			
 	
 	         }
@@ -209,7 +188,7 @@ namespace detail
 					// do zeroeth element
 					*result = *first2; // assign value
 					// scan oneth element and beyond
-					for ( unsigned int i=1; i< sz;  i++)
+					for ( size_t i=1; i< sz;  i++)
 					{
 						// load value
 						oType currentValue = *(first2 + i); // convertible
@@ -235,7 +214,7 @@ namespace detail
 					oType temp = *first2;
 					*result = static_cast<oType>(init);
 					// scan oneth element and beyond
-					for ( unsigned int i= 1; i<sz; i++)
+					for ( size_t i= 1; i<sz; i++)
 					{
 						// load value
 						oType currentValue = temp; // convertible
@@ -289,42 +268,19 @@ namespace detail
 					if (sz == 0)
 						return; 
 				
-				typedef typename std::iterator_traits<InputIterator1>::value_type kType;
-				typedef typename std::iterator_traits<InputIterator2>::value_type iType;
-				typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-				/*Get The associated OpenCL buffer for each of the iterators*/
-				::cl::Buffer first1Buffer  = first1.base().getContainer( ).getBuffer( );
-				::cl::Buffer first2Buffer  = first2.base().getContainer( ).getBuffer( );
-				::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-				/*Get The size of each OpenCL buffer*/
-				size_t first1_sz  = first1Buffer.getInfo<CL_MEM_SIZE>();
-				size_t first2_sz  = first2Buffer.getInfo<CL_MEM_SIZE>();
-				size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-
-				cl_int map_err;
-				kType *first1Ptr = (kType*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-																					first1_sz, NULL, NULL, &map_err);
-				iType *first2Ptr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-																					first2_sz, NULL, NULL, &map_err);
-				oType *resultPtr = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-																					result_sz, NULL, NULL, &map_err);
-				auto mapped_fst1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-																ctl, first1, first1Ptr);
-				auto mapped_fst2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-																ctl, first2, first2Ptr);
-				auto mapped_res_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(),
-																ctl, result, resultPtr);
+				mapped_range< InputIterator1 > keys( ctl, first1, sz, CL_MAP_READ );
+				mapped_range< InputIterator2 > values( ctl, first2, sz, CL_MAP_READ );
+				mapped_range< OutputIterator > output( ctl, result, sz, overwrite_flags( result, first1, first2 ) );
+				auto mapped_fst1_itr = keys.begin( );
+				auto mapped_fst2_itr = values.begin( );
+				auto mapped_res_itr = output.begin( );
 				if(inclusive)
-					bolt::btbb::inclusive_scan_by_key(mapped_fst1_itr, mapped_fst1_itr + (int)sz, mapped_fst2_itr, mapped_res_itr, binary_pred, binary_op );
+					bolt::btbb::inclusive_scan_by_key(mapped_fst1_itr, mapped_fst1_itr + sz, mapped_fst2_itr, mapped_res_itr, binary_pred, binary_op );
 				else
-					bolt::btbb::exclusive_scan_by_key(mapped_fst1_itr, mapped_fst1_itr + (int)sz, mapped_fst2_itr, mapped_res_itr, init, binary_pred, binary_op );
-				
-				::cl::Event unmap_event[3];
-				ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-				ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-				ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[2] );
-				unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait(); 
+					bolt::btbb::exclusive_scan_by_key(mapped_fst1_itr, mapped_fst1_itr + sz, mapped_fst2_itr, mapped_res_itr, init, binary_pred, binary_op );
+
 				return ;		
+
 		
 				}
 
@@ -838,7 +794,7 @@ namespace detail
 				typedef typename std::iterator_traits< InputIterator2 >::value_type iType;
 				typedef typename std::iterator_traits< OutputIterator >::value_type oType;	    
 	    
-				int numElements = static_cast< int >( std::distance( first1, last1 ) );
+				size_t numElements = static_cast< size_t >( std::distance( first1, last1 ) );
 				if( numElements == 0 )
 					return;
 	    
@@ -901,7 +857,7 @@ namespace detail
 			typedef typename std::iterator_traits< InputIterator2 >::value_type iType;
 			typedef typename std::iterator_traits< OutputIterator >::value_type oType;
 
-			unsigned int numElements = static_cast< unsigned int >( std::distance( first1, last1 ) );
+			size_t numElements = static_cast< size_t >( std::distance( first1, last1 ) );
 			if( numElements == 0 )
 				return result;
 
@@ -909,7 +865,7 @@ namespace detail
 
 			if( runMode == bolt::cl::control::Automatic )
 			{
-				runMode = ctl.getDefaultPathToRun();
+				runMode = bolt::cl::detail::selectRunMode( ctl, "scan_by_key", first1, numElements );
 			}
 			#if defined(BOLT_DEBUG_LOG)
 			BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -34,7 +34,8 @@
 #include "bolt/cl/distance.h"
 #include "bolt/cl/iterator/iterator_traits.h"
 #include "bolt/cl/iterator/transform_iterator.h"
-#include "bolt/cl/iterator/addressof.h"
+#include "bolt/cl/iterator/mapped_range.h"
+#include "bolt/cl/cost_model.h"
 
 
 namespace bolt {
@@ -60,41 +61,20 @@ scatter (bolt::cl::control &ctl, InputIterator1 first1,
     typename std::iterator_traits<InputIterator1>::difference_type sz = (last1 - first1);
     if (sz == 0)
         return;
-    typedef typename std::iterator_traits<InputIterator1>::value_type iType1;
-    typedef typename std::iterator_traits<InputIterator2>::value_type iType2;
     typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-    /*Get The associated OpenCL buffer for each of the iterators*/
-    ::cl::Buffer first1Buffer = first1.base().getContainer( ).getBuffer( );
-    ::cl::Buffer first2Buffer = map.base().getContainer( ).getBuffer( );
-    ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-    /*Get The size of each OpenCL buffer*/
-    size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-    size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
-    size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-    
-    cl_int map_err;
-    iType1 *first1Ptr = (iType1*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                     first1_sz, NULL, NULL, &map_err);
-    iType2 *first2Ptr = (iType2*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                     first2_sz, NULL, NULL, &map_err);
-    oType *resultPtr  = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                     result_sz, NULL, NULL, &map_err);
-    auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-                                                   ctl, first1, first1Ptr);
-    auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-                                                   ctl, map, first2Ptr);
-    auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                   ctl, result, resultPtr);
-
-	for (int iter = 0; iter<(int)sz; iter++)
-                *(mapped_result_itr +*(mapped_first2_itr + iter)) = (oType) *(mapped_first1_itr + iter);
 
+    //  The map picks the output elements at random, so the output is mapped from its first element to its end, and
+    //  the elements that are not picked are kept
+    mapped_range< InputIterator1 > values( ctl, first1, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator2 > indices( ctl, map, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< OutputIterator > out( ctl, result, mapped_elements( result ), CL_MAP_READ | CL_MAP_WRITE );
+    auto mapped_first1_itr = values.begin( );
+    auto mapped_first2_itr = indices.begin( );
+    auto mapped_result_itr = out.begin( );
+
+	for (typename std::iterator_traits<InputIterator1>::difference_type iter = 0; iter < sz; iter++)
+                *(mapped_result_itr +*(mapped_first2_itr + iter)) = (oType) *(mapped_first1_itr + iter);
 
-    ::cl::Event unmap_event[3];
-    ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[2] );
-    unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait();
     return;
 }
 
@@ -116,7 +96,7 @@ scatter (bolt::cl::control &ctl, InputIterator1 first1,
 
     size_t numElements = static_cast<  size_t >( std::distance( first1, last1 ) );
 
-	for (int iter = 0; iter<(int)numElements; iter++)
+	for (size_t iter = 0; iter < numElements; iter++)
                 *(result+*(map + iter)) = (oType) *(first1 + iter);
 }
 
@@ -142,52 +122,26 @@ scatter_if( bolt::cl::control &ctl,
     typename std::iterator_traits<InputIterator1>::difference_type sz = (last1 - first1);
     if (sz == 0)
         return;
-    typedef typename std::iterator_traits<InputIterator1>::value_type iType1;
-    typedef typename std::iterator_traits<InputIterator2>::value_type iType2;
-	typedef typename std::iterator_traits<InputIterator3>::value_type iType3;
     typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-    /*Get The associated OpenCL buffer for each of the iterators*/
-    ::cl::Buffer first1Buffer = first1.base().getContainer( ).getBuffer( );
-    ::cl::Buffer first2Buffer = map.base().getContainer( ).getBuffer( );
-	::cl::Buffer first3Buffer = stencil.base().getContainer( ).getBuffer( );
-    ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-    /*Get The size of each OpenCL buffer*/
-    size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-    size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
-	size_t first3_sz = first3Buffer.getInfo<CL_MEM_SIZE>();
-    size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-    
-    cl_int map_err;
-    iType1 *first1Ptr = (iType1*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                     first1_sz, NULL, NULL, &map_err);
-    iType2 *first2Ptr = (iType2*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                     first2_sz, NULL, NULL, &map_err);
-	iType3 *first3Ptr = (iType3*)ctl.getCommandQueue().enqueueMapBuffer(first3Buffer, true, CL_MAP_READ, 0, 
-                                                                     first3_sz, NULL, NULL, &map_err);
-    oType *resultPtr  = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                     result_sz, NULL, NULL, &map_err);
-    auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-                                                   ctl, first1, first1Ptr);
-    auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-                                                   ctl, map, first2Ptr);
-	auto mapped_first3_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator3>::iterator_category(), 
-                                                   ctl, stencil, first3Ptr);
-    auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                   ctl, result, resultPtr);
-
-	for(int iter = 0; iter< (int)sz; iter++)
+
+    //  The map picks the output elements at random, so the output is mapped from its first element to its end, and
+    //  the elements that are not picked are kept
+    mapped_range< InputIterator1 > values( ctl, first1, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator2 > indices( ctl, map, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator3 > stencils( ctl, stencil, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< OutputIterator > out( ctl, result, mapped_elements( result ), CL_MAP_READ | CL_MAP_WRITE );
+    auto mapped_first1_itr = values.begin( );
+    auto mapped_first2_itr = indices.begin( );
+    auto mapped_first3_itr = stencils.begin( );
+    auto mapped_result_itr = out.begin( );
+
+	for(typename std::iterator_traits<InputIterator1>::difference_type iter = 0; iter < sz; iter++)
     {
           if(pred(*(mapped_first3_itr + iter) ) != 0)
                //result[*(map+(iter - 0))] = first1[iter];
 		       *(mapped_result_itr + *(mapped_first2_itr + (iter -0))) = (oType) *(mapped_first1_itr + iter);
     }
 
-    ::cl::Event unmap_event[4];
-    ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-	ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first3Ptr, NULL, &unmap_event[2] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[3] );
-    unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait(); unmap_event[3].wait();
     return;
 
 }
@@ -213,7 +167,8 @@ scatter_if( bolt::cl::control &ctl,
             Predicate pred)
 {
     size_t numElements = static_cast< size_t >( std::distance( first1, last1 ) );
-	for (int iter = 0; iter< (int)numElements; iter++)
+	for (size_t iter = 0; iter < numElements; iter++)
+
     {
           if(pred(stencil[iter]) != 0)
                result[*(map+(iter))] = first1[iter];
@@ -242,39 +197,19 @@ scatter (bolt::cl::control &ctl, InputIterator1 first1,
     typename std::iterator_traits<InputIterator1>::difference_type sz = (last1 - first1);
     if (sz == 0)
         return;
-    typedef typename std::iterator_traits<InputIterator1>::value_type iType1;
-    typedef typename std::iterator_traits<InputIterator2>::value_type iType2;
     typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-    /*Get The associated OpenCL buffer for each of the iterators*/
-    ::cl::Buffer first1Buffer = first1.base().getContainer( ).getBuffer( );
-    ::cl::Buffer first2Buffer = map.base().getContainer( ).getBuffer( );
-    ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-    /*Get The size of each OpenCL buffer*/
-    size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-    size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
-    size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-    
-    cl_int map_err;
-    iType1 *first1Ptr = (iType1*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                     first1_sz, NULL, NULL, &map_err);
-    iType2 *first2Ptr = (iType2*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                     first2_sz, NULL, NULL, &map_err);
-    oType *resultPtr  = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                     result_sz, NULL, NULL, &map_err);
-    auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-                                                   ctl, first1, first1Ptr);
-    auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-                                                   ctl, map, first2Ptr);
-    auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                   ctl, result, resultPtr);
+
+    //  The map picks the output elements at random, so the output is mapped from its first element to its end, and
+    //  the elements that are not picked are kept
+    mapped_range< InputIterator1 > values( ctl, first1, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator2 > indices( ctl, map, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< OutputIterator > out( ctl, result, mapped_elements( result ), CL_MAP_READ | CL_MAP_WRITE );
+    auto mapped_first1_itr = values.begin( );
+    auto mapped_first2_itr = indices.begin( );
+    auto mapped_result_itr = out.begin( );
 
 	bolt::btbb::scatter(mapped_first1_itr, mapped_first1_itr + sz, mapped_first2_itr, mapped_result_itr);
 
-    ::cl::Event unmap_event[3];
-    ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[2] );
-    unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait();
     return;
 }
 
@@ -317,47 +252,21 @@ scatter_if( bolt::cl::control &ctl,
     typename std::iterator_traits<InputIterator1>::difference_type sz = (last1 - first1);
     if (sz == 0)
         return;
-    typedef typename std::iterator_traits<InputIterator1>::value_type iType1;
-    typedef typename std::iterator_traits<InputIterator2>::value_type iType2;
-	typedef typename std::iterator_traits<InputIterator3>::value_type iType3;
     typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-    /*Get The associated OpenCL buffer for each of the iterators*/
-    ::cl::Buffer first1Buffer = first1.base().getContainer( ).getBuffer( );
-    ::cl::Buffer first2Buffer = map.base().getContainer( ).getBuffer( );
-	::cl::Buffer first3Buffer = stencil.base().getContainer( ).getBuffer( );
-    ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-    /*Get The size of each OpenCL buffer*/
-    size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-    size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
-	size_t first3_sz = first3Buffer.getInfo<CL_MEM_SIZE>();
-    size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-    
-    cl_int map_err;
-    iType1 *first1Ptr = (iType1*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                     first1_sz, NULL, NULL, &map_err);
-    iType2 *first2Ptr = (iType2*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                     first2_sz, NULL, NULL, &map_err);
-	iType3 *first3Ptr = (iType3*)ctl.getCommandQueue().enqueueMapBuffer(first3Buffer, true, CL_MAP_READ, 0, 
-                                                                     first3_sz, NULL, NULL, &map_err);
-    oType *resultPtr  = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                     result_sz, NULL, NULL, &map_err);
-    auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-                                                   ctl, first1, first1Ptr);
-    auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-                                                   ctl, map, first2Ptr);
-	auto mapped_first3_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator3>::iterator_category(), 
-                                                   ctl, stencil, first3Ptr);
-    auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                   ctl, result, resultPtr);
+
+    //  The map picks the output elements at random, so the output is mapped from its first element to its end, and
+    //  the elements that are not picked are kept
+    mapped_range< InputIterator1 > values( ctl, first1, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator2 > indices( ctl, map, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< InputIterator3 > stencils( ctl, stencil, static_cast< size_t >( sz ), CL_MAP_READ );
+    mapped_range< OutputIterator > out( ctl, result, mapped_elements( result ), CL_MAP_READ | CL_MAP_WRITE );
+    auto mapped_first1_itr = values.begin( );
+    auto mapped_first2_itr = indices.begin( );
+    auto mapped_first3_itr = stencils.begin( );
+    auto mapped_result_itr = out.begin( );
 
 	bolt::btbb::scatter_if(mapped_first1_itr, mapped_first1_itr + sz, mapped_first2_itr, mapped_first3_itr, mapped_result_itr, pred);
 
-    ::cl::Event unmap_event[4];
-    ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-	ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first3Ptr, NULL, &unmap_event[2] );
-    ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[3] );
-    unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait(); unmap_event[3].wait();
     return;
 
 }
@@ -605,7 +514,7 @@ public:
             &scatterIfEvent );
         V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for scatter_if() kernel" );
 
-        ::bolt::cl::wait(ctl, scatterIfEvent);
+        ::bolt::cl::wait(ctl, scatterIfEvent, "scatter_if");
 
     };
 
@@ -725,7 +634,7 @@ public:
             &scatterEvent );
         V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for scatter_if() kernel" );
 
-        ::bolt::cl::wait(ctl, scatterEvent);
+        ::bolt::cl::wait(ctl, scatterEvent, "scatter");
 
     };
 
@@ -753,7 +662,7 @@ public:
 		typedef typename std::iterator_traits<InputIterator3>::value_type iType3;
         typedef typename std::iterator_traits<OutputIterator>::value_type oType;
 
-        int sz = static_cast<int>( std::distance( first1, last1 ) );
+        size_t sz = static_cast< size_t >( std::distance( first1, last1 ) );
 
         device_vector< oType > dvResult( result, sz, CL_MEM_USE_HOST_PTR|CL_MEM_WRITE_ONLY, false, ctl );
 
@@ -819,7 +728,7 @@ public:
         typedef typename std::iterator_traits<MapIterator>::value_type iType2;
         typedef typename std::iterator_traits<OutputIterator>::value_type oType;
 
-        int sz = static_cast<int>( std::distance( first1, last1 ) );
+        size_t sz = static_cast< size_t >( std::distance( first1, last1 ) );
 
         device_vector< oType > dvResult( result, sz, CL_MEM_USE_HOST_PTR|CL_MEM_WRITE_ONLY, false, ctl );
 
@@ -881,7 +790,7 @@ public:
                 const Predicate& pred,
                 const std::string& user_code )
     {   
-		int sz = static_cast<int>( std::distance( first1, last1 ) );
+		size_t sz = static_cast< size_t >( std::distance( first1, last1 ) );
         if (sz == 0)
             return;
 
@@ -889,7 +798,7 @@ public:
         bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
         if(runMode == bolt::cl::control::Automatic)
         {
-          runMode = ctl.getDefaultPathToRun();
+          runMode = bolt::cl::detail::selectRunMode( ctl, "scatter", first1, sz );
         }
 	    #if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -983,7 +892,7 @@ public:
              const std::string& user_code )
     {
        	
-        int sz = static_cast<int>( std::distance( first1, last1 ) );
+        size_t sz = static_cast< size_t >( std::distance( first1, last1 ) );
         if (sz == 0)
             return;
 
@@ -991,7 +900,7 @@ public:
         bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
         if(runMode == bolt::cl::control::Automatic)
         {
-          runMode = ctl.getDefaultPathToRun();
+          runMode = bolt::cl::detail::selectRunMode( ctl, "scatter", first1, sz );
         }
 	    #if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
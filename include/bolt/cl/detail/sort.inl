@@ -46,9 +46,12 @@
 
 #ifdef ENABLE_TBB
 #include "bolt/btbb/sort.h"
+#include "bolt/btbb/radix_sort.h"
 #endif
 
 #include "bolt/cl/stablesort.h"
+#include "bolt/cl/cost_model.h"
+#include "bolt/cl/tuner.h"
 #define BOLT_UINT_MAX 0xFFFFFFFFU
 #define BOLT_UINT_MIN 0x0U
 #define BOLT_INT_MAX 0x7FFFFFFF
@@ -396,7 +399,10 @@ sort_enqueue(control &ctl,
         swap = swap? 0: 1;
     }
 
-    V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
+    //  Wait for the last kernel with the wait mode of the control; an asynchronous sort returns at once
+    ::cl::Event sortEvent;
+    V_OPENCL( ctl.getCommandQueue().enqueueMarker( &sortEvent ), "Error calling enqueueMarker on the command queue" );
+    bolt::cl::wait( ctl, sortEvent, "radix_sort_uint" );
     return;
 }
 
@@ -704,7 +710,10 @@ sort_enqueue(control &ctl,
 
     }//End of signed integer sorting
     
-    V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
+    //  Wait for the last kernel with the wait mode of the control; an asynchronous sort returns at once
+    ::cl::Event sortEvent;
+    V_OPENCL( ctl.getCommandQueue().enqueueMarker( &sortEvent ), "Error calling enqueueMarker on the command queue" );
+    bolt::cl::wait( ctl, sortEvent, "radix_sort_int" );
     return;
 }
 
@@ -783,31 +792,58 @@ sort_enqueue(control &ctl,
                                                 "Error setting 1st kernel argument" );
 
     V_OPENCL( kernels[0].setArg(4, *userFunctor), "Error setting 4th kernel argument" );
-    for(stage = 0; stage < numStages; ++stage)
+
+    //  Enqueues every pass of the sort with work-groups of groupSize
+    auto launch = [ & ]( size_t groupSize )
+    {
+        for(stage = 0; stage < numStages; ++stage)
+        {
+            // stage of the algorithm
+            V_OPENCL( kernels[0].setArg(2, stage), "Error setting 2nd kernel argument" );
+            // Every stage has stage + 1 passes
+            for(passOfStage = 0; passOfStage < stage + 1; ++passOfStage) {
+                // pass of the current stage
+                V_OPENCL( kernels[0].setArg(3, passOfStage), "Error setting 3rd kernel argument" );
+                /*
+                 * Enqueue a kernel run call.
+                 * Each thread writes a sorted pair.
+                 * So, the number of  threads (global) should be half the length of the input buffer.
+                 */
+                l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
+                                                kernels[0],
+                                                ::cl::NullRange,
+                                                ::cl::NDRange(szElements/2),
+                                                ::cl::NDRange(groupSize),
+                                                NULL,
+                                                NULL);
+
+                V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for sort() kernel" );
+                //V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
+            }//end of for passStage = 0:stage-1
+        }//end of for stage = 0:numStage-1
+    };
+
+    //  The work-group size is all the kernel leaves to tune.  The tuning runs sort the range again and again,
+    //  which leaves it sorted, and a bitonic sort takes as long whatever the order of its input
+    if( ctl.getAutoTuneMode( ) & control::AutoTuneWorkShape )
     {
-        // stage of the algorithm
-        V_OPENCL( kernels[0].setArg(2, stage), "Error setting 2nd kernel argument" );
-        // Every stage has stage + 1 passes
-        for(passOfStage = 0; passOfStage < stage + 1; ++passOfStage) {
-            // pass of the current stage
-            V_OPENCL( kernels[0].setArg(3, passOfStage), "Error setting 3rd kernel argument" );
-            /*
-             * Enqueue a kernel run call.
-             * Each thread writes a sorted pair.
-             * So, the number of  threads (global) should be half the length of the input buffer.
-             */
-            l_Error = ctl.getCommandQueue().enqueueNDRangeKernel(
-                                            kernels[0],
-                                            ::cl::NullRange,
-                                            ::cl::NDRange(szElements/2),
-                                            ::cl::NDRange(wgSize),
-                                            NULL,
-                                            NULL);
-
-            V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for sort() kernel" );
-            //V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
-        }//end of for passStage = 0:stage-1
-    }//end of for stage = 0:numStage-1
+        const work_shape_tuner::work_shape fallback = { wgSize, ctl.getWGPerComputeUnit( ), 1 };
+        std::vector< work_shape_tuner::work_shape > shapes = work_shape_tuner::wgSizeCandidates( ctl, fallback );
+        shapes.erase( std::remove_if( shapes.begin( ), shapes.end( ),
+            [ & ]( const work_shape_tuner::work_shape& shape ) { return shape.wgSize > szElements / 2; } ),
+            shapes.end( ) );
+
+        const std::string key = work_shape_tuner::makeKey( ctl, "bitonic_sort", typeNames[ sort_iIterType ] + ", " +
+            typeNames[ sort_StrictWeakOrdering ], szElements );
+        wgSize = work_shape_tuner::getInstance( ).tune( ctl, key, fallback, shapes,
+            [ & ]( const work_shape_tuner::work_shape& candidate )
+            {
+                launch( candidate.wgSize );
+                V_OPENCL( ctl.getCommandQueue( ).finish( ), "Error waiting for a tuning run of sort()" );
+            } ).wgSize;
+    }
+
+    launch( wgSize );
 
     //TODO this is a bug in APP SDK cl.hpp file The header file is non compliant with the khronos cl.hpp.
     //     Hence a finish function is added to wait for all the tasks to complete.
@@ -816,10 +852,48 @@ sort_enqueue(control &ctl,
                         "Error calling clEnqueueBarrierWithWaitList on the command queue" );
     l_Error = bitonicSortEvent.wait( );
     V_OPENCL( l_Error, "bitonicSortEvent failed to wait" );*/
-    V_OPENCL( ctl.getCommandQueue().finish(), "Error calling finish on the command queue" );
+    //  Wait for the last kernel with the wait mode of the control; an asynchronous sort returns at once
+    ::cl::Event sortEvent;
+    V_OPENCL( ctl.getCommandQueue().enqueueMarker( &sortEvent ), "Error calling enqueueMarker on the command queue" );
+    bolt::cl::wait( ctl, sortEvent, "bitonic_sort" );
     return;
 }// END of sort_enqueue
 
+#ifdef ENABLE_TBB
+//  The MultiCoreCpu sort: 0 is the comparison sort of TBB, 1 and 2 are the ascending and descending radix sort of
+//  btbb, which bolt::btbb::radix_sort_order picks for the built-in less and greater of the types it knows
+template<typename RandomAccessIterator, typename StrictWeakOrdering>
+void btbb_sort( RandomAccessIterator first, RandomAccessIterator last, const StrictWeakOrdering& comp,
+                std::integral_constant< int, 0 > )
+{
+    bolt::btbb::sort( first, last, comp );
+}
+
+template<typename RandomAccessIterator, typename StrictWeakOrdering>
+void btbb_sort( RandomAccessIterator first, RandomAccessIterator last, const StrictWeakOrdering&,
+                std::integral_constant< int, 1 > )
+{
+    typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+    bolt::btbb::radix_sort( first, last, std::less< T >( ) );
+}
+
+template<typename RandomAccessIterator, typename StrictWeakOrdering>
+void btbb_sort( RandomAccessIterator first, RandomAccessIterator last, const StrictWeakOrdering&,
+                std::integral_constant< int, 2 > )
+{
+    typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+    bolt::btbb::radix_sort( first, last, std::greater< T >( ) );
+}
+
+template<typename RandomAccessIterator, typename StrictWeakOrdering>
+void btbb_sort( RandomAccessIterator first, RandomAccessIterator last, const StrictWeakOrdering& comp )
+{
+    typedef typename std::iterator_traits< RandomAccessIterator >::value_type T;
+    btbb_sort( first, last, comp,
+               std::integral_constant< int, bolt::btbb::radix_sort_order< T, StrictWeakOrdering >::value >( ) );
+}
+#endif
+
 //Device Vector specialization
 template<typename DVRandomAccessIterator, typename StrictWeakOrdering>
 void sort_pick_iterator( control &ctl,
@@ -836,7 +910,7 @@ void sort_pick_iterator( control &ctl,
     bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
     if(runMode == bolt::cl::control::Automatic)
     {
-        runMode = ctl.getDefaultPathToRun();
+        runMode = bolt::cl::detail::selectRunMode( ctl, "sort", first, szElements, bolt::cl::cost_model::NLogN );
     }
     #if defined(BOLT_DEBUG_LOG)
     BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -855,8 +929,8 @@ void sort_pick_iterator( control &ctl,
         dblog->CodePathTaken(BOLTLOG::BOLT_SORT,BOLTLOG::BOLT_MULTICORE_CPU,"::Sort::MULTICORE_CPU");
         #endif
         typename bolt::cl::device_vector< T >::pointer firstPtr =  first.getContainer( ).data( );
-        //Compute parallel sort using TBB
-        bolt::btbb::sort(&firstPtr[ first.m_Index ], &firstPtr[ last.m_Index ],comp);
+        //Compute parallel sort using TBB; radix sort for the built-in comparisons
+        btbb_sort(&firstPtr[ first.m_Index ], &firstPtr[ last.m_Index ],comp);
         return;
 #else
         //std::cout << "The MultiCoreCpu version of sort is not enabled. " << std ::endl;
@@ -891,7 +965,7 @@ void sort_pick_iterator( control &ctl,
     bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
     if(runMode == bolt::cl::control::Automatic)
     {
-        runMode = ctl.getDefaultPathToRun();
+        runMode = bolt::cl::detail::selectRunMode( ctl, "sort", first, szElements, bolt::cl::cost_model::NLogN );
     }
     #if defined(BOLT_DEBUG_LOG)
     BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -908,7 +982,7 @@ void sort_pick_iterator( control &ctl,
         #if defined(BOLT_DEBUG_LOG)
         dblog->CodePathTaken(BOLTLOG::BOLT_SORT,BOLTLOG::BOLT_MULTICORE_CPU,"::Sort::MULTICORE_CPU");
         #endif
-        bolt::btbb::sort(first,last, comp);
+        btbb_sort(first,last, comp);
 #else
         throw std::runtime_error( "The MultiCoreCpu version of sort is not enabled to be built! \n" );
 #endif
@@ -50,6 +50,7 @@
 #endif
 
 #include "bolt/cl/stablesort_by_key.h"
+#include "bolt/cl/cost_model.h"
 
 #define BITONIC_SORT_WGSIZE 64
 #define DEBUG 1
@@ -819,7 +820,8 @@ enum sortByKeyTypes {sort_by_key_keyValueType, sort_by_key_keyIterType,
         bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
         if( runMode == bolt::cl::control::Automatic )
         {
-            runMode = ctl.getDefaultPathToRun( );
+            runMode = bolt::cl::detail::selectRunMode( ctl, "sort_by_key", keys_first,
+                szElements, bolt::cl::cost_model::NLogN );
         }
 		#if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -873,14 +875,15 @@ enum sortByKeyTypes {sort_by_key_keyValueType, sort_by_key_keyIterType,
 
         typedef typename std::iterator_traits<RandomAccessIterator1>::value_type T_keys;
         typedef typename std::iterator_traits<RandomAccessIterator2>::value_type T_values;
-        int szElements = static_cast<int>(keys_last - keys_first);
+        size_t szElements = static_cast< size_t >(keys_last - keys_first);
         if (szElements == 0)
             return;
 
         bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode( );
         if( runMode == bolt::cl::control::Automatic )
         {
-            runMode = ctl.getDefaultPathToRun( );
+            runMode = bolt::cl::detail::selectRunMode( ctl, "sort_by_key", keys_first,
+                szElements, bolt::cl::cost_model::NLogN );
         }
 	    #if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -897,7 +900,7 @@ enum sortByKeyTypes {sort_by_key_keyValueType, sort_by_key_keyIterType,
 			    #if defined(BOLT_DEBUG_LOG)
                 dblog->CodePathTaken(BOLTLOG::BOLT_SORTBYKEY,BOLTLOG::BOLT_MULTICORE_CPU,"::Sort_By_Key::MULTICORE_CPU");
                 #endif
-                serialCPU_sort_by_key(keys_first, keys_last, values_first, comp);
+                bolt::btbb::sort_by_key(keys_first, keys_last, values_first, comp);
                 return;
             #else
                 throw std::runtime_error("The MultiCoreCpu Version of Sort_by_key is not enabled to be built with TBB!\n");
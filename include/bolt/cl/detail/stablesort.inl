@@ -27,6 +27,7 @@
 #define BOLT_CL_STABLESORT_CPU_THRESHOLD 256
 
 #include "bolt/cl/sort.h"
+#include "bolt/cl/cost_model.h"
 
 namespace bolt {
 namespace cl {
@@ -342,7 +343,7 @@ void stablesort_pick_iterator( control &ctl, const RandomAccessIterator& first,
 
     if( runMode == bolt::cl::control::Automatic )
     {
-        runMode = ctl.getDefaultPathToRun();
+        runMode = bolt::cl::detail::selectRunMode( ctl, "stable_sort", first, vecSize, bolt::cl::cost_model::NLogN );
     }
     #if defined(BOLT_DEBUG_LOG)
     BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -402,7 +403,7 @@ void stablesort_pick_iterator( control &ctl,
 
     if( runMode == bolt::cl::control::Automatic )
     {
-        runMode = ctl.getDefaultPathToRun();
+        runMode = bolt::cl::detail::selectRunMode( ctl, "stable_sort", first, vecSize, bolt::cl::cost_model::NLogN );
     }
     #if defined(BOLT_DEBUG_LOG)
     BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
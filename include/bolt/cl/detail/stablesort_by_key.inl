@@ -26,6 +26,7 @@
 
 #define BOLT_CL_STABLESORT_BY_KEY_CPU_THRESHOLD 256
 #include "bolt/cl/sort_by_key.h"
+#include "bolt/cl/cost_model.h"
 
 namespace bolt {
 namespace cl {
@@ -150,11 +151,11 @@ namespace detail
         typedef std_stable_sort<keyType, valType> KeyValuePair;
         typedef std_stable_sort_comp<keyType, valType, StrictWeakOrdering> KeyValuePairFunctor;
 
-        int vecSize = static_cast<int>( std::distance( keys_first, keys_last ) );
+        size_t vecSize = static_cast< size_t >( std::distance( keys_first, keys_last ) );
         std::vector<KeyValuePair> KeyValuePairVector(vecSize);
         KeyValuePairFunctor functor(comp);
         //Zip the key and values iterators into a std_stable_sort vector.
-        for (int i=0; i< vecSize; i++)
+        for (size_t i=0; i< vecSize; i++)
         {
             KeyValuePairVector[i].key   = *(keys_first + i);
             KeyValuePairVector[i].value = *(values_first + i);
@@ -162,7 +163,7 @@ namespace detail
         //Sort the std_stable_sort vector using std::stable_sort
         std::stable_sort(KeyValuePairVector.begin(), KeyValuePairVector.end(), functor);
         //Extract the keys and values from the KeyValuePair and fill the respective iterators.
-        for (int i=0; i< vecSize; i++)
+        for (size_t i=0; i< vecSize; i++)
         {
             *(keys_first + i)   = KeyValuePairVector[i].key;
             *(values_first + i) = KeyValuePairVector[i].value;
@@ -465,7 +466,7 @@ namespace detail
         typedef typename std::iterator_traits< RandomAccessIterator1 >::value_type keyType;
         typedef typename std::iterator_traits< RandomAccessIterator2 >::value_type valType;
 
-        int vecSize = static_cast<int>( std::distance( keys_first, keys_last ) );
+        size_t vecSize = static_cast< size_t >( std::distance( keys_first, keys_last ) );
         if( vecSize < 2 )
             return;
 
@@ -475,7 +476,8 @@ namespace detail
 
         if( runMode == bolt::cl::control::Automatic )
         {
-            runMode = ctl.getDefaultPathToRun( );
+            runMode = bolt::cl::detail::selectRunMode( ctl, "stable_sort_by_key", keys_first,
+                vecSize, bolt::cl::cost_model::NLogN );
 
         }
         #if defined(BOLT_DEBUG_LOG)
@@ -530,7 +532,7 @@ namespace detail
     {
         typedef typename std::iterator_traits< DVRandomAccessIterator1 >::value_type keyType;
         typedef typename std::iterator_traits< DVRandomAccessIterator2 >::value_type valueType;
-        int vecSize = static_cast<int>( std::distance( keys_first, keys_last ) );
+        size_t vecSize = static_cast< size_t >( std::distance( keys_first, keys_last ) );
         if( vecSize < 2 )
             return;
 
@@ -538,7 +540,8 @@ namespace detail
 
         if( runMode == bolt::cl::control::Automatic )
         {
-            runMode = ctl.getDefaultPathToRun( );
+            runMode = bolt::cl::detail::selectRunMode( ctl, "stable_sort_by_key", keys_first,
+                vecSize, bolt::cl::cost_model::NLogN );
         }
         #if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
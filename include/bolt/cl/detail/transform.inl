@@ -33,7 +33,8 @@
 #include "bolt/cl/iterator/iterator_traits.h"
 #include "bolt/cl/iterator/transform_iterator.h"
 #include "bolt/cl/iterator/permutation_iterator.h"
-#include "bolt/cl/iterator/addressof.h"
+#include "bolt/cl/iterator/mapped_range.h"
+#include "bolt/cl/cost_model.h"
 
 namespace bolt {
 namespace cl {
@@ -51,43 +52,20 @@ namespace serial{
     binary_transform( ::bolt::cl::control &ctl, const InputIterator1& first1, const InputIterator1& last1,
                       const InputIterator2& first2, const OutputIterator& result, const BinaryFunction& f)
     {
-            typename std::iterator_traits<InputIterator1>::difference_type sz = (last1 - first1);
+            size_t sz = static_cast< size_t >(last1 - first1);
             if (sz == 0)
                 return;
-            typedef typename std::iterator_traits<InputIterator1>::value_type iType1;
-            typedef typename std::iterator_traits<InputIterator2>::value_type iType2;
-            typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-            /*Get The associated OpenCL buffer for each of the iterators*/
-            ::cl::Buffer first1Buffer = first1.base().getContainer( ).getBuffer( );
-            ::cl::Buffer first2Buffer = first2.base().getContainer( ).getBuffer( );
-            ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-            /*Get The size of each OpenCL buffer*/
-            size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-            size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
-            size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-            
-            cl_int map_err;
-            iType1 *first1Ptr = (iType1*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                             first1_sz, NULL, NULL, &map_err);
-            iType2 *first2Ptr = (iType2*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                             first2_sz, NULL, NULL, &map_err);
-            oType *resultPtr  = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                             result_sz, NULL, NULL, &map_err);
-            auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-                                                           ctl, first1, first1Ptr);
-            auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-                                                           ctl, first2, first2Ptr);
-            auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                           ctl, result, resultPtr);
-            for(int index=0; index < (int)(sz); index++)
+            mapped_range< InputIterator1 > input1( ctl, first1, static_cast< size_t >( sz ), CL_MAP_READ );
+            mapped_range< InputIterator2 > input2( ctl, first2, static_cast< size_t >( sz ), CL_MAP_READ );
+            mapped_range< OutputIterator > output( ctl, result, static_cast< size_t >( sz ),
+                                                   overwrite_flags( result, first1, first2 ) );
+            auto mapped_first1_itr = input1.begin( );
+            auto mapped_first2_itr = input2.begin( );
+            auto mapped_result_itr = output.begin( );
+            for(size_t index=0; index < sz; index++)
             {
                 *(mapped_result_itr + index) = f( *(mapped_first1_itr+index), *(mapped_first2_itr+index) );
             }
-            ::cl::Event unmap_event[3];
-            ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-            ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-            ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[2] );
-            unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait();
             return;
     }
     
@@ -103,7 +81,7 @@ namespace serial{
         size_t sz = (last1 - first1);
         if (sz == 0)
             return;
-        for(int index=0; index < (int)(sz); index++)
+        for(size_t index=0; index < sz; index++)
         {
             *(result + index) = f( *(first1+index), *(first2+index) );
         }
@@ -122,32 +100,14 @@ namespace serial{
         if (sz == 0)
             return;
 
-        typedef typename std::iterator_traits<InputIterator>::value_type iType;
-        typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-        /*Get The associated OpenCL buffer for each of the iterators*/
-        ::cl::Buffer firstBuffer  = first.base().getContainer( ).getBuffer( );
-        ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-        /*Get The size of each OpenCL buffer*/
-        size_t first_sz  = firstBuffer.getInfo<CL_MEM_SIZE>();
-        size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-
-        cl_int map_err;
-        iType *firstPtr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(firstBuffer, true, CL_MAP_READ, 0, 
-                                                                            first_sz, NULL, NULL, &map_err);
-        oType *resultPtr = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                            result_sz, NULL, NULL, &map_err);
-        auto mapped_first_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-                                                        ctl, first, firstPtr);
-        auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                        ctl, result, resultPtr);
-        for(int index=0; index < (int)(sz); index++)
+        mapped_range< InputIterator > input( ctl, first, sz, CL_MAP_READ );
+        mapped_range< OutputIterator > output( ctl, result, sz, overwrite_flags( result, first ) );
+        auto mapped_first_itr = input.begin( );
+        auto mapped_result_itr = output.begin( );
+        for(size_t index=0; index < sz; index++)
         {
             *(mapped_result_itr + index) = f( *(mapped_first_itr+index) );
         }
-        ::cl::Event unmap_event[2];
-        ctl.getCommandQueue().enqueueUnmapMemObject(firstBuffer, firstPtr, NULL, &unmap_event[0] );
-        ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[1] );
-        unmap_event[0].wait(); unmap_event[1].wait(); 
         return ;
 
     }
@@ -163,7 +123,7 @@ namespace serial{
         size_t sz = (last - first);
         if (sz == 0)
             return;
-        for(int index=0; index < (int)(sz); index++)
+        for(size_t index=0; index < sz; index++)
         {
             *(result + index) = f( *(first+index) );
         }
@@ -186,40 +146,15 @@ namespace btbb{
         typename std::iterator_traits<InputIterator1>::difference_type sz = (last1 - first1);
         if (sz == 0)
             return;
-        typedef typename std::iterator_traits<InputIterator1>::value_type iType1;
-        typedef typename std::iterator_traits<InputIterator2>::value_type iType2;
-        typedef typename std::iterator_traits<OutputIterator>::value_type oType;
+        mapped_range< InputIterator1 > input1( ctl, first1, static_cast< size_t >( sz ), CL_MAP_READ );
+        mapped_range< InputIterator2 > input2( ctl, first2, static_cast< size_t >( sz ), CL_MAP_READ );
+        mapped_range< OutputIterator > output( ctl, result, static_cast< size_t >( sz ),
+                                               overwrite_flags( result, first1, first2 ) );
+        auto mapped_first1_itr = input1.begin( );
+        auto mapped_first2_itr = input2.begin( );
+        auto mapped_result_itr = output.begin( );
+        bolt::btbb::transform(mapped_first1_itr, mapped_first1_itr+sz, mapped_first2_itr, mapped_result_itr, f);
 
-        /*Get The associated OpenCL buffer for each of the iterators*/
-        ::cl::Buffer first1Buffer = first1.base().getContainer( ).getBuffer( );
-        ::cl::Buffer first2Buffer = first2.base().getContainer( ).getBuffer( );
-        ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-        /*Get The size of each OpenCL buffer*/
-        size_t first1_sz = first1Buffer.getInfo<CL_MEM_SIZE>();
-        size_t first2_sz = first2Buffer.getInfo<CL_MEM_SIZE>();
-        size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-
-        //typename bolt::cl::device_vector< iType >::pointer firstPtr = first.base().getContainer( ).data( ); 
-        cl_int map_err;
-        iType1 *first1Ptr = (iType1*)ctl.getCommandQueue().enqueueMapBuffer(first1Buffer, true, CL_MAP_READ, 0, 
-                                                                            first1_sz, NULL, NULL, &map_err);
-        iType2 *first2Ptr = (iType2*)ctl.getCommandQueue().enqueueMapBuffer(first2Buffer, true, CL_MAP_READ, 0, 
-                                                                            first2_sz, NULL, NULL, &map_err);
-        oType *resultPtr  = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                            result_sz, NULL, NULL, &map_err);
-        auto mapped_first1_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator1>::iterator_category(), 
-                                                        ctl, first1, first1Ptr);
-        auto mapped_first2_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator2>::iterator_category(), 
-                                                        ctl, first2, first2Ptr);
-        auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                        ctl, result, resultPtr);
-        bolt::btbb::transform(mapped_first1_itr, mapped_first1_itr+(int)sz, mapped_first2_itr, mapped_result_itr, f);
-
-        ::cl::Event unmap_event[3];
-        ctl.getCommandQueue().enqueueUnmapMemObject(first1Buffer, first1Ptr, NULL, &unmap_event[0] );
-        ctl.getCommandQueue().enqueueUnmapMemObject(first2Buffer, first2Ptr, NULL, &unmap_event[1] );
-        ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[2] );
-        unmap_event[0].wait(); unmap_event[1].wait(); unmap_event[2].wait();
         return;
     }
     
@@ -250,31 +185,12 @@ namespace btbb{
         if (sz == 0)
             return;
 
-        typedef typename std::iterator_traits<InputIterator>::value_type iType;
-        typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-        /*Get The associated OpenCL buffer for each of the iterators*/
-        ::cl::Buffer firstBuffer  = first.base().getContainer( ).getBuffer( );
-        ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-        /*Get The size of each OpenCL buffer*/
-        size_t first_sz  = firstBuffer.getInfo<CL_MEM_SIZE>();
-        size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-
-        //typename bolt::cl::device_vector< iType >::pointer firstPtr = first.base().getContainer( ).data( ); 
-        cl_int map_err;
-        iType *firstPtr  = (iType*)ctl.getCommandQueue().enqueueMapBuffer(firstBuffer, true, CL_MAP_READ, 0, 
-                                                                            first_sz, NULL, NULL, &map_err);
-        oType *resultPtr = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                            result_sz, NULL, NULL, &map_err);
-        auto mapped_first_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-                                                        ctl, first, firstPtr);
-        auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                        ctl, result, resultPtr);
-        bolt::btbb::transform(mapped_first_itr, mapped_first_itr + (int)sz, mapped_result_itr, f);
-
-        ::cl::Event unmap_event[2];
-        ctl.getCommandQueue().enqueueUnmapMemObject(firstBuffer, firstPtr, NULL, &unmap_event[0] );
-        ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[1] );
-        unmap_event[0].wait(); unmap_event[1].wait(); 
+        mapped_range< InputIterator > input( ctl, first, sz, CL_MAP_READ );
+        mapped_range< OutputIterator > output( ctl, result, sz, overwrite_flags( result, first ) );
+        auto mapped_first_itr = input.begin( );
+        auto mapped_result_itr = output.begin( );
+        bolt::btbb::transform(mapped_first_itr, mapped_first_itr + sz, mapped_result_itr, f);
+
         
         return;
     }
@@ -724,7 +640,7 @@ namespace cl{
             &transformEvent );
         V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for transform() kernel" );
 
-        ::bolt::cl::wait(ctl, transformEvent);
+        ::bolt::cl::wait(ctl, transformEvent, "binary_transform");
 
 #if TRANSFORM_ENABLE_PROFILING
         if( 0 )
@@ -754,7 +670,7 @@ namespace cl{
                       const InputIterator2& first2, const OutputIterator& result, const BinaryFunction& f, 
                       const std::string& user_code )
     {
-        int sz = static_cast<int>(last1 - first1);
+        size_t sz = static_cast< size_t >(last1 - first1);
         if (sz == 0)
             return;
         typedef typename std::iterator_traits<InputIterator1>::value_type  iType1;
@@ -917,7 +833,7 @@ namespace cl{
             &transformEvent );
         V_OPENCL( l_Error, "enqueueNDRangeKernel() failed for transform() kernel" );
 
-        ::bolt::cl::wait(ctl, transformEvent);
+        ::bolt::cl::wait(ctl, transformEvent, "transform");
    
 #if TRANSFORM_ENABLE_PROFILING
         if( 0 )
@@ -949,7 +865,7 @@ namespace cl{
     const OutputIterator& result, const UnaryFunction& f, const std::string& user_code )
     {
         //size_t sz = bolt::cl::distance(first, last);
-        int sz = static_cast<int>(last - first);
+        size_t sz = static_cast< size_t >(last - first);
         if (sz == 0)
             return;
         typedef typename std::iterator_traits<InputIterator>::value_type  iType;
@@ -996,7 +912,7 @@ namespace cl{
         bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
         if(runMode == bolt::cl::control::Automatic)
         {
-           runMode = ctl.getDefaultPathToRun();
+           runMode = bolt::cl::detail::selectRunMode( ctl, "transform", first1, static_cast< size_t >( sz ) );
         }
         #if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -1084,7 +1000,7 @@ namespace cl{
         bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
         if(runMode == bolt::cl::control::Automatic)
         {
-           runMode = ctl.getDefaultPathToRun();
+           runMode = bolt::cl::detail::selectRunMode( ctl, "transform", first, static_cast< size_t >( sz ) );
         }
         #if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
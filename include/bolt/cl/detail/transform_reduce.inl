@@ -25,16 +25,18 @@
 #ifdef ENABLE_TBB
 //TBB Includes
 #include "bolt/btbb/transform_reduce.h"
+#include "bolt/btbb/simd_reduce.h"
 #endif
 
 #include "bolt/cl/bolt.h"
 #include "bolt/cl/distance.h"
 #include "bolt/cl/iterator/iterator_traits.h"
 #include "bolt/cl/iterator/transform_iterator.h"
-#include "bolt/cl/iterator/addressof.h"
+#include "bolt/cl/iterator/mapped_range.h"
 #include "bolt/cl/device_vector.h"
 #include "bolt/cl/transform.h"
 #include "bolt/cl/reduce.h"
+#include "bolt/cl/cost_model.h"
 
 namespace bolt {
 namespace cl {
@@ -58,30 +60,16 @@ namespace serial{
 
 		          size_t n = (last - first);
 
-                  typedef typename std::iterator_traits< InputIterator >::value_type iType;
-		          
-	              /*Get The associated OpenCL buffer for each of the iterators*/
-                  ::cl::Buffer inputBuffer = first.base().getContainer( ).getBuffer( );
-                  /*Get The size of each OpenCL buffer*/
-                  size_t input_sz = inputBuffer.getInfo<CL_MEM_SIZE>();
-	              
-                  cl_int map_err;
-                  iType *inputPtr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(inputBuffer, true, CL_MAP_READ, 0, 
-                                                                                      input_sz, NULL, NULL, &map_err);
-                  auto mapped_ip_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>
-					                                            ::iterator_category() ,ctl, first, inputPtr); 
+                  mapped_range< InputIterator > input( ctl, first, n, CL_MAP_READ );
+                  auto mapped_ip_itr = input.begin( );
 				  //Create a temporary array to store the transform result;
 				  std::vector<oType> output_vector(n);
 
 				  std::transform(mapped_ip_itr, mapped_ip_itr + n, output_vector.begin(),transform_op);
 	              oType output = std::accumulate(output_vector.begin(), output_vector.end(), init, reduce_op);
-		          
-	              ::cl::Event unmap_event[1];
-                  ctl.getCommandQueue().enqueueUnmapMemObject(inputBuffer, inputPtr, NULL, &unmap_event[0] );
-                  unmap_event[0].wait();  
-		          	
-		          	
+
 		          return output;
+
     }
 
 
@@ -110,7 +98,46 @@ namespace serial{
 #ifdef ENABLE_TBB
 namespace btbb{
 
-	
+    /*! \brief Selects the vectorized sum, or sum of squares, of btbb for the built-in identity and square followed by
+    *   the built-in plus; -1 keeps the transform_reduce of TBB.  The selection of reduce decides the rest.
+    */
+    template< typename InputIterator, typename oType, typename UnaryFunction, typename BinaryFunction >
+    struct simd_transform_reduce_op: std::integral_constant< int, -1 > {};
+
+    template< typename InputIterator, typename oType >
+    struct simd_transform_reduce_op< InputIterator, oType, bolt::cl::identity< oType >, bolt::cl::plus< oType > >:
+        simd_reduce_select< InputIterator, oType, bolt::btbb::simd::sum > {};
+
+    template< typename InputIterator, typename oType >
+    struct simd_transform_reduce_op< InputIterator, oType, bolt::cl::square< oType >, bolt::cl::plus< oType > >:
+        simd_reduce_select< InputIterator, oType, bolt::btbb::simd::sum_of_squares > {};
+
+    template<typename InputIterator, typename UnaryFunction, typename oType, typename BinaryFunction>
+    oType btbb_transform_reduce( const InputIterator& first, const InputIterator& last,
+        const UnaryFunction& transform_op, const oType& init, const BinaryFunction& reduce_op,
+        std::integral_constant< int, -1 > )
+    {
+        return bolt::btbb::transform_reduce( first, last, transform_op, init, reduce_op );
+    }
+
+    template<typename InputIterator, typename UnaryFunction, typename oType, typename BinaryFunction, int Op>
+    oType btbb_transform_reduce( const InputIterator& first, const InputIterator& last,
+        const UnaryFunction&, const oType& init, const BinaryFunction&, std::integral_constant< int, Op > )
+    {
+        if( first == last )
+            return init;
+        const oType* p = &*first;
+        return bolt::btbb::simd_reduce< static_cast< bolt::btbb::simd::op >( Op ) >( p, p + ( last - first ), init );
+    }
+
+    template<typename InputIterator, typename UnaryFunction, typename oType, typename BinaryFunction>
+    oType btbb_transform_reduce( const InputIterator& first, const InputIterator& last,
+        const UnaryFunction& transform_op, const oType& init, const BinaryFunction& reduce_op )
+    {
+        return btbb_transform_reduce( first, last, transform_op, init, reduce_op, std::integral_constant< int,
+            simd_transform_reduce_op< InputIterator, oType, UnaryFunction, BinaryFunction >::value >( ) );
+    }
+
 	template<typename InputIterator, typename UnaryFunction, typename oType, typename BinaryFunction>
     oType transform_reduce(control& ctl,
             const InputIterator& first,
@@ -125,29 +152,15 @@ namespace btbb{
 
 		          size_t n = (last - first);
 
-                  typedef typename std::iterator_traits< InputIterator >::value_type iType;
-		          
-	              /*Get The associated OpenCL buffer for each of the iterators*/
-                  ::cl::Buffer inputBuffer = first.base().getContainer( ).getBuffer( );
-                  /*Get The size of each OpenCL buffer*/
-                  size_t input_sz = inputBuffer.getInfo<CL_MEM_SIZE>();
-	              
-                  cl_int map_err;
-                  iType *inputPtr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(inputBuffer, true, CL_MAP_READ, 0, 
-                                                                                      input_sz, NULL, NULL, &map_err);
-                  auto mapped_ip_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>
-					                                          ::iterator_category(), ctl, first, inputPtr); 
+                  mapped_range< InputIterator > input( ctl, first, n, CL_MAP_READ );
+                  auto mapped_ip_itr = input.begin( );
 				  
-	              oType output = bolt::btbb::transform_reduce(mapped_ip_itr, mapped_ip_itr + n, transform_op,
+	              oType output = btbb_transform_reduce(mapped_ip_itr, mapped_ip_itr + n, transform_op,
 					  init, reduce_op);
-		          
-	              ::cl::Event unmap_event[1];
-                  ctl.getCommandQueue().enqueueUnmapMemObject(inputBuffer, inputPtr, NULL, &unmap_event[0] );
-                  unmap_event[0].wait();  
-		          	
-		          	
+
 		          return output;
 
+
     }
 
 
@@ -162,7 +175,7 @@ namespace btbb{
            const std::string& user_code,
 		   std::random_access_iterator_tag)
     {
-		          return bolt::btbb::transform_reduce(first,last,transform_op,init,reduce_op);
+		          return btbb_transform_reduce(first,last,transform_op,init,reduce_op);
     }
 
 }//end of namespace btbb 
@@ -333,7 +346,7 @@ namespace cl{
         bolt::cl::minimum< size_t >  min_size_t;
         size_t numTailReduce = min_size_t( ceilNumWG, numWG );
 
-        bolt::cl::wait(ctl, l_mapEvent);
+        bolt::cl::wait(ctl, l_mapEvent, "transform_reduce");
 
         oType acc = static_cast< oType >( init );
         for(unsigned int i = 0; i < numTailReduce; ++i)
@@ -363,7 +376,7 @@ namespace cl{
         const std::string& user_code,
 		std::random_access_iterator_tag)
     {
-        int sz = static_cast<int>(last - first);
+        size_t sz = static_cast< size_t >(last - first);
         if (sz == 0)
             return init;
         typedef typename std::iterator_traits<InputIterator>::value_type  iType;
@@ -424,7 +437,7 @@ namespace cl{
                 bolt::cl::control::e_RunMode runMode = ctl.getForceRunMode();  // could be dynamic choice some day.
                 if(runMode == bolt::cl::control::Automatic)
                 {
-                    runMode = ctl.getDefaultPathToRun();
+                    runMode = bolt::cl::detail::selectRunMode( ctl, "transform_reduce", first, szElements );
                 }
 			    #if defined(BOLT_DEBUG_LOG)
                 BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
@@ -40,12 +40,12 @@
 #include "bolt/cl/distance.h"
 #include "bolt/cl/iterator/iterator_traits.h"
 #include "bolt/cl/iterator/transform_iterator.h"
-#include "bolt/cl/iterator/addressof.h"
+#include "bolt/cl/iterator/mapped_range.h"
+#include "bolt/cl/cost_model.h"
 
 
 #ifdef ENABLE_TBB
-#include "bolt/btbb/transform.h"
-#include "bolt/btbb/scan.h"
+#include "bolt/btbb/transform_scan.h"
 #endif
 namespace bolt
 {
@@ -90,24 +90,12 @@ namespace serial{
         if (sz == 0)
             return;
 
-        typedef typename std::iterator_traits<InputIterator>::value_type iType;
         typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-        /*Get The associated OpenCL buffer for each of the iterators*/
-        ::cl::Buffer firstBuffer  = first.base().getContainer( ).getBuffer( );
-        ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-        /*Get The size of each OpenCL buffer*/
-        size_t first_sz  = firstBuffer.getInfo<CL_MEM_SIZE>();
-        size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-
-        cl_int map_err;
-        iType *firstPtr = (iType*)ctl.getCommandQueue().enqueueMapBuffer(firstBuffer, true, CL_MAP_READ, 0, 
-                                                                            first_sz, NULL, NULL, &map_err);
-        oType *resultPtr = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                            result_sz, NULL, NULL, &map_err);
-        auto mapped_fst_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::iterator_category(), 
-                                                        ctl, first, firstPtr);
-        auto mapped_res_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::iterator_category(), 
-                                                        ctl, result, resultPtr);
+
+        mapped_range< InputIterator > input( ctl, first, sz, CL_MAP_READ );
+        mapped_range< OutputIterator > output( ctl, result, sz, overwrite_flags( result, first ) );
+        auto mapped_fst_itr = input.begin( );
+        auto mapped_res_itr = output.begin( );
 
 
 		oType  sum, temp;
@@ -125,7 +113,7 @@ namespace serial{
 		   sum = binary_op( *mapped_res_itr, temp);
         }
 
-        for ( unsigned int index= 1; index<sz; ++index)
+        for ( size_t index= 1; index<sz; ++index)
         {
           oType currentValue =  static_cast<oType>( unary_op( *(mapped_fst_itr+index) ) ); 
           if (inclusive)
@@ -141,11 +129,6 @@ namespace serial{
           }
         }
 
-
-        ::cl::Event unmap_event[2];
-        ctl.getCommandQueue().enqueueUnmapMemObject(firstBuffer, firstPtr, NULL, &unmap_event[0] );
-        ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[1] );
-        unmap_event[0].wait(); unmap_event[1].wait(); 
         return ;
     }
 
@@ -193,7 +176,7 @@ namespace serial{
           sum = binary_op( *result, temp);  
         }
 
-        for ( unsigned int index= 1; index<sz; index++)
+        for ( size_t index= 1; index<sz; index++)
         {
           oType currentValue =  static_cast<oType>(unary_op( *(first + index) ) ); // convertible
           if (inclusive)
@@ -245,38 +228,19 @@ namespace btbb{
         if (sz == 0)
             return;
 
-        typedef typename std::iterator_traits<InputIterator>::value_type iType;
-        typedef typename std::iterator_traits<OutputIterator>::value_type oType;
-        /*Get The associated OpenCL buffer for each of the iterators*/
-        ::cl::Buffer firstBuffer  = first.base().getContainer( ).getBuffer( );
-        ::cl::Buffer resultBuffer = result.getContainer( ).getBuffer( );
-        /*Get The size of each OpenCL buffer*/
-        size_t first_sz  = firstBuffer.getInfo<CL_MEM_SIZE>();
-        size_t result_sz = resultBuffer.getInfo<CL_MEM_SIZE>();
-
-        cl_int map_err;
-        iType *firstPtr  = (iType*)ctl.getCommandQueue().enqueueMapBuffer(firstBuffer, true, CL_MAP_READ, 0, 
-                                                                            first_sz, NULL, NULL, &map_err);
-        oType *resultPtr = (oType*)ctl.getCommandQueue().enqueueMapBuffer(resultBuffer, true, CL_MAP_WRITE, 0, 
-                                                                            result_sz, NULL, NULL, &map_err);
-        auto mapped_first_itr = create_mapped_iterator(typename std::iterator_traits<InputIterator>::
-			                                            iterator_category(), 
-                                                        ctl, first, firstPtr);
-        auto mapped_result_itr = create_mapped_iterator(typename std::iterator_traits<OutputIterator>::
-			                                            iterator_category(), 
-                                                        ctl, result, resultPtr);
-        bolt::btbb::transform(mapped_first_itr, mapped_first_itr + (int)sz, mapped_result_itr, unary_op);
-
+        mapped_range< InputIterator > input( ctl, first, sz, CL_MAP_READ );
+        mapped_range< OutputIterator > output( ctl, result, sz, overwrite_flags( result, first ) );
+        auto mapped_first_itr = input.begin( );
+        auto mapped_result_itr = output.begin( );
 		if(inclusive)
-			bolt::btbb::inclusive_scan( mapped_result_itr, mapped_result_itr  + (int)sz,  mapped_result_itr, binary_op);
+			bolt::btbb::transform_inclusive_scan( mapped_first_itr, mapped_first_itr + sz, mapped_result_itr,
+                                                  unary_op, binary_op );
 		else
-			bolt::btbb::exclusive_scan( mapped_result_itr,  mapped_result_itr  + (int)sz , mapped_result_itr, init, binary_op);            
+			bolt::btbb::transform_exclusive_scan( mapped_first_itr, mapped_first_itr + sz, mapped_result_itr,
+                                                  unary_op, init, binary_op );
 
-        ::cl::Event unmap_event[2];
-        ctl.getCommandQueue().enqueueUnmapMemObject(firstBuffer, firstPtr, NULL, &unmap_event[0] );
-        ctl.getCommandQueue().enqueueUnmapMemObject(resultBuffer, resultPtr, NULL, &unmap_event[1] );
-        unmap_event[0].wait(); unmap_event[1].wait(); 
         return;
+
     }
 
 
@@ -302,15 +266,10 @@ namespace btbb{
     const bool& inclusive,
     const BinaryFunction& binary_op)
     {
-        // TODO - Add tbb host vector code.
-        bolt::btbb::transform(first, last, result, unary_op);
-        int sz = static_cast<int>( std::distance (first, last));
-        if (sz == 0)
-            return;
 		if(inclusive)
-			bolt::btbb::inclusive_scan( result, result  + sz,  result, binary_op);
+			bolt::btbb::transform_inclusive_scan( first, last, result, unary_op, binary_op );
 		else
-			bolt::btbb::exclusive_scan( result,  result  + sz , result, init, binary_op);
+			bolt::btbb::transform_exclusive_scan( first, last, result, unary_op, init, binary_op );
         return;
     }
 
@@ -751,7 +710,7 @@ aProfiler.setArchitecture(strDeviceName);
         typedef typename std::iterator_traits< OutputIterator >::value_type oType;
 	    
 	    
-        int numElements = static_cast< int >( std::distance( first, last ) );
+        size_t numElements = static_cast< size_t >( std::distance( first, last ) );
         if( numElements == 0 )
             return;
 	    
@@ -810,7 +769,7 @@ aProfiler.setArchitecture(strDeviceName);
         typedef typename std::iterator_traits< OutputIterator >::value_type oType;
 
 
-        unsigned int numElements = static_cast< unsigned int >( std::distance( first, last ) );
+        size_t numElements = static_cast< size_t >( std::distance( first, last ) );
         if( numElements == 0 )
             return result;
 
@@ -818,7 +777,7 @@ aProfiler.setArchitecture(strDeviceName);
 
         if( runMode == bolt::cl::control::Automatic )
         {
-            runMode = ctl.getDefaultPathToRun();
+            runMode = bolt::cl::detail::selectRunMode( ctl, "transform_scan", first, numElements );
         }
         #if defined(BOLT_DEBUG_LOG)
         BOLTLOG::CaptureLog *dblog = BOLTLOG::CaptureLog::getInstance();
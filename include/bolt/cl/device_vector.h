@@ -26,11 +26,14 @@
 #include <type_traits>
 #include <numeric>
 #include "bolt/cl/bolt.h"
+#include "bolt/cl/host_allocator.h"
 #include "bolt/cl/iterator/iterator_traits.h"
 #include <iostream>
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/iterator/reverse_iterator.hpp>
 #include <boost/shared_array.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
 
 /*! \file bolt/cl/device_vector.h
  *  \brief Namespace that captures OpenCL related data types and functions
@@ -60,6 +63,13 @@ namespace cl
         {   // identifying tag for random-access iterators
         };
 
+        /*! \brief How a device_vector host_view maps its elements into host memory
+        *   \ingroup CL-Device
+        *   \details \p MapWriteInvalidate does not copy the current contents of the range to the host; every
+        *   element of the view must be written before it is read.
+        */
+        enum e_MapMode { MapRead, MapWrite, MapReadWrite, MapWriteInvalidate };
+
         /*! \brief This defines the OpenCL version of a device_vector
         *   \ingroup CL-Device
         *   \details A device_vector is an abstract data type that provides random access to a flat, sequential region of memory that is performant
@@ -113,7 +123,8 @@ namespace cl
             *   memory, which may be in a partitioned memory space.  Access to a reference of the container results in
             *   a mapping and unmapping operation of device memory.
             *   \note The container element reference is implemented as a proxy object.
-            *   \warning Use of this class can be slow: each operation on it results in a map/unmap sequence.
+            *   \warning Use of this class can be slow: each operation on it results in a map/unmap sequence, unless
+            *   a host_view of the container maps the element; it is then read or written through the view.
             */
             template< typename Container >
             class reference_base
@@ -127,6 +138,10 @@ namespace cl
                 //  Automatic type conversion operator to turn the reference object into a value_type
                 operator value_type( ) const
                 {
+                    value_type viewed;
+                    if( m_Container.readViewed( m_Index, viewed ) )
+                        return viewed;
+
                     cl_int l_Error = CL_SUCCESS;
                     naked_pointer result = reinterpret_cast< naked_pointer >( m_Container.m_commQueue.enqueueMapBuffer(
                     m_Container.m_devMemory, true, CL_MAP_READ, m_Index * sizeof( value_type ), sizeof( value_type ), NULL, NULL, &l_Error ) );
@@ -143,6 +158,9 @@ namespace cl
 
                 reference_base< Container >& operator=( const value_type& rhs )
                 {
+                    if( m_Container.writeViewed( m_Index, rhs ) )
+                        return *this;
+
                     cl_int l_Error = CL_SUCCESS;
                     naked_pointer result = reinterpret_cast< naked_pointer >( m_Container.m_commQueue.enqueueMapBuffer(
                     m_Container.m_devMemory, true, CL_MAP_WRITE_INVALIDATE_REGION, m_Index * sizeof( value_type ), sizeof( value_type ), NULL, NULL, &l_Error ) );
@@ -164,6 +182,10 @@ namespace cl
 
                     cl_int l_Error = CL_SUCCESS;
                     value_type value = static_cast<value_type>(rhs);
+
+                    if( m_Container.writeViewed( m_Index, value ) )
+                        return *this;
+
                     naked_pointer result = reinterpret_cast< naked_pointer >( m_Container.m_commQueue.enqueueMapBuffer(
                     m_Container.m_devMemory, true, CL_MAP_WRITE_INVALIDATE_REGION, m_Index * sizeof( value_type ), sizeof( value_type ), NULL, NULL, &l_Error ) );
                     V_OPENCL( l_Error, "device_vector failed map device memory to host memory for operator[]" );
@@ -205,6 +227,177 @@ namespace cl
             */
             typedef const value_type const_reference;
 
+        private:
+            //  A range of the buffer mapped by a host view; the views of a container are linked from m_Views
+            struct mapped_range
+            {
+                naked_pointer ptr;
+                size_type first;
+                size_type count;
+                cl_map_flags flags;
+                mapped_range* next;
+            };
+
+        public:
+            /*! \brief Base class of host_view and const_host_view; maps a range of the container into host memory
+            *   once, and unmaps it when it is destroyed.
+            *   \details While the view lives, references to the elements it maps read and write the mapped memory
+            *   instead of mapping every element on its own, whatever the map mode of the view; writing an element
+            *   that a read only view maps throws.  The container must not be resized, swapped or cleared while a
+            *   view of it is alive.
+            */
+            template< typename Container, typename Value >
+            class host_view_base
+            {
+            public:
+                typedef Value* iterator;
+                typedef const value_type* const_iterator;
+                typedef Value& reference;
+
+                ~host_view_base( )
+                {
+                    //  Destructors must not throw; a failed unmap has nothing left to clean up
+                    try
+                    {
+                        unmap( );
+                    }
+                    catch( ... )
+                    {
+                    }
+                }
+
+                Value* data( ) const
+                {
+                    return m_Range.ptr;
+                }
+
+                iterator begin( ) const
+                {
+                    return m_Range.ptr;
+                }
+
+                iterator end( ) const
+                {
+                    return m_Range.ptr + size( );
+                }
+
+                size_type size( ) const
+                {
+                    return m_Range.ptr ? m_Range.count : 0;
+                }
+
+                reference operator[]( size_type n ) const
+                {
+                    return m_Range.ptr[ n ];
+                }
+
+                /*! \brief Unmaps the range before the view is destroyed, and reports failures that the destructor
+                *   has to ignore; the view is empty afterwards
+                */
+                void unmap( )
+                {
+                    if( m_Range.ptr == NULL )
+                        return;
+
+                    {
+                        boost::lock_guard< boost::mutex > lock( m_Container.m_ViewsGuard );
+                        for( mapped_range** link = &m_Container.m_Views; *link != NULL; link = &( *link )->next )
+                        {
+                            if( *link == &m_Range )
+                            {
+                                *link = m_Range.next;
+                                break;
+                            }
+                        }
+                    }
+
+                    naked_pointer ptr = m_Range.ptr;
+                    m_Range.ptr = NULL;
+
+                    ::cl::Event unmapEvent;
+                    V_OPENCL( m_Queue.enqueueUnmapMemObject( m_Buffer, ptr, NULL, &unmapEvent ), "host_view failed to unmap host memory back to device memory" );
+                    V_OPENCL( unmapEvent.wait( ), "failed to wait for unmap event" );
+                }
+
+            protected:
+                host_view_base( Container& vec, size_type first, size_type count, cl_map_flags flags ):
+                    m_Container( vec ), m_Buffer( vec.m_devMemory ), m_Queue( vec.m_commQueue )
+                {
+                    if( first > vec.m_Size || count > vec.m_Size - first )
+                        throw ::cl::Error( CL_INVALID_VALUE, "host_view range exceeds the size of the device_vector" );
+
+                    m_Range.ptr = NULL;
+                    m_Range.first = first;
+                    m_Range.count = count;
+                    m_Range.flags = flags;
+                    m_Range.next = NULL;
+
+                    if( count == 0 )
+                        return;
+
+                    cl_int l_Error = CL_SUCCESS;
+                    m_Range.ptr = static_cast< naked_pointer >( m_Queue.enqueueMapBuffer( m_Buffer, true, flags,
+                        first * sizeof( value_type ), count * sizeof( value_type ), NULL, NULL, &l_Error ) );
+                    V_OPENCL( l_Error, "device_vector failed map device memory to host memory for host_view" );
+
+                    boost::lock_guard< boost::mutex > lock( vec.m_ViewsGuard );
+                    m_Range.next = vec.m_Views;
+                    vec.m_Views = &m_Range;
+                }
+
+            private:
+                host_view_base( const host_view_base& );
+                host_view_base& operator=( const host_view_base& );
+
+                Container& m_Container;
+                ::cl::Buffer m_Buffer;
+                ::cl::CommandQueue m_Queue;
+                mapped_range m_Range;
+            };
+
+            /*! \brief A writeable host view of a range of the container; see host_view_base.
+            *   \code
+            *   bolt::cl::device_vector< int > dv( 1024 );
+            *   {
+            *       bolt::cl::device_vector< int >::host_view view( dv, bolt::cl::MapWriteInvalidate );
+            *       std::iota( view.begin( ), view.end( ), 0 );
+            *   }   //  dv is unmapped here
+            *   \endcode
+            */
+            class host_view: public host_view_base< device_vector, value_type >
+            {
+                typedef host_view_base< device_vector, value_type > base_type;
+
+            public:
+                //! Maps the whole container
+                explicit host_view( device_vector& vec, e_MapMode mode = MapReadWrite ):
+                    base_type( vec, 0, vec.size( ), mapFlags( mode ) )
+                {}
+
+                //! Maps the \p count elements starting at index \p first
+                host_view( device_vector& vec, size_type first, size_type count, e_MapMode mode = MapReadWrite ):
+                    base_type( vec, first, count, mapFlags( mode ) )
+                {}
+            };
+
+            /*! \brief A read only host view of a range of the container; see host_view_base.
+            */
+            class const_host_view: public host_view_base< const device_vector, const value_type >
+            {
+                typedef host_view_base< const device_vector, const value_type > base_type;
+
+            public:
+                //! Maps the whole container
+                explicit const_host_view( const device_vector& vec ):
+                    base_type( vec, 0, vec.size( ), CL_MAP_READ )
+                {}
+
+                //! Maps the \p count elements starting at index \p first
+                const_host_view( const device_vector& vec, size_type first, size_type count ):
+                    base_type( vec, first, count, CL_MAP_READ )
+                {}
+            };
+
             //  Handy for the reference class to get at the wrapped ::cl objects
             //friend class reference;
 
@@ -529,7 +722,7 @@ namespace cl
             *   \todo Find a way to be able to unambiguously specify memory flags for this constructor, that is not
             *   confused with the size constructor below.
             */
-            device_vector( /* cl_mem_flags flags = CL_MEM_READ_WRITE,*/ const control& ctl = control::getDefault( ) ): m_Size( 0 ), m_commQueue( ctl.getCommandQueue( ) ), m_Flags( CL_MEM_READ_WRITE )
+            device_vector( /* cl_mem_flags flags = CL_MEM_READ_WRITE,*/ const control& ctl = control::getDefault( ) ): m_Size( 0 ), m_commQueue( ctl.getCommandQueue( ) ), m_Flags( CL_MEM_READ_WRITE ), m_Views( NULL )
             {
                 static_assert( !std::is_polymorphic< value_type >::value, "AMD C++ template extensions do not support the virtual keyword yet" );
                 m_devMemory = NULL;
@@ -545,7 +738,7 @@ namespace cl
             *   \warning If the size of the value is a power of two, the buffer will be filled serially as opposed to using the OpenCL fill API. Refer section 5.2.3 in 'The OpenCL 1.2 Specification' (Khronos)
             */
             device_vector( size_type newSize, const value_type& value = value_type( ), cl_mem_flags flags = CL_MEM_READ_WRITE,
-                bool init = true, const control& ctl = control::getDefault( ) ): m_Size( newSize ), m_commQueue( ctl.getCommandQueue( ) ), m_Flags( flags )
+                bool init = true, const control& ctl = control::getDefault( ) ): m_Size( newSize ), m_commQueue( ctl.getCommandQueue( ) ), m_Flags( flags ), m_Views( NULL )
             {
                 static_assert( !std::is_polymorphic< value_type >::value, "AMD C++ template extensions do not support the virtual keyword yet" );
 
@@ -591,7 +784,7 @@ namespace cl
                                                                                           &l_Error );
 
                               V_OPENCL( l_Error, "Error calling map on device_vector buffer. Fill device_vector" );
-                              bolt::cl::wait( ctl, fill_mapEvent );
+                              bolt::cl::wait( ctl, fill_mapEvent, "device_vector_fill" );
 
                               // Use serial fill_n to fill the device_vector with value
 #if defined(_WIN32)
@@ -638,6 +831,80 @@ namespace cl
                 }
             }
 
+            /*! \brief A constructor that creates a new device_vector in host memory of \p hostAllocator, with the specified
+            *   number of elements, all set to \p value.
+            *   \details The memory is wrapped with CL_MEM_USE_HOST_PTR, so the serial and multicore paths work on it in place,
+            *   and on a CPU device no map or unmap copies it.  The vector reallocates from \p hostAllocator when it grows.
+            *   \param newSize The number of elements of the new device_vector
+            *   \param value The value with which to initialize new elements.
+            *   \param hostAllocator The allocator of the host memory, such as host_allocator::pageAligned( ) or
+            *   host_allocator::hugePages( ).
+            *   \param ctl A Bolt control class for copy operations; a default is used if not supplied by the user.
+            */
+            device_vector( size_type newSize, const value_type& value, const boost::shared_ptr< host_allocator >& hostAllocator,
+                const control& ctl = control::getDefault( ) ): m_Size( 0 ), m_commQueue( ctl.getCommandQueue( ) ),
+                m_Flags( CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR ), m_Views( NULL ), m_HostAllocator( hostAllocator )
+            {
+                static_assert( !std::is_polymorphic< value_type >::value, "AMD C++ template extensions do not support the virtual keyword yet" );
+
+                if( !m_HostAllocator )
+                    throw ::cl::Error( CL_INVALID_VALUE, "device_vector requires a host_allocator" );
+
+                //  This method will set the m_Size member variable upon successful completion
+                if( newSize > 0 )
+                    resize( newSize, value );
+            }
+
+            /*! \brief A constructor that creates a new device_vector in host memory of \p hostAllocator, holding a copy of a
+            *   range specified by the user.
+            *   \param begin An iterator pointing at the beginning of the range.
+            *   \param end An iterator pointing at the end of the range.
+            *   \param hostAllocator The allocator of the host memory, such as host_allocator::pageAligned( ) or
+            *   host_allocator::hugePages( ).
+            *   \param ctl A Bolt control class for copy operations; a default is used if not supplied by the user.
+            *   \note Ignore the enable_if<> parameter; it prevents this constructor from being called with integral types.
+            */
+            template< typename InputIterator >
+            device_vector( const InputIterator begin, const InputIterator end, const boost::shared_ptr< host_allocator >& hostAllocator,
+                const control& ctl = control::getDefault( ),
+                typename std::enable_if< !std::is_integral< InputIterator >::value >::type* = 0 ): m_Size( 0 ),
+                m_commQueue( ctl.getCommandQueue( ) ), m_Flags( CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR ), m_Views( NULL ),
+                m_HostAllocator( hostAllocator )
+            {
+                static_assert( std::is_convertible< value_type, typename std::iterator_traits< InputIterator >::value_type >::value,
+                    "iterator value_type does not convert to device_vector value_type" );
+                static_assert( !std::is_polymorphic< value_type >::value, "AMD C++ template extensions do not support the virtual keyword yet" );
+
+                if( !m_HostAllocator )
+                    throw ::cl::Error( CL_INVALID_VALUE, "device_vector requires a host_allocator" );
+
+                size_type l_Size = static_cast< size_type >( std::distance( begin, end ) );
+                if( l_Size == 0 )
+                    return;
+
+                cl_int l_Error = CL_SUCCESS;
+                ::cl::Context l_Context = m_commQueue.getInfo< CL_QUEUE_CONTEXT >( &l_Error );
+                V_OPENCL( l_Error, "device_vector failed to query for the context of the ::cl::CommandQueue object" );
+
+                size_t byteSize = l_Size * sizeof( value_type );
+                m_devMemory = createBuffer( l_Context, byteSize );
+                m_Size = l_Size;
+
+                //  The map returns the memory of the allocator itself; nothing is copied but the range
+                naked_pointer pointer = static_cast< naked_pointer >( m_commQueue.enqueueMapBuffer(
+                    m_devMemory, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, byteSize, 0, 0, &l_Error ) );
+                V_OPENCL( l_Error, "enqueueMapBuffer failed in device_vector constructor" );
+#if (_WIN32)
+                std::copy( begin, end, stdext::checked_array_iterator< naked_pointer >( pointer, m_Size ) );
+#else
+                std::copy( begin, end, pointer );
+#endif
+                ::cl::Event unmapEvent;
+                l_Error = m_commQueue.enqueueUnmapMemObject( m_devMemory, pointer, 0, &unmapEvent );
+                V_OPENCL( l_Error, "enqueueUnmapMemObject failed in device_vector constructor" );
+                V_OPENCL( unmapEvent.wait( ), "device_vector failed to wait for the unmap event" );
+            }
+
             /*! \brief A constructor that creates a new device_vector using a range specified by the user.
             *   \param begin An iterator pointing at the beginning of the range.
             *   \param end An iterator pointing at the end of the range.
@@ -650,7 +917,7 @@ namespace cl
             device_vector( const InputIterator begin, size_type newSize, cl_mem_flags flags = CL_MEM_READ_WRITE|CL_MEM_USE_HOST_PTR,
                 bool init = true, const control& ctl = control::getDefault( ),
                 typename std::enable_if< !std::is_integral< InputIterator >::value >::type* = 0 ): m_Size( newSize ),
-                m_commQueue( ctl.getCommandQueue( ) ), m_Flags( flags )
+                m_commQueue( ctl.getCommandQueue( ) ), m_Flags( flags ), m_Views( NULL )
             {
                 static_assert( std::is_convertible< value_type, typename std::iterator_traits< InputIterator >::value_type >::value,
                     "iterator value_type does not convert to device_vector value_type" );
@@ -704,7 +971,7 @@ namespace cl
             */
             template< typename InputIterator >
             device_vector( const InputIterator begin, const InputIterator end, cl_mem_flags flags = CL_MEM_READ_WRITE|CL_MEM_USE_HOST_PTR, const control& ctl = control::getDefault( ),
-                typename std::enable_if< !std::is_integral< InputIterator >::value >::type* = 0 ): m_commQueue( ctl.getCommandQueue( ) ), m_Flags( flags )
+                typename std::enable_if< !std::is_integral< InputIterator >::value >::type* = 0 ): m_commQueue( ctl.getCommandQueue( ) ), m_Flags( flags ), m_Views( NULL )
             {
                 static_assert( std::is_convertible< value_type, typename std::iterator_traits< InputIterator >::value_type >::value,
                     "iterator value_type does not convert to device_vector value_type" );
@@ -754,7 +1021,7 @@ namespace cl
             *   \param rhs A pre-existing ::cl::Buffer supplied by the user.
             *   \param ctl A Bolt control class for copy operations; a default is used if not supplied by the user.
             */
-            device_vector( const ::cl::Buffer& rhs, const control& ctl = control::getDefault( ) ): m_devMemory( rhs ), m_commQueue( ctl.getCommandQueue( ) )
+            device_vector( const ::cl::Buffer& rhs, const control& ctl = control::getDefault( ) ): m_devMemory( rhs ), m_commQueue( ctl.getCommandQueue( ) ), m_Views( NULL )
             {
                 static_assert( !std::is_polymorphic< value_type >::value, "AMD C++ template extensions do not support the virtual keyword yet" );
 
@@ -766,14 +1033,16 @@ namespace cl
             };
 
             //  Copying methods
-            device_vector( const device_vector& rhs ): m_Flags( rhs.m_Flags ), m_Size( 0 ), m_commQueue( rhs.m_commQueue )
+            device_vector( const device_vector& rhs ): m_Flags( rhs.m_Flags ), m_Size( 0 ), m_commQueue( rhs.m_commQueue ), m_Views( NULL ),
+                m_HostAllocator( rhs.m_HostAllocator )
             {
-                //  This method will set the m_Size member variable upon successful completion
-                resize( rhs.m_Size );
-
-                if( m_Size == 0 )
+                if( rhs.m_Size == 0 )
                     return;
 
+                //  The new elements are all overwritten by the copy, so they are not initialized
+                reserve( rhs.m_Size );
+                m_Size = rhs.m_Size;
+
                 size_type l_srcSize = m_Size * sizeof( value_type );
                 ::cl::Event copyEvent;
 
@@ -783,17 +1052,30 @@ namespace cl
                 V_OPENCL( copyEvent.wait( ), "device_vector failed to wait for copy event" );
             }
 
+            /*! \brief A move constructor that takes over the buffer of \p rhs, which is left empty; nothing is copied.
+            *   \warning \p rhs must not have a live host_view.
+            */
+            device_vector( device_vector&& rhs ): m_devMemory( rhs.m_devMemory ), m_commQueue( rhs.m_commQueue ),
+                m_Size( rhs.m_Size ), m_Flags( rhs.m_Flags ), m_Views( NULL ), m_HostAllocator( rhs.m_HostAllocator )
+            {
+                rhs.clear( );
+            }
+
             device_vector& operator=( const device_vector& rhs )
             {
                 if( this == &rhs )
                     return *this;
 
+                //  The old elements are all overwritten, so a buffer that is too small is replaced without copying them
+                if( rhs.m_Size > capacity( ) || m_Flags != rhs.m_Flags || m_HostAllocator != rhs.m_HostAllocator )
+                    clear( );
+
                 m_Flags         = rhs.m_Flags;
                 m_commQueue     = rhs.m_commQueue;
-                m_Size        = capacity( );
+                m_HostAllocator = rhs.m_HostAllocator;
 
-                //  This method will set the m_Size member variable upon successful completion
-                resize( rhs.m_Size );
+                reserve( rhs.m_Size );
+                m_Size = rhs.m_Size;
 
                 if( m_Size == 0 )
                     return *this;
@@ -809,6 +1091,24 @@ namespace cl
                 return *this;
             }
 
+            /*! \brief A move assignment that takes over the buffer of \p rhs, which is left empty; nothing is copied.
+            *   \warning Neither device_vector may have a live host_view.
+            */
+            device_vector& operator=( device_vector&& rhs )
+            {
+                if( this == &rhs )
+                    return *this;
+
+                m_devMemory     = rhs.m_devMemory;
+                m_commQueue     = rhs.m_commQueue;
+                m_Size          = rhs.m_Size;
+                m_Flags         = rhs.m_Flags;
+                m_HostAllocator = rhs.m_HostAllocator;
+
+                rhs.clear( );
+                return *this;
+            }
+
             //  Member functions
 
             /*! \brief Change the number of elements in device_vector to reqSize.
@@ -817,7 +1117,8 @@ namespace cl
             *   size, the extra padding will be initialized with the value specified by the user.
             *   \param reqSize The requested size of the device_vector in elements.
             *   \param val All new elements are initialized with this new value.
-            *   \note capacity( ) may exceed n, but is not less than n.
+            *   \note capacity( ) may exceed n, but is not less than n.  The device_vector reallocates only when reqSize
+            *   exceeds capacity( ), and then at least doubles its capacity.
             *   \warning If the device_vector must reallocate, all previous iterators, references, and pointers are invalidated.
             *   \warning The ::cl::CommandQueue is not a STD reserve( ) parameter
             *   \warning If the size of the value is a power of two, the buffer will be filled serially as opposed to using the OpenCL fill API. Refer section 5.2.3 in 'The OpenCL 1.2 Specification' (Khronos)
@@ -825,166 +1126,23 @@ namespace cl
 
             void resize( size_type reqSize, const value_type& val = value_type( ) )
             {
-                if( (m_Flags & CL_MEM_USE_HOST_PTR) != 0 )
-                {
-                    throw ::cl::Error( CL_MEM_OBJECT_ALLOCATION_FAILURE ,
-                        "A device_vector can not resize() memory not under its direct control" );
-                }
-
-                size_type cap = capacity( );
-
-                if( reqSize == cap )
-                    return;
-
-                if( reqSize > max_size( ) )
-                    throw ::cl::Error( CL_MEM_OBJECT_ALLOCATION_FAILURE ,
-                    "The amount of memory requested exceeds what is available" );
-
-                cl_int l_Error = CL_SUCCESS;
-
-                ::cl::Context l_Context = m_commQueue.getInfo< CL_QUEUE_CONTEXT >( &l_Error );
-                V_OPENCL( l_Error, "device_vector failed to query for the context of the ::cl::Buffer object" );
-
-                size_type l_reqSize = reqSize * sizeof( value_type );
-                ::cl::Buffer l_tmpBuffer( l_Context, m_Flags, l_reqSize, NULL, &l_Error );
-
-                size_type l_srcSize = m_Size * sizeof( value_type );
-
-                if( l_srcSize > 0 )
+                if( reqSize > capacity( ) )
                 {
-                    //  If the new buffer size is greater than the old, the new elements must be initialized to the value specified on the
-                    //  function parameter
-                    if( l_reqSize > l_srcSize )
+                    if( (m_Flags & CL_MEM_USE_HOST_PTR) != 0 && !m_HostAllocator )
                     {
-                        std::vector< ::cl::Event > copyEvent( 1 );
-                        l_Error = m_commQueue.enqueueCopyBuffer( m_devMemory,
-                                                                 l_tmpBuffer,
-                                                                 0,
-                                                                 0,
-                                                                 l_srcSize,
-                                                                 NULL,
-                                                                 &copyEvent.front( ) );
-                        V_OPENCL( l_Error, "device_vector failed to copy data to the new ::cl::Buffer object" );
-                        ::cl::Event fillEvent;
-
-                        size_t sizeDS = sizeof(value_type);
-                        if( !( sizeDS & (sizeDS - 1 ) ) )  // 2^n data types
-                        {
-                        l_Error = m_commQueue.enqueueFillBuffer< value_type >( l_tmpBuffer,
-                                                                               val,
-                                                                               l_srcSize,
-                                                                               (l_reqSize - l_srcSize),
-                                                                               &copyEvent,
-                                                                               &fillEvent );
-                        V_OPENCL( l_Error, "device_vector failed to fill the new data with the provided pattern" );
-                        //  Not allowed to return until the copy operation is finished
-                        }
-                        else // non 2^n data types
-                        {
-                          // Map the buffer to host
-                          ::cl::Event fill_mapEvent;
-                          value_type *host_buffer = ( value_type* )m_commQueue.enqueueMapBuffer (
-                                                                      l_tmpBuffer,
-                                                                      false,
-                                                                      CL_MAP_READ | CL_MAP_WRITE,
-                                                                      l_srcSize,
-                                                                      (l_reqSize - l_srcSize),
-                                                                      NULL,
-                                                                      &fill_mapEvent,
-                                                                      &l_Error );
-
-                          V_OPENCL( l_Error, "Error calling map on device_vector buffer. Fill device_vector" );
-                          fill_mapEvent.wait( );
-
-                          // Use serial fill_n to fill the device_vector with value
-#if defined(_WIN32)
-                       std::fill_n( stdext::make_checked_array_iterator( host_buffer , reqSize ),
-                                    reqSize,
-                                    val );
-#else
-                          std::fill_n( host_buffer,
-                                       (reqSize - m_Size),
-                                       val );
-#endif
-
-
-                          // Unmap the buffer
-                          l_Error = m_commQueue.enqueueUnmapMemObject( l_tmpBuffer,
-                                                                       host_buffer,
-                                                                       NULL,
-                                                                       &fillEvent );
-                          V_OPENCL( l_Error, "Error calling map on device_vector buffer. Fill device_vector" );
-                        }
-
-                        l_Error = fillEvent.wait( );
-                        V_OPENCL( l_Error, "device_vector failed to wait for fill event" );
-                    }
-                    else
-                    {
-                        std::vector< ::cl::Event > copyEvent( 1 );
-                        l_Error = m_commQueue.enqueueCopyBuffer( m_devMemory, l_tmpBuffer, 0, 0, l_reqSize, NULL, &copyEvent.front( ) );
-                        V_OPENCL( l_Error, "device_vector failed to copy data to the new ::cl::Buffer object" );
-                        //  Not allowed to return until the copy operation is finished
-                        l_Error = m_commQueue.enqueueWaitForEvents( copyEvent );
-                        V_OPENCL( l_Error, "device_vector failed to wait for copy event" );
+                        throw ::cl::Error( CL_MEM_OBJECT_ALLOCATION_FAILURE ,
+                            "A device_vector can not resize() memory not under its direct control" );
                     }
-                }
-                else
-                {
-                    ::cl::Event fillEvent;
-                    size_t sizeDS = sizeof(value_type);
-                    if( !( sizeDS & (sizeDS - 1 ) ) )  // 2^n data types
-                    {
-                      l_Error = m_commQueue.enqueueFillBuffer< value_type >( l_tmpBuffer, val, 0, l_reqSize, NULL, &fillEvent );
-                      V_OPENCL( l_Error, "device_vector failed to fill the new data with the provided pattern" );
 
-                    }
-                    else // non 2^n data types
-                    {
-                       // Map the buffer to host
-                       ::cl::Event fill_mapEvent;
-                       value_type *host_buffer = ( value_type* )m_commQueue.enqueueMapBuffer (
-                                                                                 l_tmpBuffer,
-                                                                                 false,
-                                                                                 CL_MAP_READ | CL_MAP_WRITE,
-                                                                                 0,
-                                                                                 l_reqSize,
-                                                                                 NULL,
-                                                                                 &fill_mapEvent,
-                                                                                 &l_Error );
-
-                       V_OPENCL( l_Error, "Error calling map on device_vector buffer. Fill device_vector" );
-                       fill_mapEvent.wait( );
-
-                       // Use serial fill_n to fill the device_vector with value
-#if defined(_WIN32)
-                       std::fill_n( stdext::make_checked_array_iterator( host_buffer , reqSize ),
-                                    reqSize,
-                                    val );
-#else
-                       std::fill_n(  host_buffer,
-                                    reqSize,
-                                    val );
-#endif
-
-                       // Unmap the buffer
-                       l_Error = m_commQueue.enqueueUnmapMemObject( l_tmpBuffer,
-                                                                    host_buffer,
-                                                                    NULL,
-                                                                    &fillEvent );
-                       V_OPENCL( l_Error, "Error calling map on device_vector buffer. Fill device_vector" );
-                    }
-
-                    //  Not allowed to return until the fill operation is finished
-                    l_Error = fillEvent.wait( );
-                    V_OPENCL( l_Error, "device_vector failed to wait for fill event" );
+                    grow( reqSize );
                 }
 
-                //  Remember the new size
-                m_Size = reqSize;
+                //  If the new size is greater than the old, the new elements must be initialized to the value specified
+                //  on the function parameter
+                if( reqSize > m_Size )
+                    fillRange( m_Size, reqSize - m_Size, val );
 
-                //  Operator= should call retain/release appropriately
-                m_devMemory = l_tmpBuffer;
+                m_Size = reqSize;
             }
 
             /*! \brief Return the number of known elements
@@ -1036,18 +1194,17 @@ namespace cl
 
                 if( m_Size == 0 )
                 {
-                    ::cl::Buffer l_tmpBuffer( l_Context, m_Flags, reqSize * sizeof( value_type ) );
+                    ::cl::Buffer l_tmpBuffer = createBuffer( l_Context, reqSize * sizeof( value_type ) );
                     m_devMemory = l_tmpBuffer;
                     return;
                 }
 
                 size_type l_size = reqSize * sizeof( value_type );
                 //  Can't user host_ptr because l_size is guranteed to be bigger
-                ::cl::Buffer l_tmpBuffer( l_Context, m_Flags, l_size, NULL, &l_Error );
-                V_OPENCL( l_Error, "device_vector can not create an temporary internal OpenCL buffer" );
+                ::cl::Buffer l_tmpBuffer = createBuffer( l_Context, l_size );
 
-                size_type l_srcSize = static_cast<size_type> (m_devMemory.getInfo< CL_MEM_SIZE >( &l_Error ) );
-                V_OPENCL( l_Error, "device_vector failed to request the size of the ::cl::Buffer object" );
+                //  Only the elements are copied, not the rest of the old capacity
+                size_type l_srcSize = m_Size * sizeof( value_type );
 
                 ::cl::Event copyEvent;
                 V_OPENCL( m_commQueue.enqueueCopyBuffer( m_devMemory, l_tmpBuffer, 0, 0, l_srcSize, NULL, &copyEvent ),
@@ -1096,18 +1253,19 @@ namespace cl
                 if( m_Size == capacity( ) )
                     return;
 
+                if( m_Size == 0 )
+                {
+                    clear( );
+                    return;
+                }
+
                 //  We want to use the context from the passed in commandqueue to initialize our buffer
                 cl_int l_Error = CL_SUCCESS;
                 ::cl::Context l_Context = m_commQueue.getInfo< CL_QUEUE_CONTEXT >( &l_Error );
                 V_OPENCL( l_Error, "device_vector failed to query for the context of the ::cl::CommandQueue object" );
 
                 size_type l_newSize = m_Size * sizeof( value_type );
-                ::cl::Buffer l_tmpBuffer( l_Context, m_Flags, l_newSize, NULL, &l_Error );
-                V_OPENCL( l_Error, "device_vector can not create an temporary internal OpenCL buffer" );
-
-                //TODO - this is equal to the capacity()
-                size_type l_srcSize = static_cast< size_type >( m_devMemory.getInfo< CL_MEM_SIZE >( &l_Error ) );
-                V_OPENCL( l_Error, "device_vector failed to request the size of the ::cl::Buffer object" );
+                ::cl::Buffer l_tmpBuffer = createBuffer( l_Context, l_newSize );
 
                 std::vector< ::cl::Event > copyEvent( 1 );
                 l_Error = m_commQueue.enqueueCopyBuffer( m_devMemory, l_tmpBuffer, 0, 0, l_newSize, NULL, &copyEvent.front( ) );
@@ -1135,6 +1293,10 @@ namespace cl
             */
             const_reference operator[]( size_type n ) const
             {
+                value_type viewed;
+                if( readViewed( n, viewed ) )
+                    return viewed;
+
                 cl_int l_Error = CL_SUCCESS;
 
                 naked_pointer ptrBuff = reinterpret_cast< naked_pointer >( m_commQueue.enqueueMapBuffer( m_devMemory, true, CL_MAP_READ, n * sizeof( value_type), sizeof( value_type), NULL, NULL, &l_Error ) );
@@ -1365,21 +1527,11 @@ namespace cl
                 //  Need to grow the vector to push new value.
                 //  Vectors double their capacity on push_back if the array is not big enough.
                 if( m_Size == capacity( ) )
-                {
-                    m_Size ? reserve( m_Size * 2 ) : reserve( 1 );
-                }
+                    grow( m_Size + 1 );
 
-                cl_int l_Error = CL_SUCCESS;
-
-                naked_pointer result = reinterpret_cast< naked_pointer >( m_commQueue.enqueueMapBuffer( m_devMemory, true, CL_MAP_WRITE_INVALIDATE_REGION,
-                    m_Size * sizeof( value_type), sizeof( value_type ), NULL, NULL, &l_Error ) );
-                V_OPENCL( l_Error, "device_vector failed map device memory to host memory for push_back" );
-                *result = value;
-
-                ::cl::Event unmapEvent;
-                l_Error = m_commQueue.enqueueUnmapMemObject( m_devMemory, result, NULL, &unmapEvent );
-                V_OPENCL( l_Error, "device_vector failed to unmap host memory back to device memory" );
-                V_OPENCL( unmapEvent.wait( ), "failed to wait for unmap event" );
+                //  A single blocking write, instead of a map and an unmap
+                V_OPENCL( m_commQueue.enqueueWriteBuffer( m_devMemory, CL_TRUE, m_Size * sizeof( value_type ), sizeof( value_type ),
+                    &value ), "device_vector failed to write the new element for push_back" );
 
                 ++m_Size;
             }
@@ -1417,6 +1569,8 @@ namespace cl
                 cl_mem_flags flagsTmp = m_Flags;
                 m_Flags = vec.m_Flags;
                 vec.m_Flags = flagsTmp;
+
+                m_HostAllocator.swap( vec.m_HostAllocator );
             }
 
             /*! \brief Removes an element.
@@ -1515,12 +1669,8 @@ namespace cl
                 }
 
                 //  Need to grow the vector to insert a new value.
-                //  TODO:  What is an appropriate growth strategy for GPU memory allocation?  Exponential growth does not seem
-                //  right at first blush.
                 if( m_Size == capacity( ) )
-                {
-                    reserve( m_Size + 10 );
-                }
+                    grow( m_Size + 1 );
 
             size_type sizeMap = (m_Size - index.m_Index) + 1;
 
@@ -1560,13 +1710,12 @@ namespace cl
                 if( index.m_Index > m_Size )
                     throw ::cl::Error( CL_INVALID_ARG_INDEX , "Iterator is pointing past the end of this container" );
 
+                if( n == 0 )
+                    return;
+
                 //  Need to grow the vector to insert a new value.
-                //  TODO:  What is an appropriate growth strategy for GPU memory allocation?  Exponential growth does not seem
-                //  right at first blush.
                 if( ( m_Size + n ) > capacity( ) )
-                {
-                    reserve( m_Size + n );
-                }
+                    grow( m_Size + n );
 
             size_type sizeMap = (m_Size - index.m_Index) + n;
 
@@ -1601,14 +1750,20 @@ namespace cl
                 if ( index.m_Index > m_Size)
                     throw ::cl::Error( CL_INVALID_ARG_INDEX , "Iterator is pointing past the end of this container" );
 
+                //  Inserting at the end moves nothing; only the new elements are written
+                if( index.m_Index == m_Size )
+                {
+                    append( begin, end );
+                    return;
+                }
+
                 //  Need to grow the vector to insert a new value.
-                //  TODO:  What is an appropriate growth strategy for GPU memory allocation?  Exponential growth does not seem
-                //  right at first blush.
                 size_type n = static_cast< size_type >( std::distance( begin, end ) );
+                if( n == 0 )
+                    return;
+
                 if( ( m_Size + n ) > capacity( ) )
-                {
-                    reserve( m_Size + n );
-                }
+                    grow( m_Size + n );
                 size_type sizeMap = (m_Size - index.m_Index) + n;
 
                 cl_int l_Error = CL_SUCCESS;
@@ -1642,69 +1797,15 @@ namespace cl
 
             void assign( size_type newSize, const value_type& value )
             {
-                if( newSize > m_Size )
+                //  The old elements are all replaced, so a buffer that is too small is not copied when it grows
+                if( newSize > capacity( ) )
                 {
+                    m_Size = 0;
                     reserve( newSize );
                 }
                 m_Size = newSize;
 
-                cl_int l_Error = CL_SUCCESS;
-
-                ::cl::Event fillEvent;
-                size_t sizeDS = sizeof(value_type);
-
-                if( !( sizeDS & (sizeDS - 1 ) ) )  // 2^n data types
-                {
-                  l_Error = m_commQueue.enqueueFillBuffer< value_type >( m_devMemory,
-                                                                         value,
-                                                                         0,
-                                                                         m_Size * sizeof( value_type ),
-                                                                         NULL,
-                                                                         &fillEvent );
-                  V_OPENCL( l_Error, "device_vector failed to fill the new data with the provided pattern" );
-                }
-                else
-                {
-                  // Map the buffer to host
-                  ::cl::Event fill_mapEvent;
-                  value_type *host_buffer = ( value_type* )m_commQueue.enqueueMapBuffer ( m_devMemory,
-                                                                                          false,
-                                                                                          CL_MAP_READ | CL_MAP_WRITE,
-                                                                                          0,
-                                                                                          sizeof( value_type )*newSize,
-                                                                                          NULL,
-                                                                                          &fill_mapEvent,
-                                                                                          &l_Error );
-
-                  V_OPENCL( l_Error, "Error calling map on device_vector buffer. Fill device_vector" );
-                  fill_mapEvent.wait( );
-
-                  // Use serial fill_n to fill the device_vector with value
-
-#if( _WIN32 )
-
-                  std::fill_n(  stdext::checked_array_iterator< naked_pointer >(  host_buffer,newSize),
-                               newSize,
-                               value );
-
-#else
-                  std::fill_n(  host_buffer ,
-                               newSize,
-                               value );
-#endif
-
-
-                  // Unmap the buffer
-                  l_Error = m_commQueue.enqueueUnmapMemObject( m_devMemory,
-                                                               host_buffer,
-                                                               NULL,
-                                                               &fillEvent );
-                  V_OPENCL( l_Error, "Error calling map on device_vector buffer. Fill device_vector" );
-                }
-
-                //  Not allowed to return until the copy operation is finished.
-                l_Error = fillEvent.wait( );
-                V_OPENCL( l_Error, "device_vector failed to wait for fill event" );
+                fillRange( 0, newSize, value );
             }
 
             /*! \brief Assigns a range of values to device_vector, replacing all previous elements.
@@ -1718,12 +1819,17 @@ namespace cl
             {
                 size_type l_Count = static_cast< size_type >( std::distance( begin, end ) );
 
-                if( l_Count > m_Size )
+                //  The old elements are all replaced, so a buffer that is too small is not copied when it grows
+                if( l_Count > capacity( ) )
                 {
+                    m_Size = 0;
                     reserve( l_Count );
                 }
                 m_Size = l_Count;
 
+                if( m_Size == 0 )
+                    return;
+
                 cl_int l_Error = CL_SUCCESS;
 
                 naked_pointer ptrBuffer = reinterpret_cast< naked_pointer >( m_commQueue.enqueueMapBuffer( m_devMemory, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0 , m_Size * sizeof( value_type ), NULL, NULL, &l_Error ) );
@@ -1740,6 +1846,42 @@ namespace cl
                 V_OPENCL( unmapEvent.wait( ), "failed to wait for unmap event" );
             }
 
+            /*! \brief Appends a copy of a range of values to the end of the device_vector, with a single transfer.
+             *  \param begin The iterator position signifiying the beginning of the range.
+             *  \param end The iterator position signifying the end of the range (exclusive).
+             *  \note If the device_vector must grow, it at least doubles its capacity, so a series of appends reallocates
+             *  only a logarithmic number of times.
+             *  \warning If the device_vector must reallocate, all previous iterators, references, and pointers are invalidated.
+            */
+            template< typename InputIterator >
+            typename std::enable_if< !std::is_integral< InputIterator >::value, void >::type
+            append( InputIterator begin, InputIterator end )
+            {
+                size_type n = static_cast< size_type >( std::distance( begin, end ) );
+                if( n == 0 )
+                    return;
+
+                if( ( m_Size + n ) > capacity( ) )
+                    grow( m_Size + n );
+
+                //  Only the new elements are mapped, and their old contents are not copied to the host
+                cl_int l_Error = CL_SUCCESS;
+                naked_pointer ptrBuffer = reinterpret_cast< naked_pointer >( m_commQueue.enqueueMapBuffer( m_devMemory, CL_TRUE,
+                    CL_MAP_WRITE_INVALIDATE_REGION, m_Size * sizeof( value_type ), n * sizeof( value_type ), NULL, NULL, &l_Error ) );
+                V_OPENCL( l_Error, "device_vector failed map device memory to host memory for append" );
+
+#if( _WIN32 )
+                std::copy( begin, end, stdext::checked_array_iterator< naked_pointer >( ptrBuffer, n ) );
+#else
+                std::copy( begin, end, ptrBuffer );
+#endif
+                ::cl::Event unmapEvent;
+                l_Error = m_commQueue.enqueueUnmapMemObject( m_devMemory, ptrBuffer, NULL, &unmapEvent );
+                V_OPENCL( l_Error, "device_vector failed to unmap host memory back to device memory" );
+                V_OPENCL( unmapEvent.wait( ), "failed to wait for unmap event" );
+
+                m_Size += n;
+            }
 
             /*! \brief A get accessor function to return the encapsulated device buffer for const objects.
             *   This member function allows access to the Buffer object, which can be retrieved through a reference or an iterator.
@@ -1763,11 +1905,138 @@ namespace cl
                 return m_devMemory;
             }
 
+            /*! \brief Returns the allocator of the host memory of this device_vector, or an empty pointer when the memory is
+            *   allocated by the OpenCL runtime
+            */
+            const boost::shared_ptr< host_allocator >& getHostAllocator( ) const
+            {
+                return m_HostAllocator;
+            }
+
         private:
+            //  Reallocates to hold at least reqSize elements; the capacity at least doubles, so that a series of appends
+            //  reallocates a logarithmic number of times
+            void grow( size_type reqSize )
+            {
+                size_type l_Capacity = capacity( );
+                if( reqSize <= l_Capacity )
+                    return;
+
+                reserve( std::max( reqSize, std::min( l_Capacity * 2, max_size( ) ) ) );
+            }
+
+            //  Sets the count elements starting at first to value, and waits for it
+            void fillRange( size_type first, size_type count, const value_type& value )
+            {
+                if( count == 0 )
+                    return;
+
+                cl_int l_Error = CL_SUCCESS;
+                ::cl::Event fillEvent;
+
+                size_t sizeDS = sizeof(value_type);
+                if( !( sizeDS & (sizeDS - 1 ) ) )  // 2^n data types
+                {
+                    l_Error = m_commQueue.enqueueFillBuffer< value_type >( m_devMemory, value, first * sizeof( value_type ),
+                                                                           count * sizeof( value_type ), NULL, &fillEvent );
+                    V_OPENCL( l_Error, "device_vector failed to fill the new data with the provided pattern" );
+                }
+                else // non 2^n data types
+                {
+                    //  The old contents of the range are not needed on the host
+                    naked_pointer host_buffer = static_cast< naked_pointer >( m_commQueue.enqueueMapBuffer( m_devMemory, CL_TRUE,
+                        CL_MAP_WRITE_INVALIDATE_REGION, first * sizeof( value_type ), count * sizeof( value_type ), NULL, NULL, &l_Error ) );
+                    V_OPENCL( l_Error, "Error calling map on device_vector buffer. Fill device_vector" );
+
+#if defined(_WIN32)
+                    std::fill_n( stdext::make_checked_array_iterator( host_buffer, count ), count, value );
+#else
+                    std::fill_n( host_buffer, count, value );
+#endif
+
+                    l_Error = m_commQueue.enqueueUnmapMemObject( m_devMemory, host_buffer, NULL, &fillEvent );
+                    V_OPENCL( l_Error, "Error calling map on device_vector buffer. Fill device_vector" );
+                }
+
+                //  Not allowed to return until the fill operation is finished
+                V_OPENCL( fillEvent.wait( ), "device_vector failed to wait for fill event" );
+            }
+
+            //  A new buffer of bytes bytes, in memory of the host allocator if the vector has one
+            ::cl::Buffer createBuffer( const ::cl::Context& context, size_type bytes ) const
+            {
+                if( m_HostAllocator )
+                    return m_HostAllocator->createBuffer( context, m_Flags, bytes );
+
+                cl_int l_Error = CL_SUCCESS;
+                ::cl::Buffer l_Buffer( context, m_Flags, bytes, NULL, &l_Error );
+                V_OPENCL( l_Error, "device_vector can not create an internal OpenCL buffer" );
+                return l_Buffer;
+            }
+
+            static cl_map_flags mapFlags( e_MapMode mode )
+            {
+                switch( mode )
+                {
+                case MapRead:
+                    return CL_MAP_READ;
+                case MapWrite:
+                    return CL_MAP_WRITE;
+                case MapWriteInvalidate:
+                    return CL_MAP_WRITE_INVALIDATE_REGION;
+                default:
+                    return CL_MAP_READ | CL_MAP_WRITE;
+                }
+            }
+
+            //  The live host_view that maps element n, or NULL; m_ViewsGuard must be held
+            const mapped_range* viewOf( size_type n ) const
+            {
+                for( const mapped_range* range = m_Views; range != NULL; range = range->next )
+                {
+                    if( n >= range->first && n - range->first < range->count )
+                        return range;
+                }
+
+                return NULL;
+            }
+
+            //  Reads element n from a live host_view that maps it, whatever its flags, since mapping the element
+            //  again would overlap the view; returns false if no view maps it
+            bool readViewed( size_type n, value_type& value ) const
+            {
+                boost::lock_guard< boost::mutex > lock( m_ViewsGuard );
+                const mapped_range* range = viewOf( n );
+                if( range == NULL )
+                    return false;
+
+                value = range->ptr[ n - range->first ];
+                return true;
+            }
+
+            //  Writes element n through a live host_view that maps it; returns false if no view maps it, and
+            //  throws if the view maps it read only
+            bool writeViewed( size_type n, const value_type& value ) const
+            {
+                boost::lock_guard< boost::mutex > lock( m_ViewsGuard );
+                const mapped_range* range = viewOf( n );
+                if( range == NULL )
+                    return false;
+
+                if( !( range->flags & ( CL_MAP_WRITE | CL_MAP_WRITE_INVALIDATE_REGION ) ) )
+                    throw ::cl::Error( CL_INVALID_OPERATION, "device_vector element is mapped read only by a host_view" );
+
+                range->ptr[ n - range->first ] = value;
+                return true;
+            }
+
             ::cl::Buffer m_devMemory;
             ::cl::CommandQueue m_commQueue;
             size_type m_Size;
             cl_mem_flags m_Flags;
+            mutable mapped_range* m_Views;
+            mutable boost::mutex m_ViewsGuard;  // protects m_Views; every copy of the container has its own
+            boost::shared_ptr< host_allocator > m_HostAllocator;
         };
 
     //  This string represents the device side definition of the constant_iterator template
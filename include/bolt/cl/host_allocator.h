@@ -0,0 +1,111 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+/*! \file bolt/cl/host_allocator.h
+    \brief Host memory that device_vector wraps in its buffers, so that the host paths use it without copies.
+*/
+
+#pragma once
+#if !defined( BOLT_CL_HOST_ALLOCATOR_H )
+#define BOLT_CL_HOST_ALLOCATOR_H
+
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "bolt/cl/bolt.h"
+
+namespace bolt {
+    namespace cl {
+
+        /*! \addtogroup miscellaneous
+        */
+
+        /*! \addtogroup CL-hostallocator
+        * \ingroup miscellaneous
+        * \{
+        */
+
+        /*! \brief A \p host_allocator provides the host memory of a device_vector that is made with it.
+        *   \details The vector creates its buffers with CL_MEM_USE_HOST_PTR over memory from the allocator, so
+        *   mapping any range of the vector returns a pointer into that memory; the serial and multicore paths then
+        *   read and write it in place.  On a CPU device the kernels work on the same memory, and no map or unmap
+        *   copies anything.  Unlike a vector that wraps memory of the caller, such a vector can still grow: every
+        *   reallocation takes new memory from the allocator.
+        *
+        *   The memory of a buffer is given back when the OpenCL runtime destroys the buffer, which may be after
+        *   the vector is gone; the buffer keeps its allocator alive until then.
+        *
+        *   Derive from this class to provide memory of another kind; the memory must stay valid and unmoved until
+        *   it is deallocated.
+        */
+        class host_allocator: public boost::enable_shared_from_this< host_allocator >
+        {
+        public:
+            virtual ~host_allocator( ) {}
+
+            /*! \brief Returns at least \p bytes bytes of host memory; throws std::bad_alloc when there is none
+            */
+            virtual void* allocate( size_t bytes ) = 0;
+
+            //! Gives back memory returned by allocate( \p bytes )
+            virtual void deallocate( void* ptr, size_t bytes ) = 0;
+
+            /*! \brief Creates a buffer of \p bytes bytes that uses memory of this allocator as its storage
+            *   \param flags The memory flags of the buffer; CL_MEM_USE_HOST_PTR is added to them
+            */
+            ::cl::Buffer createBuffer( const ::cl::Context& context, cl_mem_flags flags, size_t bytes );
+
+            //! Returns the process wide page_host_allocator
+            static boost::shared_ptr< host_allocator > pageAligned( );
+
+            //! Returns the process wide huge_page_host_allocator
+            static boost::shared_ptr< host_allocator > hugePages( );
+        };
+
+        /*! \brief Heap memory that starts on a page boundary and fills whole pages, which is what the OpenCL
+        *   runtimes need to use host memory in place instead of copying it
+        */
+        class page_host_allocator: public host_allocator
+        {
+        public:
+            void* allocate( size_t bytes );
+            void deallocate( void* ptr, size_t bytes );
+
+            //! The size of a page of the host, in bytes
+            static size_t pageSize( );
+        };
+
+        /*! \brief Memory in 2MB huge pages, for large vectors whose traversals would otherwise miss the TLB
+        *   \details Huge pages must be reserved by the administrator of the host; when none are left, the
+        *   memory is allocated aligned to 2MB and the kernel is asked to back it with transparent huge pages
+        *   where it supports them, or else it is plain memory in regular pages.
+        */
+        class huge_page_host_allocator: public host_allocator
+        {
+        public:
+            void* allocate( size_t bytes );
+            void deallocate( void* ptr, size_t bytes );
+
+            //! The size of a huge page, in bytes
+            static const size_t hugePageSize = static_cast< size_t >( 2 ) << 20;
+        };
+
+        /*!   \}  */
+
+    };
+};
+
+#endif
@@ -0,0 +1,295 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+#if !defined( BOLT_CL_MAPPED_RANGE_H )
+#define BOLT_CL_MAPPED_RANGE_H
+#pragma once
+
+#include <bolt/cl/iterator/addressof.h>
+
+/*! \file bolt/cl/iterator/mapped_range.h
+    \brief Maps the elements an algorithm works on into host memory for the serial and multicore paths.
+*/
+
+namespace bolt {
+namespace cl {
+namespace detail {
+
+    /*! \brief How a range of \p Iterator is found in its device buffer, and how it is read once it is mapped
+    *   \details The primary template describes device_vector iterators, which are read through a plain pointer.
+    */
+    template< typename Iterator, typename Category = typename std::iterator_traits< Iterator >::iterator_category >
+    struct mapped_iterator_traits
+    {
+        typedef typename std::iterator_traits< Iterator >::value_type element_type;
+        typedef element_type* iterator;
+
+        static ::cl::Buffer buffer( const Iterator& itr )
+        {
+            return itr.getContainer( ).getBuffer( );
+        }
+
+        static size_t offset( const Iterator& itr )
+        {
+            return static_cast< size_t >( itr.m_Index );
+        }
+
+        static size_t remaining( const Iterator& itr )
+        {
+            return itr.getContainer( ).size( ) - offset( itr );
+        }
+
+        static iterator make( const Iterator&, element_type* ptr )
+        {
+            return ptr;
+        }
+    };
+
+    //  A transform_iterator maps the range of the device_vector it adapts, and applies its functor to the mapping
+    template< typename Iterator >
+    struct mapped_iterator_traits< Iterator, transform_iterator_tag >
+    {
+        typedef typename Iterator::value_type element_type;
+        typedef transform_iterator< typename Iterator::unary_func, element_type* > iterator;
+
+        static ::cl::Buffer buffer( const Iterator& itr )
+        {
+            return itr.base( ).getContainer( ).getBuffer( );
+        }
+
+        static size_t offset( const Iterator& itr )
+        {
+            return static_cast< size_t >( itr.base( ).m_Index );
+        }
+
+        static size_t remaining( const Iterator& itr )
+        {
+            return itr.base( ).getContainer( ).size( ) - offset( itr );
+        }
+
+        static iterator make( const Iterator& itr, element_type* ptr )
+        {
+            return iterator( ptr, itr.functor( ) );
+        }
+    };
+
+    //  Constant and counting iterators compute their values on the host; nothing is mapped
+    template< typename Iterator >
+    struct unmapped_iterator_traits
+    {
+        typedef typename Iterator::value_type element_type;
+        typedef Iterator iterator;
+
+        static ::cl::Buffer buffer( const Iterator& )
+        {
+            return ::cl::Buffer( );
+        }
+
+        static size_t remaining( const Iterator& )
+        {
+            return 0;
+        }
+    };
+
+    template< typename Iterator >
+    struct mapped_iterator_traits< Iterator, constant_iterator_tag >: unmapped_iterator_traits< Iterator >
+    {
+    };
+
+    template< typename Iterator >
+    struct mapped_iterator_traits< Iterator, counting_iterator_tag >: unmapped_iterator_traits< Iterator >
+    {
+    };
+
+    //  A permutation_iterator may touch any element, so the whole element range behind it is mapped along with
+    //  its indices
+    template< typename Iterator >
+    struct mapped_iterator_traits< Iterator, permutation_iterator_tag >
+    {
+        typedef typename Iterator::value_type element_type;
+        typedef permutation_iterator< element_type*, typename Iterator::index_type* > iterator;
+
+        static ::cl::Buffer buffer( const Iterator& itr )
+        {
+            return itr.m_elt_iter.getContainer( ).getBuffer( );
+        }
+    };
+
+    /*! \brief The number of elements from \p first to the end of the buffer behind it; a range that is indexed at
+    *   random, like the input of a gather, is mapped that far
+    */
+    template< typename Iterator >
+    size_t mapped_elements( const Iterator& first )
+    {
+        return mapped_iterator_traits< Iterator >::remaining( first );
+    }
+
+    /*! \brief Maps the \p count elements starting at \p first from their device buffer into host memory, and
+    *   unmaps them when it is destroyed.
+    *   \details Only the elements of the range are mapped, not the whole buffer.  The map is enqueued without
+    *   blocking, so the ranges of all the iterators of an algorithm are mapped at the same time; begin( ) waits
+    *   for it.  A range whose old contents are overwritten without being read should be mapped with the flags
+    *   of overwrite_flags( ), so that they are not copied to the host.  The range of a device_vector made with a
+    *   host_allocator maps to the memory of the allocator, so the host paths work on it in place.
+    */
+    template< typename Iterator, typename Category = typename std::iterator_traits< Iterator >::iterator_category >
+    class mapped_range
+    {
+    public:
+        typedef mapped_iterator_traits< Iterator > traits;
+        typedef typename traits::element_type element_type;
+        typedef typename traits::iterator iterator;
+
+        mapped_range( control& ctl, const Iterator& first, size_t count, cl_map_flags flags ):
+            m_queue( ctl.getCommandQueue( ) ), m_first( first ), m_ptr( NULL )
+        {
+            if( count == 0 )
+                return;
+
+            m_buffer = traits::buffer( first );
+            m_ptr = static_cast< element_type* >( m_queue.enqueueMapBuffer( m_buffer, CL_FALSE, flags,
+                traits::offset( first ) * sizeof( element_type ), count * sizeof( element_type ), NULL, &m_mapEvent ) );
+        }
+
+        ~mapped_range( )
+        {
+            if( m_ptr == NULL )
+                return;
+
+            //  A destructor must not throw; the buffer is released with the queue if the unmap fails
+            try
+            {
+                ::cl::Event unmapEvent;
+                m_queue.enqueueUnmapMemObject( m_buffer, m_ptr, NULL, &unmapEvent );
+                unmapEvent.wait( );
+            }
+            catch( ::cl::Error& )
+            {
+            }
+        }
+
+        //! Waits for the map to finish and returns the host iterator to the first element of the range
+        iterator begin( )
+        {
+            if( m_mapEvent( ) != NULL )
+                m_mapEvent.wait( );
+
+            return traits::make( m_first, m_ptr );
+        }
+
+    private:
+        mapped_range( const mapped_range& );
+        mapped_range& operator=( const mapped_range& );
+
+        ::cl::CommandQueue m_queue;
+        ::cl::Buffer m_buffer;
+        ::cl::Event m_mapEvent;
+        Iterator m_first;
+        element_type* m_ptr;
+    };
+
+    template< typename Iterator >
+    class unmapped_range
+    {
+    public:
+        typedef Iterator iterator;
+
+        unmapped_range( control&, const Iterator& first, size_t, cl_map_flags ): m_first( first )
+        {}
+
+        iterator begin( )
+        {
+            return m_first;
+        }
+
+    private:
+        Iterator m_first;
+    };
+
+    template< typename Iterator >
+    class mapped_range< Iterator, constant_iterator_tag >: public unmapped_range< Iterator >
+    {
+    public:
+        mapped_range( control& ctl, const Iterator& first, size_t count, cl_map_flags flags ):
+            unmapped_range< Iterator >( ctl, first, count, flags )
+        {}
+    };
+
+    template< typename Iterator >
+    class mapped_range< Iterator, counting_iterator_tag >: public unmapped_range< Iterator >
+    {
+    public:
+        mapped_range( control& ctl, const Iterator& first, size_t count, cl_map_flags flags ):
+            unmapped_range< Iterator >( ctl, first, count, flags )
+        {}
+    };
+
+    //  The indices of a permutation are read; the elements from the one the permutation starts at to the end of
+    //  their container are mapped with the flags of the range, except that they are never invalidated, since only
+    //  the permuted ones are written
+    template< typename ElementIterator, typename IndexIterator >
+    class mapped_range< permutation_iterator< ElementIterator, IndexIterator >, permutation_iterator_tag >
+    {
+        typedef permutation_iterator< ElementIterator, IndexIterator > Iterator;
+
+    public:
+        typedef typename mapped_iterator_traits< Iterator >::iterator iterator;
+
+        mapped_range( control& ctl, const Iterator& first, size_t count, cl_map_flags flags ):
+            m_indices( ctl, first.base( ), count, CL_MAP_READ ),
+            m_elements( ctl, first.m_elt_iter, count == 0 ? 0 : mapped_elements( first.m_elt_iter ),
+                        ( flags & CL_MAP_WRITE_INVALIDATE_REGION ) ? CL_MAP_READ | CL_MAP_WRITE : flags )
+        {}
+
+        iterator begin( )
+        {
+            return iterator( m_elements.begin( ), m_indices.begin( ) );
+        }
+
+    private:
+        mapped_range< IndexIterator > m_indices;
+        mapped_range< ElementIterator > m_elements;
+    };
+
+    /*! \brief The map flags of an output range that is overwritten without being read: its old contents are not
+    *   copied to the host, unless it shares a buffer with one of the input ranges, as when an algorithm works in
+    *   place
+    */
+    template< typename OutputIterator, typename InputIterator >
+    cl_map_flags overwrite_flags( const OutputIterator& result, const InputIterator& first )
+    {
+        if( mapped_iterator_traits< OutputIterator >::buffer( result )( ) ==
+            mapped_iterator_traits< InputIterator >::buffer( first )( ) )
+            return CL_MAP_READ | CL_MAP_WRITE;
+
+        return CL_MAP_WRITE_INVALIDATE_REGION;
+    }
+
+    template< typename OutputIterator, typename InputIterator1, typename InputIterator2 >
+    cl_map_flags overwrite_flags( const OutputIterator& result, const InputIterator1& first1,
+                                  const InputIterator2& first2 )
+    {
+        if( overwrite_flags( result, first1 ) != CL_MAP_WRITE_INVALIDATE_REGION )
+            return CL_MAP_READ | CL_MAP_WRITE;
+
+        return overwrite_flags( result, first2 );
+    }
+
+}
+}
+}
+
+#endif
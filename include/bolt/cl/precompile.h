@@ -0,0 +1,231 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#if !defined( BOLT_CL_PRECOMPILE_H )
+#define BOLT_CL_PRECOMPILE_H
+#pragma once
+
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/thread/future.hpp>
+
+#include "bolt/cl/control.h"
+#include "bolt/cl/device_vector.h"
+#include "bolt/cl/functional.h"
+#include "bolt/cl/sort.h"
+#include "bolt/cl/stablesort.h"
+#include "bolt/cl/reduce.h"
+#include "bolt/cl/scan.h"
+#include "bolt/cl/transform.h"
+#include "bolt/cl/transform_reduce.h"
+
+/*! \file bolt/cl/precompile.h
+    \brief Builds the OpenCL kernels of Bolt algorithms on background threads, ahead of their first use.
+*/
+
+namespace bolt {
+    namespace cl {
+
+        /*! \addtogroup miscellaneous
+        */
+
+        /*! \addtogroup CL-precompile
+        *   \ingroup miscellaneous
+        *   \{
+        */
+
+        /*! \brief Algorithm descriptions understood by bolt::cl::precompile and bolt::cl::precompiler
+        *   \details Each description runs its algorithm once on a small device_vector, through the OpenCL path,
+        *   which compiles the same kernels that later calls with the same types use.  Any type with a static
+        *   <tt>void run( bolt::cl::control& ctl )</tt> member can be used as a description as well, for example
+        *   to warm up an algorithm with a user defined functor.
+        */
+        namespace warmup
+        {
+            //! Large enough to take the OpenCL path of every algorithm, small enough to run in no time
+            static const size_t warmupSize = 4096;
+
+            template< typename T, typename StrictWeakOrdering = bolt::cl::less< T > >
+            struct sort
+            {
+                static void run( control& ctl )
+                {
+                    device_vector< T > input( warmupSize, T( ), CL_MEM_READ_WRITE, true, ctl );
+                    bolt::cl::sort( ctl, input.begin( ), input.end( ), StrictWeakOrdering( ) );
+                }
+            };
+
+            template< typename T, typename StrictWeakOrdering = bolt::cl::less< T > >
+            struct stable_sort
+            {
+                static void run( control& ctl )
+                {
+                    device_vector< T > input( warmupSize, T( ), CL_MEM_READ_WRITE, true, ctl );
+                    bolt::cl::stable_sort( ctl, input.begin( ), input.end( ), StrictWeakOrdering( ) );
+                }
+            };
+
+            template< typename T, typename BinaryFunction = bolt::cl::plus< T > >
+            struct reduce
+            {
+                static void run( control& ctl )
+                {
+                    device_vector< T > input( warmupSize, T( ), CL_MEM_READ_WRITE, true, ctl );
+                    bolt::cl::reduce( ctl, input.begin( ), input.end( ), T( ), BinaryFunction( ) );
+                }
+            };
+
+            template< typename T, typename BinaryFunction = bolt::cl::plus< T > >
+            struct inclusive_scan
+            {
+                static void run( control& ctl )
+                {
+                    device_vector< T > input( warmupSize, T( ), CL_MEM_READ_WRITE, true, ctl );
+                    device_vector< T > output( warmupSize, T( ), CL_MEM_READ_WRITE, false, ctl );
+                    bolt::cl::inclusive_scan( ctl, input.begin( ), input.end( ), output.begin( ), BinaryFunction( ) );
+                }
+            };
+
+            template< typename T, typename BinaryFunction = bolt::cl::plus< T > >
+            struct exclusive_scan
+            {
+                static void run( control& ctl )
+                {
+                    device_vector< T > input( warmupSize, T( ), CL_MEM_READ_WRITE, true, ctl );
+                    device_vector< T > output( warmupSize, T( ), CL_MEM_READ_WRITE, false, ctl );
+                    bolt::cl::exclusive_scan( ctl, input.begin( ), input.end( ), output.begin( ), T( ),
+                        BinaryFunction( ) );
+                }
+            };
+
+            template< typename T, typename UnaryFunction, typename R = T >
+            struct transform
+            {
+                static void run( control& ctl )
+                {
+                    device_vector< T > input( warmupSize, T( ), CL_MEM_READ_WRITE, true, ctl );
+                    device_vector< R > output( warmupSize, R( ), CL_MEM_READ_WRITE, false, ctl );
+                    bolt::cl::transform( ctl, input.begin( ), input.end( ), output.begin( ), UnaryFunction( ) );
+                }
+            };
+
+            template< typename T, typename UnaryFunction, typename BinaryFunction = bolt::cl::plus< T > >
+            struct transform_reduce
+            {
+                static void run( control& ctl )
+                {
+                    device_vector< T > input( warmupSize, T( ), CL_MEM_READ_WRITE, true, ctl );
+                    bolt::cl::transform_reduce( ctl, input.begin( ), input.end( ), UnaryFunction( ), T( ),
+                        BinaryFunction( ) );
+                }
+            };
+        }
+
+        /*! \brief Collects a set of algorithm descriptions and compiles their kernels on background threads
+        *   \details Every description runs on its own thread, with a copy of the control that is forced to the
+        *   OpenCL path.  The compiled programs are shared by all threads of the process, so that the first real
+        *   call of each algorithm finds its program already built.  If the programs are still being built when the
+        *   real call arrives, the call waits for that build instead of starting a second one.
+        *
+        * \code
+        * #include <bolt/cl/precompile.h>
+        *
+        * boost::shared_future< void > ready = bolt::cl::precompiler( )
+        *     .add< bolt::cl::warmup::sort< int > >( )
+        *     .add< bolt::cl::warmup::reduce< float, bolt::cl::plus< float > > >( )
+        *     .start( );
+        *
+        * // ... other start up work
+        *
+        * ready.get( );     // rethrows the first error raised by a warm-up, if any
+        * \endcode
+        */
+        class precompiler
+        {
+        public:
+            typedef boost::function< void ( control& ) > warmup_function;
+
+            //! Adds an algorithm description, i.e. one of the types in bolt::cl::warmup
+            template< typename Algorithm >
+            precompiler& add( )
+            {
+                m_warmups.push_back( &Algorithm::run );
+                return *this;
+            }
+
+            //! Adds a function that runs the algorithms to warm up with the control it is given
+            precompiler& add( const warmup_function& warmup )
+            {
+                m_warmups.push_back( warmup );
+                return *this;
+            }
+
+            /*! \brief Starts the warm-ups on background threads and returns immediately
+            *   \return A future that becomes ready when every warm-up finished; it holds the first error raised
+            */
+            boost::shared_future< void > start( const control& ctl = control::getDefault( ) ) const;
+
+        private:
+            ::std::vector< warmup_function > m_warmups;
+        };
+
+        //! Compiles the kernels of one algorithm description on a background thread
+        template< typename Algorithm >
+        boost::shared_future< void > precompile( const control& ctl = control::getDefault( ) )
+        {
+            return precompiler( ).add< Algorithm >( ).start( ctl );
+        }
+
+        //! Compiles the kernels of two algorithm descriptions on background threads
+        template< typename Algorithm1, typename Algorithm2 >
+        boost::shared_future< void > precompile( const control& ctl = control::getDefault( ) )
+        {
+            precompiler warmups;
+            warmups.add< Algorithm1 >( );
+            warmups.add< Algorithm2 >( );
+            return warmups.start( ctl );
+        }
+
+        //! Compiles the kernels of three algorithm descriptions on background threads
+        template< typename Algorithm1, typename Algorithm2, typename Algorithm3 >
+        boost::shared_future< void > precompile( const control& ctl = control::getDefault( ) )
+        {
+            precompiler warmups;
+            warmups.add< Algorithm1 >( );
+            warmups.add< Algorithm2 >( );
+            warmups.add< Algorithm3 >( );
+            return warmups.start( ctl );
+        }
+
+        //! Compiles the kernels of four algorithm descriptions on background threads
+        template< typename Algorithm1, typename Algorithm2, typename Algorithm3, typename Algorithm4 >
+        boost::shared_future< void > precompile( const control& ctl = control::getDefault( ) )
+        {
+            precompiler warmups;
+            warmups.add< Algorithm1 >( );
+            warmups.add< Algorithm2 >( );
+            warmups.add< Algorithm3 >( );
+            warmups.add< Algorithm4 >( );
+            return warmups.start( ctl );
+        }
+
+        /*!   \}  */
+
+    };
+};
+
+#endif
@@ -0,0 +1,140 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+/*! \file bolt/cl/program_cache.h
+    \brief Persistent, on-disk cache of compiled OpenCL program binaries.
+*/
+
+#pragma once
+#if !defined( BOLT_CL_PROGRAM_CACHE_H )
+#define BOLT_CL_PROGRAM_CACHE_H
+
+#include <string>
+#include <boost/thread/mutex.hpp>
+#include "bolt/cl/bolt.h"
+
+namespace bolt {
+    namespace cl {
+
+        /*! \addtogroup miscellaneous
+        */
+
+        /*! \addtogroup CL-programcache
+        * \ingroup miscellaneous
+        * \{
+        */
+
+        /*! \brief The \p ProgramCache stores the binaries of compiled Bolt programs on disk, so that a new process
+        *   can skip the OpenCL compiler for every specialization that an earlier process already built.
+        *   \details Each entry is keyed by a ProgramDigest over the device name, vendor, device version, driver
+        *   version, the Bolt version, the compile options and the complete kernel string handed to the compiler.
+        *   Entries are reloaded with clCreateProgramWithBinary; an entry that the runtime rejects is deleted and
+        *   the program is compiled from source as before.  The total size of the cache directory is bounded;
+        *   when it grows past the limit, the least recently used entries are removed.
+        *
+        *   The cache is configured once per process, either through the setters below or through these
+        *   environment variables, which are read when the cache is first used:
+        *   - BOLT_PROGRAM_CACHE: set to 0 to disable the cache
+        *   - BOLT_PROGRAM_CACHE_DIR: directory that holds the cached binaries
+        *   - BOLT_PROGRAM_CACHE_SIZE_MB: upper bound of the cache directory, in megabytes
+        *
+        * \code
+        * bolt::cl::ProgramCache& cache = bolt::cl::ProgramCache::getInstance( );
+        * cache.setDirectory( "/var/cache/myService/bolt" );
+        * cache.setMaxSize( 64 << 20 );
+        * \endcode
+        */
+        class ProgramCache
+        {
+        public:
+            /*! \brief Counters describing how the cache has been used since the last resetStatistics( ) */
+            struct statistics
+            {
+                size_t hits;        // programs created from a cached binary
+                size_t misses;      // lookups that had to fall back to the compiler
+                size_t stores;      // binaries written to the cache
+                size_t evictions;   // entries removed to honor the size limit
+                size_t rejected;    // entries that were unreadable or refused by the OpenCL runtime
+            };
+
+            //! Returns the process wide program cache
+            static ProgramCache& getInstance( );
+
+            //! Enables or disables the cache; a disabled cache neither reads nor writes files
+            void setEnabled( bool enabled );
+            bool getEnabled( ) const;
+
+            //! Sets the directory that holds the cached binaries; it is created on the first store
+            void setDirectory( const ::std::string& directory );
+            ::std::string getDirectory( ) const;
+
+            //! Sets the maximum number of bytes the cache directory may hold
+            void setMaxSize( size_t maxSize );
+            size_t getMaxSize( ) const;
+
+            /*! \brief Computes the key under which a program is stored
+            *   \param device The device the program is built for
+            *   \param programDigest The digest of the compile options and the complete kernel string, as used
+            *   by the ProgramMap
+            */
+            static ProgramDigest makeKey( const ::cl::Device& device, const ProgramDigest& programDigest );
+
+            /*! \brief Creates and builds a program from a cached binary
+            *   \return true if \p program was loaded from the cache, false if the caller has to compile it
+            */
+            bool load( const ::cl::Context& context,
+                       const ::cl::Device& device,
+                       const ::std::string& compileOptions,
+                       const ProgramDigest& key,
+                       ::cl::Program& program );
+
+            /*! \brief Writes the binary that \p program holds for \p device into the cache
+            *   \details Failures to write are not reported; the cache is an optimization only.
+            */
+            void store( const ::cl::Device& device, const ProgramDigest& key, const ::cl::Program& program );
+
+            //! Returns the number of bytes currently held by the cache directory
+            size_t totalSize( ) const;
+
+            //! Removes every entry from the cache directory
+            void clear( );
+
+            statistics getStatistics( ) const;
+            void resetStatistics( );
+
+        private:
+            ProgramCache( );
+            ProgramCache( const ProgramCache& );
+            ProgramCache& operator=( const ProgramCache& );
+
+            ::std::string entryPath( const ::std::string& directory, const ProgramDigest& key ) const;
+            void trim( const ::std::string& directory, size_t maxSize );
+
+            mutable boost::mutex m_guard;   // protects the settings and the statistics
+            boost::mutex m_trimGuard;       // only one thread scans the directory for eviction at a time
+            bool            m_enabled;
+            ::std::string   m_directory;
+            size_t          m_maxSize;
+            statistics      m_stats;
+        };
+
+        /*!   \}  */
+
+    };
+};
+
+#endif
@@ -25,6 +25,11 @@
     }\
     barrier(CLK_LOCAL_MEM_FENCE);
 
+//  Elements a work-item reads per iteration of its loop; the host sets it when it tunes the kernel
+#ifndef REDUCE_UNROLL
+#define REDUCE_UNROLL 1
+#endif
+
 template< typename iTypePtr, typename iTypeIter, typename binary_function,typename T >
 kernel void reduceTemplate(
     global iTypePtr*    input_ptr, 
@@ -49,11 +54,24 @@ kernel void reduceTemplate(
 
     // Loop sequentially over chunks of input vector, reducing an arbitrary size input
     // length into a length related to the number of workgroups
+    int stride = get_global_size(0);
+#if REDUCE_UNROLL > 1
+    while (gx + (REDUCE_UNROLL - 1) * stride < length)
+    {
+        #pragma unroll
+        for (int u = 0; u < REDUCE_UNROLL; ++u)
+        {
+            typename iTypeIter::value_type element = input_iter[gx + u * stride];
+            accumulator = (*userFunctor)(accumulator, element);
+        }
+        gx += REDUCE_UNROLL * stride;
+    }
+#endif
     while (gx < length)
     {
         typename iTypeIter::value_type element = input_iter[gx];
         accumulator = (*userFunctor)(accumulator, element);
-        gx += get_global_size(0);
+        gx += stride;
     }
 
     //  Initialize local data store
@@ -65,15 +83,11 @@ kernel void reduceTemplate(
     uint tail = length - (get_group_id(0) * get_local_size(0));
 
     // Parallel reduction within a given workgroup using local data store
-    // to share values between workitems - 256 is good to achieve high occupancy
-    _REDUCE_STEP(tail, local_index, 128);
-    _REDUCE_STEP(tail, local_index, 64);
-    _REDUCE_STEP(tail, local_index, 32);
-    _REDUCE_STEP(tail, local_index, 16);
-    _REDUCE_STEP(tail, local_index,  8);
-    _REDUCE_STEP(tail, local_index,  4);
-    _REDUCE_STEP(tail, local_index,  2);
-    _REDUCE_STEP(tail, local_index,  1);
+    // to share values between workitems; the workgroup size is a power of two
+    for (int w = get_local_size(0) / 2; w > 0; w >>= 1)
+    {
+        _REDUCE_STEP(tail, local_index, w);
+    }
  
      //  Abort threads that are passed the end of the input vector
     if( gloId >= length )
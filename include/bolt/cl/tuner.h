@@ -0,0 +1,166 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+/*! \file bolt/cl/tuner.h
+    \brief Finds and remembers the work shape of the kernels run by controls in AutoTuneWorkShape mode.
+*/
+
+#pragma once
+#if !defined( BOLT_CL_TUNER_H )
+#define BOLT_CL_TUNER_H
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/chrono.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "bolt/cl/bolt.h"
+
+namespace bolt {
+    namespace cl {
+
+        /*! \addtogroup miscellaneous
+        */
+
+        /*! \addtogroup CL-tuner
+        * \ingroup miscellaneous
+        * \{
+        */
+
+        /*! \brief The \p work_shape_tuner picks the work-group size, the work-groups per compute unit and the unroll
+        *   factor of an algorithm, per type and device, for the controls whose auto-tune mode has AutoTuneWorkShape.
+        *   \details The first call of an algorithm with a type on a device runs every candidate shape on its own
+        *   input a few times and keeps the fastest; later calls reuse that shape.  The shapes are kept apart by the
+        *   size of the input, in buckets of a factor of four, so a small first call does not choose the shape of
+        *   the large calls after it.  Reduce tunes all three fields; scan and the bitonic sort tune only the
+        *   work-group size, since their grids cover the input and they have no loop to unroll.  The radix sort is
+        *   not tuned: its kernels size their local memory for one work-group size.  If the environment variable
+        *   BOLT_TUNING_DB names a file, the shapes are read from it, and every new shape is appended to it.
+        */
+        class work_shape_tuner
+        {
+        public:
+            struct work_shape
+            {
+                size_t wgSize;          // a power of two
+                int wgPerComputeUnit;
+                int unroll;             // elements a work-item reads per iteration of its loop
+            };
+
+            static work_shape_tuner& getInstance( );
+
+            //! The key of \p algorithm over \p types on the device of \p ctl, for calls over \p elements elements
+            static std::string makeKey( const control& ctl, const std::string& algorithm, const std::string& types,
+                                        size_t elements );
+
+            //! The shapes tried for the device of \p ctl; CPU devices also try the small work-groups they prefer
+            static std::vector< work_shape > candidates( const control& ctl );
+
+            //! The work-group sizes of candidates( \p ctl ), with the other fields of \p base; for the kernels
+            //! whose work-group size is all there is to tune
+            static std::vector< work_shape > wgSizeCandidates( const control& ctl, const work_shape& base );
+
+            //! Returns false if no shape is known for \p key
+            bool findShape( const std::string& key, work_shape& shape );
+
+            //! Remembers \p shape for \p key, and appends it to the tuning database if there is one
+            void setShape( const std::string& key, const work_shape& shape );
+
+            //! Reads the shapes in \p path, in addition to the known ones; returns false if it cannot be read
+            bool loadDatabase( const std::string& path );
+
+            //! Writes all known shapes to \p path
+            bool saveDatabase( const std::string& path );
+
+            /*! \brief Returns the shape known for \p key, or finds it by timing \p run over every candidate
+            *   \param run Runs the algorithm with the shape it is given, and waits for it to finish
+            *   \param fallback Returned if no candidate can run
+            */
+            template< typename Run >
+            work_shape tune( const control& ctl, const std::string& key, const work_shape& fallback, Run run )
+            {
+                return tune( ctl, key, fallback, candidates( ctl ), run );
+            }
+
+            //! As above, trying \p shapes instead of candidates( \p ctl )
+            template< typename Run >
+            work_shape tune( const control& ctl, const std::string& key, const work_shape& fallback,
+                             const std::vector< work_shape >& shapes, Run run )
+            {
+                work_shape best = fallback;
+                if( findShape( key, best ) )
+                    return best;
+
+                typedef boost::chrono::steady_clock clock;
+                double bestSeconds = std::numeric_limits< double >::infinity( );
+
+                //  The first run of a shape compiles its kernels, and is not timed
+                for( size_t s = 0; s < shapes.size( ); ++s )
+                {
+                    try
+                    {
+                        run( shapes[ s ] );
+                        double seconds = std::numeric_limits< double >::infinity( );
+                        for( int r = 0; r < 3; ++r )
+                        {
+                            const clock::time_point start = clock::now( );
+                            run( shapes[ s ] );
+                            seconds = std::min( seconds,
+                                boost::chrono::duration< double >( clock::now( ) - start ).count( ) );
+                        }
+
+                        if( seconds < bestSeconds )
+                        {
+                            bestSeconds = seconds;
+                            best = shapes[ s ];
+                        }
+                    }
+                    catch( ::cl::Error& )
+                    {
+                        //  The device cannot run this shape, e.g. its local memory is too small for the work-group
+                    }
+                }
+
+                if( ctl.getDebugMode( ) & control::debug::AutoTune )
+                {
+                    std::cout << "AutoTune: " << key << " -> wgSize " << best.wgSize << ", wgPerComputeUnit "
+                              << best.wgPerComputeUnit << ", unroll " << best.unroll << std::endl;
+                }
+
+                setShape( key, best );
+                return best;
+            }
+
+        private:
+            work_shape_tuner( );
+            work_shape_tuner( const work_shape_tuner& );
+            work_shape_tuner& operator=( const work_shape_tuner& );
+
+            boost::mutex m_guard;   // protects everything below
+            std::map< std::string, work_shape > m_shapes;
+            std::string m_databasePath;
+        };
+
+        /*!   \}  */
+
+    };
+};
+
+#endif
@@ -39,7 +39,7 @@ else( )
   set(Boost.Bootstrap "bootstrap.bat")
 endif( )
 
-set( Boost.Command ${Boost.B2} -j 4 --with-program_options --with-thread --with-system --with-date_time --with-chrono )
+set( Boost.Command ${Boost.B2} -j 4 --with-program_options --with-thread --with-system --with-date_time --with-chrono --with-filesystem )
 
 
 if( Bolt_BUILD64 )
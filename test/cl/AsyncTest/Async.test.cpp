@@ -0,0 +1,302 @@
+/***************************************************************************                                                                                     
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.                                     
+*                                                                                    
+*   Licensed under the Apache License, Version 2.0 (the "License");   
+*   you may not use this file except in compliance with the License.                 
+*   You may obtain a copy of the License at                                          
+*                                                                                    
+*       http://www.apache.org/licenses/LICENSE-2.0                      
+*                                                                                    
+*   Unless required by applicable law or agreed to in writing, software              
+*   distributed under the License is distributed on an "AS IS" BASIS,              
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.         
+*   See the License for the specific language governing permissions and              
+*   limitations under the License.                                                   
+
+***************************************************************************/                                                                                     
+
+#include "stdafx.h"
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
+#include "bolt/cl/async.h"
+#include "bolt/cl/control.h"
+#include "bolt/cl/device_vector.h"
+#include "bolt/cl/functional.h"
+
+#include "bolt/unicode.h"
+#include "bolt/miniDump.h"
+#include "bolt/countof.h"
+
+#include <gtest/gtest.h>
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+TEST( Async, TransformScanReducePipeline )
+{
+    const size_t length = 1 << 16;
+
+    std::vector< int > stdInput( length );
+    for( size_t i = 0; i < length; ++i )
+        stdInput[ i ] = static_cast< int >( i % 7 ) - 3;
+
+    bolt::cl::device_vector< int > input( stdInput.begin( ), stdInput.end( ) );
+    bolt::cl::device_vector< int > squares( length );
+    bolt::cl::device_vector< int > sums( length );
+
+    bolt::cl::control& ctl = bolt::cl::control::getDefault( );
+
+    //  Every step waits for the event of the one before it, not for the host
+    bolt::cl::async::future< void > transformed = bolt::cl::async::transform( ctl, input.begin( ), input.end( ),
+        squares.begin( ), bolt::cl::square< int >( ) );
+
+    bolt::cl::async::event_list afterTransform( 1, transformed.getEvent( ) );
+    bolt::cl::async::future< void > scanned = bolt::cl::async::inclusive_scan( ctl, squares.begin( ), squares.end( ),
+        sums.begin( ), bolt::cl::plus< int >( ), afterTransform );
+
+    bolt::cl::async::future< int > reduced = bolt::cl::async::reduce( ctl, squares.begin( ), squares.end( ), 1,
+        bolt::cl::plus< int >( ), afterTransform );
+
+    bolt::cl::async::event_list afterScan( 1, scanned.getEvent( ) );
+    bolt::cl::async::future< int > last = bolt::cl::async::reduce( ctl, sums.begin( ), sums.end( ), 0,
+        bolt::cl::maximum< int >( ), afterScan );
+
+    std::vector< int > stdSquares( length );
+    std::transform( stdInput.begin( ), stdInput.end( ), stdSquares.begin( ), []( int x ) { return x * x; } );
+    std::vector< int > stdSums( length );
+    std::partial_sum( stdSquares.begin( ), stdSquares.end( ), stdSums.begin( ) );
+
+    EXPECT_EQ( std::accumulate( stdSquares.begin( ), stdSquares.end( ), 1 ), reduced.get( ) );
+    EXPECT_EQ( stdSums.back( ), last.get( ) );
+
+    scanned.wait( );
+    EXPECT_TRUE( scanned.ready( ) );
+    EXPECT_TRUE( std::equal( stdSums.begin( ), stdSums.end( ), sums.begin( ) ) );
+}
+
+TEST( Async, SortAfterTransform )
+{
+    const size_t length = 1 << 14;
+
+    std::vector< int > stdInput( length );
+    for( size_t i = 0; i < length; ++i )
+        stdInput[ i ] = static_cast< int >( ( i * 7919 ) % length );
+
+    bolt::cl::device_vector< int > input( stdInput.begin( ), stdInput.end( ) );
+    bolt::cl::device_vector< int > keys( length );
+
+    bolt::cl::control& ctl = bolt::cl::control::getDefault( );
+
+    bolt::cl::async::future< void > negated = bolt::cl::async::transform( ctl, input.begin( ), input.end( ),
+        keys.begin( ), bolt::cl::negate< int >( ) );
+
+    bolt::cl::async::future< void > sorted = bolt::cl::async::sort( ctl, keys.begin( ), keys.end( ),
+        bolt::cl::less< int >( ), bolt::cl::async::event_list( 1, negated.getEvent( ) ) );
+    sorted.get( );
+
+    std::transform( stdInput.begin( ), stdInput.end( ), stdInput.begin( ), std::negate< int >( ) );
+    std::sort( stdInput.begin( ), stdInput.end( ) );
+
+    EXPECT_TRUE( std::equal( stdInput.begin( ), stdInput.end( ), keys.begin( ) ) );
+}
+
+TEST( Async, BinaryTransformAndExclusiveScan )
+{
+    const size_t length = 1000;
+
+    std::vector< int > stdA( length, 2 ), stdB( length );
+    for( size_t i = 0; i < length; ++i )
+        stdB[ i ] = static_cast< int >( i );
+
+    bolt::cl::device_vector< int > a( stdA.begin( ), stdA.end( ) ), b( stdB.begin( ), stdB.end( ) );
+    bolt::cl::device_vector< int > products( length ), scanned( length );
+
+    bolt::cl::control& ctl = bolt::cl::control::getDefault( );
+
+    bolt::cl::async::future< void > multiplied = bolt::cl::async::transform( ctl, a.begin( ), a.end( ), b.begin( ),
+        products.begin( ), bolt::cl::multiplies< int >( ) );
+    bolt::cl::async::exclusive_scan( ctl, products.begin( ), products.end( ), scanned.begin( ), 5,
+        bolt::cl::plus< int >( ), bolt::cl::async::event_list( 1, multiplied.getEvent( ) ) ).get( );
+
+    std::vector< int > stdProducts( length ), stdScanned( length );
+    std::transform( stdA.begin( ), stdA.end( ), stdB.begin( ), stdProducts.begin( ), std::multiplies< int >( ) );
+    stdScanned[ 0 ] = 5;
+    for( size_t i = 1; i < length; ++i )
+        stdScanned[ i ] = stdScanned[ i - 1 ] + stdProducts[ i - 1 ];
+
+    EXPECT_TRUE( std::equal( stdScanned.begin( ), stdScanned.end( ), scanned.begin( ) ) );
+}
+
+//  A future that goes out of scope without being waited for finishes the call before its buffers are reused
+TEST( Async, DroppedFutureCompletes )
+{
+    const size_t length = 1 << 15;
+    bolt::cl::device_vector< int > input( length, 3 );
+    bolt::cl::device_vector< int > sums( length );
+
+    {
+        bolt::cl::async::inclusive_scan( bolt::cl::control::getDefault( ), input.begin( ), input.end( ),
+            sums.begin( ), bolt::cl::plus< int >( ) );
+    }
+
+    std::vector< int > stdSums( length );
+    for( size_t i = 0; i < length; ++i )
+        stdSums[ i ] = 3 * static_cast< int >( i + 1 );
+
+    EXPECT_TRUE( std::equal( stdSums.begin( ), stdSums.end( ), sums.begin( ) ) );
+}
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+    ::testing::InitGoogleTest( &argc, &argv[ 0 ] );
+
+    //  Register our minidump generating logic
+    //bolt::miniDumpSingleton::enableMiniDumps( );
+
+    /******************************************************************************
+     * Default Benchmark Parameters
+     *****************************************************************************/
+    cl_uint userPlatform = 0;
+    cl_uint userDevice = 0;
+    cl_device_type deviceType = CL_DEVICE_TYPE_DEFAULT;
+    bool defaultDevice = true;
+    bool print_clInfo = false;
+    bool hostMemory = false;
+    bolt::cl::control& ctrl = bolt::cl::control::getDefault();
+
+    /******************************************************************************
+     * Parameter Parsing
+     ******************************************************************************/
+    try
+    {
+        // Declare the supported options.
+        po::options_description desc( "OpenCL sort command line options" );
+        desc.add_options()
+            ( "help,h",         "produces this help message" )
+            ( "version",        "Print queryable version information from the Bolt CL library" )
+            ( "queryOpenCL,q",  "Print queryable platform and device info and return" )
+            ( "gpu,g",          "Report only OpenCL GPU devices" )
+            ( "cpu,c",          "Report only OpenCL CPU devices" )
+            ( "all,a",          "Report all OpenCL devices" )
+            ( "hostMemory,m",   "Allocate vectors in host memory, otherwise device memory" )
+            ( "platform,p",     po::value< cl_uint >( &userPlatform )->default_value( 0 ),
+                "Specify the platform under test using the index reported by -q flag" )
+            ( "device,d",       po::value< cl_uint >( &userDevice )->default_value( 0 ),
+                "Specify the device under test using the index reported by the -q flag.  "
+                    "Index is relative with respect to -g, -c or -a flags" )
+            ;
+
+        po::variables_map vm;
+        po::store( po::parse_command_line( argc, argv, desc ), vm );
+        po::notify( vm );
+
+        if( vm.count( "version" ) )
+        {
+            cl_uint libMajor, libMinor, libPatch;
+            bolt::cl::getVersion( libMajor, libMinor, libPatch );
+
+            const int indent = countOf( "Bolt version: " );
+            bolt::tout << std::left << std::setw( indent ) << _T( "Bolt version: " )
+                << libMajor << _T( "." )
+                << libMinor << _T( "." )
+                << libPatch << std::endl;
+        }
+
+        if( vm.count( "help" ) )
+        {
+            //  This needs to be 'cout' as program-options does not support wcout yet
+            std::cout << desc << std::endl;
+            return 0;
+        }
+
+        if( vm.count( "queryOpenCL" ) )
+        {
+            print_clInfo = true;
+        }
+
+        if( vm.count( "gpu" ) )
+        {
+            deviceType  = CL_DEVICE_TYPE_GPU;
+        }
+        
+        if( vm.count( "cpu" ) )
+        {
+            deviceType  = CL_DEVICE_TYPE_CPU;
+        }
+
+        if( vm.count( "all" ) )
+        {
+            deviceType  = CL_DEVICE_TYPE_ALL;
+        }
+
+        if( vm.count( "hostMemory" ) )
+        {
+            hostMemory = true;
+        }
+    }
+    catch( std::exception& e )
+    {
+        std::cout << _T( "Sort Benchmark error condition reported:" ) << std::endl << e.what() << std::endl;
+        return 1;
+    }
+
+    /******************************************************************************
+    * Initialize platforms and devices                                            *
+    * /todo we should move this logic inside of the control class                 *
+    ******************************************************************************/
+    //  Query OpenCL for available platforms
+    cl_int err = CL_SUCCESS;
+
+    // Platform vector contains all available platforms on system
+    std::vector< ::cl::Platform > platforms;
+    bolt::cl::V_OPENCL( ::cl::Platform::get( &platforms ), "Platform::get() failed" );
+
+    // Device info
+    ::cl::Context myContext = bolt::cl::control::getDefault( ).getContext( );
+    std::vector< cl::Device > devices = myContext.getInfo< CL_CONTEXT_DEVICES >();
+
+    ::cl::CommandQueue myQueue( myContext, devices.at( userDevice ) , CL_QUEUE_PROFILING_ENABLE);
+    ctrl.setCommandQueue( myQueue );
+    std::string strDeviceName = ctrl.getDevice( ).getInfo< CL_DEVICE_NAME >( &err );
+    bolt::cl::V_OPENCL( err, "Device::getInfo< CL_DEVICE_NAME > failed" );
+
+    std::cout << "Device under test : " << strDeviceName << std::endl;
+
+    if( print_clInfo )
+    {
+        bolt::cl::control::printPlatforms( true, deviceType );
+        return 0;
+    }
+
+    int retVal = RUN_ALL_TESTS( );
+
+    //  Reflection code to inspect how many tests failed in gTest
+    ::testing::UnitTest& unitTest = *::testing::UnitTest::GetInstance( );
+
+    unsigned int failedTests = 0;
+    for( int i = 0; i < unitTest.total_test_case_count( ); ++i )
+    {
+        const ::testing::TestCase& testCase = *unitTest.GetTestCase( i );
+        for( int j = 0; j < testCase.total_test_count( ); ++j )
+        {
+            const ::testing::TestInfo& testInfo = *testCase.GetTestInfo( j );
+            if( testInfo.result( )->Failed( ) )
+                ++failedTests;
+        }
+    }
+
+    //  Print helpful message at termination if we detect errors, to help users figure out what to do next
+    if( failedTests )
+    {
+        bolt::tout << _T( "\nFailed tests detected in test pass; please run test again with:" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_filter=<XXX> to select a specific failing test of interest" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_catch_exceptions=0 to generate minidump of failing test, or" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_break_on_failure to debug interactively with debugger" ) << std::endl;
+        bolt::tout << _T( "\t    (only on googletest assertion failures, not SEH exceptions)" ) << std::endl;
+    }
+
+    return retVal;
+}
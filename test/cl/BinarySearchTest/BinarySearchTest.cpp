@@ -38,6 +38,9 @@
 #include <bolt/miniDump.h>
 //#include <bolt/unicode.h>
 #include <bolt/cl/functional.h>
+#if defined( ENABLE_TBB )
+#include "bolt/btbb/binary_search.h"
+#endif
 
 #include <boost/shared_array.hpp>
 #include <array>
@@ -2820,6 +2823,45 @@ TEST (rawArrayTest, floatarray){
 }
 #endif
 
+#if defined( ENABLE_TBB )
+//  Many queries into one table, in random order and then sorted, against the std searches
+TEST( MultiCoreCPU, BatchedSearches )
+{
+    int length = ( 1 << 20 ) + 7, numValues = ( 1 << 18 ) + 3;
+    std::vector< int > table( length ), values( numValues );
+    for( int i = 0; i < length; i++ )
+        table[ i ] = rand( ) % ( 2 * length );
+    std::sort( table.begin( ), table.end( ), std::greater< int >( ) );
+    for( int i = 0; i < numValues; i++ )
+        values[ i ] = rand( ) % ( 2 * length + 2 ) - 1;
+
+    for( int sorted = 0; sorted < 2; sorted++ )
+    {
+        if( sorted )
+            std::sort( values.begin( ), values.end( ), std::greater< int >( ) );
+
+        std::vector< size_t > lower( numValues ), upper( numValues );
+        std::vector< int > found( numValues );
+        bolt::btbb::lower_bound( table.begin( ), table.end( ), values.begin( ), values.end( ), lower.begin( ),
+                                 std::greater< int >( ) );
+        bolt::btbb::upper_bound( table.begin( ), table.end( ), values.begin( ), values.end( ), upper.begin( ),
+                                 std::greater< int >( ) );
+        bolt::btbb::binary_search( table.begin( ), table.end( ), values.begin( ), values.end( ), found.begin( ),
+                                   std::greater< int >( ) );
+
+        for( int i = 0; i < numValues; i++ )
+        {
+            EXPECT_EQ( static_cast< size_t >( std::lower_bound( table.begin( ), table.end( ), values[ i ],
+                       std::greater< int >( ) ) - table.begin( ) ), lower[ i ] ) << "Where i = " << i;
+            EXPECT_EQ( static_cast< size_t >( std::upper_bound( table.begin( ), table.end( ), values[ i ],
+                       std::greater< int >( ) ) - table.begin( ) ), upper[ i ] ) << "Where i = " << i;
+            EXPECT_EQ( std::binary_search( table.begin( ), table.end( ), values[ i ], std::greater< int >( ) ),
+                       found[ i ] != 0 ) << "Where i = " << i;
+        }
+    }
+}
+#endif
+
 int main(int argc, char* argv[])
 {
     ::testing::InitGoogleTest( &argc, &argv[ 0 ] );
@@ -21,6 +21,7 @@
 #include <array>
 
 #include "bolt/cl/control.h"
+#include "bolt/cl/cost_model.h"
 #include "bolt/cl/functional.h"
 #include "bolt/cl/device_vector.h"
 #include "bolt/cl/scan.h"
@@ -31,6 +32,7 @@
 
 #include <gtest/gtest.h>
 #include <boost/program_options.hpp>
+#include <boost/thread/thread.hpp>
 namespace po = boost::program_options;
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -176,6 +178,8 @@ public:
 
     virtual void TearDown( )
     {
+        //  The copy shares the buffer pool of the default control
+        myControl.freeBuffers( );
     };
 
 protected:
@@ -194,7 +198,7 @@ TEST_F( ReferenceControlTest, zeroMemory )
     myControl.acquireBuffer( 100 * sizeof( int ) );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 400, internalBuffSize );
+    EXPECT_EQ( 512, internalBuffSize );
 
     myControl.freeBuffers( );
     internalBuffSize = myControl.totalBufferSize( );
@@ -208,7 +212,7 @@ TEST_F( ReferenceControlTest, acquire1Buffer )
     EXPECT_EQ( 1, myRefCount );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 400, internalBuffSize );
+    EXPECT_EQ( 512, internalBuffSize );
 }
 
 TEST_F( ReferenceControlTest, acquire1BufferReleaseAcquireSame )
@@ -223,7 +227,7 @@ TEST_F( ReferenceControlTest, acquire1BufferReleaseAcquireSame )
     EXPECT_EQ( 1, myRefCount );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 400, internalBuffSize );
+    EXPECT_EQ( 512, internalBuffSize );
 }
 
 TEST_F( ReferenceControlTest, acquire1BufferReleaseAcquireSmaller )
@@ -238,7 +242,7 @@ TEST_F( ReferenceControlTest, acquire1BufferReleaseAcquireSmaller )
     EXPECT_EQ( 1, myRefCount );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 400, internalBuffSize );
+    EXPECT_EQ( 512, internalBuffSize );
 }
 
 TEST_F( ReferenceControlTest, acquire1BufferReleaseAcquireBigger )
@@ -253,7 +257,7 @@ TEST_F( ReferenceControlTest, acquire1BufferReleaseAcquireBigger )
     EXPECT_EQ( 1, myRefCount );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 404, internalBuffSize );
+    EXPECT_EQ( 512, internalBuffSize );
 }
 
 TEST_F( ReferenceControlTest, acquire2BufferEqual )
@@ -267,7 +271,7 @@ TEST_F( ReferenceControlTest, acquire2BufferEqual )
     EXPECT_EQ( 1, myRefCount2 );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 800, internalBuffSize );
+    EXPECT_EQ( 1024, internalBuffSize );
 }
 
 TEST_F( ReferenceControlTest, acquire2BufferBigger )
@@ -281,7 +285,7 @@ TEST_F( ReferenceControlTest, acquire2BufferBigger )
     EXPECT_EQ( 1, myRefCount2 );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 804, internalBuffSize );
+    EXPECT_EQ( 1024, internalBuffSize );
 }
 
 TEST_F( ReferenceControlTest, acquire2BufferSmaller )
@@ -295,7 +299,7 @@ TEST_F( ReferenceControlTest, acquire2BufferSmaller )
     EXPECT_EQ( 1, myRefCount2 );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 796, internalBuffSize );
+    EXPECT_EQ( 1024, internalBuffSize );
 }
 
 TEST_F( CopyControlTest, init )
@@ -310,7 +314,7 @@ TEST_F( CopyControlTest, zeroMemory )
     myControl.acquireBuffer( 100 * sizeof( int ) );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 400, internalBuffSize );
+    EXPECT_EQ( 512, internalBuffSize );
 
     myControl.freeBuffers( );
     internalBuffSize = myControl.totalBufferSize( );
@@ -324,7 +328,7 @@ TEST_F( CopyControlTest, acquire1Buffer )
     EXPECT_EQ( 1, myRefCount );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 400, internalBuffSize );
+    EXPECT_EQ( 512, internalBuffSize );
 }
 
 TEST_F( CopyControlTest, acquire1BufferReleaseAcquireSame )
@@ -339,7 +343,7 @@ TEST_F( CopyControlTest, acquire1BufferReleaseAcquireSame )
     EXPECT_EQ( 1, myRefCount );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 400, internalBuffSize );
+    EXPECT_EQ( 512, internalBuffSize );
 }
 
 TEST_F( CopyControlTest, acquire1BufferReleaseAcquireSmaller )
@@ -354,7 +358,7 @@ TEST_F( CopyControlTest, acquire1BufferReleaseAcquireSmaller )
     EXPECT_EQ( 1, myRefCount );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 400, internalBuffSize );
+    EXPECT_EQ( 512, internalBuffSize );
 }
 
 TEST_F( CopyControlTest, acquire1BufferReleaseAcquireBigger )
@@ -369,7 +373,7 @@ TEST_F( CopyControlTest, acquire1BufferReleaseAcquireBigger )
     EXPECT_EQ( 1, myRefCount );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 404, internalBuffSize );
+    EXPECT_EQ( 512, internalBuffSize );
 }
 
 TEST_F( CopyControlTest, acquire2BufferEqual )
@@ -383,7 +387,7 @@ TEST_F( CopyControlTest, acquire2BufferEqual )
     EXPECT_EQ( 1, myRefCount2 );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 800, internalBuffSize );
+    EXPECT_EQ( 1024, internalBuffSize );
 }
 
 TEST_F( CopyControlTest, acquire2BufferBigger )
@@ -397,7 +401,7 @@ TEST_F( CopyControlTest, acquire2BufferBigger )
     EXPECT_EQ( 1, myRefCount2 );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 804, internalBuffSize );
+    EXPECT_EQ( 1024, internalBuffSize );
 }
 
 TEST_F( CopyControlTest, acquire2BufferSmaller )
@@ -411,7 +415,7 @@ TEST_F( CopyControlTest, acquire2BufferSmaller )
     EXPECT_EQ( 1, myRefCount2 );
 
     size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 796, internalBuffSize );
+    EXPECT_EQ( 1024, internalBuffSize );
 }
 
 TEST_F( CopyControlTest, ScanIntegerVector )
@@ -424,13 +428,310 @@ TEST_F( CopyControlTest, ScanIntegerVector )
 
     bolt::cl::inclusive_scan( myControl, boltInput1.begin( ), boltInput1.end( ), boltInput1.begin( ) );
     cmpArrays( stdInput, boltInput1 );
+    size_t internalBuffSize = myControl.totalBufferSize( );
 
+    //  The second scan runs entirely on the buffers the first one released, its functor buffer included
     bolt::cl::inclusive_scan( myControl, boltInput2.begin( ), boltInput2.end( ), boltInput2.begin( ) );
     cmpArrays( stdInput, boltInput2 );
 
-    size_t internalBuffSize = myControl.totalBufferSize( );
-    EXPECT_EQ( 2049, internalBuffSize );
+    EXPECT_EQ( internalBuffSize, myControl.totalBufferSize( ) );
+}
+
+TEST_F( CopyControlTest, poolStatistics )
+{
+    bolt::cl::BufferPool& pool = myControl.getBufferPool( );
+    pool.resetStatistics( );
+
+    bolt::cl::control::buffPointer myBuff1 = myControl.acquireBuffer( 100 * sizeof( int ) );
+    bolt::cl::control::buffPointer myBuff2 = myControl.acquireBuffer( 1000 * sizeof( int ) );
+
+    bolt::cl::BufferPool::statistics stats = pool.getStatistics( );
+    EXPECT_EQ( 0, stats.hits );
+    EXPECT_EQ( 2, stats.misses );
+    EXPECT_EQ( 512 + 4096, stats.bytesHeld );
+    EXPECT_EQ( 512 + 4096, stats.bytesInUse );
+
+    myBuff1.reset( );
+    myBuff2.reset( );
+
+    //  Both requests fall in the size class of a released buffer
+    myBuff1 = myControl.acquireBuffer( 700 * sizeof( int ) );
+    myBuff2 = myControl.acquireBuffer( 80 * sizeof( int ) );
+
+    stats = pool.getStatistics( );
+    EXPECT_EQ( 2, stats.hits );
+    EXPECT_EQ( 2, stats.misses );
+    EXPECT_EQ( 512 + 4096, stats.bytesHeld );
+    EXPECT_EQ( 4096, myBuff1->getInfo< CL_MEM_SIZE >( ) );
+    EXPECT_EQ( 512, myBuff2->getInfo< CL_MEM_SIZE >( ) );
+
+    myBuff1.reset( );
+    myBuff2.reset( );
+    EXPECT_EQ( 0, pool.getStatistics( ).bytesInUse );
+}
+
+TEST_F( CopyControlTest, poolFlagsAreSeparate )
+{
+    myControl.getBufferPool( ).resetStatistics( );
+
+    bolt::cl::control::buffPointer myBuff = myControl.acquireBuffer( 100 * sizeof( int ), CL_MEM_READ_ONLY );
+    myBuff.reset( );
+
+    myBuff = myControl.acquireBuffer( 100 * sizeof( int ), CL_MEM_WRITE_ONLY );
+    EXPECT_EQ( 1024, myControl.totalBufferSize( ) );
+    EXPECT_EQ( 2, myControl.getBufferPool( ).getStatistics( ).misses );
+}
+
+TEST_F( CopyControlTest, poolMaxSizeTrimsLeastRecentlyUsed )
+{
+    bolt::cl::BufferPool& pool = myControl.getBufferPool( );
+    const size_t maxSize = pool.getMaxSize( );
+    pool.resetStatistics( );
+    pool.setMaxSize( 2048 );
+
+    bolt::cl::control::buffPointer myBuff1 = myControl.acquireBuffer( 1024 );
+    bolt::cl::control::buffPointer myBuff2 = myControl.acquireBuffer( 256 );
+    myBuff1.reset( );
+    myBuff2.reset( );
+    EXPECT_EQ( 1280, myControl.totalBufferSize( ) );
+
+    //  Room for the new buffer is made by freeing the 1024 byte buffer, which was released first
+    myBuff1 = myControl.acquireBuffer( 1024, CL_MEM_READ_ONLY );
+    bolt::cl::BufferPool::statistics stats = pool.getStatistics( );
+    EXPECT_EQ( 1, stats.evictions );
+    EXPECT_EQ( 1280, stats.bytesHeld );
+
+    //  Buffers in use are never freed
+    myBuff2 = myControl.acquireBuffer( 4096 );
+    EXPECT_EQ( 1024 + 4096, myControl.totalBufferSize( ) );
+
+    myBuff1.reset( );
+    myBuff2.reset( );
+    pool.setMaxSize( 0 );
+    EXPECT_EQ( 0, myControl.totalBufferSize( ) );
+
+    pool.setMaxSize( maxSize );
+}
+
+TEST_F( CopyControlTest, poolFunctorBuffer )
+{
+    myControl.getBufferPool( ).resetStatistics( );
+
+    bolt::cl::plus< int > functor;
+    for( int i = 0; i < 4; ++i )
+    {
+        bolt::cl::control::buffPointer userFunctor = myControl.acquireBuffer( sizeof( functor ),
+            CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, &functor );
+    }
+
+    bolt::cl::BufferPool::statistics stats = myControl.getBufferPool( ).getStatistics( );
+    EXPECT_EQ( 3, stats.hits );
+    EXPECT_EQ( 1, stats.misses );
+    EXPECT_EQ( 256, stats.bytesHeld );
+}
+
+TEST_F( CopyControlTest, poolSharedByContext )
+{
+    //  Copies, and controls made for the same command queue, reuse each other's buffers
+    bolt::cl::control::buffPointer myBuff = myControl.acquireBuffer( 100 * sizeof( int ) );
+    myBuff.reset( );
+
+    bolt::cl::control copyControl( myControl );
+    bolt::cl::control queueControl( myControl.getCommandQueue( ) );
+    EXPECT_EQ( &myControl.getBufferPool( ), &copyControl.getBufferPool( ) );
+    EXPECT_EQ( &myControl.getBufferPool( ), &queueControl.getBufferPool( ) );
+    EXPECT_EQ( &bolt::cl::control::getDefault( ).getBufferPool( ), &queueControl.getBufferPool( ) );
+
+    myControl.getBufferPool( ).resetStatistics( );
+    myBuff = queueControl.acquireBuffer( 100 * sizeof( int ) );
+    EXPECT_EQ( 1, myControl.getBufferPool( ).getStatistics( ).hits );
+    EXPECT_EQ( 512, myControl.totalBufferSize( ) );
+}
+
+//  Acquires and releases buffers of a few sizes, through a control of its own
+struct acquireLoop
+{
+    const bolt::cl::control* parent;
+
+    void operator( )( ) const
+    {
+        bolt::cl::control threadControl( *parent );
+        for( int i = 0; i < 1000; ++i )
+        {
+            bolt::cl::control::buffPointer myBuff1 = threadControl.acquireBuffer( ( i % 4 + 1 ) * 1024 );
+            bolt::cl::control::buffPointer myBuff2 = threadControl.acquireBuffer( 100 * sizeof( int ) );
+        }
+    }
+};
+
+TEST_F( CopyControlTest, poolManyThreads )
+{
+    bolt::cl::BufferPool& pool = myControl.getBufferPool( );
+    pool.resetStatistics( );
+
+    acquireLoop loop = { &myControl };
+    boost::thread_group threads;
+    for( int t = 0; t < 8; ++t )
+        threads.create_thread( loop );
+    threads.join_all( );
+
+    //  Every thread needs no more than four buffers at a time, and finds them in the pool after the first round
+    bolt::cl::BufferPool::statistics stats = pool.getStatistics( );
+    EXPECT_EQ( 16000, stats.hits + stats.misses );
+    EXPECT_GE( 8 * 4, stats.misses );
+    EXPECT_EQ( 0, stats.bytesInUse );
+}
+
+TEST_F( CopyControlTest, waitModesAgree )
+{
+    std::vector< int > stdInput( 4096, 1 );
+    std::partial_sum( stdInput.begin( ), stdInput.end( ), stdInput.begin( ) );
+
+    const bolt::cl::control::e_WaitMode modes[ ] = { bolt::cl::control::BalancedWait, bolt::cl::control::NiceWait,
+                                                     bolt::cl::control::BusyWait, bolt::cl::control::ClFinish };
+    for( size_t m = 0; m < countOf( modes ); ++m )
+    {
+        myControl.setWaitMode( modes[ m ] );
+        bolt::cl::device_vector< int > boltInput( 4096, 1 );
+        bolt::cl::inclusive_scan( myControl, boltInput.begin( ), boltInput.end( ), boltInput.begin( ) );
+        cmpArrays( stdInput, boltInput );
+    }
+}
+
+TEST_F( CopyControlTest, balancedWaitStatistics )
+{
+    myControl.setWaitMode( bolt::cl::control::BalancedWait );
+    myControl.setForceRunMode( bolt::cl::control::OpenCL );
+    bolt::cl::resetWaitStatistics( );
+
+    std::vector< int > stdInput( 1 << 16, 1 );
+    std::partial_sum( stdInput.begin( ), stdInput.end( ), stdInput.begin( ) );
+    for( int i = 0; i < 16; ++i )
+    {
+        bolt::cl::device_vector< int > boltInput( 1 << 16, 1 );
+        bolt::cl::inclusive_scan( myControl, boltInput.begin( ), boltInput.end( ), boltInput.begin( ) );
+        cmpArrays( stdInput, boltInput );
+    }
+
+    //  Every wait either saw its command complete while spinning or blocked until the callback woke it
+    bolt::cl::waitStatistics stats = bolt::cl::getWaitStatistics( );
+    EXPECT_LE( 16u, stats.waits );
+    EXPECT_EQ( stats.waits, stats.spinCompletions + stats.blockingWaits );
+    EXPECT_GE( stats.wakeupNanoseconds, stats.maxWakeupNanoseconds );
+    if( stats.blockingWaits == 0 )
+        EXPECT_EQ( 0u, stats.wakeupNanoseconds );
+
+    bolt::cl::resetWaitStatistics( );
+    stats = bolt::cl::getWaitStatistics( );
+    EXPECT_EQ( 0u, stats.waits );
+    EXPECT_EQ( 0u, stats.spinNanoseconds );
+}
+
+//  A device that launches slowly but streams fast, behind a slow bus
+bolt::cl::cost_model::profile slowBusProfile( )
+{
+    bolt::cl::cost_model::profile p;
+    p.serialBytesPerSecond = 1e9;
+    p.multicoreSecondsPerCall = 1e-3;
+    p.multicoreBytesPerSecond = 4e9;
+    p.openclSecondsPerCall = 1e-4;
+    p.openclBytesPerSecond = 1e11;
+    p.transferBytesPerSecond = 1e9;
+    p.hostUnifiedMemory = false;
+    return p;
+}
+
+TEST_F( CopyControlTest, costModelFollowsSizeAndLocation )
+{
+    bolt::cl::cost_model& model = bolt::cl::cost_model::getInstance( );
+    model.setProfile( myControl.getDevice( ), slowBusProfile( ) );
+
+    //  Few elements run serially; nothing else pays off its cost per call
+    bolt::cl::cost_model::estimate small = model.choose( myControl, 1000, sizeof( int ),
+        bolt::cl::cost_model::HostData, bolt::cl::cost_model::Linear, true );
+    EXPECT_EQ( bolt::cl::control::SerialCpu, small.runMode );
+
+    //  Many elements in host memory stay on the host, because copying them costs more than the device saves
+    bolt::cl::cost_model::estimate host = model.choose( myControl, 1 << 24, sizeof( int ),
+        bolt::cl::cost_model::HostData, bolt::cl::cost_model::Linear, true );
+    EXPECT_EQ( bolt::cl::control::MultiCoreCpu, host.runMode );
+    EXPECT_LT( host.multicoreSeconds, host.openclSeconds );
+
+    //  The same elements in a device_vector run on the device, and without TBB on the host serially at worst
+    bolt::cl::cost_model::estimate device = model.choose( myControl, 1 << 24, sizeof( int ),
+        bolt::cl::cost_model::DeviceData, bolt::cl::cost_model::Linear, true );
+    EXPECT_EQ( bolt::cl::control::OpenCL, device.runMode );
+
+    bolt::cl::cost_model::estimate noTbb = model.choose( myControl, 1 << 24, sizeof( int ),
+        bolt::cl::cost_model::HostData, bolt::cl::cost_model::Linear, false );
+    EXPECT_NE( bolt::cl::control::MultiCoreCpu, noTbb.runMode );
+
+    //  A sort does more work per element than a reduce over the same range
+    bolt::cl::cost_model::estimate sorted = model.choose( myControl, 1 << 24, sizeof( int ),
+        bolt::cl::cost_model::DeviceData, bolt::cl::cost_model::NLogN, true );
+    EXPECT_GT( sorted.serialSeconds, device.serialSeconds );
+}
+
+TEST_F( CopyControlTest, costModelProfileRoundTrip )
+{
+    bolt::cl::cost_model& model = bolt::cl::cost_model::getInstance( );
+    model.setProfile( myControl.getDevice( ), slowBusProfile( ) );
+
+    const std::string path = "bolt_cost_profile.test.txt";
+    ASSERT_TRUE( model.saveProfiles( path ) );
+
+    bolt::cl::cost_model::profile other = slowBusProfile( );
+    other.openclSecondsPerCall = 1.0;
+    model.setProfile( myControl.getDevice( ), other );
+    ASSERT_TRUE( model.loadProfiles( path ) );
+    std::remove( path.c_str( ) );
+
+    bolt::cl::cost_model::profile loaded = model.getProfile( myControl );
+    EXPECT_DOUBLE_EQ( slowBusProfile( ).openclSecondsPerCall, loaded.openclSecondsPerCall );
+    EXPECT_DOUBLE_EQ( slowBusProfile( ).transferBytesPerSecond, loaded.transferBytesPerSecond );
+    EXPECT_FALSE( loaded.hostUnifiedMemory );
+}
+
+TEST_F( CopyControlTest, automaticRunModeScan )
+{
+    myControl.setForceRunMode( bolt::cl::control::Automatic );
+
+    for( size_t length = 16; length <= ( 1 << 20 ); length <<= 4 )
+    {
+        std::vector< int > stdInput( length, 1 );
+        std::vector< int > hostInput( length, 1 );
+        bolt::cl::device_vector< int > boltInput( length, 1 );
+        std::partial_sum( stdInput.begin( ), stdInput.end( ), stdInput.begin( ) );
+
+        bolt::cl::inclusive_scan( myControl, hostInput.begin( ), hostInput.end( ), hostInput.begin( ) );
+        bolt::cl::inclusive_scan( myControl, boltInput.begin( ), boltInput.end( ), boltInput.begin( ) );
+        cmpArrays( stdInput, hostInput );
+        cmpArrays( stdInput, boltInput );
+    }
+}
+
+#if defined( ENABLE_TBB )
+TEST_F( CopyControlTest, cpuConcurrencyOnNumaNode )
+{
+    myControl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+
+    //  Node 0 exists on every machine, and a node that does not exist falls back to an arena without constraints
+    const int numaNodes[ ] = { 0, 1 << 20, bolt::btbb::arena::anyNumaNode };
+    for( size_t n = 0; n < countOf( numaNodes ); ++n )
+    {
+        myControl.setCpuConcurrency( 2, numaNodes[ n ] );
+        EXPECT_EQ( numaNodes[ n ], bolt::btbb::arena::getInstance( ).getNumaNode( ) );
+
+        std::vector< int > stdInput( 1 << 20, 1 );
+        std::vector< int > boltInput( 1 << 20, 1 );
+        std::partial_sum( stdInput.begin( ), stdInput.end( ), stdInput.begin( ) );
+        bolt::cl::inclusive_scan( myControl, boltInput.begin( ), boltInput.end( ), boltInput.begin( ) );
+        cmpArrays( stdInput, boltInput );
+    }
+
+    myControl.setCpuConcurrency( bolt::btbb::arena::automatic );
 }
+#endif
 
 int _tmain(int argc, _TCHAR* argv[])
 {
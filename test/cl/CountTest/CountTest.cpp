@@ -29,6 +29,9 @@
 #include "bolt/miniDump.h"
 #include "bolt/unicode.h"
 #include "bolt/cl/device_vector.h"
+#if defined( ENABLE_TBB )
+#include "bolt/btbb/simd_reduce.h"
+#endif
 
 #include <gtest/gtest.h>
 #include <boost/shared_array.hpp>
@@ -1154,6 +1157,38 @@ TEST (sanity_count_if_testCountIfIntWithStdVector3, EPR400650_400651){
 	EXPECT_EQ (stdCount, boltCount);
 }
 
+#if defined( ENABLE_TBB )
+TEST(countSimd, EveryLevel)
+{
+  const size_t lengths[] = { 1, 15, 16, 63, 64, 65, 100003 };
+  bolt::cl::control ctl;
+  ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+
+  for( int level = bolt::btbb::simd::scalar; level <= bolt::btbb::simd::supportedLevel( ); ++level )
+  {
+    bolt::btbb::simd::setLevel( static_cast< bolt::btbb::simd::level >( level ) );
+    for( size_t l = 0; l < sizeof( lengths ) / sizeof( lengths[ 0 ] ); ++l )
+    {
+      std::vector< int > ints( lengths[ l ] );
+      std::vector< float > floats( lengths[ l ] );
+      for( size_t i = 0; i < lengths[ l ]; ++i )
+      {
+        ints[ i ] = rand( ) % 10;
+        floats[ i ] = static_cast< float >( rand( ) % 10 ) * 0.5f;
+      }
+      bolt::cl::device_vector< float > dvFloats( floats.begin( ), floats.end( ) );
+
+      EXPECT_EQ( std::count( ints.begin( ), ints.end( ), 3 ), bolt::cl::count( ctl, ints.begin( ), ints.end( ), 3 ) );
+      EXPECT_EQ( std::count( floats.begin( ), floats.end( ), 1.5f ),
+                 bolt::cl::count( ctl, floats.begin( ), floats.end( ), 1.5f ) );
+      EXPECT_EQ( std::count( floats.begin( ), floats.end( ), 1.5f ),
+                 bolt::cl::count( ctl, dvFloats.begin( ), dvFloats.end( ), 1.5f ) );
+    }
+  }
+  bolt::btbb::simd::setLevel( bolt::btbb::simd::supportedLevel( ) );
+}
+#endif
+
 int main(int argc, char* argv[])
 {
     ::testing::InitGoogleTest( &argc, &argv[ 0 ] );
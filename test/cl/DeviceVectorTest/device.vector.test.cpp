@@ -823,6 +823,83 @@ TEST( Vector, ShrinkToFit)
 #endif
 }
 
+TEST( Vector, PushBackGrowsGeometrically )
+{
+    bolt::cl::device_vector< int > dV;
+
+    //  The capacity at least doubles whenever it is exhausted
+    size_t reallocations = 0;
+    for( int i = 0; i < 1000; ++i )
+    {
+        size_t capacity = dV.capacity( );
+        dV.push_back( i );
+        if( dV.capacity( ) != capacity )
+        {
+            ++reallocations;
+            EXPECT_LE( 2 * capacity, dV.capacity( ) );
+        }
+    }
+    EXPECT_GE( 11u, reallocations );
+
+    EXPECT_EQ( 1000, dV.size( ) );
+    bolt::cl::device_vector< int >::const_host_view view( dV );
+    for( int i = 0; i < 1000; ++i )
+        EXPECT_EQ( i, view[ i ] );
+}
+
+TEST( Vector, ResizeKeepsCapacity )
+{
+    bolt::cl::device_vector< int > dV( 100, 3 );
+    dV.resize( 10 );
+    EXPECT_EQ( 10, dV.size( ) );
+    EXPECT_EQ( 100, dV.capacity( ) );
+
+    //  Growing within the capacity initializes the new elements
+    dV.resize( 50, 7 );
+    EXPECT_EQ( 100, dV.capacity( ) );
+    for( int i = 0; i < 50; ++i )
+        EXPECT_EQ( i < 10 ? 3 : 7, dV[ i ] );
+}
+
+TEST( Vector, Append )
+{
+    std::vector< int > sV( 1000 );
+    for( int i = 0; i < 1000; ++i )
+        sV[ i ] = i;
+
+    bolt::cl::device_vector< int > dV( 10, -1 );
+    dV.append( sV.begin( ), sV.end( ) );
+    dV.append( sV.begin( ), sV.begin( ) );
+    dV.insert( dV.cend( ), sV.begin( ), sV.begin( ) + 5 );
+    EXPECT_EQ( 1015, dV.size( ) );
+
+    bolt::cl::device_vector< int >::const_host_view view( dV );
+    for( int i = 0; i < 1015; ++i )
+        EXPECT_EQ( i < 10 ? -1 : ( i < 1010 ? i - 10 : i - 1010 ), view[ i ] );
+}
+
+TEST( DeviceVector, Move )
+{
+    bolt::cl::device_vector< int > dV( 100, 3 );
+    ::cl::Buffer buffer = dV.getBuffer( );
+
+    //  The buffer is taken over, not copied
+    bolt::cl::device_vector< int > moved( std::move( dV ) );
+    EXPECT_EQ( 100, moved.size( ) );
+    EXPECT_EQ( 0, dV.size( ) );
+    EXPECT_TRUE( moved.getBuffer( )( ) == buffer( ) );
+
+    bolt::cl::device_vector< int > assigned( 5, 1 );
+    assigned = std::move( moved );
+    EXPECT_EQ( 100, assigned.size( ) );
+    EXPECT_EQ( 0, moved.size( ) );
+    EXPECT_TRUE( assigned.getBuffer( )( ) == buffer( ) );
+    EXPECT_EQ( 3, assigned[ 99 ] );
+
+    dV.push_back( 4 );
+    EXPECT_EQ( 4, dV[ 0 ] );
+}
+
 TEST( Vector, DataRoutine )
 {
     std::vector<int>a( 100 );
@@ -1333,6 +1410,122 @@ TEST_P(FillUDDIntVector, VariableAssignInt)
 
 INSTANTIATE_TEST_CASE_P( VariableSizeResizeWithValues, FillUDDIntVector, ::testing::Range( 0, 1048576, 4096 ) );
 
+TEST( HostView, ReadWrite )
+{
+    bolt::cl::device_vector< int > dV( 1000, 3 );
+    {
+        bolt::cl::device_vector< int >::host_view view( dV );
+        EXPECT_EQ( 1000, view.size( ) );
+        EXPECT_EQ( 3000, std::accumulate( view.begin( ), view.end( ), 0 ) );
+
+        for( size_t i = 0; i < view.size( ); ++i )
+            view[ i ] = i;
+    }
+
+    for( int i = 0; i < 1000; i += 111 )
+        EXPECT_EQ( i, dV[ i ] );
+}
+
+TEST( HostView, WriteInvalidateSubRange )
+{
+    bolt::cl::device_vector< int > dV( 100, 3 );
+    {
+        bolt::cl::device_vector< int >::host_view view( dV, 10, 20, bolt::cl::MapWriteInvalidate );
+        EXPECT_EQ( 20, view.size( ) );
+        std::fill( view.begin( ), view.end( ), 7 );
+    }
+
+    bolt::cl::device_vector< int >::const_host_view view( dV );
+    for( size_t i = 0; i < view.size( ); ++i )
+        EXPECT_EQ( ( i >= 10 && i < 30 ) ? 7 : 3, view[ i ] );
+}
+
+TEST( HostView, ReferencesUseTheView )
+{
+    bolt::cl::device_vector< int > dV( 100, 3 );
+    {
+        bolt::cl::device_vector< int >::host_view view( dV, 50, 50 );
+
+        //  Elements inside the view are accessed through it, the others are mapped one by one
+        for( int i = 0; i < 100; ++i )
+            dV[ i ] = i;
+
+        EXPECT_EQ( 75, view[ 25 ] );
+        EXPECT_EQ( 75, dV[ 75 ] );
+        EXPECT_EQ( 25, dV[ 25 ] );
+
+        const bolt::cl::device_vector< int >& cdV = dV;
+        EXPECT_EQ( 99, cdV[ 99 ] );
+        EXPECT_EQ( 99, *( dV.end( ) - 1 ) );
+    }
+
+    for( int i = 0; i < 100; ++i )
+        EXPECT_EQ( i, dV[ i ] );
+}
+
+TEST( HostView, EmptyAndOutOfRange )
+{
+    bolt::cl::device_vector< int > dV( 10, 3 );
+
+    bolt::cl::device_vector< int >::host_view empty( dV, 10, 0 );
+    EXPECT_EQ( 0, empty.size( ) );
+    EXPECT_TRUE( empty.begin( ) == empty.end( ) );
+
+    EXPECT_THROW( bolt::cl::device_vector< int >::host_view view( dV, 5, 6 ), ::cl::Error );
+}
+
+TEST( HostView, UnmapEarly )
+{
+    bolt::cl::device_vector< int > dV( 10, 3 );
+    bolt::cl::device_vector< int >::host_view view( dV, bolt::cl::MapWrite );
+    view[ 0 ] = 5;
+    view.unmap( );
+
+    EXPECT_EQ( 0, view.size( ) );
+    EXPECT_EQ( 5, dV[ 0 ] );
+    dV[ 1 ] = 6;
+    EXPECT_EQ( 6, dV[ 1 ] );
+}
+
+TEST( HostAllocator, PageAlignedResizeAndReserve )
+{
+    bolt::cl::device_vector< int > dV( 100, 3, bolt::cl::host_allocator::pageAligned( ) );
+    EXPECT_TRUE( dV.getHostAllocator( ) == bolt::cl::host_allocator::pageAligned( ) );
+    {
+        //  The host paths see the memory of the allocator itself
+        bolt::cl::device_vector< int >::const_host_view view( dV );
+        EXPECT_EQ( 0, reinterpret_cast< size_t >( &view[ 0 ] ) % bolt::cl::page_host_allocator::pageSize( ) );
+    }
+
+    dV.resize( 5000, 7 );
+    dV.reserve( 10000 );
+    EXPECT_EQ( 5000, dV.size( ) );
+    EXPECT_LE( 10000, dV.capacity( ) );
+
+    bolt::cl::device_vector< int >::const_host_view view( dV );
+    for( size_t i = 0; i < view.size( ); ++i )
+        EXPECT_EQ( i < 100 ? 3 : 7, view[ i ] );
+}
+
+TEST( HostAllocator, HugePagesFromRange )
+{
+    std::vector< int > src( 1 << 20 );
+    for( size_t i = 0; i < src.size( ); ++i )
+        src[ i ] = static_cast< int >( i );
+
+    bolt::cl::device_vector< int > dV( src.begin( ), src.end( ), bolt::cl::host_allocator::hugePages( ) );
+    dV.push_back( -1 );
+    src.push_back( -1 );
+
+    //  A copy allocates from the same allocator
+    bolt::cl::device_vector< int > copy( dV );
+    EXPECT_TRUE( copy.getHostAllocator( ) == bolt::cl::host_allocator::hugePages( ) );
+
+    bolt::cl::device_vector< int >::const_host_view view( copy );
+    ASSERT_EQ( src.size( ), view.size( ) );
+    EXPECT_TRUE( std::equal( src.begin( ), src.end( ), view.begin( ) ) );
+}
+
 TEST(BUG, BUG398791)
 {
     int length = 100;
@@ -30,6 +30,9 @@
 #include <bolt/cl/iterator/constant_iterator.h>
 #include <bolt/cl/iterator/counting_iterator.h>
 #include <bolt/miniDump.h>
+#if defined( ENABLE_TBB )
+#include <bolt/btbb/merge_by_key.h>
+#endif
 
 #include <gtest/gtest.h>
 #include <boost/shared_array.hpp>
@@ -439,6 +442,74 @@ TEST(sanity_merge__dev_vect_2, wi_ctrl_floats){
 }
 
 
+//  A long and a short sequence sorted in descending order, so that the whole merge happens in a few places
+TEST(Merge, MultiCoreSkewedGreater)
+{
+    std::vector< int > A( ( 1 << 20 ) + 3 ), B( 100 );
+    for( size_t i = 0; i < A.size( ); i++ )
+        A[ i ] = rand( ) % 1000;
+    for( size_t i = 0; i < B.size( ); i++ )
+        B[ i ] = rand( ) % 1000;
+    std::sort( A.begin( ), A.end( ), std::greater< int >( ) );
+    std::sort( B.begin( ), B.end( ), std::greater< int >( ) );
+
+    std::vector< int > stdmerge( A.size( ) + B.size( ) ), boltmerge( A.size( ) + B.size( ) );
+    std::merge( A.begin( ), A.end( ), B.begin( ), B.end( ), stdmerge.begin( ), std::greater< int >( ) );
+
+    bolt::cl::control ctl;
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+    bolt::cl::merge( ctl, A.begin( ), A.end( ), B.begin( ), B.end( ), boltmerge.begin( ),
+                     bolt::cl::greater< int >( ) );
+    cmpArrays( stdmerge, boltmerge );
+
+    bolt::cl::merge( ctl, B.begin( ), B.end( ), A.begin( ), A.end( ), boltmerge.begin( ),
+                     bolt::cl::greater< int >( ) );
+    std::merge( B.begin( ), B.end( ), A.begin( ), A.end( ), stdmerge.begin( ), std::greater< int >( ) );
+    cmpArrays( stdmerge, boltmerge );
+}
+
+#if defined( ENABLE_TBB )
+//  Few distinct keys, so that the values show whether equivalent keys of the first range stay in front
+TEST(MergeByKey, MultiCoreStable)
+{
+    int length1 = ( 1 << 18 ) + 11, length2 = ( 1 << 17 ) + 5;
+    std::vector< int > keys1( length1 ), keys2( length2 ), values1( length1 ), values2( length2 );
+    for( int i = 0; i < length1; i++ )
+        keys1[ i ] = rand( ) % 50;
+    for( int i = 0; i < length2; i++ )
+        keys2[ i ] = rand( ) % 50;
+    std::sort( keys1.begin( ), keys1.end( ) );
+    std::sort( keys2.begin( ), keys2.end( ) );
+    for( int i = 0; i < length1; i++ )
+        values1[ i ] = i;
+    for( int i = 0; i < length2; i++ )
+        values2[ i ] = length1 + i;
+
+    //  Concatenating both ranges and sorting them stably by key is the stable merge
+    std::vector< std::pair< int, int > > ref;
+    for( int i = 0; i < length1; i++ )
+        ref.push_back( std::make_pair( keys1[ i ], values1[ i ] ) );
+    for( int i = 0; i < length2; i++ )
+        ref.push_back( std::make_pair( keys2[ i ], values2[ i ] ) );
+    std::stable_sort( ref.begin( ), ref.end( ),
+        []( const std::pair< int, int >& l, const std::pair< int, int >& r ) { return l.first < r.first; } );
+
+    std::vector< int > keys( length1 + length2 ), values( length1 + length2 );
+    std::pair< std::vector< int >::iterator, std::vector< int >::iterator > end =
+        bolt::btbb::merge_by_key( keys1.begin( ), keys1.end( ), keys2.begin( ), keys2.end( ),
+                                  values1.begin( ), values2.begin( ), keys.begin( ), values.begin( ) );
+    EXPECT_TRUE( end.first == keys.end( ) );
+    EXPECT_TRUE( end.second == values.end( ) );
+
+    for( int i = 0; i < length1 + length2; i++ )
+    {
+        EXPECT_EQ( ref[ i ].first, keys[ i ] ) << "Where i = " << i;
+        EXPECT_EQ( ref[ i ].second, values[ i ] ) << "Where i = " << i;
+    }
+}
+#endif
+
+
 
 
 int main(int argc, char* argv[])
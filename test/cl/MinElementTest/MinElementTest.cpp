@@ -32,6 +32,9 @@
 #include "bolt/cl/min_element.h"
 #include "bolt/cl/functional.h"
 #include "bolt/cl/control.h"
+#if defined( ENABLE_TBB )
+#include "bolt/btbb/simd_reduce.h"
+#endif
 #include "stdafx.h"
 #include "common/myocl.h"
 #include "common/test_common.h"
@@ -1442,6 +1445,35 @@ void simpleMinele_countingiterator(int start,int size)
 //    EXPECT_EQ(*boltGpuMin,*stdCpuMin);
 //    EXPECT_EQ(*boltCpuMin,*stdCpuMin);
 //}
+#if defined( ENABLE_TBB )
+TEST( Min_Element, SimdEveryLevel )
+{
+  //  Few distinct values, so every extremum has ties and the first of them must be found
+  const size_t lengths[] = { 1, 15, 16, 63, 64, 65, 100003 };
+  bolt::cl::control ctl;
+  ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+
+  for( int level = bolt::btbb::simd::scalar; level <= bolt::btbb::simd::supportedLevel( ); ++level )
+  {
+    bolt::btbb::simd::setLevel( static_cast< bolt::btbb::simd::level >( level ) );
+    for( size_t l = 0; l < sizeof( lengths ) / sizeof( lengths[ 0 ] ); ++l )
+    {
+      std::vector< int > ints( lengths[ l ] );
+      for( size_t i = 0; i < lengths[ l ]; ++i )
+        ints[ i ] = rand( ) % 100 - 50;
+      bolt::cl::device_vector< int > dvInts( ints.begin( ), ints.end( ) );
+
+      EXPECT_EQ( std::min_element( ints.begin( ), ints.end( ) ) - ints.begin( ),
+                 bolt::cl::min_element( ctl, ints.begin( ), ints.end( ) ) - ints.begin( ) );
+      EXPECT_EQ( std::max_element( ints.begin( ), ints.end( ) ) - ints.begin( ),
+                 bolt::cl::max_element( ctl, ints.begin( ), ints.end( ) ) - ints.begin( ) );
+      EXPECT_EQ( std::min_element( ints.begin( ), ints.end( ) ) - ints.begin( ),
+                 bolt::cl::min_element( ctl, dvInts.begin( ), dvInts.end( ) ) - dvInts.begin( ) );
+    }
+  }
+  bolt::btbb::simd::setLevel( bolt::btbb::simd::supportedLevel( ) );
+}
+#endif
 
 
 int _tmain(int argc, _TCHAR* argv[])
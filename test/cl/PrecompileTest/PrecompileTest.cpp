@@ -0,0 +1,145 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#include "stdafx.h"
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/precompile.h"
+#include "bolt/cl/control.h"
+#include "bolt/cl/device_vector.h"
+#include "bolt/cl/sort.h"
+#include "bolt/cl/reduce.h"
+#include "bolt/unicode.h"
+
+#include <gtest/gtest.h>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  The warm-ups run on the OpenCL path; the calls checked afterwards are forced onto it as well, so that
+//  they look up the programs the warm-ups built
+
+class PrecompileTest: public ::testing::Test
+{
+public:
+    PrecompileTest( ): ctl( bolt::cl::control::getDefault( ) )
+    {}
+
+    virtual void SetUp( )
+    {
+        ctl.setForceRunMode( bolt::cl::control::OpenCL );
+        bolt::cl::clearKernelCache( );
+        bolt::cl::programMap.clear( );
+    }
+
+protected:
+    bolt::cl::control ctl;
+};
+
+struct failingWarmup
+{
+    static void run( bolt::cl::control& )
+    {
+        throw std::runtime_error( "failingWarmup" );
+    }
+};
+
+TEST_F( PrecompileTest, BuildsProgramsInBackground )
+{
+    boost::shared_future< void > ready =
+        bolt::cl::precompile< bolt::cl::warmup::sort< int >, bolt::cl::warmup::reduce< float > >( ctl );
+    ready.get( );
+
+    EXPECT_TRUE( ready.is_ready( ) );
+    EXPECT_FALSE( ready.has_exception( ) );
+
+    //  Both algorithms need at least one program each
+    size_t warmPrograms = bolt::cl::programMap.size( );
+    EXPECT_LE( 2u, warmPrograms );
+
+    std::vector< int > input( 4096 );
+    for( size_t i = 0; i < input.size( ); ++i )
+        input[ i ] = static_cast< int >( input.size( ) - i );
+
+    bolt::cl::device_vector< int > dv( input.begin( ), input.end( ), CL_MEM_READ_WRITE, ctl );
+    bolt::cl::sort( ctl, dv.begin( ), dv.end( ) );
+    std::sort( input.begin( ), input.end( ) );
+
+    for( size_t i = 0; i < input.size( ); ++i )
+        EXPECT_EQ( input[ i ], dv[ i ] );
+
+    bolt::cl::device_vector< float > df( 1000, 0.5f, CL_MEM_READ_WRITE, true, ctl );
+    EXPECT_FLOAT_EQ( 500.0f, bolt::cl::reduce( ctl, df.begin( ), df.end( ), 0.0f, bolt::cl::plus< float >( ) ) );
+
+    //  The calls above found every program they needed
+    EXPECT_EQ( warmPrograms, bolt::cl::programMap.size( ) );
+}
+
+TEST_F( PrecompileTest, ReportsFailedWarmup )
+{
+    boost::shared_future< void > ready = bolt::cl::precompiler( )
+        .add< bolt::cl::warmup::reduce< int > >( )
+        .add< failingWarmup >( )
+        .start( ctl );
+
+    ready.wait( );
+    EXPECT_TRUE( ready.has_exception( ) );
+    EXPECT_THROW( ready.get( ), std::exception );
+}
+
+TEST_F( PrecompileTest, EmptyWarmupIsReady )
+{
+    boost::shared_future< void > ready = bolt::cl::precompiler( ).start( ctl );
+    ready.get( );
+    EXPECT_TRUE( ready.is_ready( ) );
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest( &argc, &argv[ 0 ] );
+
+    int retVal = RUN_ALL_TESTS( );
+
+    //  Reflection code to inspect how many tests failed in gTest
+    ::testing::UnitTest& unitTest = *::testing::UnitTest::GetInstance( );
+
+    unsigned int failedTests = 0;
+    for( int i = 0; i < unitTest.total_test_case_count( ); ++i )
+    {
+        const ::testing::TestCase& testCase = *unitTest.GetTestCase( i );
+        for( int j = 0; j < testCase.total_test_count( ); ++j )
+        {
+            const ::testing::TestInfo& testInfo = *testCase.GetTestInfo( j );
+            if( testInfo.result( )->Failed( ) )
+                ++failedTests;
+        }
+    }
+
+    //  Print helpful message at termination if we detect errors, to help users figure out what to do next
+    if( failedTests )
+    {
+        bolt::tout << _T( "\nFailed tests detected in test pass; please run test again with:" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_filter=<XXX> to select a specific failing test of interest" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_catch_exceptions=0 to generate minidump of failing test, or" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_break_on_failure to debug interactively with debugger" ) << std::endl;
+        bolt::tout << _T( "\t    (only on googletest assertion failures, not SEH exceptions)" ) << std::endl;
+    }
+
+    return retVal;
+}
@@ -0,0 +1,331 @@
+/***************************************************************************
+*    2012,2014 Advanced Micro Devices, Inc. All rights reserved.
+*
+*   Licensed under the Apache License, Version 2.0 (the "License");
+*   you may not use this file except in compliance with the License.
+*   You may obtain a copy of the License at
+*
+*       http://www.apache.org/licenses/LICENSE-2.0
+*
+*   Unless required by applicable law or agreed to in writing, software
+*   distributed under the License is distributed on an "AS IS" BASIS,
+*   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*   See the License for the specific language governing permissions and
+*   limitations under the License.
+
+***************************************************************************/
+
+#include "stdafx.h"
+
+#include <vector>
+#include <numeric>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+#include "bolt/cl/bolt.h"
+#include "bolt/cl/program_cache.h"
+#include "bolt/cl/control.h"
+#include "bolt/cl/device_vector.h"
+#include "bolt/cl/reduce.h"
+#include "bolt/unicode.h"
+
+#include <gtest/gtest.h>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  The fixture points the process wide cache at a private, empty directory and forces the OpenCL path,
+//  so that the tests also run on CPU only runtimes such as pocl
+
+class ProgramCacheTest: public ::testing::Test
+{
+public:
+    ProgramCacheTest( ): cache( bolt::cl::ProgramCache::getInstance( ) ), ctl( bolt::cl::control::getDefault( ) )
+    {}
+
+    virtual void SetUp( )
+    {
+        directory = boost::filesystem::temp_directory_path( ) /
+                    boost::filesystem::unique_path( "bolt-program-cache-test-%%%%-%%%%" );
+
+        oldDirectory = cache.getDirectory( );
+        oldMaxSize = cache.getMaxSize( );
+        oldEnabled = cache.getEnabled( );
+
+        cache.setDirectory( directory.string( ) );
+        cache.setMaxSize( 64 << 20 );
+        cache.setEnabled( true );
+        cache.resetStatistics( );
+
+        ctl.setForceRunMode( bolt::cl::control::OpenCL );
+        forgetPrograms( );
+    }
+
+    virtual void TearDown( )
+    {
+        cache.setDirectory( oldDirectory );
+        cache.setMaxSize( oldMaxSize );
+        cache.setEnabled( oldEnabled );
+
+        boost::system::error_code ec;
+        boost::filesystem::remove_all( directory, ec );
+    }
+
+    //  Drops the programs this process compiled, so that the next call has to go to the disk cache
+    void forgetPrograms( )
+    {
+        bolt::cl::clearKernelCache( );
+        bolt::cl::programMap.clear( );
+    }
+
+    int reduceOnDevice( )
+    {
+        std::vector< int > input( 1024 );
+        std::iota( input.begin( ), input.end( ), 1 );
+
+        bolt::cl::device_vector< int > dv( input.begin( ), input.end( ) );
+        return bolt::cl::reduce( ctl, dv.begin( ), dv.end( ), 0 );
+    }
+
+protected:
+    bolt::cl::ProgramCache& cache;
+    bolt::cl::control& ctl;
+    boost::filesystem::path directory;
+    std::string oldDirectory;
+    size_t oldMaxSize;
+    bool oldEnabled;
+};
+
+TEST_F( ProgramCacheTest, DisabledCacheWritesNothing )
+{
+    cache.setEnabled( false );
+
+    EXPECT_EQ( 1024 * 1025 / 2, reduceOnDevice( ) );
+
+    bolt::cl::ProgramCache::statistics stats = cache.getStatistics( );
+    EXPECT_EQ( 0, stats.stores );
+    EXPECT_EQ( 0, stats.hits );
+    EXPECT_EQ( 0, cache.totalSize( ) );
+}
+
+TEST_F( ProgramCacheTest, StoreAndReload )
+{
+    EXPECT_EQ( 1024 * 1025 / 2, reduceOnDevice( ) );
+
+    bolt::cl::ProgramCache::statistics stats = cache.getStatistics( );
+    EXPECT_LE( 1u, stats.stores );
+    EXPECT_LT( 0u, cache.totalSize( ) );
+
+    forgetPrograms( );
+    cache.resetStatistics( );
+
+    EXPECT_EQ( 1024 * 1025 / 2, reduceOnDevice( ) );
+
+    stats = cache.getStatistics( );
+    EXPECT_LE( 1u, stats.hits );
+    EXPECT_EQ( 0, stats.stores );
+    EXPECT_EQ( 0, stats.rejected );
+}
+
+TEST_F( ProgramCacheTest, EvictsBeyondMaxSize )
+{
+    cache.setMaxSize( 1 );
+
+    EXPECT_EQ( 1024 * 1025 / 2, reduceOnDevice( ) );
+
+    bolt::cl::ProgramCache::statistics stats = cache.getStatistics( );
+    EXPECT_LE( 1u, stats.evictions );
+    EXPECT_EQ( 0, cache.totalSize( ) );
+}
+
+TEST_F( ProgramCacheTest, CorruptEntryFallsBackToCompiler )
+{
+    EXPECT_EQ( 1024 * 1025 / 2, reduceOnDevice( ) );
+    ASSERT_LT( 0u, cache.totalSize( ) );
+
+    //  Overwrite every entry with garbage that still carries the right extension
+    for( boost::filesystem::directory_iterator it( directory ), end; it != end; ++it )
+    {
+        std::ofstream garbage( it->path( ).string( ).c_str( ), std::ios::out | std::ios::binary | std::ios::trunc );
+        garbage << "not an OpenCL binary";
+    }
+
+    forgetPrograms( );
+    cache.resetStatistics( );
+
+    EXPECT_EQ( 1024 * 1025 / 2, reduceOnDevice( ) );
+
+    bolt::cl::ProgramCache::statistics stats = cache.getStatistics( );
+    EXPECT_LE( 1u, stats.rejected );
+    EXPECT_EQ( 0, stats.hits );
+    EXPECT_LE( 1u, stats.stores );
+}
+
+TEST_F( ProgramCacheTest, RepeatCallsReuseKernels )
+{
+    EXPECT_EQ( 1024 * 1025 / 2, reduceOnDevice( ) );
+    EXPECT_LT( 0u, bolt::cl::programMap.size( ) );
+
+    //  The kernels cached for this thread do not need the program map anymore
+    bolt::cl::programMap.clear( );
+    EXPECT_EQ( 1024 * 1025 / 2, reduceOnDevice( ) );
+    EXPECT_EQ( 0u, bolt::cl::programMap.size( ) );
+
+    bolt::cl::clearKernelCache( );
+    EXPECT_EQ( 1024 * 1025 / 2, reduceOnDevice( ) );
+    EXPECT_LT( 0u, bolt::cl::programMap.size( ) );
+}
+
+namespace
+{
+    class fillSpecializer: public bolt::cl::KernelTemplateSpecializer
+    {
+    public:
+        fillSpecializer( ) { addKernelName( "fill" ); }
+
+        const std::string operator( )( const std::vector< std::string >& typeNames ) const
+        {
+            return "template __attribute__((mangled_name(" + name( 0 ) + "Instantiated)))\n"
+                   "kernel void fill( global " + typeNames[ 0 ] + "* output );\n";
+        }
+    };
+
+    int runFill( const bolt::cl::control& ctl, const std::string& kernelString )
+    {
+        std::vector< std::string > typeNames( 1, "int" );
+        std::vector< std::string > typeDefs;
+        fillSpecializer kts;
+        std::vector< ::cl::Kernel > kernels = bolt::cl::getKernels( ctl, typeNames, &kts, typeDefs, kernelString );
+
+        int result = 0;
+        ::cl::Buffer output( ctl.getContext( ), CL_MEM_WRITE_ONLY, sizeof( result ) );
+        kernels[ 0 ].setArg( 0, output );
+        ctl.getCommandQueue( ).enqueueTask( kernels[ 0 ] );
+        ctl.getCommandQueue( ).enqueueReadBuffer( output, CL_TRUE, 0, sizeof( result ), &result );
+        return result;
+    }
+}
+
+TEST_F( ProgramCacheTest, SameLengthKernelsAreDistinct )
+{
+    //  Same specializer, same type names and kernels of the same length; only the text tells them apart
+    const std::string fillOne = "template< typename T > kernel void fill( global T* output ) { *output = 1; }\n";
+    const std::string fillTwo = "template< typename T > kernel void fill( global T* output ) { *output = 2; }\n";
+    ASSERT_EQ( fillOne.length( ), fillTwo.length( ) );
+
+    EXPECT_EQ( 1, runFill( ctl, fillOne ) );
+    EXPECT_EQ( 2, runFill( ctl, fillTwo ) );
+    EXPECT_EQ( 1, runFill( ctl, fillOne ) );
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  The ProgramMap itself does not need a device; the builders below stand in for the OpenCL compiler
+
+namespace
+{
+    struct countingBuilder
+    {
+        countingBuilder( ): builds( 0 ), failuresLeft( 0 ) {}
+
+        ::cl::Program operator( )( )
+        {
+            {
+                boost::lock_guard< boost::mutex > lock( guard );
+                ++builds;
+                if( failuresLeft > 0 )
+                {
+                    --failuresLeft;
+                    throw ::cl::Error( CL_BUILD_PROGRAM_FAILURE, "countingBuilder" );
+                }
+            }
+
+            //  Give the other threads time to pile up on the same key
+            boost::this_thread::sleep( boost::posix_time::milliseconds( 50 ) );
+            return ::cl::Program( );
+        }
+
+        boost::mutex guard;
+        int builds;
+        int failuresLeft;
+    };
+
+    void acquireFrom( bolt::cl::ProgramMap* map, bolt::cl::ProgramMapKey key, countingBuilder* builder )
+    {
+        map->acquire( key, ::cl::Context( ), ::cl::Device( ), boost::ref( *builder ) );
+    }
+
+    bolt::cl::ProgramMapKey makeMapKey( const std::string& source )
+    {
+        bolt::cl::ProgramMapKey key = { NULL, NULL, bolt::cl::ProgramDigester( ).add( source ).digest( ) };
+        return key;
+    }
+}
+
+TEST( ProgramMap, BuildsEachKeyOnce )
+{
+    bolt::cl::ProgramMap map;
+    countingBuilder builder;
+    bolt::cl::ProgramMapKey key = makeMapKey( "kernel void k( ) { }" );
+
+    boost::thread_group threads;
+    for( int i = 0; i < 8; ++i )
+        threads.create_thread( boost::bind( &acquireFrom, &map, key, &builder ) );
+    threads.join_all( );
+
+    EXPECT_EQ( 1, builder.builds );
+    EXPECT_EQ( 1u, map.size( ) );
+
+    ::cl::Program program;
+    EXPECT_TRUE( map.find( key, program ) );
+    EXPECT_FALSE( map.find( makeMapKey( "kernel void l( ) { }" ), program ) );
+}
+
+TEST( ProgramMap, FailedBuildIsRetried )
+{
+    bolt::cl::ProgramMap map;
+    countingBuilder builder;
+    builder.failuresLeft = 1;
+    bolt::cl::ProgramMapKey key = makeMapKey( "kernel void k( ) { }" );
+
+    EXPECT_THROW( acquireFrom( &map, key, &builder ), ::cl::Error );
+    EXPECT_EQ( 0u, map.size( ) );
+
+    acquireFrom( &map, key, &builder );
+    EXPECT_EQ( 2, builder.builds );
+    EXPECT_EQ( 1u, map.size( ) );
+}
+
+int main(int argc, char* argv[])
+{
+    ::testing::InitGoogleTest( &argc, &argv[ 0 ] );
+
+    int retVal = RUN_ALL_TESTS( );
+
+    //  Reflection code to inspect how many tests failed in gTest
+    ::testing::UnitTest& unitTest = *::testing::UnitTest::GetInstance( );
+
+    unsigned int failedTests = 0;
+    for( int i = 0; i < unitTest.total_test_case_count( ); ++i )
+    {
+        const ::testing::TestCase& testCase = *unitTest.GetTestCase( i );
+        for( int j = 0; j < testCase.total_test_count( ); ++j )
+        {
+            const ::testing::TestInfo& testInfo = *testCase.GetTestInfo( j );
+            if( testInfo.result( )->Failed( ) )
+                ++failedTests;
+        }
+    }
+
+    //  Print helpful message at termination if we detect errors, to help users figure out what to do next
+    if( failedTests )
+    {
+        bolt::tout << _T( "\nFailed tests detected in test pass; please run test again with:" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_filter=<XXX> to select a specific failing test of interest" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_catch_exceptions=0 to generate minidump of failing test, or" ) << std::endl;
+        bolt::tout << _T( "\t--gtest_break_on_failure to debug interactively with debugger" ) << std::endl;
+        bolt::tout << _T( "\t    (only on googletest assertion failures, not SEH exceptions)" ) << std::endl;
+    }
+
+    return retVal;
+}
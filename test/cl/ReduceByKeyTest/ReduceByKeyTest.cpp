@@ -2435,6 +2435,39 @@ TEST(ReduceByKeyBasic, MultiCoreIntegerTestOddSizes)
 
 }
 
+TEST(ReduceByKeyBasic, MultiCoreSegmentsAcrossTiles)
+{
+    //  Segments shorter and much longer than the tiles of the TBB version, some ending exactly at a tile boundary
+    const int segmentLengths[] = { 1, 16383, 1, 16384, 40000, 3, 100000, 16384, 7 };
+    std::vector< int > keys, input;
+    for( int s = 0; s < int( sizeof( segmentLengths ) / sizeof( segmentLengths[ 0 ] ) ); ++s )
+    {
+        for( int i = 0; i < segmentLengths[ s ]; ++i )
+        {
+            keys.push_back( s % 2 );
+            input.push_back( std::rand( ) % 4 );
+        }
+    }
+    const size_t length = keys.size( );
+
+    std::vector< int > koutput( length ), voutput( length );
+    std::vector< int > krefOutput( length ), vrefOutput( length );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode(bolt::cl::control::MultiCoreCpu);
+
+    auto p = bolt::cl::reduce_by_key( ctl, keys.begin(), keys.end(), input.begin(), koutput.begin(),
+                                      voutput.begin(), bolt::cl::equal_to<int>(), bolt::cl::plus<int>());
+    auto refPair = gold_reduce_by_key( keys.begin(), keys.end(), input.begin(), krefOutput.begin(),
+                                       vrefOutput.begin(),std::plus<int>());
+
+    //  The reference returns the last output, bolt the end of the output
+    EXPECT_EQ( refPair.first - krefOutput.begin( ) + 1, p.first - koutput.begin( ) );
+    EXPECT_EQ( refPair.second - vrefOutput.begin( ) + 1, p.second - voutput.begin( ) );
+    cmpArrays(krefOutput, koutput);
+    cmpArrays(vrefOutput, voutput);
+}
+
 #if UDD
 TEST(ReduceByKeyPairUDDTest, UDDFloatIntTest)
 {
@@ -28,6 +28,10 @@
 #include <bolt/cl/reduce.h>
 #include <bolt/cl/functional.h>
 #include <bolt/cl/control.h>
+#include <bolt/cl/tuner.h>
+#if defined( ENABLE_TBB )
+#include "bolt/btbb/simd_reduce.h"
+#endif
 
 #include <iostream>
 #include <algorithm>  // for testing against STL functions.
@@ -372,6 +376,35 @@ TEST( ReduceStdVectWithInit, OffsetTestMultiCoreCpu)
     EXPECT_EQ( stlTransformReduce, boltTransformReduce );
 }
 
+//  More elements than a 32 bit int can count; needs about 2 GB of host memory
+TEST( ReduceStdVectWithInit, LargeSizeSerialAndMultiCoreCpu)
+{
+    const size_t length = ( size_t( 1 ) << 31 ) + 4097;
+    std::vector< cl_uchar > stdInput;
+    try
+    {
+        stdInput.assign( length, 1 );
+    }
+    catch( std::bad_alloc& )
+    {
+        std::cout << "Not enough host memory for " << length << " elements; test skipped" << std::endl;
+        return;
+    }
+
+    bolt::cl::control ctl;
+    ctl.setForceRunMode(bolt::cl::control::SerialCpu);
+    cl_ulong serialReduce = bolt::cl::reduce( ctl, stdInput.begin( ), stdInput.end( ), cl_ulong( 0 ),
+                                              bolt::cl::plus< cl_ulong >( ) );
+    EXPECT_EQ( cl_ulong( length ), serialReduce );
+
+#if defined( ENABLE_TBB )
+    ctl.setForceRunMode(bolt::cl::control::MultiCoreCpu);
+    cl_ulong multiCoreReduce = bolt::cl::reduce( ctl, stdInput.begin( ), stdInput.end( ), cl_ulong( 0 ),
+                                                 bolt::cl::plus< cl_ulong >( ) );
+    EXPECT_EQ( cl_ulong( length ), multiCoreReduce );
+#endif
+}
+
 TEST( ReduceStdVectWithInit, OffsetTestSerialCpu)
 {
     int length = 1024;
@@ -1732,6 +1765,85 @@ TEST(ReduceAuto, Reduce386717)
 }
 
 
+TEST(ReduceAutoTune, WorkShape)
+{
+  bolt::cl::control my_ctl;
+  my_ctl.setForceRunMode( bolt::cl::control::OpenCL );
+  my_ctl.setAutoTuneMode( bolt::cl::control::AutoTuneWorkShape );
+
+  //  The first call tunes, the second reuses the shape it found; both must reduce every element
+  for( int run = 0; run < 2; ++run )
+  {
+    bolt::cl::device_vector< int > input( 1000003, 1 );
+    int boltClReduce = bolt::cl::reduce( my_ctl, input.begin( ), input.end( ), 7, bolt::cl::plus< int >( ) );
+    EXPECT_EQ( 1000003 + 7, boltClReduce );
+  }
+}
+
+TEST(ReduceAutoTune, DatabaseRoundTrip)
+{
+  bolt::cl::control my_ctl;
+  bolt::cl::work_shape_tuner& tuner = bolt::cl::work_shape_tuner::getInstance( );
+  const std::string key = bolt::cl::work_shape_tuner::makeKey( my_ctl, "reduce", "test", 1000003 );
+
+  const bolt::cl::work_shape_tuner::work_shape shape = { 64, 4, 2 };
+  tuner.setShape( key, shape );
+
+  const std::string path = "bolt_tuning_db.test.txt";
+  ASSERT_TRUE( tuner.saveDatabase( path ) );
+
+  const bolt::cl::work_shape_tuner::work_shape other = { 128, 16, 1 };
+  tuner.setShape( key, other );
+  ASSERT_TRUE( tuner.loadDatabase( path ) );
+  std::remove( path.c_str( ) );
+
+  bolt::cl::work_shape_tuner::work_shape loaded = other;
+  ASSERT_TRUE( tuner.findShape( key, loaded ) );
+  EXPECT_EQ( shape.wgSize, loaded.wgSize );
+  EXPECT_EQ( shape.wgPerComputeUnit, loaded.wgPerComputeUnit );
+  EXPECT_EQ( shape.unroll, loaded.unroll );
+}
+
+#if defined( ENABLE_TBB )
+TEST(ReduceSimd, EveryLevel)
+{
+  //  Lengths around the vector widths and the TBB grain; the doubles are whole, so their sums are exact
+  const size_t lengths[] = { 1, 15, 16, 63, 64, 65, 100003 };
+  bolt::cl::control my_ctl;
+  my_ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+
+  for( int level = bolt::btbb::simd::scalar; level <= bolt::btbb::simd::supportedLevel( ); ++level )
+  {
+    bolt::btbb::simd::setLevel( static_cast< bolt::btbb::simd::level >( level ) );
+    for( size_t l = 0; l < sizeof( lengths ) / sizeof( lengths[ 0 ] ); ++l )
+    {
+      std::vector< int > ints( lengths[ l ] );
+      std::vector< unsigned int > uints( lengths[ l ] );
+      std::vector< double > doubles( lengths[ l ] );
+      for( size_t i = 0; i < lengths[ l ]; ++i )
+      {
+        ints[ i ] = rand( ) % 2001 - 1000;
+        uints[ i ] = static_cast< unsigned int >( rand( ) ) * 3u;
+        doubles[ i ] = static_cast< double >( rand( ) % 1000 );
+      }
+      bolt::cl::device_vector< int > dvInts( ints.begin( ), ints.end( ) );
+
+      EXPECT_EQ( std::accumulate( ints.begin( ), ints.end( ), 7 ),
+                 bolt::cl::reduce( my_ctl, ints.begin( ), ints.end( ), 7, bolt::cl::plus< int >( ) ) );
+      EXPECT_EQ( std::accumulate( ints.begin( ), ints.end( ), 7 ),
+                 bolt::cl::reduce( my_ctl, dvInts.begin( ), dvInts.end( ), 7, bolt::cl::plus< int >( ) ) );
+      EXPECT_EQ( std::accumulate( doubles.begin( ), doubles.end( ), 0.5 ),
+                 bolt::cl::reduce( my_ctl, doubles.begin( ), doubles.end( ), 0.5, bolt::cl::plus< double >( ) ) );
+      EXPECT_EQ( *std::min_element( ints.begin( ), ints.end( ) ),
+                 bolt::cl::reduce( my_ctl, ints.begin( ), ints.end( ), 1000, bolt::cl::minimum< int >( ) ) );
+      EXPECT_EQ( *std::max_element( uints.begin( ), uints.end( ) ),
+                 bolt::cl::reduce( my_ctl, uints.begin( ), uints.end( ), 0u, bolt::cl::maximum< unsigned int >( ) ) );
+    }
+  }
+  bolt::btbb::simd::setLevel( bolt::btbb::simd::supportedLevel( ) );
+}
+#endif
+
 
 #if 0
 // Disable test since the buffer interface is moving to device_vector.
@@ -22,6 +22,9 @@
 //#include "bolt/cl/scan.h"
 #include "bolt/cl/functional.h"
 #include "bolt/cl/scan_by_key.h"
+#if defined( ENABLE_TBB )
+#include "bolt/btbb/scan_engine.h"
+#endif
 #include "bolt/unicode.h"
 #include "bolt/miniDump.h"
 
@@ -3003,6 +3006,121 @@ TEST(InclusiveScanByKey, MultiCore_OffsetIncFloat)
     cmpArrays(refInput, input);
 }
 
+#if defined( ENABLE_TBB )
+//  Segments that span the tiles of the single pass scan, compared with the two pass tbb::parallel_scan
+TEST(InclusiveScanByKey, MultiCoreLookbackAndTwoPass)
+{
+    int length = ( 1 << 20 ) + 17;
+
+    //  Segments of 1 to 40000 elements, so that some stay inside a tile and others cover several
+    std::vector< int > keys( length );
+    int key = 0;
+    for( int i = 0; i < length; )
+    {
+        int segmentLength = 1 + rand( ) % 40000;
+        for( int j = 0; j < segmentLength && i < length; j++, i++ )
+            keys[ i ] = key;
+        ++key;
+    }
+
+    std::vector< int > input( length );
+    for( int i = 0; i < length; i++ )
+        input[ i ] = rand( ) % 7 - 3;
+
+    std::vector< int > refInclusive( length ), refExclusive( length );
+    gold_scan_by_key( keys.begin( ), keys.end( ), input.begin( ), refInclusive.begin( ), bolt::cl::plus< int >( ) );
+    gold_scan_by_key_exclusive( keys.begin( ), keys.end( ), input.begin( ), refExclusive.begin( ),
+                                bolt::cl::plus< int >( ), 4 );
+
+    bolt::cl::control ctl;
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+
+    bolt::btbb::e_ScanEngine engines[ ] = { bolt::btbb::LookbackScan, bolt::btbb::TwoPassScan };
+    for( int e = 0; e < 2; e++ )
+    {
+        bolt::btbb::setScanEngine( engines[ e ] );
+
+        std::vector< int > output( length );
+        bolt::cl::inclusive_scan_by_key( ctl, keys.begin( ), keys.end( ), input.begin( ), output.begin( ),
+                                         bolt::cl::equal_to< int >( ), bolt::cl::plus< int >( ) );
+        cmpArrays( refInclusive, output );
+
+        bolt::cl::exclusive_scan_by_key( ctl, keys.begin( ), keys.end( ), input.begin( ), output.begin( ), 4,
+                                         bolt::cl::equal_to< int >( ), bolt::cl::plus< int >( ) );
+        cmpArrays( refExclusive, output );
+    }
+    bolt::btbb::setScanEngine( bolt::btbb::LookbackScan );
+}
+
+//  Segments that start where a flag is set
+struct FlagSegments
+{
+    const std::vector< int >* flags;
+    bool operator( )( size_t i ) const { return ( *flags )[ i ] != 0; }
+};
+
+//  The segmented scan engine with flagged segments and a transform, and the segmented reduce under it
+TEST(InclusiveScanByKey, MultiCoreSegmentedEngine)
+{
+    int length = ( 1 << 19 ) + 5;
+    std::vector< int > flags( length ), input( length ), keys( length );
+    int key = 0;
+    for( int i = 0; i < length; i++ )
+    {
+        flags[ i ] = ( i == 0 ) || ( rand( ) % 30000 == 0 );
+        key += flags[ i ];
+        keys[ i ] = key;
+        input[ i ] = rand( ) % 7 - 3;
+    }
+
+    std::vector< int > refInclusive( length ), refExclusive( length ), refKeys, refValues;
+    for( int i = 0; i < length; i++ )
+    {
+        refInclusive[ i ] = flags[ i ] ? -input[ i ] : refInclusive[ i - 1 ] - input[ i ];
+        refExclusive[ i ] = flags[ i ] ? 2 : refExclusive[ i - 1 ] - input[ i - 1 ];
+        if( flags[ i ] )
+        {
+            refKeys.push_back( keys[ i ] );
+            refValues.push_back( 0 );
+        }
+        refValues.back( ) += input[ i ];
+    }
+
+    FlagSegments heads = { &flags };
+    bolt::btbb::e_ScanEngine engines[ ] = { bolt::btbb::LookbackScan, bolt::btbb::TwoPassScan };
+    for( int e = 0; e < 2; e++ )
+    {
+        bolt::btbb::setScanEngine( engines[ e ] );
+
+        std::vector< int > output( length );
+        bolt::btbb::segmented_scan( length, heads, input.begin( ), output.begin( ), std::negate< int >( ),
+                                    std::plus< int >( ), true, 0 );
+        cmpArrays( refInclusive, output );
+
+        bolt::btbb::segmented_scan( length, heads, input.begin( ), output.begin( ), std::negate< int >( ),
+                                    std::plus< int >( ), false, 2 );
+        cmpArrays( refExclusive, output );
+
+        //  In place; a tile publishes its sum before its scan overwrites it
+        output = input;
+        bolt::btbb::segmented_scan( length, heads, output.begin( ), output.begin( ), std::negate< int >( ),
+                                    std::plus< int >( ), false, 2 );
+        cmpArrays( refExclusive, output );
+
+        std::vector< int > keysOutput( length ), valuesOutput( length );
+        size_t segments = bolt::btbb::segmented_reduce( length, heads, keys.begin( ), input.begin( ),
+                                                        keysOutput.begin( ), valuesOutput.begin( ),
+                                                        std::plus< int >( ) );
+        EXPECT_EQ( refKeys.size( ), segments );
+        keysOutput.resize( segments );
+        valuesOutput.resize( segments );
+        cmpArrays( refKeys, keysOutput );
+        cmpArrays( refValues, valuesOutput );
+    }
+    bolt::btbb::setScanEngine( bolt::btbb::LookbackScan );
+}
+#endif
+
 
 
 TEST(ExclusiveScanByKey, Serial_OffsetExclFloat)
@@ -24,6 +24,9 @@
 #include "bolt/unicode.h"
 #include "bolt/miniDump.h"
 #include <bolt/cl/iterator/counting_iterator.h>
+#if defined( ENABLE_TBB )
+#include "bolt/btbb/scan_engine.h"
+#endif
 
 #include <gtest/gtest.h>
 #include <boost/shared_array.hpp>
@@ -378,6 +381,94 @@ TEST(InclusiveScan, MulticorenormalArrayTest)
     
 } 
 
+#if defined( ENABLE_TBB )
+//  Many tiles of the single pass scan, compared with the two pass tbb::parallel_scan and the reference
+TEST(InclusiveScan, MultiCoreLookbackAndTwoPass)
+{
+    const int length = ( 1 << 20 ) + 17;
+    std::vector< int > input( length );
+    for( int i = 0; i < length; i++ )
+        input[ i ] = rand( ) % 7 - 3;
+
+    std::vector< int > refInclusive( length ), refExclusive( length );
+    ::std::partial_sum( input.begin( ), input.end( ), refInclusive.begin( ) );
+    refExclusive[ 0 ] = 5;
+    for( int i = 1; i < length; i++ )
+        refExclusive[ i ] = refExclusive[ i - 1 ] + input[ i - 1 ];
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+
+    bolt::btbb::e_ScanEngine engines[ ] = { bolt::btbb::LookbackScan, bolt::btbb::TwoPassScan };
+    for( int e = 0; e < 2; e++ )
+    {
+        bolt::btbb::setScanEngine( engines[ e ] );
+
+        std::vector< int > output( length );
+        bolt::cl::inclusive_scan( ctl, input.begin( ), input.end( ), output.begin( ), bolt::cl::plus< int >( ) );
+        cmpArrays( refInclusive, output );
+
+        //  In place
+        output = input;
+        bolt::cl::exclusive_scan( ctl, output.begin( ), output.end( ), output.begin( ), 5, bolt::cl::plus< int >( ) );
+        cmpArrays( refExclusive, output );
+    }
+    bolt::btbb::setScanEngine( bolt::btbb::LookbackScan );
+}
+#endif
+
+BOLT_FUNCTOR(AddUChar,
+struct AddUChar
+{
+    cl_uchar operator()(const cl_uchar &lhs, const cl_uchar &rhs) const
+    {
+        return static_cast< cl_uchar >( lhs + rhs );
+    };
+};
+);
+
+//  More elements than a 32 bit int can count; needs about 2 GB of host memory.  The sums wrap around at 256
+TEST(InclusiveScan, LargeSizeSerialAndMultiCore)
+{
+    const size_t length = ( size_t( 1 ) << 31 ) + 4097;
+    std::vector< cl_uchar > input;
+    try
+    {
+        input.assign( length, 1 );
+    }
+    catch( std::bad_alloc& )
+    {
+        std::cout << "Not enough host memory for " << length << " elements; test skipped" << std::endl;
+        return;
+    }
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    bolt::cl::control::e_RunMode runModes[ ] = { bolt::cl::control::SerialCpu, bolt::cl::control::MultiCoreCpu };
+#if defined( ENABLE_TBB )
+    const int numRunModes = 2;
+#else
+    const int numRunModes = 1;
+#endif
+    for( int m = 0; m < numRunModes; m++ )
+    {
+        ctl.setForceRunMode( runModes[ m ] );
+        std::fill( input.begin( ), input.end( ), cl_uchar( 1 ) );
+
+        std::vector< cl_uchar >::iterator end =
+            bolt::cl::inclusive_scan( ctl, input.begin( ), input.end( ), input.begin( ), AddUChar( ) );
+        EXPECT_EQ( length, static_cast< size_t >( end - input.begin( ) ) );
+
+        size_t errors = 0;
+        for( size_t i = 0; i < length; i++ )
+        {
+            if( input[ i ] != static_cast< cl_uchar >( i + 1 ) )
+                ++errors;
+        }
+        EXPECT_EQ( 0u, errors );
+    }
+}
+
+
 
 
 TEST(InclusiveScan, DeviceVectorInclFloat)
@@ -3182,6 +3273,29 @@ INSTANTIATE_TYPED_TEST_CASE_P( Integer, ScanArrayTest, IntegerTests );
 INSTANTIATE_TYPED_TEST_CASE_P( Float, ScanArrayTest, FloatTests );
 //here
 
+TEST(ScanAutoTune, WorkGroupSize)
+{
+    bolt::cl::control ctl;
+    ctl.setForceRunMode( bolt::cl::control::OpenCL );
+    ctl.setAutoTuneMode( bolt::cl::control::AutoTuneWorkShape );
+
+    const int length = 1000003;
+    std::vector< int > ref( length, 1 );
+    std::partial_sum( ref.begin( ), ref.end( ), ref.begin( ) );
+
+    //  The first call tunes, the second reuses the size it found; the scan in place is not tuned
+    for( int run = 0; run < 2; ++run )
+    {
+        bolt::cl::device_vector< int > input( length, 1 );
+        bolt::cl::device_vector< int > output( length );
+        bolt::cl::inclusive_scan( ctl, input.begin( ), input.end( ), output.begin( ), bolt::cl::plus< int >( ) );
+        cmpArrays( ref, output );
+
+        bolt::cl::inclusive_scan( ctl, input.begin( ), input.end( ), input.begin( ), bolt::cl::plus< int >( ) );
+        cmpArrays( ref, input );
+    }
+}
+
 
 /* TEST(Scan, cpuQueue)
 {
@@ -717,6 +717,76 @@ TEST_P( StableSortbyKeyIntegerVector, MultiCoreCPU )
 
 }
 
+#if defined( ENABLE_TBB )
+//  The MultiCoreCpu path radix sorts the keys and values in place, or, for other comparisons and when the memory
+//  limit does not allow the radix buffers, sorts ( key, index ) pairs and permutes the values afterwards
+template< typename keyType, typename StrictWeakOrdering >
+void checkMultiCoreSortByKey( size_t length, StrictWeakOrdering comp, size_t memoryLimit )
+{
+    std::vector< keyType > keys( length );
+    std::vector< int > values( length );
+    for( size_t i = 0; i < length; ++i )
+    {
+        keys[ i ] = static_cast< keyType >( rand( ) % 1000 ) - static_cast< keyType >( 500 );
+        values[ i ] = static_cast< int >( i );
+    }
+    std::vector< keyType > originalKeys( keys );
+    std::vector< keyType > stdKeys( keys );
+    std::sort( stdKeys.begin( ), stdKeys.end( ), comp );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+
+    size_t oldLimit = bolt::btbb::getSortByKeyMemoryLimit( );
+    bolt::btbb::setSortByKeyMemoryLimit( memoryLimit );
+    bolt::cl::sort_by_key( ctl, keys.begin( ), keys.end( ), values.begin( ), comp );
+    bolt::btbb::setSortByKeyMemoryLimit( oldLimit );
+
+    //  The keys are sorted, and every value still belongs to its key
+    std::vector< bool > seen( length, false );
+    for( size_t i = 0; i < length; ++i )
+    {
+        EXPECT_FALSE( comp( keys[ i ], stdKeys[ i ] ) || comp( stdKeys[ i ], keys[ i ] ) ) << "at " << i;
+        ASSERT_LE( 0, values[ i ] );
+        ASSERT_GT( static_cast< int >( length ), values[ i ] );
+        EXPECT_FALSE( seen[ values[ i ] ] );
+        seen[ values[ i ] ] = true;
+        EXPECT_EQ( originalKeys[ values[ i ] ], keys[ i ] );
+    }
+}
+
+//  Orders by the distance to zero, which the radix sort does not know
+BOLT_FUNCTOR( absoluteLess,
+struct absoluteLess
+{
+    bool operator( )( const int& lhs, const int& rhs ) const
+    {
+        return ( lhs < 0 ? -lhs : lhs ) < ( rhs < 0 ? -rhs : rhs );
+    }
+};
+);
+
+TEST( MultiCoreSortByKey, RadixSort )
+{
+    checkMultiCoreSortByKey< int >( ( 1 << 17 ) + 5, bolt::cl::less< int >( ), 0 );
+    checkMultiCoreSortByKey< float >( ( 1 << 17 ) + 5, bolt::cl::greater< float >( ), 0 );
+    checkMultiCoreSortByKey< cl_long >( 4099, bolt::cl::less< cl_long >( ), 0 );
+}
+
+TEST( MultiCoreSortByKey, PermutationWithGather )
+{
+    checkMultiCoreSortByKey< int >( ( 1 << 17 ) + 5, absoluteLess( ), 0 );
+    checkMultiCoreSortByKey< int >( 4099, absoluteLess( ), 4099 * sizeof( int ) );
+}
+
+TEST( MultiCoreSortByKey, PermutationInPlace )
+{
+    checkMultiCoreSortByKey< int >( ( 1 << 17 ) + 5, absoluteLess( ), 1 );
+    checkMultiCoreSortByKey< int >( 4099, absoluteLess( ), 4099 * sizeof( int ) - 1 );
+    checkMultiCoreSortByKey< double >( 4099, bolt::cl::greater< double >( ), 1 );
+}
+#endif
+
 // Come Back here
 TEST_P( StableSortbyKeyFloatVector, Normal )
 {
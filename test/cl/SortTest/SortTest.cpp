@@ -253,6 +253,56 @@ TEST(Sort, MultiCore_DevclLong)
 
 }
 
+//  The MultiCoreCpu path radix sorts the built-in types when the comparator is less or greater; the sizes cross
+//  the serial cutoff and the tile size of the radix sort
+template< typename T, typename StrictWeakOrdering >
+void checkMultiCoreRadixSort( size_t length, StrictWeakOrdering comp )
+{
+    std::vector< T > bolt_source( length );
+    for( size_t j = 0; j < length; j++ )
+    {
+        //  Mix of negative, positive and repeated values
+        bolt_source[ j ] = static_cast< T >( ( rand( ) % 2 ? 1 : -1 ) * ( rand( ) % 100000 ) );
+    }
+    std::vector< T > std_source( bolt_source );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+
+    std::sort( std_source.begin( ), std_source.end( ), comp );
+    bolt::cl::sort( ctl, bolt_source.begin( ), bolt_source.end( ), comp );
+
+    cmpArrays( std_source, bolt_source );
+}
+
+TEST(Sort, MultiCore_RadixLess)
+{
+    size_t lengths[ ] = { 1000, 5000, (1<<16) + 3, (1<<20) + 17 };
+    for( size_t i = 0; i < sizeof( lengths ) / sizeof( lengths[ 0 ] ); ++i )
+    {
+        checkMultiCoreRadixSort< int >( lengths[ i ], bolt::cl::less< int >( ) );
+        checkMultiCoreRadixSort< unsigned int >( lengths[ i ], bolt::cl::less< unsigned int >( ) );
+        checkMultiCoreRadixSort< float >( lengths[ i ], bolt::cl::less< float >( ) );
+        checkMultiCoreRadixSort< double >( lengths[ i ], bolt::cl::less< double >( ) );
+        checkMultiCoreRadixSort< cl_long >( lengths[ i ], bolt::cl::less< cl_long >( ) );
+        checkMultiCoreRadixSort< cl_ulong >( lengths[ i ], bolt::cl::less< cl_ulong >( ) );
+    }
+}
+
+TEST(Sort, MultiCore_RadixGreater)
+{
+    size_t lengths[ ] = { 1000, 5000, (1<<16) + 3, (1<<20) + 17 };
+    for( size_t i = 0; i < sizeof( lengths ) / sizeof( lengths[ 0 ] ); ++i )
+    {
+        checkMultiCoreRadixSort< int >( lengths[ i ], bolt::cl::greater< int >( ) );
+        checkMultiCoreRadixSort< unsigned int >( lengths[ i ], bolt::cl::greater< unsigned int >( ) );
+        checkMultiCoreRadixSort< float >( lengths[ i ], bolt::cl::greater< float >( ) );
+        checkMultiCoreRadixSort< double >( lengths[ i ], bolt::cl::greater< double >( ) );
+        checkMultiCoreRadixSort< cl_long >( lengths[ i ], bolt::cl::greater< cl_long >( ) );
+        checkMultiCoreRadixSort< cl_ulong >( lengths[ i ], bolt::cl::greater< cl_ulong >( ) );
+    }
+}
+
 TEST(SortUDD, AddDouble4)
 {
     //setup containers
@@ -2709,6 +2759,27 @@ TEST_P(sort_withStdVectFloat_2, floatSerial_EPR){
 }
 
 INSTANTIATE_TEST_CASE_P(sortDescending, sort_withStdVectFloat_2, ::testing::Range( 1, 1129, 7));  //Passing for each iteration
+
+TEST(SortAutoTune, BitonicWorkGroupSize)
+{
+    bolt::cl::control ctl;
+    ctl.setForceRunMode( bolt::cl::control::OpenCL );
+    ctl.setAutoTuneMode( bolt::cl::control::AutoTuneWorkShape );
+
+    //  Floats of a power of two length take the bitonic sort; the first call tunes, the second reuses the size
+    const size_t length = 1 << 16;
+    for( int run = 0; run < 2; ++run )
+    {
+        std::vector< float > stdVect( length );
+        for( size_t i = 0; i < length; ++i )
+            stdVect[ i ] = static_cast< float >( ( i * 7919 + run ) % length );
+
+        bolt::cl::device_vector< float > boltVect( stdVect.begin( ), stdVect.end( ) );
+        std::sort( stdVect.begin( ), stdVect.end( ) );
+        bolt::cl::sort( ctl, boltVect.begin( ), boltVect.end( ) );
+        cmpArrays( stdVect, boltVect );
+    }
+}
 //test code ends
 
 int main(int argc, char* argv[])
@@ -888,6 +888,32 @@ BOLT_TEMPLATE_REGISTER_NEW_TYPE(bolt::cl::greater, int, UDD);
 BOLT_TEMPLATE_REGISTER_NEW_TYPE(bolt::cl::less, int, UDD);
 BOLT_TEMPLATE_REGISTER_NEW_ITERATOR(bolt::cl::device_vector, int, UDD);
 
+//  Few distinct keys over more elements than one leaf of the parallel merge sort, so that equal keys meet in the
+//  merges of every level; b records the original position
+TEST( MultiCoreCPU, MultiCoreStableAcrossMerges )
+{
+    size_t length = ( 1 << 18 ) + 7;
+    std::vector< UDD > stdInput( length );
+    for( size_t i = 0; i < length; ++i )
+    {
+        stdInput[ i ].a = rand( ) % 64;
+        stdInput[ i ].b = static_cast< int >( i );
+    }
+    std::vector< UDD > boltInput( stdInput );
+
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode( bolt::cl::control::MultiCoreCpu );
+
+    std::stable_sort( stdInput.begin( ), stdInput.end( ), sortBy_UDD_a( ) );
+    bolt::cl::stable_sort( ctl, boltInput.begin( ), boltInput.end( ), sortBy_UDD_a( ) );
+
+    for( size_t i = 0; i < length; ++i )
+    {
+        ASSERT_EQ( stdInput[ i ].a, boltInput[ i ].a ) << "at " << i;
+        ASSERT_EQ( stdInput[ i ].b, boltInput[ i ].b ) << "at " << i;
+    }
+}
+
 //  ::testing::TestWithParam< int > means that GetParam( ) returns int values, which i use for array size
 class StableSortUDDDeviceVector: public ::testing::TestWithParam< int >
 {
@@ -1985,6 +1985,44 @@ TEST(simple,MultiCoreCPU)
     cmpArrays( stdOutput, boltOutput, 1024 );
 }
 
+//  The host paths map only the elements they work on; the elements around the ranges must keep their values
+void transformSubRange( bolt::cl::control& ctl )
+{
+    std::vector<int> input(1024);
+    for( int i = 0; i < 1024; ++i )
+        input[i] = i;
+    std::vector<int> stdOutput(1024, -1);
+    std::vector<int> stdInPlace(input);
+
+    bolt::cl::device_vector<int> dvInput(input.begin(), input.end());
+    bolt::cl::device_vector<int> dvOutput(stdOutput.begin(), stdOutput.end());
+
+    std::transform( input.begin() + 100, input.begin() + 612, stdOutput.begin() + 200, bolt::cl::negate<int>());
+    bolt::cl::transform(ctl, dvInput.begin() + 100, dvInput.begin() + 612, dvOutput.begin() + 200,
+                        bolt::cl::negate<int>());
+    cmpArrays( stdOutput, dvOutput );
+
+    std::transform( stdInPlace.begin() + 300, stdInPlace.begin() + 400, stdInPlace.begin() + 300,
+                    bolt::cl::negate<int>());
+    bolt::cl::transform(ctl, dvInput.begin() + 300, dvInput.begin() + 400, dvInput.begin() + 300,
+                        bolt::cl::negate<int>());
+    cmpArrays( stdInPlace, dvInput );
+}
+
+TEST(simple,SerialSubRange)
+{
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode(bolt::cl::control::SerialCpu);
+    transformSubRange( ctl );
+}
+
+TEST(simple,MultiCoreCPUSubRange)
+{
+    bolt::cl::control ctl = bolt::cl::control::getDefault( );
+    ctl.setForceRunMode(bolt::cl::control::MultiCoreCpu);
+    transformSubRange( ctl );
+}
+
 //Teststotestthecountingiterator
 TEST(simple1,counting)
 {